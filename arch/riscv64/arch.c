@@ -6,6 +6,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-25     lizhirui     add hart initialization
+ * 2021-07-27     lizhirui     inherit fpu context on clone and drop it on execve
+ * 2021-07-27     lizhirui     keep sscratch zero in kernel mode
+ * 2021-07-28     lizhirui     return 0 to the child task on clone
  */
 
 // @formatter:off
@@ -36,14 +40,22 @@ void arch_task_stack_frame_init(os_task_t *task)
     frame -> sstatus = 0x000401120;
 }
 
+//用于arch实现初始化当前hart，内核态下sscratch为0，返回用户态时sscratch保存hart私有数据指针，trap入口据此区分来源并恢复tp
+void arch_hart_init(os_hart_p hart)
+{
+    write_csr(sscratch,0);
+}
+
 void arch_task_clone_stack_frame_init(struct TrapFrame *regs,os_task_t *task,os_size_t new_sp)
 {
     struct TrapFrame *src_frame = (struct TrapFrame *)os_task_get_current_task() -> sp;
     struct TrapFrame *dst_frame = (struct TrapFrame *)(task -> sp = (task -> stack_addr + task -> stack_size - sizeof(struct TrapFrame) * 2));
 
     os_memcpy(&dst_frame[1],src_frame,sizeof(struct TrapFrame));
-    dst_frame[1].a0 = task -> pid;
+    //子任务从clone返回0，父任务的返回值由系统调用处理程序设置为子任务的pid
+    dst_frame[1].a0 = 0;
     dst_frame[1].user_sp = new_sp;
+    arch_fpu_clone(regs,task,&dst_frame[1]);
     dst_frame[0].user_sp = task -> stack_addr + task -> stack_size - sizeof(struct TrapFrame);
     dst_frame[0].gp = (os_size_t)&__global_pointer$;
     dst_frame[0].sepc = (os_size_t)syscall_exit;
@@ -57,4 +69,5 @@ void arch_task_execve_stack_frame_init(struct TrapFrame *regs,os_size_t entry)
     os_memset(regs,0,sizeof(struct TrapFrame));
     regs -> sepc = entry - 4;
     regs -> sstatus = sstatus;
+    arch_fpu_execve(regs);
 }
\ No newline at end of file
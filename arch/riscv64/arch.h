@@ -6,6 +6,12 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-20     lizhirui     add zicboz cache block zero support
+ * 2021-07-25     lizhirui     add thread pointer access
+ * 2021-07-26     lizhirui     add wait for interrupt
+ * 2021-07-27     lizhirui     add lazy fpu support
+ * 2021-07-27     lizhirui     remove interrupt stack reserved area
+ * 2021-07-28     lizhirui     add thread pointer relative load
  */
 
 // @formatter:off
@@ -21,8 +27,19 @@
     #define SYNC_DATA() do{asm volatile("fence");}while(0)
     #define SYNC_INSTRUCTION() do{asm volatile("fence.i");}while(0)
 
+    //Zicboz扩展的cbo.zero指令，将addr所在的cache块清零，使用.insn编码以兼容rv64imac工具链
+    #define ARCH_CBO_ZERO(addr) do{asm volatile(".insn i 0x0F,2,x0,%0,4" :: "r"(addr) : "memory");}while(0)
+    #define ARCH_GET_CYCLE() rdcycle()
+    //内核态下tp寄存器指向当前hart的私有数据
+    #define ARCH_GET_THREAD_POINTER() ({os_size_t __tp;asm volatile("mv %0, tp" : "=r"(__tp));__tp;})
+    //以tp为基址通过单条指令读取当前hart私有数据中偏移为offset的字段，读取过程不会被中断和任务迁移打断
+    #define ARCH_LOAD_THREAD_POINTER_FIELD(offset) ({os_size_t __value;asm volatile("ld %0, %1(tp)" : "=r"(__value) : "i"(offset));__value;})
+    //等待中断，即使全局中断关闭，sie中允许的中断到来时也会返回
+    #define ARCH_WAIT_FOR_INTERRUPT() do{asm volatile("wfi" ::: "memory");}while(0)
+
     #include "arch_trap.h"
     #include "arch_mmu.h"
     #include "arch_syscall.h"
+    #include "arch_fpu.h"
 
 #endif
\ No newline at end of file
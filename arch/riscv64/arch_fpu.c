@@ -0,0 +1,160 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-27     lizhirui     the first version
+ */
+
+// @formatter:off
+#include <dreamos.h>
+#include <encoding.h>
+
+/*
+ * 惰性浮点上下文切换
+ * 内核本身不使用浮点单元，用户任务初始时sstatus.FS为Off，首次执行浮点指令时触发非法指令异常，此时才为该任务启用浮点单元
+ * 任务切换时只有用户上下文中的sstatus.FS为Dirty（即上次同步之后执行过浮点指令）的任务才需要保存浮点寄存器，
+ * 每个hart记录浮点寄存器当前属于哪个任务，若切换回的任务仍拥有当前hart的浮点寄存器，则无需恢复
+ */
+
+/*!
+ * 获取任务的用户态上下文，用户任务处于内核态时（系统调用或在中断中被切换），其用户态上下文总是位于内核栈顶
+ * @param task 任务结构体指针
+ * @return 用户态上下文指针
+ */
+static struct TrapFrame *fpu_get_user_frame(os_task_p task)
+{
+    return (struct TrapFrame *)(os_task_get_kernel_stack_top(task) - sizeof(struct TrapFrame));
+}
+
+/*!
+ * 设置上下文中的sstatus.FS字段
+ * @param regs 上下文指针
+ * @param fs 新的FS状态
+ */
+static void fpu_set_frame_state(struct TrapFrame *regs,os_size_t fs)
+{
+    regs -> sstatus = (regs -> sstatus & ~SSTATUS_FS) | fs;
+}
+
+/*!
+ * 将任务的浮点上下文载入当前hart的浮点寄存器，并将当前hart的浮点寄存器所有者设置为该任务，调用者必须关闭中断
+ * @param task 任务结构体指针
+ */
+static void fpu_load(os_task_p task)
+{
+    os_hart_p hart = os_hart_get_current();
+    arch_fpu_context_restore(&task -> fpu_context);
+    hart -> fpu_owner = task;
+    task -> fpu_cpu_id = hart -> cpu_id;
+}
+
+/*!
+ * 浮点单元首次使用处理程序，由trap_handler在非法指令异常中调用
+ * 若异常来自浮点单元尚未启用的用户任务，则为其启用浮点单元并以全0的浮点上下文初始化浮点寄存器，返回后重新执行该指令
+ * 若该指令并不是浮点指令，重新执行时会再次触发非法指令异常，此时浮点单元已经启用，不会再被本函数处理
+ * @param regs 异常上下文
+ * @return 已处理返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t arch_fpu_first_use_handler(struct TrapFrame *regs)
+{
+    os_task_p task = os_task_get_current_task();
+
+    if((regs -> sstatus & SSTATUS_SPP) || ((regs -> sstatus & SSTATUS_FS) != SSTATUS_FS_OFF) || (task == OS_NULL) || task -> fpu_used)
+    {
+        return OS_FALSE;
+    }
+
+    os_memset(&task -> fpu_context,0,sizeof(task -> fpu_context));
+    fpu_load(task);
+    task -> fpu_used = OS_TRUE;
+    fpu_set_frame_state(regs,SSTATUS_FS_CLEAN);
+    return OS_TRUE;
+}
+
+/*!
+ * 任务被切换出当前hart时调用，若任务在上次同步之后修改过浮点寄存器，则将其保存到任务的浮点上下文中
+ * 该函数由上下文切换汇编程序在旧任务上下文保存完毕、允许其它hart切换到该任务之前调用，此时中断处于关闭状态
+ * @param task 被切换出的任务
+ */
+void arch_fpu_switch_out(os_task_p task)
+{
+    if(!task -> fpu_used)
+    {
+        return;
+    }
+
+    struct TrapFrame *regs = fpu_get_user_frame(task);
+
+    if((regs -> sstatus & SSTATUS_FS) == SSTATUS_FS_DIRTY)
+    {
+        os_hart_p hart = os_hart_get_current();
+        OS_ASSERT(hart -> fpu_owner == task);
+        arch_fpu_context_save(&task -> fpu_context);
+        task -> fpu_cpu_id = hart -> cpu_id;
+        fpu_set_frame_state(regs,SSTATUS_FS_CLEAN);
+    }
+}
+
+/*!
+ * 任务被切换到当前hart时调用，若当前hart的浮点寄存器不属于该任务，则恢复该任务的浮点上下文
+ * 该函数由上下文切换汇编程序在新任务的上下文已在其它hart上保存完毕之后调用，此时中断处于关闭状态
+ * @param task 被切换到的任务
+ */
+void arch_fpu_switch_in(os_task_p task)
+{
+    if(!task -> fpu_used)
+    {
+        return;
+    }
+
+    os_hart_p hart = os_hart_get_current();
+
+    //任务在其它hart上运行过时，即使当前hart的所有者仍是该任务，浮点寄存器中的内容也可能已经过期
+    if((hart -> fpu_owner != task) || (task -> fpu_cpu_id != hart -> cpu_id))
+    {
+        fpu_load(task);
+    }
+}
+
+/*!
+ * 用于Clone时复制浮点上下文，子任务继承父任务当前的浮点寄存器，调用者必须处于临界区
+ * @param regs 父任务的用户态上下文
+ * @param task 子任务
+ * @param child_regs 子任务的用户态上下文
+ */
+void arch_fpu_clone(struct TrapFrame *regs,os_task_p task,struct TrapFrame *child_regs)
+{
+    os_task_p cur_task = os_task_get_current_task();
+    task -> fpu_used = cur_task -> fpu_used;
+    task -> fpu_cpu_id = OS_TASK_FPU_CPU_NONE;
+
+    if(!cur_task -> fpu_used)
+    {
+        fpu_set_frame_state(child_regs,SSTATUS_FS_OFF);
+        return;
+    }
+
+    //父任务的浮点寄存器尚未保存时先将其保存，保存后父任务仍然拥有当前hart的浮点寄存器
+    if((regs -> sstatus & SSTATUS_FS) == SSTATUS_FS_DIRTY)
+    {
+        arch_fpu_context_save(&cur_task -> fpu_context);
+        cur_task -> fpu_cpu_id = os_hart_get_cpu_id();
+        fpu_set_frame_state(regs,SSTATUS_FS_CLEAN);
+    }
+
+    os_memcpy(&task -> fpu_context,&cur_task -> fpu_context,sizeof(task -> fpu_context));
+    fpu_set_frame_state(child_regs,SSTATUS_FS_CLEAN);
+}
+
+/*!
+ * 用于Execve时丢弃当前任务的浮点上下文，新程序首次执行浮点指令时重新启用浮点单元
+ * @param regs 当前任务的用户态上下文
+ */
+void arch_fpu_execve(struct TrapFrame *regs)
+{
+    os_task_get_current_task() -> fpu_used = OS_FALSE;
+    fpu_set_frame_state(regs,SSTATUS_FS_OFF);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-27     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __ARCH_FPU_H__
+#define __ARCH_FPU_H__
+
+    #include <dreamos.h>
+
+    //该头文件由arch.h引入，此时任务结构体尚未定义，因此使用前置声明
+    struct os_task;
+    struct os_task_fpu_context;
+
+    //sstatus.FS字段的四种状态，浮点指令执行后硬件会自动将其置为Dirty
+    #define SSTATUS_FS_OFF      0x00000000
+    #define SSTATUS_FS_INITIAL  0x00002000
+    #define SSTATUS_FS_CLEAN    0x00004000
+    #define SSTATUS_FS_DIRTY    0x00006000
+
+    void arch_fpu_context_save(struct os_task_fpu_context *context);
+    void arch_fpu_context_restore(struct os_task_fpu_context *context);
+    os_bool_t arch_fpu_first_use_handler(struct TrapFrame *regs);
+    void arch_fpu_switch_out(struct os_task *task);
+    void arch_fpu_switch_in(struct os_task *task);
+    void arch_fpu_clone(struct TrapFrame *regs,struct os_task *task,struct TrapFrame *child_regs);
+    void arch_fpu_execve(struct TrapFrame *regs);
+
+#endif
\ No newline at end of file
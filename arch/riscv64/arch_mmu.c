@@ -8,6 +8,9 @@
  * 2021-07-04     lizhirui     the first version
  * 2021-07-05     lizhirui     add vaddr find support
  * 2021-07-09     lizhirui     fix a bug for remove function
+ * 2021-07-20     lizhirui     use page zero and page copy for pagetable and user mapping copy
+ * 2021-07-25     lizhirui     add satp value calculation
+ * 2021-07-28     lizhirui     add shared pagetable creation and keep shared kernel pagetables on vtable removal
  */
 
 // @formatter:off
@@ -71,8 +74,8 @@ static os_err_t __create_l2_entry(os_mmu_pt_l2_t *vtable,os_size_t va,os_size_t
             if(__is_null_entry(vtable[l2_id].value))
             {
                 OS_ANNOTATION_NEED_MMU_PREINIT();
+                //os_memory_alloc已通过os_page_zero完成清零
                 os_size_t l3_vtable = (os_size_t)os_memory_alloc(OS_MMU_L3_PAGES * OS_MMU_PAGE_SIZE);
-                os_memset((void *)l3_vtable,0,OS_MMU_L3_PAGES * OS_MMU_PAGE_SIZE);
 
                 if(!l3_vtable)
                 {
@@ -131,8 +134,8 @@ os_err_t os_mmu_create_mapping(os_mmu_vtable_p vtable,os_size_t va,os_size_t pa,
         {
             if(__is_null_entry(vtable -> l1_vtable[l1_id].value))
             {
+                //os_memory_alloc已通过os_page_zero完成清零
                 os_size_t l2_vtable = (os_size_t)os_memory_alloc(OS_MMU_L2_PAGES * OS_MMU_PAGE_SIZE);
-                os_memset((void *)l2_vtable,0,OS_MMU_L2_PAGES * OS_MMU_PAGE_SIZE);
 
                 if(!l2_vtable)
                 {
@@ -165,6 +168,38 @@ os_err_t os_mmu_create_mapping(os_mmu_vtable_p vtable,os_size_t va,os_size_t pa,
     return OS_ERR_OK;
 }
 
+/*!
+ * 为指定的虚拟地址范围预先建立L1页表项指向的下级页表，但不建立任何映射
+ * 复制内核映射时只复制L1页表项，因此在复制之前建立的下级页表被所有页表共享，此后在该范围内建立的映射对所有页表可见
+ * @param vtable 页表结构体指针
+ * @param va 起始虚拟地址，必须与L1页表项对应的虚拟地址边界对齐
+ * @param size 范围大小，必须为L1页表项对应的虚拟地址空间大小的整数倍
+ * @return 成功返回OS_ERR_OK，失败返回负数错误码
+ */
+os_err_t os_mmu_create_pagetable(os_mmu_vtable_p vtable,os_size_t va,os_size_t size)
+{
+    OS_ASSERT(OS_MMU_L1_CHECK_ALIGN(va));
+    OS_ASSERT(OS_MMU_L1_CHECK_ALIGN(size));
+
+    for(;size > 0;va += OS_MMU_L1_SIZE,size -= OS_MMU_L1_SIZE)
+    {
+        os_size_t l1_id = OS_MMU_L1_ID(va);
+
+        if(__is_pagetable(vtable -> l1_vtable[l1_id].value))
+        {
+            continue;
+        }
+
+        OS_ERR_RETURN_ERROR(!__is_null_entry(vtable -> l1_vtable[l1_id].value),-OS_ERR_EPERM);
+        //os_memory_alloc已通过os_page_zero完成清零
+        os_size_t l2_vtable = (os_size_t)os_memory_alloc(OS_MMU_L2_PAGES * OS_MMU_PAGE_SIZE);
+        OS_ERR_RETURN_ERROR(l2_vtable == 0,-OS_ERR_ENOMEM);
+        vtable -> l1_vtable[l1_id] = OS_MMU_L1_ENTRY(OS_MMU_VA_TO_PA(l2_vtable),OS_MMU_PROT_PAGETABLE);
+    }
+
+    return OS_ERR_OK;
+}
+
 static os_err_t __remove_l3_entry(os_mmu_pt_l3_t *vtable,os_size_t va,os_size_t size)
 {
     os_size_t l3_id = OS_MMU_L3_ID(va);
@@ -323,6 +358,12 @@ void os_mmu_remove_all_mapping(os_mmu_vtable_p vtable)
 
     for(i = 0;i < OS_MMU_L1_ENTRY_NUM;i++)
     {
+        //用户页表中内核空间和IO空间的L1页表项复制自内核页表，其下级页表与内核页表共享，不能随用户页表一起释放
+        if((vtable != os_mmu_get_kernel_pagetable()) && ((i < user_l1_start) || (i > user_l1_end)))
+        {
+            continue;
+        }
+
         if(!__is_null_entry(vtable -> l1_vtable[i].value))
         {
             if(__is_pagetable(vtable -> l1_vtable[i].value))
@@ -406,12 +447,17 @@ os_size_t os_mmu_find_vaddr(os_mmu_vtable_p vtable,os_size_t va_start,os_size_t
     return 0;
 }
 
-void arch_mmu_switch(os_mmu_vtable_p vtable)
+os_size_t arch_mmu_get_satp(os_mmu_vtable_p vtable)
 {
     os_size_t vtable_addr = os_mmu_is_preinitialized() ? OS_MMU_VA_TO_PA((os_size_t)vtable -> l1_vtable) : ((os_size_t)vtable -> l1_vtable);
+    return (vtable_addr >> OS_MMU_OFFSET_BITS) | (((os_size_t)SATP_MODE_SV39) << 60);
+}
+
+void arch_mmu_switch(os_mmu_vtable_p vtable)
+{
     SYNC_DATA();
     SYNC_INSTRUCTION();
-    write_csr(satp,(vtable_addr >> OS_MMU_OFFSET_BITS) | (((os_size_t)SATP_MODE_SV39) << 60));
+    write_csr(satp,arch_mmu_get_satp(vtable));
     OS_MMU_FLUSH_TLB();
 }
 
@@ -464,7 +510,7 @@ static os_err_t os_mmu_user_mapping_copy_l3(os_mmu_pt_l3_p dst_vtable,os_mmu_pt_
             OS_ERR_SET_ERROR_AND_GOTO(dst_mem == OS_NULL,ret,-OS_ERR_ENOMEM,err);
             dst_vtable[i] = OS_MMU_L3_ENTRY(OS_MMU_VA_TO_PA((os_size_t)dst_mem),OS_MMU_PROT(__MMU_GET_PROT(src_vtable[i].value)));
             void *src_mem = (void *)OS_MMU_PA_TO_VA(OS_MMU_PPN_TO_PA(__get_ppn(src_vtable[i].value)));
-            os_memcpy(dst_mem,src_mem,OS_MMU_L3_SIZE);
+            os_page_copy(dst_mem,src_mem,OS_MMU_L3_SIZE);
         }
     }
 
@@ -483,11 +529,11 @@ static os_err_t os_mmu_user_mapping_copy_l2(os_mmu_pt_l2_p dst_vtable,os_mmu_pt_
     {
         if(__is_pagetable(dst_vtable[i].value))
         {
-            os_mmu_pt_l3_p dst_next_vtable = os_memory_alloc(sizeof(os_mmu_pt_l3_t));
+            os_mmu_pt_l3_p dst_next_vtable = os_memory_alloc(OS_MMU_L3_PAGES * OS_MMU_PAGE_SIZE);
             OS_ERR_SET_ERROR_AND_GOTO(dst_next_vtable == OS_NULL,ret,-OS_ERR_ENOMEM,err);
             dst_vtable[i] = OS_MMU_L2_ENTRY(OS_MMU_VA_TO_PA((os_size_t)dst_next_vtable),OS_MMU_PROT(__MMU_GET_PROT(src_vtable[i].value)));
             os_mmu_pt_l3_p src_next_vtable = (os_mmu_pt_l3_t *)OS_MMU_PA_TO_VA(OS_MMU_PPN_TO_PA(__get_ppn(src_vtable[i].value)));
-            os_memcpy(dst_next_vtable,src_next_vtable,sizeof(os_mmu_pt_l3_t));
+            os_page_copy(dst_next_vtable,src_next_vtable,OS_MMU_L3_PAGES * OS_MMU_PAGE_SIZE);
             OS_ERR_GET_ERROR_AND_GOTO(os_mmu_user_mapping_copy_l3(dst_next_vtable,src_next_vtable),ret,err);
         }
         else if(!__is_null_entry(dst_vtable[i].value))
@@ -496,7 +542,7 @@ static os_err_t os_mmu_user_mapping_copy_l2(os_mmu_pt_l2_p dst_vtable,os_mmu_pt_
             OS_ERR_SET_ERROR_AND_GOTO(dst_mem == OS_NULL,ret,-OS_ERR_ENOMEM,err);
             dst_vtable[i] = OS_MMU_L2_ENTRY(OS_MMU_VA_TO_PA((os_size_t)dst_mem),OS_MMU_PROT(__MMU_GET_PROT(src_vtable[i].value)));
             void *src_mem = (void *)OS_MMU_PA_TO_VA(OS_MMU_PPN_TO_PA(__get_ppn(src_vtable[i].value)));
-            os_memcpy(dst_mem,src_mem,OS_MMU_L2_SIZE);
+            os_page_copy(dst_mem,src_mem,OS_MMU_L2_SIZE);
         }
     }
 
@@ -511,7 +557,7 @@ os_err_t os_mmu_user_mapping_copy(os_mmu_vtable_p dst_vtable,os_mmu_vtable_p src
     os_size_t l1_id_start = OS_MMU_L1_ID(OS_MMU_MEMORYMAP_USER_START);
     os_size_t l1_id_end = OS_MMU_L1_ID(OS_MMU_MEMORYMAP_USER_START + OS_MMU_MEMORYMAP_USER_SIZE - 1);
 
-    os_memcpy(&dst_vtable -> l1_vtable[l1_id_start],&kernel_pagetable.l1_vtable[l1_id_start],(l1_id_end - l1_id_start + 1) * sizeof(os_mmu_pt_l1_t));
+    os_memcpy(&dst_vtable -> l1_vtable[l1_id_start],&src_vtable -> l1_vtable[l1_id_start],(l1_id_end - l1_id_start + 1) * sizeof(os_mmu_pt_l1_t));
 
     os_size_t i;
     os_err_t ret;
@@ -520,11 +566,11 @@ os_err_t os_mmu_user_mapping_copy(os_mmu_vtable_p dst_vtable,os_mmu_vtable_p src
     {
         if(__is_pagetable(dst_vtable -> l1_vtable[i].value))
         {
-            os_mmu_pt_l2_p dst_next_vtable = os_memory_alloc(sizeof(os_mmu_pt_l2_t));
+            os_mmu_pt_l2_p dst_next_vtable = os_memory_alloc(OS_MMU_L2_PAGES * OS_MMU_PAGE_SIZE);
             OS_ERR_SET_ERROR_AND_GOTO(dst_next_vtable == OS_NULL,ret,-OS_ERR_ENOMEM,err);
             dst_vtable -> l1_vtable[i] = OS_MMU_L1_ENTRY(OS_MMU_VA_TO_PA((os_size_t)dst_next_vtable),OS_MMU_PROT(__MMU_GET_PROT(src_vtable -> l1_vtable[i].value)));
             os_mmu_pt_l2_p src_next_vtable = (os_mmu_pt_l2_t *)OS_MMU_PA_TO_VA(OS_MMU_PPN_TO_PA(__get_ppn(src_vtable -> l1_vtable[i].value)));
-            os_memcpy(dst_next_vtable,src_next_vtable,sizeof(os_mmu_pt_l2_t));
+            os_page_copy(dst_next_vtable,src_next_vtable,OS_MMU_L2_PAGES * OS_MMU_PAGE_SIZE);
             OS_ERR_GET_ERROR_AND_GOTO(os_mmu_user_mapping_copy_l2(dst_next_vtable,src_next_vtable),ret,err);
         }
         else if(!__is_null_entry(dst_vtable -> l1_vtable[i].value))
@@ -533,7 +579,7 @@ os_err_t os_mmu_user_mapping_copy(os_mmu_vtable_p dst_vtable,os_mmu_vtable_p src
             OS_ERR_SET_ERROR_AND_GOTO(dst_mem == OS_NULL,ret,-OS_ERR_ENOMEM,err);
             dst_vtable -> l1_vtable[i] = OS_MMU_L1_ENTRY(OS_MMU_VA_TO_PA((os_size_t)dst_mem),OS_MMU_PROT(__MMU_GET_PROT(src_vtable -> l1_vtable[i].value)));
             void *src_mem = (void *)OS_MMU_PA_TO_VA(OS_MMU_PPN_TO_PA(__get_ppn(src_vtable -> l1_vtable[i].value)));
-            os_memcpy(dst_mem,src_mem,OS_MMU_L1_SIZE);
+            os_page_copy(dst_mem,src_mem,OS_MMU_L1_SIZE);
         }
     }
 
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-28     lizhirui     add kernel stack region with guard pages
  */
 
 // @formatter:off
@@ -34,6 +35,13 @@
 
     #define OS_MMU_KERNEL_VA_PA_OFFSET (OS_MMU_MEMORYMAP_KERNEL_START - MEMORY_BASE)
 
+    //内核栈映射区域，位于内核空间的最高处，大小为2^OS_MMU_MEMORYMAP_KSTACK_BITS，以下定义同时被trap入口汇编程序使用，因此不能带有UL后缀
+    #define OS_MMU_MEMORYMAP_KSTACK_START 0x0000003F00000000
+    #define OS_MMU_MEMORYMAP_KSTACK_BITS 32
+    //每个内核栈占用2^OS_MMU_KSTACK_SLOT_BITS大小的槽位，槽位最低处2^OS_MMU_KSTACK_GUARD_BITS大小的区域不映射，作为保护页
+    #define OS_MMU_KSTACK_SLOT_BITS 16
+    #define OS_MMU_KSTACK_GUARD_BITS 12
+
     #ifndef __ASSEMBLY__
         #include <dreamos.h>
 
@@ -7,6 +7,8 @@
  * Date           Author       Notes
  * 2021-07-06     lizhirui     the first version
  * 2021-07-08     lizhirui     add getpid and getppid syscall
+ * 2021-07-27     lizhirui     add sched_setattr and sched_getattr syscall
+ * 2021-07-27     lizhirui     add getrusage syscall
  */
 
 // @formatter:off
@@ -40,10 +42,13 @@ static os_syscall_handler_t syscall_handler_table[SYSCALL_MAX_NUM] =
     [__NR_munmap] = (os_syscall_handler_t)os_syscall_munmap,
     [__NR_mmap] = (os_syscall_handler_t)os_syscall_mmap,
     [__NR_times] = (os_syscall_handler_t)os_syscall_times,
+    [__NR_getrusage] = (os_syscall_handler_t)os_syscall_getrusage,
     [__NR_uname] = (os_syscall_handler_t)os_syscall_uname,
     [__NR_sched_yield] = (os_syscall_handler_t)os_syscall_sched_yield,
     [__NR_gettimeofday] = (os_syscall_handler_t)os_syscall_gettimeofday,
-    [__NR_nanosleep] = (os_syscall_handler_t)os_syscall_nanosleep
+    [__NR_nanosleep] = (os_syscall_handler_t)os_syscall_nanosleep,
+    [__NR_sched_setattr] = (os_syscall_handler_t)os_syscall_sched_setattr,
+    [__NR_sched_getattr] = (os_syscall_handler_t)os_syscall_sched_getattr
 };
 
 void arch_syscall_handler(struct TrapFrame *regs)
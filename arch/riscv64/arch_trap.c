@@ -7,6 +7,9 @@
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
  * 2021-05-20     lizhirui     add os debug support
+ * 2021-07-21     lizhirui     flush log ring buffer before dumping unhandled trap
+ * 2021-07-27     lizhirui     enable fpu on first use
+ * 2021-07-28     lizhirui     report kernel stack overflow
  */
 
 // @formatter:off
@@ -71,37 +74,24 @@ const char *get_trap_name(os_size_t scause)
 
 os_bool_t bsp_interrupt_handler(enum interrupt_type interrupt_type);
 
-void trap_handler(os_size_t scause,os_size_t stval,os_size_t sepc,struct TrapFrame *regs)
+/*!
+ * 输出无法处理的trap的信息并停机
+ * @param scause trap原因
+ * @param stval trap附加信息
+ * @param sepc trap发生时的pc
+ * @param regs trap发生时的上下文
+ */
+static OS_NORETURN void trap_panic(os_size_t scause,os_size_t stval,os_size_t sepc,struct TrapFrame *regs)
 {
-    if(SCAUSE_IS_INTERRUPT(scause))
-    {
-        if(bsp_interrupt_handler((enum interrupt_type)SCAUSE_GET_ID(scause)))
-        {
-            return;
-        }
-    }
+    os_log_panic();
+    os_printf("Unhandled %s %ld:%s\n",SCAUSE_IS_INTERRUPT(scause) ? "Interrupt" : "Exception",SCAUSE_GET_ID(scause),get_trap_name(scause));
+    os_printf("scause = 0x%p\tstval = 0x%p\tsepc = 0x%p\n\n",scause,stval,sepc);
 
-    switch(((enum exception_type)SCAUSE_GET_ID(scause)))
+    if(!SCAUSE_IS_INTERRUPT(scause) && os_task_stack_is_guard_page(stval))
     {
-        case EXCEPTION_LOAD_PAGE_FAULT:
-            if(os_mmu_page_fault_handler(stval,OS_FALSE))
-            {
-                return;
-            }
-
-            break;
-
-        case EXCEPTION_STORE_AMO_PAGE_FAULT:
-            if(os_mmu_page_fault_handler(stval,OS_TRUE))
-            {
-                return;
-            }
-
-            break;
+        os_printf("Kernel stack overflow:guard page 0x%p is accessed\n",stval);
     }
 
-    os_printf("Unhandled %s %ld:%s\n",SCAUSE_IS_INTERRUPT(scause) ? "Interrupt" : "Exception",SCAUSE_GET_ID(scause),get_trap_name(scause));
-    os_printf("scause = 0x%p\tstval = 0x%p\tsepc = 0x%p\n\n",scause,stval,sepc);
     os_task_p task = os_task_get_current_task();
     os_printf("Current Context:%s\n",os_is_in_interrupt() ? "Interrupt" : ((task == OS_NULL) ? "Boot" : "Task"));
 
@@ -150,4 +140,58 @@ void trap_handler(os_size_t scause,os_size_t stval,os_size_t sepc,struct TrapFra
     os_printf("---------------------------------Dump OK--------------------------------\n");
     print_stacktrace(sepc,regs -> s0_fp);
     while(1);
+}
+
+void trap_handler(os_size_t scause,os_size_t stval,os_size_t sepc,struct TrapFrame *regs)
+{
+    if(SCAUSE_IS_INTERRUPT(scause))
+    {
+        if(bsp_interrupt_handler((enum interrupt_type)SCAUSE_GET_ID(scause)))
+        {
+            return;
+        }
+    }
+
+    switch(((enum exception_type)SCAUSE_GET_ID(scause)))
+    {
+        case EXCEPTION_ILLEGAL_INSTRUCTION:
+            if(arch_fpu_first_use_handler(regs))
+            {
+                return;
+            }
+
+            break;
+
+        case EXCEPTION_LOAD_PAGE_FAULT:
+            if(os_mmu_page_fault_handler(stval,OS_FALSE))
+            {
+                return;
+            }
+
+            break;
+
+        case EXCEPTION_STORE_AMO_PAGE_FAULT:
+            if(os_mmu_page_fault_handler(stval,OS_TRUE))
+            {
+                return;
+            }
+
+            break;
+    }
+
+    trap_panic(scause,stval,sepc,regs);
+}
+
+/*!
+ * 内核栈溢出处理程序，由trap入口汇编程序在被中断的内核栈已经溢出时调用，此时上下文保存在启动栈上
+ * @param scause trap原因
+ * @param stval trap附加信息
+ * @param sepc trap发生时的pc
+ * @param regs trap发生时的上下文
+ */
+void arch_kernel_stack_overflow_handler(os_size_t scause,os_size_t stval,os_size_t sepc,struct TrapFrame *regs)
+{
+    os_log_panic();
+    os_printf("Kernel stack overflow:sp = 0x%p\n",regs -> user_sp);
+    trap_panic(scause,stval,sepc,regs);
 }
\ No newline at end of file
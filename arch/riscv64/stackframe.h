@@ -6,6 +6,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-25     lizhirui     restore tp only when returning to user mode
+ * 2021-07-27     lizhirui     split caller-saved and callee-saved register save/restore for trap fast path
+ * 2021-07-27     lizhirui     add cpu time accounting hooks at user/kernel boundaries
+ * 2021-07-28     lizhirui     add interrupt stack top offset for kernel stack overflow handling
  */
 
 #ifndef __STACKFRAME_H__
@@ -16,6 +20,12 @@
     #define REGBYTES                8
     #define SAVE_ALL_REG_NUM        33
 
+    //os_hart_t中供trap入口汇编程序访问的成员偏移
+    #define HART_INTERRUPT_STACK_TOP (0 * REGBYTES)
+    #define HART_KERNEL_STACK_TOP   (3 * REGBYTES)
+    #define HART_TRAP_SCRATCH       (4 * REGBYTES)
+
+    //保存全部寄存器，sp所在的槽位由调用者负责保存
     .macro SAVE_ALL
         addi sp, sp, -SAVE_ALL_REG_NUM * REGBYTES
 
@@ -56,33 +66,71 @@
         STORE x29, 29 * REGBYTES(sp)
         STORE x30, 30 * REGBYTES(sp)
         STORE x31, 31 * REGBYTES(sp)
-        csrr t0, sscratch
-        STORE t0, 32 * REGBYTES(sp)
     .endm
 
-    .macro SAVE_ALL_AND_RESTORE_SSCRATCH
-        SAVE_ALL
-        addi t0, sp, SAVE_ALL_REG_NUM * REGBYTES
-        csrw sscratch, t0
+    //trap入口只保存调用者保存寄存器，以及用于回溯栈帧的s0，其余寄存器由C函数负责保存
+    //tp与sp所在的槽位由调用者负责保存
+    .macro SAVE_CALLER_REGS
+        STORE x1,   1 * REGBYTES(sp)
+        STORE x3,   3 * REGBYTES(sp)
+        STORE x5,   5 * REGBYTES(sp)
+        csrr  t0, sstatus
+        STORE t0,   2 * REGBYTES(sp)
+        csrr  t0, sepc
+        STORE t0,   0 * REGBYTES(sp)
+        STORE x6,   6 * REGBYTES(sp)
+        STORE x7,   7 * REGBYTES(sp)
+        STORE x8,   8 * REGBYTES(sp)
+        STORE x10, 10 * REGBYTES(sp)
+        STORE x11, 11 * REGBYTES(sp)
+        STORE x12, 12 * REGBYTES(sp)
+        STORE x13, 13 * REGBYTES(sp)
+        STORE x14, 14 * REGBYTES(sp)
+        STORE x15, 15 * REGBYTES(sp)
+        STORE x16, 16 * REGBYTES(sp)
+        STORE x17, 17 * REGBYTES(sp)
+        STORE x28, 28 * REGBYTES(sp)
+        STORE x29, 29 * REGBYTES(sp)
+        STORE x30, 30 * REGBYTES(sp)
+        STORE x31, 31 * REGBYTES(sp)
     .endm
 
-    .macro RESTORE_ALL
-            /* resw ra to sepc */
+    //补全SAVE_CALLER_REGS未保存的被调用者保存寄存器，C函数返回后这些寄存器仍然保持被中断时的值
+    .macro SAVE_CALLEE_REGS
+        STORE x9,   9 * REGBYTES(sp)
+        STORE x18, 18 * REGBYTES(sp)
+        STORE x19, 19 * REGBYTES(sp)
+        STORE x20, 20 * REGBYTES(sp)
+        STORE x21, 21 * REGBYTES(sp)
+        STORE x22, 22 * REGBYTES(sp)
+        STORE x23, 23 * REGBYTES(sp)
+        STORE x24, 24 * REGBYTES(sp)
+        STORE x25, 25 * REGBYTES(sp)
+        STORE x26, 26 * REGBYTES(sp)
+        STORE x27, 27 * REGBYTES(sp)
+    .endm
+
+    //恢复SAVE_CALLER_REGS保存的寄存器并恢复sp，返回用户态时将hart私有数据指针放回sscratch，以便下一次trap入口找到内核栈
+    .macro RESTORE_CALLER_REGS
         LOAD x1,   0 * REGBYTES(sp)
         csrw sepc, x1
 
         LOAD x1,   2 * REGBYTES(sp)
         csrw sstatus, x1
 
+        //tp在内核态下指向当前hart的私有数据，任务可能在不同hart之间迁移，因此仅在返回用户态时恢复tp
+        andi x1, x1, 0x100
+        bnez x1, 1f
+        csrw sscratch, x4
+        LOAD x4,   4 * REGBYTES(sp)
+    1:
         LOAD x1,   1 * REGBYTES(sp)
 
         LOAD x3,   3 * REGBYTES(sp)
-        LOAD x4,   4 * REGBYTES(sp)
         LOAD x5,   5 * REGBYTES(sp)
         LOAD x6,   6 * REGBYTES(sp)
         LOAD x7,   7 * REGBYTES(sp)
         LOAD x8,   8 * REGBYTES(sp)
-        LOAD x9,   9 * REGBYTES(sp)
         LOAD x10, 10 * REGBYTES(sp)
         LOAD x11, 11 * REGBYTES(sp)
         LOAD x12, 12 * REGBYTES(sp)
@@ -91,6 +139,17 @@
         LOAD x15, 15 * REGBYTES(sp)
         LOAD x16, 16 * REGBYTES(sp)
         LOAD x17, 17 * REGBYTES(sp)
+        LOAD x28, 28 * REGBYTES(sp)
+        LOAD x29, 29 * REGBYTES(sp)
+        LOAD x30, 30 * REGBYTES(sp)
+        LOAD x31, 31 * REGBYTES(sp)
+
+        //restore user sp
+        LOAD sp, 32 * REGBYTES(sp)
+    .endm
+
+    .macro RESTORE_ALL
+        LOAD x9,   9 * REGBYTES(sp)
         LOAD x18, 18 * REGBYTES(sp)
         LOAD x19, 19 * REGBYTES(sp)
         LOAD x20, 20 * REGBYTES(sp)
@@ -101,13 +160,25 @@
         LOAD x25, 25 * REGBYTES(sp)
         LOAD x26, 26 * REGBYTES(sp)
         LOAD x27, 27 * REGBYTES(sp)
-        LOAD x28, 28 * REGBYTES(sp)
-        LOAD x29, 29 * REGBYTES(sp)
-        LOAD x30, 30 * REGBYTES(sp)
-        LOAD x31, 31 * REGBYTES(sp)
+        RESTORE_CALLER_REGS
+    .endm
 
-        //restore user sp
-        LOAD sp, 32 * REGBYTES(sp)
+    //若sp处的上下文来自用户态，通知CPU时间统计模块已经离开用户态，会破坏调用者保存寄存器
+    .macro CPUTIME_USER_EXIT
+        LOAD t0, 2 * REGBYTES(sp)
+        andi t0, t0, 0x100
+        bnez t0, 1f
+        call os_cputime_user_exit
+    1:
+    .endm
+
+    //若即将恢复的上下文返回用户态，通知CPU时间统计模块即将进入用户态，会破坏调用者保存寄存器
+    .macro CPUTIME_USER_ENTER
+        LOAD t0, 2 * REGBYTES(sp)
+        andi t0, t0, 0x100
+        bnez t0, 1f
+        call os_cputime_user_enter
+    1:
     .endm
 
     .macro RESTORE_SYS_GP
@@ -6,8 +6,12 @@
     #define PAGE_BITS (12)
     #define MEMORY_BASE (0x80000000UL)
     #define MEMORY_SIZE (128 * 0x100000)
+    //最低任务优先级（数值越大优先级越低），最大为255
     #define TASK_PRIORITY_MAX (31)
     #define TICK_PER_SECOND (100)
+    //定时器时间轮每层槽位数为2^OS_TIMER_WHEEL_BITS，共OS_TIMER_WHEEL_LEVEL_NUM层，可覆盖2^(OS_TIMER_WHEEL_BITS * OS_TIMER_WHEEL_LEVEL_NUM)个tick
+    #define OS_TIMER_WHEEL_BITS (6)
+    #define OS_TIMER_WHEEL_LEVEL_NUM (4)
     #define IDLE_TASK_STACK_SIZE (8192)
     #define IDLE_TASK_TICK_INIT (10)
     #define MAIN_TASK_STACK_SIZE (16384)
@@ -15,13 +19,61 @@
     #define MAIN_TASK_TICK_INIT (1)
     #define OS_VFS_PATH_MAX (255)
     #define OS_TASK_MAX_NUM (65536)
+    //每种大小的内核栈最多缓存的数量，释放时缓存已满的内核栈会解除映射并归还物理内存
+    #define OS_TASK_STACK_CACHE_NUM (16)
+    //公平调度的调度周期与最小时间片（tick），以及唤醒抢占粒度（纳秒）
+    #define OS_TASK_FAIR_LATENCY_TICKS (4)
+    #define OS_TASK_FAIR_MIN_GRANULARITY_TICKS (1)
+    #define OS_TASK_FAIR_WAKEUP_GRANULARITY_NS (1000000)
+    //每个hart上截止时间调度任务最多占用的带宽百分比，其余带宽留给其它调度类的任务
+    #define OS_TASK_DEADLINE_BW_PERCENT (95)
 
     #define SLUB_MIN_PARTIAL (2)
 
     #define OS_MAX_OPEN_FILES (128)
 
+    //日志环形缓冲区槽位数量（必须为2的幂）及单条记录大小
+    #define OS_LOG_RECORD_NUM (128)
+    #define OS_LOG_RECORD_SIZE (OS_PRINTF_BUFFER_SIZE)
+    #define OS_LOG_TASK_STACK_SIZE (8192)
+    //日志输出任务优先级高于普通任务，避免输出过程被抢占后其它上下文因无法获取消费者锁而丢弃日志
+    #define OS_LOG_TASK_PRIORITY (MAIN_TASK_PRIORITY - 1)
+    #define OS_LOG_TASK_TICK_INIT (1)
+    //缓冲区中的日志数量达到该值时由生产者唤醒日志输出任务
+    #define OS_LOG_WAKEUP_WATERMARK (OS_LOG_RECORD_NUM / 4)
+    //任务回收线程，负责批量释放已退出任务的内核栈、页表和文件描述符表
+    #define OS_TASK_REAPER_STACK_SIZE (8192)
+    #define OS_TASK_REAPER_PRIORITY (TASK_PRIORITY_MAX - 1)
+    #define OS_TASK_REAPER_TICK_INIT (1)
+    //下半部线程，执行最外层中断退出时超出单次处理上限（OS_BH_BATCH_MAX）的下半部，以及在任务上下文中调度的下半部
+    #define OS_BH_BATCH_MAX (16)
+    #define OS_BH_TASK_STACK_SIZE (8192)
+    #define OS_BH_TASK_PRIORITY (MAIN_TASK_PRIORITY)
+    #define OS_BH_TASK_TICK_INIT (1)
+    //工作队列的工作线程栈大小与时间片，以及系统工作队列的工作线程数量与优先级
+    #define OS_WORKQUEUE_WORKER_STACK_SIZE (8192)
+    #define OS_WORKQUEUE_WORKER_TICK_INIT (1)
+    #define OS_SYSTEM_WORKQUEUE_WORKER_NUM (2)
+    #define OS_SYSTEM_WORKQUEUE_PRIORITY (MAIN_TASK_PRIORITY)
+    //互斥锁的默认解锁策略，以及加锁的慢速路径中拥有者正在其它hart上运行时乐观自旋的最大次数（为0时不自旋，单hart时总是不自旋）
+    #define OS_MUTEX_DEFAULT_POLICY (OS_MUTEX_POLICY_STEAL)
+    #define OS_MUTEX_SPIN_MAX (1000)
+
     #define OS_ARCH64
+    //缓存行大小，用于将频繁访问的数据按缓存行对齐
+    #define OS_CACHE_LINE_SIZE (64)
+
+    //最多支持的处理器（hart）数量，主核之外的hart通过SBI HSM扩展启动（QEMU需要-smp参数）
+    #define OS_CPU_MAX_NUM (4)
+    //从核中断栈大小，主核中断栈由链接脚本提供
+    #define OS_HART_INTERRUPT_STACK_SIZE (16384)
+
+    //CPU支持Zicboz扩展时可开启，启用后os_page_zero使用cbo.zero指令清零页面（QEMU需要-cpu rv64,zicboz=true）
+    //#define OS_ARCH_ZICBOZ
+    #define OS_ARCH_CBOZ_BLOCK_SIZE (64)
 
     #define OS_CONSOLE_DEVICE "/dev/console"
+    //开启后控制台设备和内核日志通过SBI输出（支持Debug Console扩展时批量输出），而不使用UART驱动
+    //#define BSP_USING_SBI_CONSOLE
 
 #endif
\ No newline at end of file
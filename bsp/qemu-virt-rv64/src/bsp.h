@@ -6,11 +6,14 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-22     lizhirui     add plic and uart headers
  */
 
 #ifndef __BSP_H__
 #define __BSP_H__
 
     #include "tick.h"
+    #include "plic.h"
+    #include "uart.h"
 
 #endif
\ No newline at end of file
@@ -7,42 +7,112 @@
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
  * 2021-07-09     lizhirui     add a simple console driver
+ * 2021-07-22     lizhirui     move uart driver to uart.c and add plic support
+ * 2021-07-23     lizhirui     add sbi debug console support
+ * 2021-07-25     lizhirui     add sbi hsm based secondary hart startup
+ * 2021-07-26     lizhirui     add inter-processor interrupt support
+ * 2021-07-26     lizhirui     add one-shot tick interface
+ * 2021-07-27     lizhirui     add nanosecond time interface
+ * 2021-07-28     lizhirui     add remote tlb flush support
+ * 2021-07-28     lizhirui     translate kernel stack buffers through page table for sbi debug console
  */
 
 #include <dreamos.h>
 #include <sbi.h>
 
-static volatile uint64_t uart_hwbase;
+extern os_mmu_pt_l1_t kernel_pagetable[];
 
-#define UART_BASE            (0x10000000L)
+//SBI是否支持Debug Console扩展
+static os_bool_t sbi_dbcn_available = OS_FALSE;
+//SBI是否支持HSM扩展
+static os_bool_t sbi_hsm_available = OS_FALSE;
 
-#define RHR 0    // Receive Holding Register (read mode)
-#define THR 0    // Transmit Holding Register (write mode)
-#define DLL 0    // LSB of Divisor Latch (write mode)
-#define IER 1    // Interrupt Enable Register (write mode)
-#define DLM 1    // MSB of Divisor Latch (write mode)
-#define FCR 2    // FIFO Control Register (write mode)
-#define ISR 2    // Interrupt Status Register (read mode)
-#define LCR 3    // Line Control Register
-#define MCR 4    // Modem Control Register
-#define LSR 5    // Line Status Register
-#define MSR 6    // Modem Status Register
-#define SPR 7    // ScratchPad Register
+//从核入口，位于entry_gcc.S中
+void _secondary_start();
 
-#define UART_REG(reg) ((volatile uint8_t *)(uart_hwbase + reg))
+//探测SBI固件支持的扩展，HSM扩展自SBI v0.2起提供，Debug Console扩展自SBI v2.0起提供
+static void bsp_sbi_probe()
+{
+    long version = sbi_get_spec_version();
 
-#define LSR_RX_READY (1 << 0)
-#define LSR_TX_IDLE  (1 << 5)
+    //legacy固件不支持扩展探测
+    if(version != 0)
+    {
+        sbi_hsm_available = sbi_probe_extension(SBI_EXT_ID_HSM) != 0;
+    }
 
-#define uart_read_reg(reg) (*(UART_REG(reg)))
-#define uart_write_reg(reg, v) (*(UART_REG(reg)) = (v))
+    if(((version & SBI_SPEC_VERS_MAJOR_MASK) >> SBI_SPEC_VERS_MAJOR_OFFSET) >= 2)
+    {
+        sbi_dbcn_available = sbi_probe_extension(SBI_EXT_ID_DBCN) != 0;
+    }
+}
 
-extern os_mmu_pt_l1_t kernel_pagetable[];
+//检查地址是否位于内核栈区域中，os_printf等函数的栈上缓冲区位于该区域，该区域不属于内核线性映射区，其映射以页面为单位，且相邻页面在物理上不保证连续
+static inline os_bool_t bsp_in_kernel_stack_region(os_size_t va)
+{
+    return (va >= OS_MMU_MEMORYMAP_KSTACK_START) && ((va - OS_MMU_MEMORYMAP_KSTACK_START) < SIZE(OS_MMU_MEMORYMAP_KSTACK_BITS));
+}
+
+//获取内核虚拟地址所在的物理地址，内核栈区域中的地址需要查询内核页表，失败返回0
+static os_size_t bsp_kernel_va_to_pa(os_size_t va)
+{
+    if(bsp_in_kernel_stack_region(va))
+    {
+        void *kva = os_mmu_user_va_to_kernel_va(os_mmu_get_kernel_pagetable(),va);
+        return (kva != OS_NULL) ? OS_MMU_VA_TO_PA((os_size_t)kva) : 0;
+    }
+
+    return OS_MMU_VA_TO_PA(va);
+}
+
+//通过SBI输出数据，支持Debug Console扩展时每段物理上连续的数据只需一次ecall，否则回退到逐字节的legacy接口
+static void bsp_sbi_write(const char *buf,os_size_t size)
+{
+    if(sbi_dbcn_available)
+    {
+        while(size > 0)
+        {
+            os_size_t va = (os_size_t)buf;
+            os_size_t pa = bsp_kernel_va_to_pa(va);
+            os_size_t chunk = size;
+
+            if(pa == 0)
+            {
+                break;
+            }
+
+            //内核栈区域中的数据不能跨越页面边界
+            if(bsp_in_kernel_stack_region(va))
+            {
+                chunk = MIN(size,OS_MMU_PAGE_SIZE - OS_MMU_PAGE_OFFSET(va));
+            }
+
+            struct sbi_ret ret = sbi_debug_console_write(chunk,pa,0);
+
+            if(ret.error != SBI_SUCCESS)
+            {
+                break;
+            }
+
+            buf += ret.value;
+            size -= ret.value;
+        }
+    }
+
+    while(size > 0)
+    {
+        sbi_console_putchar(*buf++);
+        size--;
+    }
+}
 
 //用于进入内核时的初始化
 void bsp_early_init()
 {
+    bsp_sbi_probe();
     tick_init();
+    //允许接收其它hart发送的IPI
+    set_csr(sie,SIP_SSIP);
 }
 
 //用于完成堆分配后的初始化
@@ -51,17 +121,66 @@ void bsp_after_heap_init()
     void *va = os_mmu_create_io_mapping(os_mmu_get_kernel_pagetable(),0,OS_MMU_L1_SIZE);
     os_mmu_switch(os_mmu_get_kernel_pagetable());
     OS_MMU_FLUSH_TLB();
-    uart_hwbase = ((os_size_t)va) + UART_BASE;
+    plic_init(((os_size_t)va) + PLIC_BASE);
+    uart_init(((os_size_t)va) + UART_BASE);
+}
+
+//检查hart是否存在且处于停止状态，即是否可以通过bsp_hart_start启动
+os_bool_t bsp_hart_is_available(os_size_t hart_id)
+{
+    if(!sbi_hsm_available)
+    {
+        return OS_FALSE;
+    }
 
-    uart_write_reg(IER, 0x00);
+    struct sbi_ret ret = sbi_hsm_hart_get_status(hart_id);
+    return (ret.error == SBI_SUCCESS) && (ret.value == SBI_HSM_STATUS_STOPPED);
+}
 
-    uint8_t lcr = uart_read_reg(LCR);
-    uart_write_reg(LCR, lcr | (1 << 7));
-    uart_write_reg(DLL, 0x03);
-    uart_write_reg(DLM, 0x00);
+//通过SBI HSM扩展启动hart，hart从_secondary_start开始执行，opaque通过a1传递
+os_err_t bsp_hart_start(os_size_t hart_id,os_size_t opaque)
+{
+    struct sbi_ret ret = sbi_hsm_hart_start(hart_id,OS_MMU_VA_TO_PA((os_size_t)_secondary_start),opaque);
+    return (ret.error == SBI_SUCCESS) ? OS_ERR_OK : -OS_ERR_EPERM;
+}
 
-    lcr = 0;
-    uart_write_reg(LCR, lcr | (3 << 0));
+//用于从核启动时的初始化，每个hart都有独立的定时器
+void bsp_hart_secondary_init()
+{
+    tick_hart_init();
+    set_csr(sie,SIP_SSIP);
+}
+
+//向指定hart发送IPI，目标hart将在supervisor软件中断中重新调度
+void bsp_hart_send_ipi(os_size_t hart_id)
+{
+    unsigned long hart_mask = 1UL << hart_id;
+    sbi_send_ipi(&hart_mask);
+}
+
+//刷新指定hart的TLB中指定范围的映射，SBI返回时目标hart已完成刷新
+void bsp_hart_flush_tlb(os_size_t hart_id,os_size_t va,os_size_t size)
+{
+    unsigned long hart_mask = 1UL << hart_id;
+    sbi_remote_sfence_vma(&hart_mask,va,size);
+}
+
+//获取当前系统tick
+os_size_t bsp_tick_get()
+{
+    return tick_get();
+}
+
+//获取系统启动以来经过的纳秒数
+os_size_t bsp_tick_get_ns()
+{
+    return tick_get_ns();
+}
+
+//设置当前hart的下一次时钟中断的tick
+void bsp_tick_set_deadline(os_size_t deadline)
+{
+    tick_set_deadline(deadline);
 }
 
 //用于调度器完成初始化之后的初始化
@@ -71,33 +190,29 @@ void bsp_after_task_scheduler_init()
     //asm volatile("ebreak");
 }
 
-#define UART_RBR(hw)    HWREG32(hw + 0x00)
-#define UART_IER(hw)    HWREG32(hw + 0x04)
-#define UART_LSR(hw)    HWREG32(hw + 0x14)
+#ifdef BSP_USING_SBI_CONSOLE
 
 //用于向控制台打印字符串
 void bsp_puts(const char *str)
 {
-    while(*str)
-    {
-        sbi_console_putchar(*str++);
-        //while((uart_read_reg(LSR) & LSR_TX_IDLE) == 0);
-        //uart_write_reg(THR,*str++);
-    }
+    bsp_sbi_write(str,os_strlen(str));
 }
 
-static os_err_t console_write(os_device_p dev,const void *buf,os_size_t pos,os_size_t size)
+static os_err_t console_open(os_device_p dev,os_size_t open_flag)
 {
-    os_size_t i;
+    dev -> open_flag = OS_FILE_FLAG_RDWR;
+    return OS_ERR_OK;
+}
 
-    for(i = 0;i < size;i++)
-    {
-        sbi_console_putchar(((const char *)buf)[i]);
-    }
+static os_err_t console_write(os_device_p dev,const void *buf,os_size_t pos,os_size_t size)
+{
+    bsp_sbi_write((const char *)buf,size);
+    return size;
 }
 
 static os_device_ops_t dev_ops =
 {
+    .open = console_open,
     .write = console_write
 };
 
@@ -107,7 +222,31 @@ static os_device_t dev_console =
     .ops = &dev_ops
 };
 
+//注册控制台设备
 void bsp_console_init()
 {
     os_device_register(&dev_console);
-}
\ No newline at end of file
+}
+
+#else
+
+//用于向控制台打印字符串，UART初始化完成前通过SBI输出
+void bsp_puts(const char *str)
+{
+    if(uart_is_initialized())
+    {
+        uart_puts_polled(str);
+    }
+    else
+    {
+        bsp_sbi_write(str,os_strlen(str));
+    }
+}
+
+//注册控制台设备
+void bsp_console_init()
+{
+    uart_console_register();
+}
+
+#endif
\ No newline at end of file
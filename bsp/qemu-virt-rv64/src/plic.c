@@ -0,0 +1,101 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-22     lizhirui     the first version
+ * 2021-07-28     lizhirui     use the boot hart id instead of hart0 for the plic context
+ */
+
+#include <dreamos.h>
+
+static volatile os_size_t plic_hwbase;
+
+//目前只有启动hart接收外部中断，其编号在plic_init中记录，对应的S态PLIC上下文编号为hart_id * 2 + 1
+static os_size_t plic_hart;
+
+#define PLIC_PRIORITY(irq) ((volatile os_uint32_t *)(plic_hwbase + (irq) * 4))
+#define PLIC_SENABLE(hart,irq) ((volatile os_uint32_t *)(plic_hwbase + 0x2080 + (hart) * 0x100 + ((irq) >> 5) * 4))
+#define PLIC_STHRESHOLD(hart) ((volatile os_uint32_t *)(plic_hwbase + 0x201000 + (hart) * 0x2000))
+#define PLIC_SCLAIM(hart) ((volatile os_uint32_t *)(plic_hwbase + 0x201004 + (hart) * 0x2000))
+
+//中断处理函数表
+static plic_irq_handler_t plic_irq_handler_table[PLIC_IRQ_NUM];
+
+/*!
+ * PLIC初始化函数，必须在启动hart上调用
+ * @param hwbase PLIC寄存器的虚拟地址
+ */
+void plic_init(os_size_t hwbase)
+{
+    os_size_t i;
+
+    plic_hwbase = hwbase;
+    plic_hart = os_hart_get_current() -> hart_id;
+
+    for(i = 1;i < PLIC_IRQ_NUM;i++)
+    {
+        *PLIC_PRIORITY(i) = 0;
+        plic_irq_handler_table[i] = OS_NULL;
+    }
+
+    for(i = 0;i < PLIC_IRQ_NUM;i += 32)
+    {
+        *PLIC_SENABLE(plic_hart,i) = 0;
+    }
+
+    *PLIC_STHRESHOLD(plic_hart) = 0;
+    set_csr(sie,MIP_SEIP);
+}
+
+/*!
+ * 注册外部中断处理函数
+ * @param irq 中断号
+ * @param handler 中断处理函数
+ */
+void plic_irq_register(os_size_t irq,plic_irq_handler_t handler)
+{
+    OS_ASSERT((irq > 0) && (irq < PLIC_IRQ_NUM));
+    plic_irq_handler_table[irq] = handler;
+}
+
+/*!
+ * 使能外部中断
+ * @param irq 中断号
+ */
+void plic_irq_enable(os_size_t irq)
+{
+    OS_ASSERT((irq > 0) && (irq < PLIC_IRQ_NUM));
+    *PLIC_PRIORITY(irq) = 1;
+    *PLIC_SENABLE(plic_hart,irq) |= 1U << (irq & 0x1F);
+}
+
+/*!
+ * 禁止外部中断
+ * @param irq 中断号
+ */
+void plic_irq_disable(os_size_t irq)
+{
+    OS_ASSERT((irq > 0) && (irq < PLIC_IRQ_NUM));
+    *PLIC_SENABLE(plic_hart,irq) &= ~(1U << (irq & 0x1F));
+}
+
+/*!
+ * 外部中断处理函数，循环认领并处理所有挂起的外部中断
+ */
+void plic_isr()
+{
+    os_uint32_t irq;
+
+    while((irq = *PLIC_SCLAIM(plic_hart)) != 0)
+    {
+        if((irq < PLIC_IRQ_NUM) && (plic_irq_handler_table[irq] != OS_NULL))
+        {
+            plic_irq_handler_table[irq](irq);
+        }
+
+        *PLIC_SCLAIM(plic_hart) = irq;
+    }
+}
\ No newline at end of file
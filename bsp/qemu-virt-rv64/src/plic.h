@@ -0,0 +1,29 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-22     lizhirui     the first version
+ */
+
+#ifndef __PLIC_H__
+#define __PLIC_H__
+
+    #include <dreamos.h>
+
+    #define PLIC_BASE (0x0C000000L)
+    #define PLIC_IRQ_NUM (54)
+
+    #define PLIC_IRQ_UART0 (10)
+
+    typedef void (*plic_irq_handler_t)(os_size_t irq);
+
+    void plic_init(os_size_t hwbase);
+    void plic_irq_register(os_size_t irq,plic_irq_handler_t handler);
+    void plic_irq_enable(os_size_t irq);
+    void plic_irq_disable(os_size_t irq);
+    void plic_isr();
+
+#endif
\ No newline at end of file
@@ -6,6 +6,33 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-24     lizhirui     add task switch test
+ * 2021-07-25     lizhirui     add smp scaling test
+ * 2021-07-26     lizhirui     print runqueue statistics
+ * 2021-07-26     lizhirui     sleep instead of busy waiting in main loop
+ * 2021-07-26     lizhirui     print tick statistics
+ * 2021-07-27     lizhirui     add fair scheduling latency test
+ * 2021-07-27     lizhirui     add deadline scheduling test
+ * 2021-07-27     lizhirui     add mutex priority inheritance test
+ * 2021-07-27     lizhirui     add fpu context switch cost test
+ * 2021-07-27     lizhirui     add interrupt round trip test
+ * 2021-07-27     lizhirui     print cpu utilization
+ * 2021-07-28     lizhirui     add task creation latency test
+ * 2021-07-28     lizhirui     add many task wakeup and context switch cost test
+ * 2021-07-28     lizhirui     add pid allocation test
+ * 2021-07-28     lizhirui     add task exit and reap test and print task reaper statistics
+ * 2021-07-28     lizhirui     add deferred work test and print bottom half and workqueue statistics
+ * 2021-07-28     lizhirui     add cyclictest style wakeup latency test
+ * 2021-07-28     lizhirui     add condition variable throughput test and thundering herd test
+ * 2021-07-28     lizhirui     add parallel vfs lookup test
+ * 2021-07-28     lizhirui     add rcu lookup test
+ * 2021-07-28     lizhirui     add mutex contention test
+ * 2021-07-28     lizhirui     measure fpu context switch cost with two tasks switching to each other
+ * 2021-07-28     lizhirui     measure task switch cost against the number of ready priority levels
+ * 2021-07-28     lizhirui     add null syscall round trip test
+ * 2021-07-28     lizhirui     measure task creation without stack cache through the full heap stack path
+ * 2021-07-28     lizhirui     reap exit test tasks with os_task_wait and check their exit status and memory
+ * 2021-07-28     lizhirui     share one parallel test harness among the multi-task benchmarks
  */
 
 #include <dreamos.h>
@@ -170,6 +197,1703 @@ os_ssize_t task2_entry(os_size_t arg)
     }
 }
 
+//任务切换测试，两个同优先级任务通过os_task_yield交替运行，统计单次任务切换的平均周期数
+//同时在更低的若干个优先级上放置一直处于就绪态的任务，统计单次任务切换的平均周期数随非空就绪优先级数量的变化
+//其它hart空闲时会窃取任务，因此每个优先级放置与在线hart数量相同的任务，保证当前hart的运行队列中每个优先级都保留有就绪任务
+#define TASK_SWITCH_TEST_COUNT 10000
+#define TASK_SWITCH_TEST_LEVEL_MAX (TASK_PRIORITY_MAX - MAIN_TASK_PRIORITY - 2)
+
+static const os_size_t task_switch_test_level_num[] = {0,1,2,4,8,16};
+static volatile os_size_t task_switch_test_counter;
+static volatile os_bool_t task_switch_test_filler_run;
+static volatile os_size_t task_switch_test_alive;
+
+static os_ssize_t task_switch_test_entry(os_size_t arg)
+{
+    while(task_switch_test_counter < TASK_SWITCH_TEST_COUNT)
+    {
+        task_switch_test_counter++;
+        os_task_yield();
+    }
+
+    __atomic_sub_fetch(&task_switch_test_alive,1,__ATOMIC_RELEASE);
+    return 0;
+}
+
+static os_ssize_t task_switch_test_filler_entry(os_size_t arg)
+{
+    while(task_switch_test_filler_run)
+    {
+        os_task_yield();
+    }
+
+    __atomic_sub_fetch(&task_switch_test_alive,1,__ATOMIC_RELEASE);
+    return 0;
+}
+
+/*!
+ * 运行一轮任务切换测试
+ * @param level_num 放置就绪任务的较低优先级数量，不包括测试任务自身的优先级
+ * @return 单次任务切换的平均周期数
+ */
+static os_size_t task_switch_test_run(os_size_t level_num)
+{
+    os_task_p task = os_task_get_current_task();
+    os_size_t hart_num = os_hart_get_online_num();
+    os_size_t i,j;
+
+    OS_ASSERT(level_num <= TASK_SWITCH_TEST_LEVEL_MAX);
+    task_switch_test_counter = 0;
+    task_switch_test_filler_run = OS_TRUE;
+    task_switch_test_alive = level_num * hart_num + 1;
+
+    //填充任务的优先级低于测试任务，只占据就绪优先级位图，不会在测试期间被当前hart选中
+    for(i = 0;i < level_num;i++)
+    {
+        for(j = 0;j < hart_num;j++)
+        {
+            os_task_p filler = os_task_alloc();
+            OS_ASSERT(filler != OS_NULL);
+            OS_ASSERT(os_task_init(filler,MAIN_TASK_STACK_SIZE,task -> priority + 1 + i,task -> tick_init,task_switch_test_filler_entry,i,"task_switch_filler") == OS_ERR_OK);
+            os_task_startup(filler);
+        }
+    }
+
+    os_task_p test_task = os_task_alloc();
+    OS_ASSERT(test_task != OS_NULL);
+    OS_ASSERT(os_task_init(test_task,MAIN_TASK_STACK_SIZE,task -> priority,task -> tick_init,task_switch_test_entry,0,"task_switch_test") == OS_ERR_OK);
+    os_task_startup(test_task);
+
+    os_size_t start = ARCH_GET_CYCLE();
+
+    while(task_switch_test_counter < TASK_SWITCH_TEST_COUNT)
+    {
+        task_switch_test_counter++;
+        os_task_yield();
+    }
+
+    os_size_t cycles = ARCH_GET_CYCLE() - start;
+    task_switch_test_filler_run = OS_FALSE;
+
+    //当前任务睡眠期间填充任务才能在当前hart上运行并退出，退出的任务由回收线程回收
+    while(__atomic_load_n(&task_switch_test_alive,__ATOMIC_ACQUIRE) != 0)
+    {
+        os_task_sleep_ns(1000000);
+    }
+
+    return cycles / TASK_SWITCH_TEST_COUNT;
+}
+
+static void task_switch_test()
+{
+    os_size_t i;
+
+    for(i = 0;i < sizeof(task_switch_test_level_num) / sizeof(task_switch_test_level_num[0]);i++)
+    {
+        os_size_t cycles = task_switch_test_run(task_switch_test_level_num[i]);
+        os_printf("task switch: %ld switches,%ld ready priority levels,%ld cycles/switch\n",(os_size_t)TASK_SWITCH_TEST_COUNT,task_switch_test_level_num[i] + 1,cycles);
+    }
+}
+
+//浮点上下文切换开销测试，两个任务通过os_task_yield严格交替运行，分别在不使用和使用浮点单元的情况下统计单次任务切换的平均周期数，两者之差即为浮点上下文的额外开销
+//内核任务本身不使用浮点单元，因此仿照用户任务在内核栈顶保留用户态上下文，并在每次让出CPU之前将其中的sstatus.FS置为Dirty，
+//模拟任务在两次切换之间执行过浮点指令，使每次切换都经过arch_fpu_switch_out中的保存和arch_fpu_switch_in中的恢复
+#define FPU_SWITCH_TEST_COUNT 10000
+
+static os_task_t fpu_switch_test_task[2][2];
+static volatile os_size_t fpu_switch_test_counter;
+static volatile os_size_t fpu_switch_test_turn;
+static volatile os_bool_t fpu_switch_test_fp;
+static volatile os_bool_t fpu_switch_test_done;
+static os_size_t fpu_switch_test_start;
+static os_size_t fpu_switch_test_cycles;
+static os_waitqueue_t fpu_switch_test_waitqueue;
+
+static os_ssize_t fpu_switch_test_entry(os_size_t arg)
+{
+    struct TrapFrame *frame = (struct TrapFrame *)(os_task_get_kernel_stack_top(os_task_get_current_task()) - sizeof(struct TrapFrame));
+
+    while(fpu_switch_test_counter < FPU_SWITCH_TEST_COUNT)
+    {
+        if(fpu_switch_test_turn != arg)
+        {
+            os_task_yield();
+            continue;
+        }
+
+        if(fpu_switch_test_counter == 0)
+        {
+            fpu_switch_test_start = ARCH_GET_CYCLE();
+        }
+
+        if(fpu_switch_test_fp)
+        {
+            frame -> sstatus = (frame -> sstatus & ~SSTATUS_FS) | SSTATUS_FS_DIRTY;
+        }
+
+        fpu_switch_test_turn = 1 - arg;
+
+        if(++fpu_switch_test_counter == FPU_SWITCH_TEST_COUNT)
+        {
+            fpu_switch_test_cycles = ARCH_GET_CYCLE() - fpu_switch_test_start;
+            OS_ENTER_CRITICAL_AREA();
+            fpu_switch_test_done = OS_TRUE;
+            os_waitqueue_wakeup(&fpu_switch_test_waitqueue);
+            OS_LEAVE_CRITICAL_AREA();
+            break;
+        }
+
+        os_task_yield();
+    }
+
+    //测试结束后保持睡眠，避免占用CPU
+    while(1)
+    {
+        os_task_sleep();
+    }
+}
+
+/*!
+ * 运行一轮浮点上下文切换测试
+ * @param fp 为OS_TRUE时两个任务都使用浮点单元
+ * @return 单次任务切换的平均周期数
+ */
+static os_size_t fpu_switch_test_run(os_bool_t fp)
+{
+    os_task_p task = os_task_get_current_task();
+    os_size_t i;
+
+    fpu_switch_test_counter = 0;
+    fpu_switch_test_turn = 0;
+    fpu_switch_test_fp = fp;
+    fpu_switch_test_done = OS_FALSE;
+
+    for(i = 0;i < 2;i++)
+    {
+        os_task_p test_task = &fpu_switch_test_task[fp ? 1 : 0][i];
+        OS_ASSERT(os_task_init(test_task,MAIN_TASK_STACK_SIZE,task -> priority,task -> tick_init,fpu_switch_test_entry,i,"fpu_switch_test") == OS_ERR_OK);
+
+        if(fp)
+        {
+            //任务运行时的栈顶下移一个上下文，栈顶处的上下文即作为用户态上下文，其初始浮点状态为Clean
+            struct TrapFrame *frame = (struct TrapFrame *)test_task -> sp;
+            frame -> user_sp -= sizeof(struct TrapFrame);
+            ((struct TrapFrame *)frame -> user_sp) -> sstatus = SSTATUS_FS_CLEAN;
+            os_memset(&test_task -> fpu_context,0,sizeof(test_task -> fpu_context));
+            test_task -> fpu_used = OS_TRUE;
+        }
+    }
+
+    os_task_startup(&fpu_switch_test_task[fp ? 1 : 0][0]);
+    os_task_startup(&fpu_switch_test_task[fp ? 1 : 0][1]);
+    OS_ENTER_CRITICAL_AREA();
+
+    while(!fpu_switch_test_done)
+    {
+        os_waitqueue_wait(&fpu_switch_test_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return fpu_switch_test_cycles / FPU_SWITCH_TEST_COUNT;
+}
+
+static void fpu_switch_test()
+{
+    os_waitqueue_init(&fpu_switch_test_waitqueue);
+    os_size_t non_fp_cycles = fpu_switch_test_run(OS_FALSE);
+    os_size_t fp_cycles = fpu_switch_test_run(OS_TRUE);
+    os_printf("fpu switch: %ld switches,non-fp task %ld cycles/switch,fp task %ld cycles/switch,fp overhead %ld cycles/switch\n",(os_size_t)FPU_SWITCH_TEST_COUNT,non_fp_cycles,fp_cycles,(fp_cycles > non_fp_cycles) ? (fp_cycles - non_fp_cycles) : 0);
+}
+
+//中断与系统调用往返测试，在开中断的任务上下文中反复向当前hart发送软件中断，统计从触发中断到返回被中断任务的平均耗时（包含IPI处理程序本身）
+//然后由用户态任务反复执行getpid系统调用，统计从用户态ecall进入内核到返回用户态的平均耗时
+//测试任务分别执行N次和0次系统调用，两者耗时之差除以N，以扣除创建任务、进入用户态和退出的开销，两项测试均以os_tick_get_ns计时，结果可以直接对比
+#define TRAP_ROUNDTRIP_TEST_COUNT 10000
+#define NULL_SYSCALL_TEST_COUNT 100000
+
+static os_task_t null_syscall_test_task[2];
+
+extern void *null_syscall_test_code;
+extern void *null_syscall_test_code_end;
+extern void *null_syscall_test_count;
+
+void enter_user_space(os_size_t entry);
+
+static OS_NORETURN os_ssize_t null_syscall_test_entry(os_size_t arg)
+{
+    os_size_t start = (os_size_t)&null_syscall_test_code;
+    os_size_t size = (os_size_t)&null_syscall_test_code_end - start;
+    os_task_p task = os_task_get_current_task();
+
+    //用户态代码只占一页，直接通过内核地址拷贝，并写入系统调用次数
+    OS_ASSERT(size <= OS_MMU_PAGE_SIZE);
+    os_mmu_vtable_p vtable = os_memory_alloc(sizeof(os_mmu_vtable_t));
+    OS_ASSERT(vtable != OS_NULL);
+    OS_ASSERT(os_mmu_vtable_create(vtable,OS_NULL,OS_MMU_MEMORYMAP_USER_VTABLE_START,OS_MMU_MEMORYMAP_USER_VTABLE_SIZE) == OS_ERR_OK);
+    os_mmu_pt_prot_t prot = OS_MMU_PROT_USER;
+    OS_MMU_PROT_RWX(&prot);
+    OS_ASSERT(os_mmu_create_mapping_auto(vtable,OS_MMU_MEMORYMAP_USER_REAL_START,OS_MMU_PAGE_SIZE,prot) == OS_ERR_OK);
+    os_uint8_t *mem = os_mmu_user_va_to_kernel_va(vtable,OS_MMU_MEMORYMAP_USER_REAL_START);
+    OS_ASSERT(mem != OS_NULL);
+    os_memcpy(mem,(void *)start,size);
+    *(os_size_t *)(mem + ((os_size_t)&null_syscall_test_count - start)) = arg;
+    os_mmu_io_mapping_copy(vtable);
+    os_mmu_kernel_mapping_copy(vtable);
+
+    //改用新页表，新页表由任务退出时的回收流程销毁
+    OS_ENTER_CRITICAL_AREA();
+    task -> vtable -> refcnt--;
+    vtable -> refcnt = 1;
+    task -> vtable = vtable;
+    OS_LEAVE_CRITICAL_AREA();
+
+    os_mmu_switch(vtable);
+    enter_user_space(OS_MMU_MEMORYMAP_USER_REAL_START);
+    while(1);
+}
+
+/*!
+ * 运行一次空系统调用测试任务
+ * @param task 测试任务
+ * @param count 系统调用次数
+ * @return 从启动测试任务到测试任务退出的耗时（纳秒）
+ */
+static os_size_t null_syscall_test_run(os_task_p task,os_size_t count)
+{
+    //测试任务优先级高于当前任务，启动后立即抢占当前任务，退出后当前任务才会继续运行
+    OS_ASSERT(os_task_init(task,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY - 1,MAIN_TASK_TICK_INIT,null_syscall_test_entry,count,"null_syscall_test") == OS_ERR_OK);
+    os_size_t start = os_tick_get_ns();
+    os_task_startup(task);
+
+    //当前任务被其它hart窃取时，测试任务仍在运行，需要等待其退出
+    while(task -> task_state != OS_TASK_STATE_STOPPED)
+    {
+        os_task_yield();
+    }
+
+    return os_tick_get_ns() - start;
+}
+
+static void trap_roundtrip_test()
+{
+    os_size_t i;
+    os_size_t start = ARCH_GET_CYCLE();
+    os_size_t start_ns = os_tick_get_ns();
+
+    for(i = 0;i < TRAP_ROUNDTRIP_TEST_COUNT;i++)
+    {
+        set_csr(sip,SIP_SSIP);
+    }
+
+    os_size_t ns = os_tick_get_ns() - start_ns;
+    os_size_t cycles = ARCH_GET_CYCLE() - start;
+    os_printf("interrupt round trip: %ld interrupts,%ld cycles/interrupt,%ldns/interrupt\n",(os_size_t)TRAP_ROUNDTRIP_TEST_COUNT,cycles / TRAP_ROUNDTRIP_TEST_COUNT,ns / TRAP_ROUNDTRIP_TEST_COUNT);
+
+    os_size_t syscall_ns = null_syscall_test_run(&null_syscall_test_task[0],NULL_SYSCALL_TEST_COUNT);
+    os_size_t base_ns = null_syscall_test_run(&null_syscall_test_task[1],0);
+    syscall_ns = (syscall_ns > base_ns) ? (syscall_ns - base_ns) : 0;
+    os_printf("null syscall round trip: %ld syscalls,%ldns/syscall,task create and exit = %ldns\n",(os_size_t)NULL_SYSCALL_TEST_COUNT,syscall_ns / NULL_SYSCALL_TEST_COUNT,base_ns);
+}
+
+//并行测试框架，测试任务在每轮开始前睡眠，每轮同时唤醒其中的前n个，各测试任务执行一次测试函数后通知当前任务，当前任务等待全部完成并统计本轮耗时
+typedef void (*parallel_test_func_t)(os_size_t id);
+
+typedef struct parallel_test_worker
+{
+    struct parallel_test *test;//所属的并行测试
+    os_size_t id;//测试任务编号
+    os_task_p task;//测试任务
+}parallel_test_worker_t,*parallel_test_worker_p;
+
+typedef struct parallel_test
+{
+    parallel_test_worker_p worker;//测试任务数组
+    os_size_t worker_num;//测试任务数量
+    parallel_test_func_t func;//测试函数
+    volatile os_size_t finished;//本轮已经完成的测试任务数量
+    os_size_t active_num;//本轮参与测试的测试任务数量
+    os_waitqueue_t waitqueue;//用于等待本轮测试完成
+}parallel_test_t,*parallel_test_p;
+
+static os_ssize_t parallel_test_entry(os_size_t arg)
+{
+    parallel_test_worker_p worker = (parallel_test_worker_p)arg;
+    parallel_test_p test = worker -> test;
+
+    while(1)
+    {
+        //等待下一轮测试开始
+        os_task_sleep();
+        test -> func(worker -> id);
+
+        OS_ENTER_CRITICAL_AREA();
+
+        if(++test -> finished == test -> active_num)
+        {
+            os_waitqueue_wakeup(&test -> waitqueue);
+        }
+
+        OS_LEAVE_CRITICAL_AREA();
+    }
+}
+
+/*!
+ * 创建并启动并行测试的测试任务，测试任务启动后进入睡眠态等待第一轮测试开始
+ * @param test 并行测试结构体指针
+ * @param worker_num 测试任务数量
+ * @param stack_size 测试任务内核栈大小
+ * @param func 测试函数，参数为测试任务编号
+ * @param name 测试任务名称
+ */
+static void parallel_test_init(parallel_test_p test,os_size_t worker_num,os_size_t stack_size,parallel_test_func_t func,const char *name)
+{
+    os_size_t i;
+
+    test -> worker = os_memory_alloc(worker_num * sizeof(parallel_test_worker_t));
+    OS_ASSERT(test -> worker != OS_NULL);
+    test -> worker_num = worker_num;
+    test -> func = func;
+    test -> finished = 0;
+    test -> active_num = 0;
+    os_waitqueue_init(&test -> waitqueue);
+
+    for(i = 0;i < worker_num;i++)
+    {
+        parallel_test_worker_p worker = &test -> worker[i];
+        worker -> test = test;
+        worker -> id = i;
+        worker -> task = os_task_alloc();
+        OS_ASSERT(worker -> task != OS_NULL);
+        OS_ASSERT(os_task_init(worker -> task,stack_size,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,parallel_test_entry,(os_size_t)worker,name) == OS_ERR_OK);
+        os_task_startup(worker -> task);
+    }
+}
+
+/*!
+ * 运行一轮并行测试，同时唤醒前n个测试任务并等待它们全部完成
+ * @param test 并行测试结构体指针
+ * @param n 参与本轮测试的测试任务数量
+ * @param wakeup_ns 若不为OS_NULL，则返回唤醒全部测试任务的耗时（纳秒）
+ * @return 从开始唤醒到全部测试任务完成的耗时（纳秒），至少为1
+ */
+static os_size_t parallel_test_run(parallel_test_p test,os_size_t n,os_size_t *wakeup_ns)
+{
+    os_size_t i;
+
+    OS_ASSERT(n <= test -> worker_num);
+
+    //等待所有测试任务进入睡眠态
+    for(i = 0;i < test -> worker_num;i++)
+    {
+        while(test -> worker[i].task -> task_state != OS_TASK_STATE_SLEEPING)
+        {
+            os_task_yield();
+        }
+    }
+
+    OS_ENTER_CRITICAL_AREA();
+    test -> finished = 0;
+    test -> active_num = n;
+    os_size_t start = os_tick_get_ns();
+    os_task_wakeup_batch_t batch;
+    os_task_wakeup_batch_init(&batch);
+
+    for(i = 0;i < n;i++)
+    {
+        os_task_wakeup_batch_add(&batch,test -> worker[i].task);
+    }
+
+    os_task_wakeup_batch_flush(&batch);
+    os_size_t wakeup_end = os_tick_get_ns();
+
+    //唤醒期间当前任务可能被切换出去，测试任务可能在此之前已经全部完成
+    while(test -> finished < n)
+    {
+        os_waitqueue_wait(&test -> waitqueue);
+    }
+
+    os_size_t ns = MAX(os_tick_get_ns() - start,1);
+    OS_LEAVE_CRITICAL_AREA();
+
+    if(wakeup_ns != OS_NULL)
+    {
+        *wakeup_ns = wakeup_end - start;
+    }
+
+    return ns;
+}
+
+//多核扩展性测试，分别让1~N个计算密集型任务（N为在线hart数）各自完成相同的计算量，统计耗时并计算相对于单任务的吞吐量加速比
+#define SMP_SCALING_TEST_WORK 20000000
+
+static parallel_test_t smp_scaling_test_parallel;
+
+static void smp_scaling_test_func(os_size_t id)
+{
+    volatile os_size_t sum = 0;
+    os_size_t i;
+
+    for(i = 0;i < SMP_SCALING_TEST_WORK;i++)
+    {
+        sum += i;
+    }
+}
+
+static void smp_scaling_test()
+{
+    os_size_t hart_num = os_hart_get_online_num();
+    os_size_t base_ns = 0;
+    os_size_t n;
+
+    parallel_test_init(&smp_scaling_test_parallel,hart_num,MAIN_TASK_STACK_SIZE,smp_scaling_test_func,"smp_scaling_test");
+
+    for(n = 1;n <= hart_num;n++)
+    {
+        os_size_t ns = parallel_test_run(&smp_scaling_test_parallel,n,OS_NULL);
+
+        if(n == 1)
+        {
+            base_ns = ns;
+        }
+
+        os_size_t speedup = base_ns * n * 100 / ns;
+        os_printf("smp scaling: %ld tasks on %ld harts,%ldus,throughput speedup = %ld.%02ld\n",n,hart_num,ns / 1000,speedup / 100,speedup % 100);
+    }
+}
+
+//公平调度延迟测试，在计算密集型任务占满所有hart时，统计周期性睡眠的交互任务从定时到期到实际运行的延迟
+//分别在所有任务使用同等优先级的固定优先级调度和使用公平调度时进行测试
+#define FAIR_SCHED_TEST_SAMPLE_NUM 200
+#define FAIR_SCHED_TEST_HOG_TICK_INIT 10
+
+static os_task_t fair_sched_test_hog_task[OS_CPU_MAX_NUM * 2];
+static os_task_t fair_sched_test_interactive_task;
+static volatile os_bool_t fair_sched_test_running;
+static volatile os_bool_t fair_sched_test_finished;
+static os_size_t fair_sched_test_latency[FAIR_SCHED_TEST_SAMPLE_NUM];
+static os_waitqueue_t fair_sched_test_waitqueue;
+
+static os_ssize_t fair_sched_test_hog_entry(os_size_t arg)
+{
+    while(1)
+    {
+        //等待下一轮测试开始
+        os_task_sleep();
+
+        while(fair_sched_test_running);
+    }
+}
+
+static os_ssize_t fair_sched_test_interactive_entry(os_size_t arg)
+{
+    while(1)
+    {
+        os_task_sleep();
+
+        os_size_t i;
+
+        for(i = 0;i < FAIR_SCHED_TEST_SAMPLE_NUM;i++)
+        {
+            os_size_t target = os_tick_get() + 1;
+            os_task_sleep_ticks(1);
+            fair_sched_test_latency[i] = os_tick_get_ns() - target * OS_NS_PER_TICK;
+        }
+
+        OS_ENTER_CRITICAL_AREA();
+        fair_sched_test_finished = OS_TRUE;
+        os_waitqueue_wakeup(&fair_sched_test_waitqueue);
+        OS_LEAVE_CRITICAL_AREA();
+    }
+}
+
+static void fair_sched_test_run(os_task_sched_policy_t policy,const char *name)
+{
+    os_size_t hog_num = os_hart_get_online_num() * 2;
+    os_ssize_t param = (policy == OS_TASK_SCHED_RT) ? (MAIN_TASK_PRIORITY + 1) : 0;
+    os_size_t i,j;
+
+    OS_ASSERT(os_task_set_sched_policy(&fair_sched_test_interactive_task,policy,param) == OS_ERR_OK);
+
+    for(i = 0;i < hog_num;i++)
+    {
+        OS_ASSERT(os_task_set_sched_policy(&fair_sched_test_hog_task[i],policy,param) == OS_ERR_OK);
+    }
+
+    //等待所有测试任务进入睡眠态
+    while(fair_sched_test_interactive_task.task_state != OS_TASK_STATE_SLEEPING)
+    {
+        os_task_yield();
+    }
+
+    for(i = 0;i < hog_num;i++)
+    {
+        while(fair_sched_test_hog_task[i].task_state != OS_TASK_STATE_SLEEPING)
+        {
+            os_task_yield();
+        }
+    }
+
+    OS_ENTER_CRITICAL_AREA();
+    fair_sched_test_running = OS_TRUE;
+    fair_sched_test_finished = OS_FALSE;
+
+    for(i = 0;i < hog_num;i++)
+    {
+        os_task_wakeup(&fair_sched_test_hog_task[i]);
+    }
+
+    os_task_wakeup(&fair_sched_test_interactive_task);
+
+    while(!fair_sched_test_finished)
+    {
+        os_waitqueue_wait(&fair_sched_test_waitqueue);
+    }
+
+    fair_sched_test_running = OS_FALSE;
+    OS_LEAVE_CRITICAL_AREA();
+
+    //插入排序后取分位数
+    for(i = 1;i < FAIR_SCHED_TEST_SAMPLE_NUM;i++)
+    {
+        os_size_t value = fair_sched_test_latency[i];
+
+        for(j = i;(j > 0) && (fair_sched_test_latency[j - 1] > value);j--)
+        {
+            fair_sched_test_latency[j] = fair_sched_test_latency[j - 1];
+        }
+
+        fair_sched_test_latency[j] = value;
+    }
+
+    os_printf("fair sched: %s,%ld hogs,wakeup latency p50 = %ldus,p99 = %ldus,max = %ldus\n",name,hog_num,
+              fair_sched_test_latency[FAIR_SCHED_TEST_SAMPLE_NUM / 2] / 1000,
+              fair_sched_test_latency[FAIR_SCHED_TEST_SAMPLE_NUM * 99 / 100] / 1000,
+              fair_sched_test_latency[FAIR_SCHED_TEST_SAMPLE_NUM - 1] / 1000);
+}
+
+static void fair_sched_test()
+{
+    os_size_t hog_num = os_hart_get_online_num() * 2;
+    os_size_t i;
+
+    os_waitqueue_init(&fair_sched_test_waitqueue);
+
+    for(i = 0;i < hog_num;i++)
+    {
+        OS_ASSERT(os_task_init(&fair_sched_test_hog_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 1,FAIR_SCHED_TEST_HOG_TICK_INIT,fair_sched_test_hog_entry,i,"fair_sched_hog") == OS_ERR_OK);
+        os_task_startup(&fair_sched_test_hog_task[i]);
+    }
+
+    OS_ASSERT(os_task_init(&fair_sched_test_interactive_task,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 1,MAIN_TASK_TICK_INIT,fair_sched_test_interactive_entry,0,"fair_sched_interactive") == OS_ERR_OK);
+    os_task_startup(&fair_sched_test_interactive_task);
+
+    fair_sched_test_run(OS_TASK_SCHED_RT,"rt");
+    fair_sched_test_run(OS_TASK_SCHED_FAIR,"fair");
+}
+
+//两次采样间隔超过该值时认为期间被抢占
+#define BUSY_RUN_PREEMPT_THRESHOLD_NS 100000
+
+/*!
+ * 忙等待直到当前任务实际获得ns纳秒的处理器时间，被抢占的时间不计入
+ * @param ns 需要获得的处理器时间（纳秒）
+ */
+static void busy_run_ns(os_size_t ns)
+{
+    os_size_t last = os_tick_get_ns();
+
+    while(ns > 0)
+    {
+        os_size_t now = os_tick_get_ns();
+        os_size_t delta = now - last;
+        last = now;
+
+        if(delta < BUSY_RUN_PREEMPT_THRESHOLD_NS)
+        {
+            ns -= MIN(ns,delta);
+        }
+    }
+}
+
+//截止时间调度测试，每个hart上运行一个按预算执行的周期任务，另有一个每个作业都超出预算的周期任务，
+//并用公平调度的计算密集型任务占满所有hart，统计各周期任务错过截止时间与预算超支的次数，并测试准入控制
+#define DEADLINE_SCHED_TEST_JOB_NUM 50
+#define DEADLINE_SCHED_TEST_PERIOD_NS (100 * 1000000UL)
+#define DEADLINE_SCHED_TEST_RUNTIME_NS (30 * 1000000UL)
+
+static os_task_t deadline_sched_test_task[OS_CPU_MAX_NUM + 1];
+static os_size_t deadline_sched_test_late_count[OS_CPU_MAX_NUM + 1];
+static os_task_t deadline_sched_test_hog_task[OS_CPU_MAX_NUM];
+static volatile os_bool_t deadline_sched_test_running;
+static volatile os_size_t deadline_sched_test_finished;
+static os_size_t deadline_sched_test_task_num;
+static os_waitqueue_t deadline_sched_test_waitqueue;
+
+static os_ssize_t deadline_sched_test_hog_entry(os_size_t arg)
+{
+    while(deadline_sched_test_running);
+
+    while(1)
+    {
+        os_task_sleep();
+    }
+}
+
+static os_ssize_t deadline_sched_test_entry(os_size_t arg)
+{
+    os_size_t index = arg;
+    //最后一个任务每个作业的执行时间超出预算
+    os_size_t work_ns = (index == (deadline_sched_test_task_num - 1)) ? (DEADLINE_SCHED_TEST_RUNTIME_NS * 2) : (DEADLINE_SCHED_TEST_RUNTIME_NS / 2);
+    os_size_t release = os_tick_get_ns();
+    os_size_t i;
+
+    for(i = 0;i < DEADLINE_SCHED_TEST_JOB_NUM;i++)
+    {
+        busy_run_ns(work_ns);
+
+        if(os_tick_get_ns() > (release + DEADLINE_SCHED_TEST_PERIOD_NS))
+        {
+            deadline_sched_test_late_count[index]++;
+        }
+
+        //睡眠到下一个周期的起点
+        release += DEADLINE_SCHED_TEST_PERIOD_NS;
+        os_size_t now = os_tick_get_ns();
+
+        while(now < release)
+        {
+            os_task_sleep_ns(release - now);
+            now = os_tick_get_ns();
+        }
+    }
+
+    OS_ENTER_CRITICAL_AREA();
+
+    if(++deadline_sched_test_finished == deadline_sched_test_task_num)
+    {
+        os_waitqueue_wakeup(&deadline_sched_test_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+
+    while(1)
+    {
+        os_task_sleep();
+    }
+}
+
+static void deadline_sched_test()
+{
+    os_size_t hart_num = os_hart_get_online_num();
+    os_size_t i;
+
+    os_waitqueue_init(&deadline_sched_test_waitqueue);
+    deadline_sched_test_running = OS_TRUE;
+    deadline_sched_test_finished = 0;
+    deadline_sched_test_task_num = hart_num + 1;
+
+    for(i = 0;i < hart_num;i++)
+    {
+        OS_ASSERT(os_task_init(&deadline_sched_test_hog_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 1,MAIN_TASK_TICK_INIT,deadline_sched_test_hog_entry,i,"deadline_sched_hog") == OS_ERR_OK);
+        OS_ASSERT(os_task_set_sched_policy(&deadline_sched_test_hog_task[i],OS_TASK_SCHED_FAIR,0) == OS_ERR_OK);
+        os_task_startup(&deadline_sched_test_hog_task[i]);
+    }
+
+    for(i = 0;i < deadline_sched_test_task_num;i++)
+    {
+        deadline_sched_test_late_count[i] = 0;
+        OS_ASSERT(os_task_init(&deadline_sched_test_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 1,MAIN_TASK_TICK_INIT,deadline_sched_test_entry,i,"deadline_sched") == OS_ERR_OK);
+        OS_ASSERT(os_task_set_deadline(&deadline_sched_test_task[i],DEADLINE_SCHED_TEST_RUNTIME_NS,DEADLINE_SCHED_TEST_PERIOD_NS,DEADLINE_SCHED_TEST_PERIOD_NS) == OS_ERR_OK);
+    }
+
+    //剩余带宽不足以容纳一个独占处理器的任务，应当被准入控制拒绝
+    os_err_t err = os_task_set_deadline(&deadline_sched_test_hog_task[0],DEADLINE_SCHED_TEST_PERIOD_NS,DEADLINE_SCHED_TEST_PERIOD_NS,DEADLINE_SCHED_TEST_PERIOD_NS);
+    os_printf("deadline sched: admission of a full-bandwidth task returns %d\n",err);
+
+    for(i = 0;i < deadline_sched_test_task_num;i++)
+    {
+        os_task_startup(&deadline_sched_test_task[i]);
+    }
+
+    OS_ENTER_CRITICAL_AREA();
+
+    while(deadline_sched_test_finished < deadline_sched_test_task_num)
+    {
+        os_waitqueue_wait(&deadline_sched_test_waitqueue);
+    }
+
+    deadline_sched_test_running = OS_FALSE;
+    OS_LEAVE_CRITICAL_AREA();
+
+    for(i = 0;i < deadline_sched_test_task_num;i++)
+    {
+        os_task_p task = &deadline_sched_test_task[i];
+        os_printf("deadline sched: task %ld,%ld jobs,%ld late jobs,%ld deadline misses,%ld budget overruns\n",i,(os_size_t)DEADLINE_SCHED_TEST_JOB_NUM,deadline_sched_test_late_count[i],task -> dl_miss_count,task -> dl_overrun_count);
+    }
+}
+
+//互斥锁优先级继承测试，低优先级任务持有互斥锁m2，中低优先级任务持有互斥锁m1并等待m2，随后中优先级的计算密集型任务占满所有hart，
+//高优先级任务此时申请m1，统计其阻塞时间。优先级需要沿等待链传递两级，否则持锁任务无法运行，高优先级任务会一直阻塞
+#define PI_MUTEX_TEST_ROUND_NUM 20
+#define PI_MUTEX_TEST_HOLD_NS (50 * 1000000UL)
+#define PI_MUTEX_TEST_HOG_MAX_NS (1000 * 1000000UL)
+
+static os_task_t pi_mutex_test_high_task;
+static os_task_t pi_mutex_test_low_task;
+static os_task_t pi_mutex_test_lowest_task;
+static os_task_t pi_mutex_test_hog_task[OS_CPU_MAX_NUM];
+static os_mutex_t pi_mutex_test_m1;
+static os_mutex_t pi_mutex_test_m2;
+static volatile os_bool_t pi_mutex_test_running;
+static volatile os_bool_t pi_mutex_test_finished;
+static os_size_t pi_mutex_test_block_ns;
+static os_waitqueue_t pi_mutex_test_waitqueue;
+
+static os_ssize_t pi_mutex_test_hog_entry(os_size_t arg)
+{
+    while(1)
+    {
+        os_task_sleep();
+
+        //限制最长运行时间，避免优先级继承失效时测试无法结束
+        os_size_t start = os_tick_get_ns();
+
+        while(pi_mutex_test_running && ((os_tick_get_ns() - start) < PI_MUTEX_TEST_HOG_MAX_NS));
+    }
+}
+
+static os_ssize_t pi_mutex_test_lowest_entry(os_size_t arg)
+{
+    while(1)
+    {
+        os_task_sleep();
+        os_mutex_lock(&pi_mutex_test_m2);
+        busy_run_ns(PI_MUTEX_TEST_HOLD_NS);
+        os_mutex_unlock(&pi_mutex_test_m2);
+    }
+}
+
+static os_ssize_t pi_mutex_test_low_entry(os_size_t arg)
+{
+    while(1)
+    {
+        os_task_sleep();
+        os_mutex_lock(&pi_mutex_test_m1);
+        os_mutex_lock(&pi_mutex_test_m2);
+        os_mutex_unlock(&pi_mutex_test_m2);
+        os_mutex_unlock(&pi_mutex_test_m1);
+    }
+}
+
+static os_ssize_t pi_mutex_test_high_entry(os_size_t arg)
+{
+    while(1)
+    {
+        os_task_sleep();
+
+        os_size_t start = os_tick_get_ns();
+        os_mutex_lock(&pi_mutex_test_m1);
+        pi_mutex_test_block_ns = os_tick_get_ns() - start;
+        os_mutex_unlock(&pi_mutex_test_m1);
+
+        OS_ENTER_CRITICAL_AREA();
+        pi_mutex_test_finished = OS_TRUE;
+        os_waitqueue_wakeup(&pi_mutex_test_waitqueue);
+        OS_LEAVE_CRITICAL_AREA();
+    }
+}
+
+static void pi_mutex_test_wait_sleeping(os_task_p task)
+{
+    while(task -> task_state != OS_TASK_STATE_SLEEPING)
+    {
+        os_task_sleep_ticks(1);
+    }
+}
+
+static void pi_mutex_test()
+{
+    os_size_t hog_num = os_hart_get_online_num();
+    os_size_t max_ns = 0;
+    os_size_t total_ns = 0;
+    os_size_t i,j;
+
+    os_mutex_init(&pi_mutex_test_m1);
+    os_mutex_init(&pi_mutex_test_m2);
+    os_waitqueue_init(&pi_mutex_test_waitqueue);
+
+    OS_ASSERT(os_task_init(&pi_mutex_test_high_task,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 1,MAIN_TASK_TICK_INIT,pi_mutex_test_high_entry,0,"pi_mutex_high") == OS_ERR_OK);
+    OS_ASSERT(os_task_init(&pi_mutex_test_low_task,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 3,MAIN_TASK_TICK_INIT,pi_mutex_test_low_entry,0,"pi_mutex_low") == OS_ERR_OK);
+    OS_ASSERT(os_task_init(&pi_mutex_test_lowest_task,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 4,MAIN_TASK_TICK_INIT,pi_mutex_test_lowest_entry,0,"pi_mutex_lowest") == OS_ERR_OK);
+    os_task_startup(&pi_mutex_test_high_task);
+    os_task_startup(&pi_mutex_test_low_task);
+    os_task_startup(&pi_mutex_test_lowest_task);
+
+    for(i = 0;i < hog_num;i++)
+    {
+        OS_ASSERT(os_task_init(&pi_mutex_test_hog_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 2,MAIN_TASK_TICK_INIT,pi_mutex_test_hog_entry,i,"pi_mutex_hog") == OS_ERR_OK);
+        os_task_startup(&pi_mutex_test_hog_task[i]);
+    }
+
+    for(i = 0;i < PI_MUTEX_TEST_ROUND_NUM;i++)
+    {
+        //等待所有测试任务进入睡眠态
+        pi_mutex_test_wait_sleeping(&pi_mutex_test_high_task);
+        pi_mutex_test_wait_sleeping(&pi_mutex_test_low_task);
+        pi_mutex_test_wait_sleeping(&pi_mutex_test_lowest_task);
+
+        for(j = 0;j < hog_num;j++)
+        {
+            pi_mutex_test_wait_sleeping(&pi_mutex_test_hog_task[j]);
+        }
+
+        //依次建立等待链：lowest持有m2，low持有m1并等待m2
+        os_task_wakeup(&pi_mutex_test_lowest_task);
+        os_task_sleep_ticks(1);
+        os_task_wakeup(&pi_mutex_test_low_task);
+        os_task_sleep_ticks(1);
+
+        OS_ENTER_CRITICAL_AREA();
+        pi_mutex_test_running = OS_TRUE;
+        pi_mutex_test_finished = OS_FALSE;
+
+        for(j = 0;j < hog_num;j++)
+        {
+            os_task_wakeup(&pi_mutex_test_hog_task[j]);
+        }
+
+        os_task_wakeup(&pi_mutex_test_high_task);
+
+        while(!pi_mutex_test_finished)
+        {
+            os_waitqueue_wait(&pi_mutex_test_waitqueue);
+        }
+
+        pi_mutex_test_running = OS_FALSE;
+        OS_LEAVE_CRITICAL_AREA();
+
+        max_ns = MAX(max_ns,pi_mutex_test_block_ns);
+        total_ns += pi_mutex_test_block_ns;
+    }
+
+    os_printf("pi mutex: %ld rounds,hold time = %ldus,%ld hogs,blocking time avg = %ldus,max = %ldus\n",(os_size_t)PI_MUTEX_TEST_ROUND_NUM,PI_MUTEX_TEST_HOLD_NS / 1000,hog_num,total_ns / PI_MUTEX_TEST_ROUND_NUM / 1000,max_ns / 1000);
+}
+
+//任务创建延迟测试，统计clone路径中os_task_init与os_task_remove的平均耗时，首轮内核栈缓存为空，需要分配物理内存并建立映射，之后的轮次直接复用缓存中的内核栈
+//同时以无法使用内核栈槽位的大小（不是2的幂）运行同样的测试作为对比，此时内核栈退化为普通内存分配，即改用内核栈缓存之前的完整创建与销毁路径
+#define CLONE_LATENCY_TEST_TASK_NUM OS_TASK_STACK_CACHE_NUM
+#define CLONE_LATENCY_TEST_ROUND_NUM 100
+#define CLONE_LATENCY_TEST_HEAP_STACK_SIZE (MAIN_TASK_STACK_SIZE + OS_MMU_PAGE_SIZE)
+
+static os_task_p clone_latency_test_task[CLONE_LATENCY_TEST_TASK_NUM];
+
+static os_ssize_t clone_latency_test_entry(os_size_t arg)
+{
+    return 0;
+}
+
+/*!
+ * 运行一轮任务创建延迟测试
+ * @param stack_size 任务内核栈大小
+ * @return 单个任务创建与销毁的平均耗时（纳秒）
+ */
+static os_size_t clone_latency_test_round(os_size_t stack_size)
+{
+    os_size_t i;
+    os_size_t start = os_tick_get_ns();
+
+    for(i = 0;i < CLONE_LATENCY_TEST_TASK_NUM;i++)
+    {
+        clone_latency_test_task[i] = os_task_alloc();
+        OS_ASSERT(clone_latency_test_task[i] != OS_NULL);
+        OS_ASSERT(os_task_init(clone_latency_test_task[i],stack_size,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,clone_latency_test_entry,0,"clone_test") == OS_ERR_OK);
+    }
+
+    for(i = 0;i < CLONE_LATENCY_TEST_TASK_NUM;i++)
+    {
+        os_task_remove(clone_latency_test_task[i]);
+    }
+
+    return (os_tick_get_ns() - start) / CLONE_LATENCY_TEST_TASK_NUM;
+}
+
+static void clone_latency_test()
+{
+    os_size_t i;
+    os_size_t cold_ns = clone_latency_test_round(MAIN_TASK_STACK_SIZE);
+    os_size_t warm_ns = 0;
+    os_size_t heap_ns = 0;
+
+    for(i = 0;i < CLONE_LATENCY_TEST_ROUND_NUM;i++)
+    {
+        warm_ns += clone_latency_test_round(MAIN_TASK_STACK_SIZE);
+    }
+
+    for(i = 0;i < CLONE_LATENCY_TEST_ROUND_NUM;i++)
+    {
+        heap_ns += clone_latency_test_round(CLONE_LATENCY_TEST_HEAP_STACK_SIZE);
+    }
+
+    os_printf("clone latency(init and remove): stack size = %ld,cold = %ldns,warm = %ldns\n",(os_size_t)MAIN_TASK_STACK_SIZE,cold_ns,warm_ns / CLONE_LATENCY_TEST_ROUND_NUM);
+    os_printf("clone latency(init and remove): heap stack size = %ld,without stack cache = %ldns\n",(os_size_t)CLONE_LATENCY_TEST_HEAP_STACK_SIZE,heap_ns / CLONE_LATENCY_TEST_ROUND_NUM);
+    os_task_stack_print_info();
+}
+
+//大量任务下的唤醒与任务切换开销测试，创建1000个任务，每轮唤醒全部任务，统计单个任务的平均唤醒耗时以及全部任务依次运行一次的平均切换耗时
+//任务数量远大于缓存容量时，每次调度访问的任务结构体缓存行数量决定了开销，因此同时打印任务结构体大小与热数据大小
+#define MANY_TASK_TEST_TASK_NUM 1000
+#define MANY_TASK_TEST_STACK_SIZE 8192
+#define MANY_TASK_TEST_ROUND_NUM 10
+
+static parallel_test_t many_task_test_parallel;
+
+static void many_task_test_func(os_size_t id)
+{
+    //测试任务被唤醒后直接返回，只统计唤醒与任务切换的开销
+}
+
+static void many_task_test()
+{
+    os_size_t wakeup_ns = 0;
+    os_size_t switch_ns = 0;
+    os_size_t round;
+
+    parallel_test_init(&many_task_test_parallel,MANY_TASK_TEST_TASK_NUM,MANY_TASK_TEST_STACK_SIZE,many_task_test_func,"many_task_test");
+
+    for(round = 0;round < MANY_TASK_TEST_ROUND_NUM;round++)
+    {
+        os_size_t round_wakeup_ns;
+        os_size_t ns = parallel_test_run(&many_task_test_parallel,MANY_TASK_TEST_TASK_NUM,&round_wakeup_ns);
+        wakeup_ns += round_wakeup_ns;
+        switch_ns += ns - MIN(ns,round_wakeup_ns);
+    }
+
+    os_printf("many task: %ld tasks,task size = %ld,hot size = %ld,wakeup = %ldns,switch = %ldns\n",(os_size_t)MANY_TASK_TEST_TASK_NUM,(os_size_t)sizeof(os_task_t),(os_size_t)OS_TASK_HOT_SIZE,wakeup_ns / MANY_TASK_TEST_ROUND_NUM / MANY_TASK_TEST_TASK_NUM,switch_ns / MANY_TASK_TEST_ROUND_NUM / MANY_TASK_TEST_TASK_NUM);
+}
+
+//pid分配测试，先创建10000个不启动的任务作为存活任务，再反复创建并销毁任务模拟fork密集的负载，统计单次创建销毁和单次pid查找的平均耗时
+//同时在同样数量的存活id下单独统计ID分配器循环分配与释放的平均耗时
+#define PID_ALLOC_TEST_LIVE_NUM 10000
+#define PID_ALLOC_TEST_ROUND_NUM 10000
+#define PID_ALLOC_TEST_STACK_SIZE 4096
+
+static os_task_p pid_alloc_test_task[PID_ALLOC_TEST_LIVE_NUM];
+static os_idr_t pid_alloc_test_idr;
+
+static os_ssize_t pid_alloc_test_entry(os_size_t arg)
+{
+    return 0;
+}
+
+static void pid_alloc_test()
+{
+    os_size_t i,id;
+
+    for(i = 0;i < PID_ALLOC_TEST_LIVE_NUM;i++)
+    {
+        pid_alloc_test_task[i] = os_task_alloc();
+        OS_ASSERT(pid_alloc_test_task[i] != OS_NULL);
+        OS_ASSERT(os_task_init(pid_alloc_test_task[i],PID_ALLOC_TEST_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,pid_alloc_test_entry,i,"pid_test") == OS_ERR_OK);
+    }
+
+    os_size_t start = os_tick_get_ns();
+
+    for(i = 0;i < PID_ALLOC_TEST_ROUND_NUM;i++)
+    {
+        os_task_p task = os_task_alloc();
+        OS_ASSERT(task != OS_NULL);
+        OS_ASSERT(os_task_init(task,PID_ALLOC_TEST_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,pid_alloc_test_entry,i,"pid_test") == OS_ERR_OK);
+        os_task_remove(task);
+    }
+
+    os_size_t fork_ns = (os_tick_get_ns() - start) / PID_ALLOC_TEST_ROUND_NUM;
+    start = os_tick_get_ns();
+
+    for(i = 0;i < PID_ALLOC_TEST_LIVE_NUM;i++)
+    {
+        OS_ASSERT(os_task_get_task_by_pid(pid_alloc_test_task[i] -> pid) == pid_alloc_test_task[i]);
+    }
+
+    os_size_t lookup_ns = (os_tick_get_ns() - start) / PID_ALLOC_TEST_LIVE_NUM;
+
+    for(i = 0;i < PID_ALLOC_TEST_LIVE_NUM;i++)
+    {
+        os_task_remove(pid_alloc_test_task[i]);
+    }
+
+    os_idr_init(&pid_alloc_test_idr,0,OS_TASK_MAX_NUM);
+
+    for(i = 0;i < PID_ALLOC_TEST_LIVE_NUM;i++)
+    {
+        OS_ASSERT(os_idr_alloc_cyclic(&pid_alloc_test_idr,OS_NULL,&id) == OS_ERR_OK);
+    }
+
+    start = os_tick_get_ns();
+
+    //每轮释放最早分配的一个id并分配一个新id，使存活id数量保持不变，且分配位置持续向后推进并回绕
+    for(i = 0;i < PID_ALLOC_TEST_ROUND_NUM;i++)
+    {
+        os_idr_remove(&pid_alloc_test_idr,(id + OS_TASK_MAX_NUM - PID_ALLOC_TEST_LIVE_NUM + 1) % OS_TASK_MAX_NUM);
+        OS_ASSERT(os_idr_alloc_cyclic(&pid_alloc_test_idr,OS_NULL,&id) == OS_ERR_OK);
+    }
+
+    os_size_t idr_ns = (os_tick_get_ns() - start) / PID_ALLOC_TEST_ROUND_NUM;
+    os_idr_destroy(&pid_alloc_test_idr);
+    os_printf("pid alloc: %ld live tasks,create and remove = %ldns,pid lookup = %ldns,idr cyclic alloc and remove = %ldns\n",(os_size_t)PID_ALLOC_TEST_LIVE_NUM,fork_ns,lookup_ns,idr_ns);
+}
+
+//任务退出回收测试，反复创建立即退出的任务，由当前任务通过os_task_wait逐个回收，检查每个任务的退出码及其wait4退出状态编码，统计单个任务从创建到回收的平均耗时
+//回收线程释放全部资源并且宽限期结束后，已分配的内存应当回到本轮测试开始前的值，首轮测试用于填满内核栈缓存等不会归还内存的缓存，只检查第二轮的内存
+#define EXIT_REAP_TEST_TASK_NUM 1000
+#define EXIT_REAP_TEST_SETTLE_TICKS 10
+#define EXIT_REAP_TEST_TIMEOUT_NS 1000000000UL
+
+static os_ssize_t exit_reap_test_pid[EXIT_REAP_TEST_TASK_NUM];
+
+static os_ssize_t exit_reap_test_entry(os_size_t arg)
+{
+    return arg;
+}
+
+/*!
+ * 运行一轮任务退出回收测试
+ * @return 单个任务从创建到回收的平均耗时（纳秒）
+ */
+static os_size_t exit_reap_test_round()
+{
+    os_size_t i;
+    os_size_t start = os_tick_get_ns();
+
+    //测试任务优先级高于当前任务，启动后立即运行并退出，保留为终止态直到被当前任务回收
+    for(i = 0;i < EXIT_REAP_TEST_TASK_NUM;i++)
+    {
+        os_task_p task = os_task_alloc();
+        OS_ASSERT(task != OS_NULL);
+        OS_ASSERT(os_task_init(task,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY - 1,MAIN_TASK_TICK_INIT,exit_reap_test_entry,i,"exit_test") == OS_ERR_OK);
+        exit_reap_test_pid[i] = task -> pid;
+        os_task_startup(task);
+    }
+
+    for(i = 0;i < EXIT_REAP_TEST_TASK_NUM;i++)
+    {
+        os_ssize_t exit_code;
+        OS_ASSERT(os_task_wait(exit_reap_test_pid[i],OS_FALSE,&exit_code,OS_NULL,OS_NULL) == exit_reap_test_pid[i]);
+        OS_ASSERT(exit_code == (os_ssize_t)i);
+        //退出码超过255时只保留低8位
+        os_int32_t status = OS_TASK_WAIT_STATUS(exit_code);
+        OS_ASSERT((status & 0x7F) == 0);
+        OS_ASSERT(((status >> 8) & 0xFF) == (os_int32_t)(i & 0xFF));
+    }
+
+    return (os_tick_get_ns() - start) / EXIT_REAP_TEST_TASK_NUM;
+}
+
+/*!
+ * 等待回收线程和宽限期结束后的回调释放完已回收任务的资源，已分配内存在连续若干个时钟节拍内不再变化时认为释放完毕
+ * @return 已分配内存大小
+ */
+static os_size_t exit_reap_test_settle()
+{
+    os_size_t start = os_tick_get_ns();
+    os_size_t memory = os_get_allocated_memory();
+    os_size_t stable_ticks = 0;
+
+    //回收线程优先级较低，当前任务睡眠时其才能运行
+    while((stable_ticks < EXIT_REAP_TEST_SETTLE_TICKS) && ((os_tick_get_ns() - start) < EXIT_REAP_TEST_TIMEOUT_NS))
+    {
+        os_task_sleep_ticks(1);
+        os_size_t cur_memory = os_get_allocated_memory();
+        stable_ticks = (cur_memory == memory) ? (stable_ticks + 1) : 0;
+        memory = cur_memory;
+    }
+
+    return memory;
+}
+
+static void exit_reap_test()
+{
+    os_task_set_reap_child(OS_TRUE);
+    os_size_t cold_ns = exit_reap_test_round();
+    os_size_t memory = exit_reap_test_settle();
+    os_size_t ns = exit_reap_test_round();
+    os_size_t memory_end = exit_reap_test_settle();
+    os_task_set_reap_child(OS_FALSE);
+    os_printf("exit reap: %ld tasks,create,exit and wait = %ldns(first round = %ldns),memory = %ld -> %ld\n",(os_size_t)EXIT_REAP_TEST_TASK_NUM,ns,cold_ns,memory,memory_end);
+    OS_ASSERT(memory_end == memory);
+    os_task_reaper_print_info();
+}
+
+//延迟工作测试，由定时器回调（时钟中断上下文）调度下半部，下半部再将工作项加入系统工作队列，统计从中断到工作函数执行的延迟
+//然后向多线程工作队列批量加入工作项并等待全部完成，统计单个工作项的平均开销
+#define DEFERRED_WORK_TEST_ROUND_NUM 100
+#define DEFERRED_WORK_TEST_WORK_NUM 64
+#define DEFERRED_WORK_TEST_WORKER_NUM 4
+
+static os_timer_t deferred_work_test_timer;
+static os_bh_t deferred_work_test_bh;
+static os_work_t deferred_work_test_work;
+static os_size_t deferred_work_test_irq_time;
+static os_size_t deferred_work_test_latency_total;
+static os_size_t deferred_work_test_latency_max;
+static os_workqueue_t deferred_work_test_wq;
+static os_work_t deferred_work_test_batch_work[DEFERRED_WORK_TEST_WORK_NUM];
+static volatile os_size_t deferred_work_test_batch_done;
+
+static void deferred_work_test_work_func(os_size_t arg)
+{
+    os_size_t latency = os_tick_get_ns() - deferred_work_test_irq_time;
+    deferred_work_test_latency_total += latency;
+    deferred_work_test_latency_max = MAX(deferred_work_test_latency_max,latency);
+}
+
+static void deferred_work_test_bh_func(os_size_t arg)
+{
+    os_work_schedule(&deferred_work_test_work);
+}
+
+static void deferred_work_test_timer_func(os_size_t arg)
+{
+    deferred_work_test_irq_time = os_tick_get_ns();
+    os_bh_schedule(&deferred_work_test_bh);
+}
+
+static void deferred_work_test_batch_func(os_size_t arg)
+{
+    __atomic_add_fetch(&deferred_work_test_batch_done,1,__ATOMIC_RELAXED);
+}
+
+static void deferred_work_test()
+{
+    os_size_t i;
+
+    os_timer_init(&deferred_work_test_timer,deferred_work_test_timer_func,0);
+    os_timer_set_slack(&deferred_work_test_timer,0);
+    os_bh_init(&deferred_work_test_bh,deferred_work_test_bh_func,0);
+    os_work_init(&deferred_work_test_work,deferred_work_test_work_func,0);
+    deferred_work_test_latency_total = 0;
+    deferred_work_test_latency_max = 0;
+
+    for(i = 0;i < DEFERRED_WORK_TEST_ROUND_NUM;i++)
+    {
+        os_timer_start(&deferred_work_test_timer,1);
+        os_task_sleep_ticks(2);
+        os_work_flush(&deferred_work_test_work);
+    }
+
+    os_printf("deferred work: irq -> bh -> work latency avg = %ldns,max = %ldns\n",deferred_work_test_latency_total / DEFERRED_WORK_TEST_ROUND_NUM,deferred_work_test_latency_max);
+
+    OS_ASSERT(os_workqueue_create(&deferred_work_test_wq,"wq_test",DEFERRED_WORK_TEST_WORKER_NUM,MAIN_TASK_PRIORITY) == OS_ERR_OK);
+    deferred_work_test_batch_done = 0;
+    os_size_t start = os_tick_get_ns();
+
+    for(i = 0;i < DEFERRED_WORK_TEST_WORK_NUM;i++)
+    {
+        os_work_init(&deferred_work_test_batch_work[i],deferred_work_test_batch_func,i);
+        os_workqueue_queue(&deferred_work_test_wq,&deferred_work_test_batch_work[i]);
+    }
+
+    os_workqueue_flush(&deferred_work_test_wq);
+    os_size_t ns = (os_tick_get_ns() - start) / DEFERRED_WORK_TEST_WORK_NUM;
+    OS_ASSERT(deferred_work_test_batch_done == DEFERRED_WORK_TEST_WORK_NUM);
+    os_printf("deferred work: %ld workers,queue and flush = %ldns per work\n",(os_size_t)DEFERRED_WORK_TEST_WORKER_NUM,ns);
+    os_bh_print_info();
+    os_workqueue_print_info(os_workqueue_get_system());
+    os_workqueue_print_info(&deferred_work_test_wq);
+}
+
+//仿cyclictest的唤醒延迟测试，最高优先级的测量任务反复通过定时器睡眠1个tick，由定时器回调（时钟中断上下文）记录时刻并唤醒测量任务，
+//统计从唤醒到测量任务开始运行的延迟分布，同时运行若干个负载任务反复创建和销毁任务、申请和释放内存，以制造较长的内核路径
+#define CYCLICTEST_LOOP_NUM 1000
+#define CYCLICTEST_LOAD_TASK_NUM 4
+#define CYCLICTEST_HIST_BUCKET_NS 10000
+#define CYCLICTEST_HIST_BUCKET_NUM 100
+
+static os_task_t cyclictest_task;
+static os_task_t cyclictest_load_task[CYCLICTEST_LOAD_TASK_NUM];
+static os_timer_t cyclictest_timer;
+static os_waitqueue_t cyclictest_waitqueue;
+static volatile os_size_t cyclictest_wakeup_ns;
+static volatile os_bool_t cyclictest_stop;
+static volatile os_size_t cyclictest_finished;
+static os_size_t cyclictest_hist[CYCLICTEST_HIST_BUCKET_NUM];
+
+static void cyclictest_timer_func(os_size_t arg)
+{
+    cyclictest_wakeup_ns = os_tick_get_ns();
+    os_task_wakeup(&cyclictest_task);
+}
+
+static os_ssize_t cyclictest_load_entry(os_size_t arg)
+{
+    while(!cyclictest_stop)
+    {
+        os_task_p task = os_task_alloc();
+        void *mem = os_memory_alloc(65536);
+
+        if(task != OS_NULL)
+        {
+            if(os_task_init(task,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 1,MAIN_TASK_TICK_INIT,cyclictest_load_entry,0,"cyclictest_dummy") == OS_ERR_OK)
+            {
+                os_task_remove(task);
+            }
+            else
+            {
+                os_task_free(task);
+            }
+        }
+
+        if(mem != OS_NULL)
+        {
+            os_memory_free(mem);
+        }
+    }
+
+    __atomic_add_fetch(&cyclictest_finished,1,__ATOMIC_RELAXED);
+    os_waitqueue_wakeup(&cyclictest_waitqueue);
+    return 0;
+}
+
+static os_ssize_t cyclictest_entry(os_size_t arg)
+{
+    os_size_t i;
+    os_size_t min = OS_NUMBER_MAX(os_size_t);
+    os_size_t max = 0;
+    os_size_t total = 0;
+
+    for(i = 0;i < CYCLICTEST_LOOP_NUM;i++)
+    {
+        OS_ENTER_CRITICAL_AREA();
+        os_timer_start(&cyclictest_timer,1);
+        os_task_sleep();
+        OS_LEAVE_CRITICAL_AREA();
+
+        os_size_t latency = os_tick_get_ns() - cyclictest_wakeup_ns;
+        min = MIN(min,latency);
+        max = MAX(max,latency);
+        total += latency;
+        cyclictest_hist[MIN(latency / CYCLICTEST_HIST_BUCKET_NS,CYCLICTEST_HIST_BUCKET_NUM - 1)]++;
+    }
+
+    os_printf("cyclictest: %ld loops,%ld load tasks,min = %ldns,avg = %ldns,max = %ldns\n",(os_size_t)CYCLICTEST_LOOP_NUM,(os_size_t)CYCLICTEST_LOAD_TASK_NUM,min,total / CYCLICTEST_LOOP_NUM,max);
+
+    for(i = 0;i < CYCLICTEST_HIST_BUCKET_NUM;i++)
+    {
+        if(cyclictest_hist[i] > 0)
+        {
+            os_printf("cyclictest: %s%ldus: %ld\n",(i == (CYCLICTEST_HIST_BUCKET_NUM - 1)) ? ">=" : "<",((i == (CYCLICTEST_HIST_BUCKET_NUM - 1)) ? i : (i + 1)) * (CYCLICTEST_HIST_BUCKET_NS / 1000),cyclictest_hist[i]);
+        }
+    }
+
+    cyclictest_stop = OS_TRUE;
+    __atomic_add_fetch(&cyclictest_finished,1,__ATOMIC_RELAXED);
+    os_waitqueue_wakeup(&cyclictest_waitqueue);
+    return 0;
+}
+
+static void cyclictest()
+{
+    os_size_t i;
+
+    os_timer_init(&cyclictest_timer,cyclictest_timer_func,0);
+    os_timer_set_slack(&cyclictest_timer,0);
+    os_waitqueue_init(&cyclictest_waitqueue);
+    os_memset(cyclictest_hist,0,sizeof(cyclictest_hist));
+    cyclictest_stop = OS_FALSE;
+    cyclictest_finished = 0;
+
+    for(i = 0;i < CYCLICTEST_LOAD_TASK_NUM;i++)
+    {
+        OS_ASSERT(os_task_init(&cyclictest_load_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY + 1,MAIN_TASK_TICK_INIT,cyclictest_load_entry,i,"cyclictest_load") == OS_ERR_OK);
+        os_task_startup(&cyclictest_load_task[i]);
+    }
+
+    OS_ASSERT(os_task_init(&cyclictest_task,MAIN_TASK_STACK_SIZE,0,MAIN_TASK_TICK_INIT,cyclictest_entry,0,"cyclictest") == OS_ERR_OK);
+    os_task_startup(&cyclictest_task);
+
+    OS_ENTER_CRITICAL_AREA();
+
+    while(cyclictest_finished < (CYCLICTEST_LOAD_TASK_NUM + 1))
+    {
+        os_waitqueue_wait(&cyclictest_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    os_task_print_runqueue_info();
+}
+
+//有界缓冲区生产者消费者测试，统计条件变量的吞吐量，唤醒在持有互斥锁时进行，等待任务会被直接移动到互斥锁的等待队列中
+#define COND_TEST_TASK_NUM 4
+#define COND_TEST_ITEM_NUM 10000
+#define COND_TEST_BUFFER_SIZE 16
+
+static os_task_t cond_test_producer_task[COND_TEST_TASK_NUM];
+static os_task_t cond_test_consumer_task[COND_TEST_TASK_NUM];
+static os_mutex_t cond_test_mutex;
+static os_cond_t cond_test_not_full;
+static os_cond_t cond_test_not_empty;
+static os_size_t cond_test_buffer[COND_TEST_BUFFER_SIZE];
+static os_size_t cond_test_head;
+static os_size_t cond_test_count;
+static os_size_t cond_test_sum;
+static volatile os_size_t cond_test_finished;
+static os_waitqueue_t cond_test_waitqueue;
+
+static void cond_test_finish()
+{
+    OS_ENTER_CRITICAL_AREA();
+    cond_test_finished++;
+    os_waitqueue_wakeup(&cond_test_waitqueue);
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+static os_ssize_t cond_test_producer_entry(os_size_t arg)
+{
+    os_size_t i;
+
+    for(i = 0;i < COND_TEST_ITEM_NUM;i++)
+    {
+        os_mutex_lock(&cond_test_mutex);
+
+        while(cond_test_count == COND_TEST_BUFFER_SIZE)
+        {
+            os_cond_wait(&cond_test_not_full,&cond_test_mutex);
+        }
+
+        cond_test_buffer[(cond_test_head + cond_test_count) % COND_TEST_BUFFER_SIZE] = i;
+        cond_test_count++;
+        os_cond_signal(&cond_test_not_empty);
+        os_mutex_unlock(&cond_test_mutex);
+    }
+
+    cond_test_finish();
+    return 0;
+}
+
+static os_ssize_t cond_test_consumer_entry(os_size_t arg)
+{
+    os_size_t i;
+
+    for(i = 0;i < COND_TEST_ITEM_NUM;i++)
+    {
+        os_mutex_lock(&cond_test_mutex);
+
+        while(cond_test_count == 0)
+        {
+            os_cond_wait(&cond_test_not_empty,&cond_test_mutex);
+        }
+
+        cond_test_sum += cond_test_buffer[cond_test_head];
+        cond_test_head = (cond_test_head + 1) % COND_TEST_BUFFER_SIZE;
+        cond_test_count--;
+        os_cond_signal(&cond_test_not_full);
+        os_mutex_unlock(&cond_test_mutex);
+    }
+
+    cond_test_finish();
+    return 0;
+}
+
+static void cond_test()
+{
+    os_size_t i;
+
+    os_mutex_init(&cond_test_mutex);
+    os_cond_init(&cond_test_not_full);
+    os_cond_init(&cond_test_not_empty);
+    os_waitqueue_init(&cond_test_waitqueue);
+    cond_test_head = 0;
+    cond_test_count = 0;
+    cond_test_sum = 0;
+    cond_test_finished = 0;
+
+    //超时等待必须重新持有互斥锁后返回
+    os_mutex_lock(&cond_test_mutex);
+    OS_ASSERT(os_cond_wait_timeout(&cond_test_not_empty,&cond_test_mutex,1) == -OS_ERR_ETIMEDOUT);
+    OS_ASSERT(os_mutex_get_owner(&cond_test_mutex) == os_task_get_current_task());
+    os_mutex_unlock(&cond_test_mutex);
+
+    os_size_t start = os_tick_get_ns();
+
+    for(i = 0;i < COND_TEST_TASK_NUM;i++)
+    {
+        OS_ASSERT(os_task_init(&cond_test_producer_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,cond_test_producer_entry,i,"cond_test_producer") == OS_ERR_OK);
+        OS_ASSERT(os_task_init(&cond_test_consumer_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,cond_test_consumer_entry,i,"cond_test_consumer") == OS_ERR_OK);
+        os_task_startup(&cond_test_producer_task[i]);
+        os_task_startup(&cond_test_consumer_task[i]);
+    }
+
+    OS_ENTER_CRITICAL_AREA();
+
+    while(cond_test_finished < (COND_TEST_TASK_NUM << 1))
+    {
+        os_waitqueue_wait(&cond_test_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+
+    os_size_t ns = MAX(os_tick_get_ns() - start,1);
+    os_size_t item_num = COND_TEST_TASK_NUM * COND_TEST_ITEM_NUM;
+    OS_ASSERT(cond_test_sum == (COND_TEST_TASK_NUM * ((COND_TEST_ITEM_NUM * (COND_TEST_ITEM_NUM - 1)) >> 1)));
+    os_printf("cond_test: %ld producers,%ld consumers,buffer = %ld,%ld items in %ldus,%ld items/s,%ldns per item\n",(os_size_t)COND_TEST_TASK_NUM,(os_size_t)COND_TEST_TASK_NUM,(os_size_t)COND_TEST_BUFFER_SIZE,item_num,ns / 1000,item_num * 1000000000UL / ns,ns / item_num);
+}
+
+//惊群测试，多个任务在同一等待队列中等待令牌，每轮只放入一个令牌，比较唤醒全部非互斥等待任务与只唤醒一个互斥等待任务的开销
+#define HERD_TEST_TASK_NUM 32
+#define HERD_TEST_ROUND_NUM 1000
+
+static os_task_t herd_test_task[HERD_TEST_TASK_NUM];
+static os_waitqueue_t herd_test_waitqueue;
+static os_waitqueue_t herd_test_done_waitqueue;
+static volatile os_size_t herd_test_token;
+static volatile os_bool_t herd_test_exclusive;
+static volatile os_size_t herd_test_wakeup_num;
+
+static os_ssize_t herd_test_entry(os_size_t arg)
+{
+    OS_ENTER_CRITICAL_AREA();
+
+    while(1)
+    {
+        if(herd_test_token > 0)
+        {
+            herd_test_token--;
+            os_waitqueue_wakeup(&herd_test_done_waitqueue);
+        }
+        else if(herd_test_exclusive)
+        {
+            os_waitqueue_wait_exclusive(&herd_test_waitqueue);
+            herd_test_wakeup_num++;
+        }
+        else
+        {
+            os_waitqueue_wait(&herd_test_waitqueue);
+            herd_test_wakeup_num++;
+        }
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return 0;
+}
+
+static void herd_test_wait_sleeping()
+{
+    os_size_t i;
+
+    for(i = 0;i < HERD_TEST_TASK_NUM;i++)
+    {
+        while(herd_test_task[i].task_state != OS_TASK_STATE_SLEEPING)
+        {
+            os_task_yield();
+        }
+    }
+}
+
+static void herd_test_set_exclusive(os_bool_t exclusive)
+{
+    //唤醒所有测试任务，使其按新的方式重新等待
+    OS_ENTER_CRITICAL_AREA();
+    herd_test_exclusive = exclusive;
+    os_waitqueue_wakeup_all(&herd_test_waitqueue);
+    OS_LEAVE_CRITICAL_AREA();
+    herd_test_wait_sleeping();
+}
+
+static void herd_test_run(os_bool_t exclusive,const char *name)
+{
+    os_size_t i;
+
+    herd_test_set_exclusive(exclusive);
+    OS_ENTER_CRITICAL_AREA();
+    herd_test_wakeup_num = 0;
+    os_size_t start = os_tick_get_ns();
+
+    for(i = 0;i < HERD_TEST_ROUND_NUM;i++)
+    {
+        herd_test_token = 1;
+
+        if(exclusive)
+        {
+            os_waitqueue_wakeup_nr(&herd_test_waitqueue,1);
+        }
+        else
+        {
+            os_waitqueue_wakeup_all(&herd_test_waitqueue);
+        }
+
+        while(herd_test_token > 0)
+        {
+            os_waitqueue_wait(&herd_test_done_waitqueue);
+        }
+    }
+
+    os_size_t ns = os_tick_get_ns() - start;
+    OS_LEAVE_CRITICAL_AREA();
+    herd_test_wait_sleeping();
+    os_printf("herd_test[%s]: %ld waiters,%ld rounds,%ldns per round,%ld wakeups,%ld wasted wakeups\n",name,(os_size_t)HERD_TEST_TASK_NUM,(os_size_t)HERD_TEST_ROUND_NUM,ns / HERD_TEST_ROUND_NUM,herd_test_wakeup_num,herd_test_wakeup_num - HERD_TEST_ROUND_NUM);
+}
+
+static void herd_test()
+{
+    os_size_t i;
+
+    os_waitqueue_init(&herd_test_waitqueue);
+    os_waitqueue_init(&herd_test_done_waitqueue);
+    herd_test_token = 0;
+    herd_test_exclusive = OS_FALSE;
+
+    for(i = 0;i < HERD_TEST_TASK_NUM;i++)
+    {
+        OS_ASSERT(os_task_init(&herd_test_task[i],MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,herd_test_entry,i,"herd_test") == OS_ERR_OK);
+        os_task_startup(&herd_test_task[i]);
+    }
+
+    herd_test_run(OS_FALSE,"wakeup_all");
+    herd_test_run(OS_TRUE,"exclusive");
+}
+
+//VFS并行查找测试，1至hart数个任务同时反复对同一文件执行stat和open/close，统计总吞吐量及相对单任务的加速比
+#define VFS_LOOKUP_TEST_ROUND_NUM 1000
+#define VFS_LOOKUP_TEST_PATH "/test.elf"
+
+static parallel_test_t vfs_lookup_test_parallel;
+
+static void vfs_lookup_test_func(os_size_t id)
+{
+    os_file_state_t state;
+    os_file_fd_t fd;
+    os_size_t i;
+
+    for(i = 0;i < VFS_LOOKUP_TEST_ROUND_NUM;i++)
+    {
+        OS_ASSERT(os_vfs_stat(VFS_LOOKUP_TEST_PATH,&state) == OS_ERR_OK);
+        OS_ASSERT(os_file_open(&fd,VFS_LOOKUP_TEST_PATH,OS_FILE_FLAG_RDONLY) == OS_ERR_OK);
+        OS_ASSERT(os_file_close(&fd) == OS_ERR_OK);
+    }
+}
+
+static void vfs_lookup_test()
+{
+    os_size_t hart_num = os_hart_get_online_num();
+    os_size_t base_ns = 0;
+    os_size_t n;
+
+    parallel_test_init(&vfs_lookup_test_parallel,hart_num,MAIN_TASK_STACK_SIZE,vfs_lookup_test_func,"vfs_lookup_test");
+
+    for(n = 1;n <= hart_num;n++)
+    {
+        os_size_t ns = parallel_test_run(&vfs_lookup_test_parallel,n,OS_NULL);
+
+        if(n == 1)
+        {
+            base_ns = ns;
+        }
+
+        os_size_t op_num = n * VFS_LOOKUP_TEST_ROUND_NUM * 2;
+        os_size_t speedup = base_ns * n * 100 / ns;
+        os_printf("vfs lookup: %ld tasks,%ld stat+open/close pairs in %ldus,%ld ops/s,throughput speedup = %ld.%02ld\n",n,op_num >> 1,ns / 1000,op_num * 1000000000UL / ns,speedup / 100,speedup % 100);
+    }
+}
+
+//RCU查找测试，1至hart数个任务同时反复通过pid查找任务并按名称查找设备，读者不加锁，统计单次查找延迟及相对单任务的加速比
+#define RCU_LOOKUP_TEST_ROUND_NUM 10000
+#define RCU_LOOKUP_TEST_DEVICE_NAME "console"
+
+static parallel_test_t rcu_lookup_test_parallel;
+
+static void rcu_lookup_test_func(os_size_t id)
+{
+    os_task_p task = os_task_get_current_task();
+    os_size_t i;
+
+    for(i = 0;i < RCU_LOOKUP_TEST_ROUND_NUM;i++)
+    {
+        OS_ASSERT(os_task_get_task_by_pid(task -> pid) == task);
+        OS_ASSERT(os_device_find(RCU_LOOKUP_TEST_DEVICE_NAME) != OS_NULL);
+    }
+}
+
+static void rcu_lookup_test()
+{
+    os_size_t hart_num = os_hart_get_online_num();
+    os_size_t base_ns = 0;
+    os_size_t n;
+
+    parallel_test_init(&rcu_lookup_test_parallel,hart_num,MAIN_TASK_STACK_SIZE,rcu_lookup_test_func,"rcu_lookup_test");
+
+    for(n = 1;n <= hart_num;n++)
+    {
+        os_size_t ns = parallel_test_run(&rcu_lookup_test_parallel,n,OS_NULL);
+
+        if(n == 1)
+        {
+            base_ns = ns;
+        }
+
+        os_size_t op_num = n * RCU_LOOKUP_TEST_ROUND_NUM * 2;
+        os_size_t speedup = base_ns * n * 100 / ns;
+        os_printf("rcu lookup: %ld tasks,%ld pid+device lookups in %ldus,%ldns per lookup,%ld ops/s,throughput speedup = %ld.%02ld\n",n,op_num,ns / 1000,ns * n / op_num,op_num * 1000000000UL / ns,speedup / 100,speedup % 100);
+    }
+
+    //测量写者等待一个宽限期的时间
+    os_size_t start = os_tick_get_ns();
+    os_rcu_synchronize();
+    os_printf("rcu lookup: synchronize takes %ldns\n",os_tick_get_ns() - start);
+    os_rcu_print_info();
+}
+
+//互斥锁竞争测试，2至16个任务同时反复加锁并在临界区中进行少量计算，分别统计直接移交与抢先策略下的锁吞吐量
+#define MUTEX_CONTENTION_TEST_TASK_NUM 16
+#define MUTEX_CONTENTION_TEST_ROUND_NUM 2000
+#define MUTEX_CONTENTION_TEST_WORK 50
+
+static parallel_test_t mutex_contention_test_parallel;
+static os_mutex_t mutex_contention_test_mutex;
+static volatile os_size_t mutex_contention_test_counter;
+
+static void mutex_contention_test_func(os_size_t id)
+{
+    os_size_t i;
+    volatile os_size_t j;
+
+    for(i = 0;i < MUTEX_CONTENTION_TEST_ROUND_NUM;i++)
+    {
+        os_mutex_lock(&mutex_contention_test_mutex);
+
+        for(j = 0;j < MUTEX_CONTENTION_TEST_WORK;j++);
+
+        mutex_contention_test_counter++;
+        os_mutex_unlock(&mutex_contention_test_mutex);
+
+        for(j = 0;j < MUTEX_CONTENTION_TEST_WORK;j++);
+    }
+}
+
+static void mutex_contention_test_run(os_mutex_policy_t policy,const char *name,os_size_t n)
+{
+    //上一轮的测试任务在通知完成之前已经释放互斥锁，此时可以重新初始化互斥锁
+    os_mutex_init(&mutex_contention_test_mutex);
+    os_mutex_set_policy(&mutex_contention_test_mutex,policy);
+    mutex_contention_test_counter = 0;
+    os_size_t ns = parallel_test_run(&mutex_contention_test_parallel,n,OS_NULL);
+
+    os_size_t op_num = n * MUTEX_CONTENTION_TEST_ROUND_NUM;
+    OS_ASSERT(mutex_contention_test_counter == op_num);
+    os_printf("mutex contention[%s]: %ld tasks,%ld lock/unlock pairs in %ldus,%ld ops/s,sleep = %ld,spin = %ld,handoff = %ld\n",name,n,op_num,ns / 1000,op_num * 1000000000UL / ns,mutex_contention_test_mutex.sleep_count,mutex_contention_test_mutex.spin_count,mutex_contention_test_mutex.handoff_count);
+}
+
+static void mutex_contention_test()
+{
+    os_size_t n;
+
+    parallel_test_init(&mutex_contention_test_parallel,MUTEX_CONTENTION_TEST_TASK_NUM,MAIN_TASK_STACK_SIZE,mutex_contention_test_func,"mutex_contention_test");
+
+    for(n = 2;n <= MUTEX_CONTENTION_TEST_TASK_NUM;n <<= 1)
+    {
+        mutex_contention_test_run(OS_MUTEX_POLICY_HANDOFF,"handoff",n);
+        mutex_contention_test_run(OS_MUTEX_POLICY_STEAL,"steal",n);
+    }
+}
+
 static os_task_t task_user;
 
 extern void *user_entry_code;
@@ -218,6 +1942,24 @@ os_ssize_t os_task_main_entry(os_size_t arg)
     os_printf("mount = %d\n",os_vfs_mount("/dev","devfs",OS_NULL,OS_FILE_FLAG_RDONLY,OS_NULL));
 
     os_mutex_init(&mutex);
+    //task_switch_test();
+    //fpu_switch_test();
+    //trap_roundtrip_test();
+    //smp_scaling_test();
+    //fair_sched_test();
+    //deadline_sched_test();
+    //pi_mutex_test();
+    //clone_latency_test();
+    //many_task_test();
+    //pid_alloc_test();
+    //exit_reap_test();
+    //deferred_work_test();
+    //cyclictest();
+    //cond_test();
+    //herd_test();
+    //vfs_lookup_test();
+    //rcu_lookup_test();
+    //mutex_contention_test();
     //os_task_init(&task1,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,task1_entry,0,"task1");
     //os_task_init(&task2,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,task2_entry,0,"task2");
     os_task_init(&task_user,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,os_task_user_entry,OS_MMU_MEMORYMAP_USER_REAL_START,"task_user");
@@ -244,7 +1986,19 @@ os_ssize_t os_task_main_entry(os_size_t arg)
         os_printf("memory:%d/%d\n",os_get_allocated_memory(),os_get_total_memory());
         os_size_t tick = os_tick_get();
         os_task_print_tree(os_task_get_root_task());
+        os_task_print_runqueue_info();
+        os_tick_print_info();
+        os_cputime_print_info();
+        os_task_reaper_print_info();
+        os_bh_print_info();
+        os_workqueue_print_info(os_workqueue_get_system());
+        os_rcu_print_info();
+
+        os_size_t elapsed = os_tick_get() - tick;
 
-        while((os_tick_get() - tick) < TICK_PER_SECOND);
+        if(elapsed < TICK_PER_SECOND)
+        {
+            os_task_sleep_ticks(TICK_PER_SECOND - elapsed);
+        }
     }
 }
\ No newline at end of file
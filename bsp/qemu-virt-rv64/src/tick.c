@@ -6,12 +6,14 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-26     lizhirui     use one-shot timer and derive tick from time counter
+ * 2021-07-27     lizhirui     add tick_get_ns
  */
 
 #include <dreamos.h>
 
-static volatile os_uint64_t time_elapsed = 0;
-static volatile os_uint64_t tick_cycles = 0;
+static os_uint64_t tick_start_time = 0;//系统tick为0时的time计数器值
+static os_uint64_t tick_cycles = 0;//每个tick对应的time计数器周期数
 
 os_uint64_t get_ticks()
 {
@@ -21,17 +23,48 @@ os_uint64_t get_ticks()
     return r;
 }
 
+//主核初始化，记录系统tick的起点，并启动主核的时钟中断
 void tick_init()
 {
-    os_uint64_t interval = 1000ULL / TICK_PER_SECOND;
+    tick_cycles = TICK_TIMEBASE_FREQUENCY / TICK_PER_SECOND;
+    tick_start_time = get_ticks();
+    tick_hart_init();
+}
+
+//每个hart的时钟中断初始化，在下一个tick产生第一次时钟中断
+void tick_hart_init()
+{
     clear_csr(sie,SIP_STIP);
-    tick_cycles = 10000000 / 1000 * interval - 1;
-    sbi_set_timer(get_ticks() + tick_cycles);
+    tick_set_deadline(tick_get() + 1);
     set_csr(sie,SIP_STIP);
 }
 
+//获取当前系统tick，由time计数器换算得到，因此不依赖于时钟中断
+os_size_t tick_get()
+{
+    return (get_ticks() - tick_start_time) / tick_cycles;
+}
+
+//获取系统启动以来经过的纳秒数，精度为time计数器的一个周期
+os_uint64_t tick_get_ns()
+{
+    return (get_ticks() - tick_start_time) * (1000000000ULL / TICK_TIMEBASE_FREQUENCY);
+}
+
+//设置当前hart的下一次时钟中断，时钟中断为单次触发，deadline为OS_TICK_DEADLINE_NONE时不再产生时钟中断
+void tick_set_deadline(os_size_t deadline)
+{
+    if(deadline == OS_TICK_DEADLINE_NONE)
+    {
+        sbi_set_timer(~0ULL);
+    }
+    else
+    {
+        sbi_set_timer(tick_start_time + deadline * tick_cycles);
+    }
+}
+
 void tick_isr()
 {
     os_tick_handler();
-    sbi_set_timer(get_ticks() + tick_cycles);
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-26     lizhirui     add one-shot timer interface
+ * 2021-07-27     lizhirui     add tick_get_ns
  */
 
 #ifndef __TICK_H__
@@ -13,8 +15,15 @@
 
     #include <dreamos.h>
 
+    //time计数器频率，见virt.dts中的timebase-frequency
+    #define TICK_TIMEBASE_FREQUENCY (10000000ULL)
+
     os_uint64_t get_ticks();
     void tick_init();
+    void tick_hart_init();
+    os_size_t tick_get();
+    os_uint64_t tick_get_ns();
+    void tick_set_deadline(os_size_t deadline);
     void tick_isr();
 
 #endif
\ No newline at end of file
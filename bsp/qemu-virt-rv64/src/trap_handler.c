@@ -6,6 +6,9 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-22     lizhirui     add external interrupt support
+ * 2021-07-26     lizhirui     add inter-processor interrupt support
+ * 2021-07-26     lizhirui     reprogram tick after inter-processor interrupt
  */
 
 #include <dreamos.h>
@@ -20,6 +23,24 @@ os_bool_t bsp_interrupt_handler(enum interrupt_type interrupt_type)
         os_leave_interrupt();
         return OS_TRUE;
     }
+    else if(interrupt_type == INTERRUPT_SUPERVISOR_EXTERNAL)
+    {
+        os_enter_interrupt();
+        plic_isr();
+        os_leave_interrupt();
+        return OS_TRUE;
+    }
+    else if(interrupt_type == INTERRUPT_SUPERVISOR_SOFTWARE)
+    {
+        //其它hart发送的IPI，用于通知当前hart重新调度
+        os_enter_interrupt();
+        clear_csr(sip,SIP_SSIP);
+        os_task_schedule();
+        //目标hart可能刚结束空闲，或者有新的定时器需要由主核处理
+        os_tick_program_next();
+        os_leave_interrupt();
+        return OS_TRUE;
+    }
 
     return OS_FALSE;
 }
\ No newline at end of file
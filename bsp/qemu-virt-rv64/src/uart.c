@@ -0,0 +1,343 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-22     lizhirui     the first version
+ * 2021-07-28     lizhirui     protect polled output with its own spinlock instead of the big kernel lock
+ */
+
+#include <dreamos.h>
+
+static volatile os_size_t uart_hwbase = 0;
+
+#define RHR 0    // Receive Holding Register (read mode)
+#define THR 0    // Transmit Holding Register (write mode)
+#define DLL 0    // LSB of Divisor Latch (write mode)
+#define IER 1    // Interrupt Enable Register (write mode)
+#define DLM 1    // MSB of Divisor Latch (write mode)
+#define FCR 2    // FIFO Control Register (write mode)
+#define ISR 2    // Interrupt Status Register (read mode)
+#define LCR 3    // Line Control Register
+#define MCR 4    // Modem Control Register
+#define LSR 5    // Line Status Register
+#define MSR 6    // Modem Status Register
+#define SPR 7    // ScratchPad Register
+
+#define UART_REG(reg) ((volatile uint8_t *)(uart_hwbase + reg))
+
+#define IER_RX_ENABLE (1 << 0)
+#define IER_TX_ENABLE (1 << 1)
+
+#define FCR_FIFO_ENABLE (1 << 0)
+#define FCR_FIFO_CLEAR  (3 << 1)
+
+#define ISR_NO_INTERRUPT (1 << 0)
+#define ISR_ID_MASK      (0x0E)
+#define ISR_ID_TX_EMPTY  (0x02)
+#define ISR_ID_RX_READY  (0x04)
+#define ISR_ID_RX_LINE   (0x06)
+#define ISR_ID_RX_TIMEOUT (0x0C)
+
+#define LSR_RX_READY (1 << 0)
+#define LSR_TX_IDLE  (1 << 5)
+
+#define uart_read_reg(reg) (*(UART_REG(reg)))
+#define uart_write_reg(reg, v) (*(UART_REG(reg)) = (v))
+
+//发送缓冲区，tx_head由写入者推进，tx_tail由发送中断推进，两者均单调递增
+static char uart_tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile os_size_t uart_tx_head = 0;
+static volatile os_size_t uart_tx_tail = 0;
+static os_waitqueue_t uart_tx_waitqueue;
+
+//接收缓冲区，rx_head由接收中断推进，rx_tail由读取者推进，两者均单调递增
+static char uart_rx_buffer[UART_RX_BUFFER_SIZE];
+static volatile os_size_t uart_rx_head = 0;
+static volatile os_size_t uart_rx_tail = 0;
+static volatile os_size_t uart_rx_dropped = 0;
+static os_waitqueue_t uart_rx_waitqueue;
+
+static volatile os_uint8_t uart_ier = 0;
+
+//轮询输出锁，轮询输出可能在持有任务树锁等内层锁时被调用，因此不能获取内核大锁
+static os_spinlock_t uart_polled_lock = OS_SPINLOCK_INIT;
+
+/*!
+ * UART初始化函数，配置波特率、8N1格式并使能FIFO，此时中断尚未开启
+ * @param hwbase UART寄存器的虚拟地址
+ */
+void uart_init(os_size_t hwbase)
+{
+    uart_hwbase = hwbase;
+
+    uart_write_reg(IER, 0x00);
+
+    uint8_t lcr = uart_read_reg(LCR);
+    uart_write_reg(LCR, lcr | (1 << 7));
+    uart_write_reg(DLL, 0x03);
+    uart_write_reg(DLM, 0x00);
+
+    lcr = 0;
+    uart_write_reg(LCR, lcr | (3 << 0));
+    uart_write_reg(FCR, FCR_FIFO_ENABLE | FCR_FIFO_CLEAR);
+}
+
+/*!
+ * 指示UART是否已初始化
+ * @return 已初始化返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t uart_is_initialized()
+{
+    return uart_hwbase != 0;
+}
+
+/*!
+ * 以轮询方式输出字符串，每次发送FIFO为空时连续写入UART_FIFO_SIZE个字符，可在任意上下文中调用，用于内核日志输出
+ * @param str 字符串指针
+ */
+void uart_puts_polled(const char *str)
+{
+    while(*str)
+    {
+        os_bool_t interrupt_state = os_interrupt_disable();
+        os_spinlock_lock(&uart_polled_lock);
+        os_size_t i;
+
+        while((uart_read_reg(LSR) & LSR_TX_IDLE) == 0);
+
+        for(i = 0;(i < UART_FIFO_SIZE) && *str;i++)
+        {
+            uart_write_reg(THR,*str++);
+        }
+
+        os_spinlock_unlock(&uart_polled_lock);
+        os_interrupt_enable(interrupt_state);
+    }
+}
+
+/*!
+ * 将发送缓冲区中的数据填入发送FIFO，缓冲区为空时关闭发送中断，调用者必须关闭中断
+ */
+static void uart_tx_fill()
+{
+    os_size_t i = 0;
+
+    if(uart_read_reg(LSR) & LSR_TX_IDLE)
+    {
+        for(;(i < UART_FIFO_SIZE) && (uart_tx_tail != uart_tx_head);i++)
+        {
+            uart_write_reg(THR,uart_tx_buffer[uart_tx_tail & (UART_TX_BUFFER_SIZE - 1)]);
+            uart_tx_tail++;
+        }
+    }
+
+    //缓冲区仍有数据时开启发送中断，在FIFO为空时继续发送
+    if(uart_tx_tail == uart_tx_head)
+    {
+        uart_ier &= ~IER_TX_ENABLE;
+    }
+    else
+    {
+        uart_ier |= IER_TX_ENABLE;
+    }
+
+    uart_write_reg(IER,uart_ier);
+
+    //发送缓冲区有了空闲空间，唤醒等待的写入者
+    if((i > 0) && !os_waitqueue_empty(&uart_tx_waitqueue))
+    {
+        os_waitqueue_wakeup(&uart_tx_waitqueue);
+    }
+}
+
+/*!
+ * 将接收FIFO中的数据全部读入接收缓冲区，缓冲区满时丢弃数据，调用者必须关闭中断
+ */
+static void uart_rx_drain()
+{
+    os_bool_t received = OS_FALSE;
+
+    while(uart_read_reg(LSR) & LSR_RX_READY)
+    {
+        char ch = uart_read_reg(RHR);
+
+        if((uart_rx_head - uart_rx_tail) < UART_RX_BUFFER_SIZE)
+        {
+            uart_rx_buffer[uart_rx_head & (UART_RX_BUFFER_SIZE - 1)] = ch;
+            uart_rx_head++;
+            received = OS_TRUE;
+        }
+        else
+        {
+            uart_rx_dropped++;
+        }
+    }
+
+    if(received && !os_waitqueue_empty(&uart_rx_waitqueue))
+    {
+        os_waitqueue_wakeup(&uart_rx_waitqueue);
+    }
+}
+
+/*!
+ * UART中断处理函数
+ * @param irq 中断号
+ */
+static void uart_isr(os_size_t irq)
+{
+    os_uint8_t isr;
+
+    while(!((isr = uart_read_reg(ISR)) & ISR_NO_INTERRUPT))
+    {
+        switch(isr & ISR_ID_MASK)
+        {
+            case ISR_ID_RX_READY:
+            case ISR_ID_RX_TIMEOUT:
+                uart_rx_drain();
+                break;
+
+            case ISR_ID_TX_EMPTY:
+                uart_tx_fill();
+                break;
+
+            case ISR_ID_RX_LINE:
+                uart_read_reg(LSR);
+                break;
+
+            default:
+                uart_read_reg(MSR);
+                break;
+        }
+    }
+}
+
+/*!
+ * 控制台设备初始化，开启UART接收中断
+ * @param dev 设备结构体指针
+ * @return 成功返回OS_ERR_OK
+ */
+static os_err_t console_init(os_device_p dev)
+{
+    OS_ENTER_CRITICAL_AREA();
+    os_waitqueue_init(&uart_tx_waitqueue);
+    os_waitqueue_init(&uart_rx_waitqueue);
+    plic_irq_register(PLIC_IRQ_UART0,uart_isr);
+    uart_ier = IER_RX_ENABLE;
+    uart_write_reg(IER,uart_ier);
+    plic_irq_enable(PLIC_IRQ_UART0);
+    OS_LEAVE_CRITICAL_AREA();
+    return OS_ERR_OK;
+}
+
+/*!
+ * 控制台设备打开，控制台被stdin/stdout/stderr以不同方式共享打开，因此始终以读写方式工作
+ * @param dev 设备结构体指针
+ * @param open_flag 打开标志
+ * @return 成功返回OS_ERR_OK
+ */
+static os_err_t console_open(os_device_p dev,os_size_t open_flag)
+{
+    dev -> open_flag = OS_FILE_FLAG_RDWR;
+    return OS_ERR_OK;
+}
+
+/*!
+ * 控制台设备读取，接收缓冲区为空时阻塞，直到至少收到一个字符
+ * @param dev 设备结构体指针
+ * @param buf 数据缓冲区
+ * @param pos 读指针位置（忽略）
+ * @param size 数据大小
+ * @return 返回读取的字节数
+ */
+static os_err_t console_read(os_device_p dev,void *buf,os_size_t pos,os_size_t size)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_size_t i;
+
+    if(size == 0)
+    {
+        return 0;
+    }
+
+    OS_ENTER_CRITICAL_AREA();
+
+    while(uart_rx_head == uart_rx_tail)
+    {
+        os_waitqueue_wait(&uart_rx_waitqueue);
+    }
+
+    for(i = 0;(i < size) && (uart_rx_tail != uart_rx_head);i++)
+    {
+        ((char *)buf)[i] = uart_rx_buffer[uart_rx_tail & (UART_RX_BUFFER_SIZE - 1)];
+        uart_rx_tail++;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return i;
+}
+
+/*!
+ * 控制台设备写入，数据写入发送缓冲区后由发送中断异步输出，缓冲区满时阻塞
+ * @param dev 设备结构体指针
+ * @param buf 数据缓冲区
+ * @param pos 写指针位置（忽略）
+ * @param size 数据大小
+ * @return 返回写入的字节数
+ */
+static os_err_t console_write(os_device_p dev,const void *buf,os_size_t pos,os_size_t size)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    const char *str = (const char *)buf;
+    os_size_t i = 0;
+
+    OS_ENTER_CRITICAL_AREA();
+
+    while(i < size)
+    {
+        while((uart_tx_head - uart_tx_tail) == UART_TX_BUFFER_SIZE)
+        {
+            os_waitqueue_wait(&uart_tx_waitqueue);
+        }
+
+        while((i < size) && ((uart_tx_head - uart_tx_tail) < UART_TX_BUFFER_SIZE))
+        {
+            uart_tx_buffer[uart_tx_head & (UART_TX_BUFFER_SIZE - 1)] = str[i++];
+            uart_tx_head++;
+        }
+
+        //若发送中断尚未开启，则直接填充FIFO启动发送
+        if(!(uart_ier & IER_TX_ENABLE))
+        {
+            uart_tx_fill();
+        }
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return size;
+}
+
+static os_device_ops_t console_ops =
+{
+    .init = console_init,
+    .open = console_open,
+    .read = console_read,
+    .write = console_write
+};
+
+static os_device_t dev_console =
+{
+    .name = "console",
+    .flag = OS_DEVICE_FLAG_SELF_LOCK,
+    .ops = &console_ops
+};
+
+/*!
+ * 注册控制台设备
+ */
+void uart_console_register()
+{
+    os_device_register(&dev_console);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-22     lizhirui     the first version
+ */
+
+#ifndef __UART_H__
+#define __UART_H__
+
+    #include <dreamos.h>
+
+    #define UART_BASE (0x10000000L)
+
+    //UART硬件FIFO深度
+    #define UART_FIFO_SIZE (16)
+    //UART软件发送/接收缓冲区大小（必须为2的幂）
+    #define UART_TX_BUFFER_SIZE (1024)
+    #define UART_RX_BUFFER_SIZE (256)
+
+    void uart_init(os_size_t hwbase);
+    os_bool_t uart_is_initialized();
+    void uart_puts_polled(const char *str);
+    void uart_console_register();
+
+#endif
\ No newline at end of file
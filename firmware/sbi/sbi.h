@@ -47,6 +47,50 @@
 #define	SBI_REMOTE_SFENCE_VMA_ASID	7
 #define	SBI_SHUTDOWN			8
 
+/* SBI v0.2+ standard error codes */
+#define	SBI_SUCCESS			0
+#define	SBI_ERR_FAILED			-1
+#define	SBI_ERR_NOT_SUPPORTED		-2
+#define	SBI_ERR_INVALID_PARAM		-3
+#define	SBI_ERR_DENIED			-4
+#define	SBI_ERR_INVALID_ADDRESS		-5
+
+/* SBI Specification Version */
+#define	SBI_SPEC_VERS_MAJOR_OFFSET	24
+#define	SBI_SPEC_VERS_MAJOR_MASK	(0x7F << SBI_SPEC_VERS_MAJOR_OFFSET)
+#define	SBI_SPEC_VERS_MINOR_OFFSET	0
+#define	SBI_SPEC_VERS_MINOR_MASK	(0xFFFFFF << SBI_SPEC_VERS_MINOR_OFFSET)
+
+/* SBI Base Extension */
+#define	SBI_EXT_ID_BASE			0x10
+#define	SBI_BASE_GET_SPEC_VERSION	0
+#define	SBI_BASE_GET_IMPL_ID		1
+#define	SBI_BASE_GET_IMPL_VERSION	2
+#define	SBI_BASE_PROBE_EXTENSION	3
+
+/* Debug Console Extension */
+#define	SBI_EXT_ID_DBCN			0x4442434E
+#define	SBI_DBCN_CONSOLE_WRITE		0
+#define	SBI_DBCN_CONSOLE_READ		1
+#define	SBI_DBCN_CONSOLE_WRITE_BYTE	2
+
+/* Hart State Management (HSM) Extension */
+#define	SBI_EXT_ID_HSM			0x48534D
+#define	SBI_HSM_HART_START		0
+#define	SBI_HSM_HART_STOP		1
+#define	SBI_HSM_HART_STATUS		2
+
+/* HSM hart states */
+#define	SBI_HSM_STATUS_STARTED		0
+#define	SBI_HSM_STATUS_STOPPED		1
+#define	SBI_HSM_STATUS_START_PENDING	2
+#define	SBI_HSM_STATUS_STOP_PENDING	3
+
+struct sbi_ret {
+	long error;
+	long value;
+};
+
 /*
  * Documentation available at
  * https://github.com/riscv/riscv-sbi-doc/blob/master/riscv-sbi.md
@@ -71,6 +115,100 @@ sbi_call(uint64_t arg7, uint64_t arg0, uint64_t arg1, uint64_t arg2,
 	return (a0);
 }
 
+/*
+ * SBI v0.2+ calling convention: extension id in a7, function id in a6,
+ * error code returned in a0 and value in a1.
+ */
+static __inline struct sbi_ret
+sbi_ecall(uint64_t ext, uint64_t fid, uint64_t arg0, uint64_t arg1,
+    uint64_t arg2)
+{
+	struct sbi_ret ret;
+
+	register uintptr_t a0 __asm ("a0") = (uintptr_t)(arg0);
+	register uintptr_t a1 __asm ("a1") = (uintptr_t)(arg1);
+	register uintptr_t a2 __asm ("a2") = (uintptr_t)(arg2);
+	register uintptr_t a6 __asm ("a6") = (uintptr_t)(fid);
+	register uintptr_t a7 __asm ("a7") = (uintptr_t)(ext);
+
+	__asm __volatile(			\
+		"ecall"				\
+		:"+r"(a0), "+r"(a1)		\
+		:"r"(a2), "r"(a6), "r"(a7)	\
+		:"memory");
+
+	ret.error = a0;
+	ret.value = a1;
+	return (ret);
+}
+
+/* Returns the SBI specification version, or 0 for legacy (v0.1) firmware. */
+static __inline long
+sbi_get_spec_version(void)
+{
+	struct sbi_ret ret;
+
+	ret = sbi_ecall(SBI_EXT_ID_BASE, SBI_BASE_GET_SPEC_VERSION, 0, 0, 0);
+	if (ret.error != SBI_SUCCESS)
+		return (0);
+
+	return (ret.value);
+}
+
+/* Returns non-zero if the extension is implemented. */
+static __inline long
+sbi_probe_extension(long id)
+{
+	struct sbi_ret ret;
+
+	ret = sbi_ecall(SBI_EXT_ID_BASE, SBI_BASE_PROBE_EXTENSION, id, 0, 0);
+	if (ret.error != SBI_SUCCESS)
+		return (0);
+
+	return (ret.value);
+}
+
+/*
+ * Write num_bytes from the physical address base to the debug console.
+ * On success ret.value holds the number of bytes actually written.
+ */
+static __inline struct sbi_ret
+sbi_debug_console_write(unsigned long num_bytes, unsigned long base_addr_lo,
+    unsigned long base_addr_hi)
+{
+
+	return (sbi_ecall(SBI_EXT_ID_DBCN, SBI_DBCN_CONSOLE_WRITE, num_bytes,
+	    base_addr_lo, base_addr_hi));
+}
+
+static __inline struct sbi_ret
+sbi_debug_console_write_byte(uint8_t byte)
+{
+
+	return (sbi_ecall(SBI_EXT_ID_DBCN, SBI_DBCN_CONSOLE_WRITE_BYTE, byte,
+	    0, 0));
+}
+
+/*
+ * Start the hart in supervisor mode at start_addr (a physical address),
+ * with a0 = hart_id and a1 = opaque.
+ */
+static __inline struct sbi_ret
+sbi_hsm_hart_start(unsigned long hart_id, unsigned long start_addr,
+    unsigned long opaque)
+{
+
+	return (sbi_ecall(SBI_EXT_ID_HSM, SBI_HSM_HART_START, hart_id,
+	    start_addr, opaque));
+}
+
+static __inline struct sbi_ret
+sbi_hsm_hart_get_status(unsigned long hart_id)
+{
+
+	return (sbi_ecall(SBI_EXT_ID_HSM, SBI_HSM_HART_STATUS, hart_id, 0, 0));
+}
+
 static __inline void
 sbi_console_putchar(int ch)
 {
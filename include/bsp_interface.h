@@ -6,6 +6,11 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-25     lizhirui     add secondary hart startup interface
+ * 2021-07-26     lizhirui     add inter-processor interrupt interface
+ * 2021-07-26     lizhirui     add one-shot tick interface
+ * 2021-07-27     lizhirui     add nanosecond time interface
+ * 2021-07-28     lizhirui     add remote tlb flush interface
  */
 
 // @formatter:off
@@ -15,5 +20,13 @@
     void bsp_early_init();
     void bsp_after_heap_init();
     void bsp_after_task_scheduler_init();
+    os_bool_t bsp_hart_is_available(os_size_t hart_id);
+    os_err_t bsp_hart_start(os_size_t hart_id,os_size_t opaque);
+    void bsp_hart_secondary_init();
+    void bsp_hart_send_ipi(os_size_t hart_id);
+    void bsp_hart_flush_tlb(os_size_t hart_id,os_size_t va,os_size_t size);
+    os_size_t bsp_tick_get();
+    os_size_t bsp_tick_get_ns();
+    void bsp_tick_set_deadline(os_size_t deadline);
 
 #endif
\ No newline at end of file
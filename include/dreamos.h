@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-25     lizhirui     add hart and spinlock support
  */
 
 // @formatter:off
@@ -22,6 +23,7 @@
     #include <os_elf.h>
     
     #include <os_io.h>
+    #include <os_log.h>
     #include <os_tick.h>
     #include <bsp_interface.h>
     #include <os_string.h>
@@ -32,12 +34,23 @@
     #include <os_annotation.h>
     #include <os_mmu.h>
     #include <os_list.h>
+    #include <os_rcu.h>
     #include <os_bitmap.h>
     #include <os_hashmap.h>
+    #include <os_idr.h>
+    #include <os_spinlock.h>
+    #include <os_rbtree.h>
+    #include <os_timer.h>
+    #include <os_cputime.h>
     #include <os_task.h>
+    #include <os_task_stack.h>
+    #include <os_hart.h>
     #include <os_interrupt.h>
     #include <os_waitqueue.h>
+    #include <os_bh.h>
+    #include <os_workqueue.h>
     #include <os_mutex.h>
+    #include <os_rwsem.h>
     #include <os_device.h>
     #include <os_vfs.h>
     #include <os_syscall.h>
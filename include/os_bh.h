@@ -0,0 +1,40 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_BH_H__
+#define __OS_BH_H__
+
+    #include <dreamos.h>
+
+    //下半部处理函数，在最外层中断退出时开中断执行（仍处于中断上下文，不能睡眠），或在下半部线程中执行
+    typedef void (*os_bh_func_t)(os_size_t arg);
+
+    //下半部结构体，同一个下半部在执行完成之前再次被调度只会再执行一次，且不会在多个hart上同时执行
+    typedef struct os_bh
+    {
+        os_list_node_t node;//等待执行列表中的节点
+        os_bh_func_t func;//处理函数
+        os_size_t arg;//处理函数参数
+        os_size_t raise_time;//被调度的时刻（纳秒），用于统计延迟
+        volatile os_bool_t pending;//是否在等待执行
+        volatile os_bool_t running;//是否正在执行
+    }os_bh_t,*os_bh_p;
+
+    void os_bh_init(os_bh_p bh,os_bh_func_t func,os_size_t arg);
+    os_bool_t os_bh_schedule(os_bh_p bh);
+    os_bool_t os_bh_cancel(os_bh_p bh);
+    void os_bh_interrupt_exit();
+    void os_bh_system_init();
+    void os_bh_startup();
+    os_size_t os_bh_get_pending_num();
+    void os_bh_print_info();
+
+#endif
\ No newline at end of file
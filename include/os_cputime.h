@@ -0,0 +1,36 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-27     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_CPUTIME_H__
+#define __OS_CPUTIME_H__
+
+    #include <dreamos.h>
+
+    struct os_task;
+
+    //hart的CPU时间类型
+    typedef enum os_cputime_type
+    {
+        OS_CPUTIME_USER = 0,//执行用户态代码
+        OS_CPUTIME_SYSTEM,//在任务上下文中执行内核代码
+        OS_CPUTIME_IRQ,//在中断上下文中执行
+        OS_CPUTIME_IDLE,//执行idle任务
+        OS_CPUTIME_TYPE_NUM
+    }os_cputime_type_t;
+
+    void os_cputime_update();
+    void os_cputime_user_enter();
+    void os_cputime_user_exit();
+    void os_cputime_hart_init();
+    void os_cputime_get_task(struct os_task *task,os_size_t *utime,os_size_t *stime);
+    void os_cputime_print_info();
+
+#endif
\ No newline at end of file
@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-24     lizhirui     add FIND_FIRST_SET macro
+ * 2021-07-25     lizhirui     use big kernel lock in critical area
  */
 
 // @formatter:off
@@ -30,6 +32,7 @@
     #define ALIGN_DOWN(value,align_bound) ((value) & (~(align_bound - 1)))
     #define ALIGN_DOWN_MAX(value) ((sizeof(size_t) << 3) - __builtin_clzl(value) - 1)
     #define ALIGN_UP_MIN(value) (IS_POWER_OF_2(value) ? ALIGN_DOWN_MAX(value) : (ALIGN_DOWN_MAX(value) + 1))
+    #define FIND_FIRST_SET(value) ((size_t)__builtin_ctzl(value))
 
     #define DIV_UP(a,b) (((a) + (b) - 1) / (b))
 
@@ -72,7 +75,8 @@
 
     #include <os_err.h>
 
-    #define OS_ENTER_CRITICAL_AREA() os_bool_t interrupt_state = os_interrupt_disable()
-    #define OS_LEAVE_CRITICAL_AREA() os_interrupt_enable(interrupt_state)
+    //临界区会关闭当前hart的中断并获取内核大锁
+    #define OS_ENTER_CRITICAL_AREA() os_bool_t interrupt_state = os_enter_critical_area()
+    #define OS_LEAVE_CRITICAL_AREA() os_leave_critical_area(interrupt_state)
 
 #endif
\ No newline at end of file
@@ -6,6 +6,9 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
+ * 2021-07-22     lizhirui     add self lock device flag
+ * 2021-07-28     lizhirui     add device unregister
+ * 2021-07-28     lizhirui     add os_device_get and os_device_put
  */
 
 // @formatter:off
@@ -16,6 +19,9 @@
 
     typedef struct os_device os_device_t,*os_device_p;
 
+    //设备标志：设备自行处理读写操作的并发控制，os_device_op_read/os_device_op_write不再持有设备锁
+    #define OS_DEVICE_FLAG_SELF_LOCK (1 << 0)
+
     //设备操作函数集结构体
     typedef struct os_device_ops
     {
@@ -73,7 +79,7 @@
         os_bool_t initialized;//指示设备是否已初始化
         os_size_t flag;//设备标志
         os_size_t open_flag;//设备打开标志，参见OS_FILE_FLAG_相关标志
-        os_size_t refcnt;//引用数
+        os_size_t refcnt;//引用数，包括打开次数和os_device_get获取的引用，大于0时设备不能被解注册
         os_mutex_t lock;//锁
         void *priv_data;//私有数据
         os_list_node_t node;//列表节点
@@ -82,7 +88,10 @@
 
     os_list_node_p os_device_get_list();
     os_device_p os_device_find(const char *name);
+    os_device_p os_device_get(const char *name);
+    void os_device_put(os_device_p dev);
     os_err_t os_device_register(os_device_p dev);
+    os_err_t os_device_unregister(os_device_p dev);
     os_err_t os_device_op_init(os_device_p dev);
     os_err_t os_device_op_open(os_device_p dev,os_size_t open_flag);
     os_err_t os_device_op_close(os_device_p dev);
@@ -0,0 +1,65 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-25     lizhirui     the first version
+ * 2021-07-26     lizhirui     add tickless state
+ * 2021-07-27     lizhirui     add fpu owner
+ * 2021-07-27     lizhirui     add kernel stack top and trap scratch for trap entry
+ * 2021-07-27     lizhirui     add cpu time accounting
+ * 2021-07-28     lizhirui     use interrupt stack for kernel stack overflow handling
+ * 2021-07-28     lizhirui     add deferred preemption request
+ * 2021-07-28     lizhirui     add rcu quiescent state request
+ */
+
+// @formatter:off
+#ifndef __OS_HART_H__
+#define __OS_HART_H__
+
+    #include <dreamos.h>
+
+    //hart私有数据结构体，每个hart一份，在内核态下通过tp寄存器访问
+    typedef struct os_hart
+    {
+        os_size_t interrupt_stack_top;//中断栈顶，这个必须在结构体的第一项，以方便从核启动汇编程序和trap入口汇编程序访问
+        os_size_t boot_satp;//从核开启MMU时写入satp的值，这个必须在结构体的第二项
+        os_size_t hart_id;//硬件hart编号，这个必须在结构体的第三项，主核的hart编号由启动汇编程序写入
+        os_size_t kernel_stack_top;//当前任务的内核栈顶，从用户态进入trap时直接在该栈上保存上下文，这个必须在结构体的第四项
+        os_size_t trap_scratch;//trap入口汇编程序暂存被中断上下文sp的位置，这个必须在结构体的第五项
+        os_size_t cpu_id;//逻辑处理器编号，主核为0
+        os_size_t interrupt_stack_addr;//中断栈起始地址，中断栈用作启动栈，以及内核栈溢出时保存上下文的栈
+        volatile os_bool_t online;//是否已经上线
+        os_size_t interrupt_nest;//中断嵌套层次，若为0，则表示当前不在中断上下文中
+        os_size_t kernel_lock_depth;//内核大锁的嵌套层次
+        os_task_p current_task;//当前任务
+        os_task_p idle_task;//本hart的idle任务，idle任务与hart绑定，不进入就绪列表
+        //以下三个变量用于在中断中请求任务切换时推迟请求
+        os_bool_t need_lazy_task_switch;//是否有挂起的任务切换请求
+        os_task_p lazy_old_task;//切换来源任务
+        os_task_p lazy_next_task;//切换目标任务
+        os_bool_t need_resched;//当前任务禁止抢占期间被推迟的抢占请求，在重新允许抢占时处理
+        os_size_t preempt_deferred_count;//被推迟的抢占请求次数
+        volatile os_bool_t rcu_need_qs;//当前RCU宽限期是否还在等待本hart经过静止状态
+        os_mmu_vtable_p current_vtable;//当前页表
+        os_task_p fpu_owner;//浮点寄存器中保存的是哪个任务的浮点上下文
+        os_size_t tick_last;//上一次计算时间片时的tick
+        os_size_t tick_deadline;//已设置的下一次时钟中断的tick
+        os_size_t tick_interrupt_count;//时钟中断次数
+        os_size_t idle_wakeup_count;//空闲等待被中断唤醒的次数
+        os_bool_t cputime_user;//是否正在执行用户态代码
+        os_size_t cputime_timestamp;//上一次统计CPU时间的时刻（纳秒）
+        os_size_t cputime[OS_CPUTIME_TYPE_NUM];//各类型的CPU时间（纳秒）
+    }os_hart_t,*os_hart_p;
+
+    void os_hart_init();
+    os_hart_p os_hart_get_current();
+    os_hart_p os_hart_get(os_size_t cpu_id);
+    os_size_t os_hart_get_cpu_id();
+    os_size_t os_hart_get_online_num();
+    void os_hart_startup_secondary();
+    OS_NORETURN void os_hart_secondary_main();
+
+#endif
\ No newline at end of file
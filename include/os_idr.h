@@ -0,0 +1,60 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ * 2021-07-28     lizhirui     add rcu mode for lockless lookup
+ */
+
+// @formatter:off
+#ifndef __OS_IDR_H__
+#define __OS_IDR_H__
+
+    #include <dreamos.h>
+
+    //每个节点的槽位数量等于os_size_t的位数，使每个节点的空闲状态恰好可以用一个os_size_t表示
+    #define OS_IDR_BITS OS_SIZE_T_BITS
+    #define OS_IDR_SLOT_NUM SIZE(OS_IDR_BITS)
+    //树的最大高度，足以覆盖整个os_size_t范围
+    #define OS_IDR_MAX_HEIGHT (((sizeof(os_size_t) << 3) + OS_IDR_BITS - 1) / OS_IDR_BITS)
+    //无效的id
+    #define OS_IDR_NONE OS_NUMBER_MAX(os_size_t)
+
+    //基数树节点，叶子节点的槽位保存用户指针，中间节点的槽位保存子节点指针
+    typedef struct os_idr_node
+    {
+        os_size_t full;//第i位为1表示第i个槽位已被占用（叶子节点）或其子树已满（中间节点）
+        os_size_t count;//已被占用的槽位数（叶子节点）或非空的子节点数（中间节点），为0时节点被释放
+        void *slot[OS_IDR_SLOT_NUM];//槽位
+        os_rcu_head_t rcu;//RCU模式下用于延迟释放节点
+    }os_idr_node_t,*os_idr_node_p;
+
+    //ID分配器，基于基数树，同时提供id分配与id到指针的映射，自身不加锁，由调用者负责同步
+    //RCU模式下os_idr_find可以在RCU读临界区中与修改操作并发执行，被移除的节点在宽限期结束后释放
+    typedef struct os_idr
+    {
+        os_idr_node_p root;//根节点
+        os_idr_node_p spare;//缓存的一个空闲节点，避免id在节点边界附近反复分配释放时频繁申请内存
+        os_size_t height;//树的高度
+        os_size_t start;//可分配的最小id
+        os_size_t end;//可分配的最大id + 1
+        os_size_t next;//循环分配时下一次开始查找的位置
+        os_size_t count;//已分配的id数量
+        os_size_t node_count;//已分配的节点数量（不包含缓存节点）
+        os_bool_t rcu;//是否为RCU模式
+    }os_idr_t,*os_idr_p;
+
+    void os_idr_init(os_idr_p idr,os_size_t start,os_size_t end);
+    void os_idr_init_rcu(os_idr_p idr,os_size_t start,os_size_t end);
+    void os_idr_destroy(os_idr_p idr);
+    os_err_t os_idr_alloc(os_idr_p idr,void *ptr,os_size_t *id);
+    os_err_t os_idr_alloc_cyclic(os_idr_p idr,void *ptr,os_size_t *id);
+    void *os_idr_find(os_idr_p idr,os_size_t id);
+    void *os_idr_replace(os_idr_p idr,os_size_t id,void *ptr);
+    void *os_idr_remove(os_idr_p idr,os_size_t id);
+    os_size_t os_idr_get_count(os_idr_p idr);
+
+#endif
\ No newline at end of file
@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-25     lizhirui     add critical area and big kernel lock functions
+ * 2021-07-28     lizhirui     add preempt count functions
  */
 
 // @formatter:off
@@ -19,5 +21,14 @@
     os_bool_t os_is_in_interrupt();
     os_bool_t os_interrupt_disable();
     void os_interrupt_enable(os_bool_t enabled);
+    os_bool_t os_enter_critical_area();
+    void os_leave_critical_area(os_bool_t interrupt_state);
+    os_size_t os_kernel_lock_release_all();
+    void os_kernel_lock_reacquire(os_size_t depth);
+    void os_preempt_disable();
+    void os_preempt_enable_no_resched();
+    void os_preempt_enable();
+    void os_preempt_check_resched();
+    os_bool_t os_preemptible();
     
 #endif
\ No newline at end of file
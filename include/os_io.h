@@ -6,12 +6,14 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-21     lizhirui     add os_snprintf
  */
 
 // @formatter:off
 #ifndef __OS_IO_H__
 #define __OS_IO_H__
 
+    size_t os_snprintf(char *buf,size_t size,const char *fmt,...);
     void os_printf(const char *fmt,...);
     void os_puts(const char *str);
 
@@ -0,0 +1,35 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-21     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_LOG_H__
+#define __OS_LOG_H__
+
+    #include <dreamos.h>
+
+    //日志记录，每个记录占用环形缓冲区中的一个槽位
+    typedef struct os_log_record
+    {
+        volatile os_size_t sequence;//槽位同步序号，等于写入位置+1时表示记录已提交，可被消费
+        os_size_t seq;//日志序列号，全局单调递增
+        os_size_t timestamp;//写入时的系统tick
+        os_size_t length;//日志长度（不包含结尾的'\0'）
+        char data[OS_LOG_RECORD_SIZE];//日志内容
+    }os_log_record_t,*os_log_record_p;
+
+    void os_log_init();
+    void os_log_puts(const char *str);
+    void os_log_flush();
+    void os_log_panic();
+    void os_log_wakeup();
+    void os_log_task_startup();
+    os_size_t os_log_get_dropped_count();
+
+#endif
\ No newline at end of file
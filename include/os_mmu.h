@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-28     lizhirui     add shared kernel pagetable creation and global tlb flush
  */
 
 // @formatter:off
@@ -105,6 +106,11 @@
         #error "Kernel memory is overlapping with io memory!"??
     #endif
 
+    //内核栈映射区域必须位于内核空间中，且不能与内核线性映射空间重叠
+    #if ((OS_MMU_MEMORYMAP_KSTACK_START) < (OS_MMU_MEMORYMAP_KERNEL_START + DIV_UP(MEMORY_SIZE,OS_MMU_L1_SIZE) * OS_MMU_L1_SIZE)) || ((OS_MMU_MEMORYMAP_KSTACK_START + SIZE(OS_MMU_MEMORYMAP_KSTACK_BITS)) > (OS_MMU_MEMORYMAP_KERNEL_START + OS_MMU_MEMORYMAP_KERNEL_SIZE))
+        #error "Kernel stack region is overlapping with kernel linear mapping or out of kernel memory!"
+    #endif
+
     //以下两个宏用于内核线性映射空间的PA/VA互转
     #define OS_MMU_PA_TO_VA(pa) ((pa) + OS_MMU_KERNEL_VA_PA_OFFSET)
     #define OS_MMU_VA_TO_PA(va) ((va) - OS_MMU_KERNEL_VA_PA_OFFSET)
@@ -127,10 +133,12 @@
     os_err_t os_mmu_create_mapping(os_mmu_vtable_p vtable,os_size_t va,os_size_t pa,os_size_t size,os_mmu_pt_prot_t prot);
     os_err_t os_mmu_remove_mapping(os_mmu_vtable_p vtable,os_size_t va,os_size_t size);
     os_err_t os_mmu_create_mapping_auto(os_mmu_vtable_p vtable,os_size_t va,os_size_t size,os_mmu_pt_prot_t prot);
+    os_err_t os_mmu_create_pagetable(os_mmu_vtable_p vtable,os_size_t va,os_size_t size);
     void *os_mmu_user_va_to_kernel_va(os_mmu_vtable_p vtable,os_size_t user_va);
     os_size_t os_mmu_find_vaddr(os_mmu_vtable_p vtable,os_size_t va_start,os_size_t size);
     void os_mmu_remove_all_mapping(os_mmu_vtable_p vtable);
     void os_mmu_switch(os_mmu_vtable_p vtable);
+    void os_mmu_flush_tlb_all(os_size_t va,os_size_t size);
     os_mmu_vtable_p os_mmu_get_current_vtable();
     os_mmu_vtable_p os_mmu_get_kernel_pagetable();
     os_bool_t os_mmu_page_fault_handler(os_size_t addr,os_bool_t write);
@@ -6,6 +6,9 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
+ * 2021-07-27     lizhirui     add held_node for priority inheritance
+ * 2021-07-28     lizhirui     add condition variable
+ * 2021-07-28     lizhirui     add atomic fast path and handoff/steal policy
  */
 
 // @formatter:off
@@ -14,17 +17,44 @@
 
     #include <dreamos.h>
 
+    //互斥锁的解锁策略
+    typedef enum os_mutex_policy
+    {
+        OS_MUTEX_POLICY_HANDOFF = 0,//解锁时直接将锁移交给优先级最高的等待任务，保证公平，但在新的拥有者被调度运行之前锁无法被其它任务使用
+        OS_MUTEX_POLICY_STEAL,//解锁时只唤醒优先级最高的等待任务并由其重新竞争，正在运行的任务可以抢先获取锁，以避免锁护航
+        OS_MUTEX_POLICY_NUM
+    }os_mutex_policy_t;
+
     //互斥锁结构体
     typedef struct os_mutex
     {
-        os_task_p owner;//拥有者
-        os_size_t refcnt;//引用数，用于支持拥有者的递归调用
-        os_bool_t locked;//锁定状态
-        os_waitqueue_t waitqueue;//关联的等待队列
+        volatile os_size_t state;//锁状态，为0时表示未被持有，否则高位为拥有者的任务结构体指针（任务结构体按缓存行对齐），低位为标志位
+        os_size_t refcnt;//引用数，用于支持拥有者的递归调用，只由拥有者访问
+        os_mutex_policy_t policy;//解锁策略
+        os_waitqueue_t waitqueue;//关联的等待队列，按等待任务的优先级排序
+        os_list_node_t held_node;//拥有者的持有互斥锁列表中的节点，只在存在等待任务时加入，用于优先级继承
+        os_size_t sleep_count;//任务在该锁上睡眠等待的次数
+        os_size_t spin_count;//通过自旋获取该锁的次数
+        os_size_t handoff_count;//解锁时直接移交给等待任务的次数
     }os_mutex_t,*os_mutex_p;
 
+    //条件变量结构体
+    typedef struct os_cond
+    {
+        os_waitqueue_t waitqueue;//关联的等待队列，按等待的先后顺序排列
+        os_mutex_p mutex;//等待时使用的互斥锁，所有等待任务必须使用同一个互斥锁
+    }os_cond_t,*os_cond_p;
+
     void os_mutex_init(os_mutex_p mutex);
+    void os_mutex_set_policy(os_mutex_p mutex,os_mutex_policy_t policy);
+    os_task_p os_mutex_get_owner(os_mutex_p mutex);
     void os_mutex_lock(os_mutex_p mutex);
+    os_bool_t os_mutex_trylock(os_mutex_p mutex);
     void os_mutex_unlock(os_mutex_p mutex);
+    void os_cond_init(os_cond_p cond);
+    void os_cond_wait(os_cond_p cond,os_mutex_p mutex);
+    os_err_t os_cond_wait_timeout(os_cond_p cond,os_mutex_p mutex,os_size_t ticks);
+    void os_cond_signal(os_cond_p cond);
+    void os_cond_broadcast(os_cond_p cond);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-27     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_RBTREE_H__
+#define __OS_RBTREE_H__
+
+    #include <dreamos.h>
+
+    //红黑树节点，嵌入到需要组织的结构体中使用
+    typedef struct os_rbtree_node
+    {
+        struct os_rbtree_node *parent;//父节点
+        struct os_rbtree_node *left;//左子节点
+        struct os_rbtree_node *right;//右子节点
+        os_size_t color;//节点颜色
+    }os_rbtree_node_t,*os_rbtree_node_p;
+
+    //红黑树
+    typedef struct os_rbtree
+    {
+        os_rbtree_node_p root;//根节点
+        os_rbtree_node_p leftmost;//最左（最小）节点，用于O(1)获取最小节点
+    }os_rbtree_t,*os_rbtree_p;
+
+    //节点比较函数，a小于b时返回OS_TRUE，相等的节点按插入顺序排列
+    typedef os_bool_t (*os_rbtree_less_func_t)(os_rbtree_node_p a,os_rbtree_node_p b);
+
+    //获取一个红黑树节点对应的原始数据结构体指针
+    #define os_rbtree_entry(node_ptr,type,member) os_container_of(node_ptr,type,member)
+
+    void os_rbtree_init(os_rbtree_p tree);
+    void os_rbtree_insert(os_rbtree_p tree,os_rbtree_node_p node,os_rbtree_less_func_t less);
+    void os_rbtree_remove(os_rbtree_p tree,os_rbtree_node_p node);
+    os_rbtree_node_p os_rbtree_first(os_rbtree_p tree);
+    os_rbtree_node_p os_rbtree_next(os_rbtree_node_p node);
+    os_bool_t os_rbtree_empty(os_rbtree_p tree);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_RCU_H__
+#define __OS_RCU_H__
+
+    #include <dreamos.h>
+
+    typedef struct os_rcu_head os_rcu_head_t,*os_rcu_head_p;
+
+    //RCU回调函数，在宽限期结束后于下半部中执行，通常用于释放被移除的对象
+    typedef void (*os_rcu_func_t)(os_rcu_head_p head);
+
+    //RCU回调节点，嵌入到需要延迟释放的结构体中
+    struct os_rcu_head
+    {
+        os_rcu_head_p next;//回调列表中的下一个节点
+        os_rcu_func_t func;//回调函数
+    };
+
+    //发布被RCU保护的指针，保证读者看到该指针时，指针指向的对象已经初始化完成
+    #define os_rcu_assign_pointer(ptr,value) __atomic_store_n(&(ptr),(value),__ATOMIC_RELEASE)
+    //在读临界区中读取被RCU保护的指针，RISC-V内存模型保证存在地址依赖的访存有序，因此无需读屏障
+    #define os_rcu_dereference(ptr) __atomic_load_n(&(ptr),__ATOMIC_RELAXED)
+
+    //以RCU方式将一个节点插入到列表的尾部，调用者必须持有写者锁
+    #define os_list_insert_tail_rcu(list,list_node_ptr) \
+        do \
+        { \
+            (list_node_ptr) -> next = &(list); \
+            (list_node_ptr) -> prev = (list).prev; \
+            os_rcu_assign_pointer((list).prev -> next,(list_node_ptr)); \
+            (list).prev = (list_node_ptr); \
+        }while(0)
+
+    //以RCU方式从列表中移除一个节点，节点的next指针保持不变，以便正在遍历该节点的读者可以继续遍历，节点必须在宽限期结束后才能释放
+    #define os_list_node_remove_rcu(list_node_ptr) \
+        do \
+        { \
+            os_rcu_assign_pointer((list_node_ptr) -> prev -> next,(list_node_ptr) -> next); \
+            (list_node_ptr) -> next -> prev = (list_node_ptr) -> prev; \
+            (list_node_ptr) -> prev = OS_NULL; \
+        }while(0)
+
+    //在读临界区中遍历列表，只能沿next方向遍历，可以与os_list_insert_tail_rcu和os_list_node_remove_rcu并发执行
+    #define os_list_entry_foreach_rcu(list,type,member,entry_variable,body) \
+    { \
+        os_list_node_p cur_node = os_rcu_dereference((list).next); \
+        \
+        for(;cur_node != &(list);cur_node = os_rcu_dereference(cur_node -> next)) \
+        { \
+            type *entry_variable = os_list_entry(cur_node,type,member); \
+            {body} \
+        } \
+    } \
+
+    void os_rcu_read_lock();
+    void os_rcu_read_unlock();
+    void os_rcu_call(os_rcu_head_p head,os_rcu_func_t func);
+    void os_rcu_synchronize();
+    void os_rcu_qs();
+    void os_rcu_check();
+    void os_rcu_system_init();
+    void os_rcu_startup();
+    void os_rcu_print_info();
+
+#endif
\ No newline at end of file
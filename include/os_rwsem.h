@@ -0,0 +1,46 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_RWSEM_H__
+#define __OS_RWSEM_H__
+
+    #include <dreamos.h>
+
+    //读写信号量的优先策略
+    typedef enum os_rwsem_policy
+    {
+        OS_RWSEM_PREFER_READER = 0,//读者优先，只要没有写者持有，新的读者总能立即获取，写者可能在持续的读负载下饥饿
+        OS_RWSEM_PREFER_WRITER,//写者优先，存在等待的写者时新的读者需要等待，释放时优先唤醒写者
+        OS_RWSEM_POLICY_NUM
+    }os_rwsem_policy_t;
+
+    //读写信号量结构体，允许多个读者或一个写者同时持有，不支持递归获取
+    typedef struct os_rwsem
+    {
+        os_ssize_t count;//大于0时为持有的读者数量，为-1时表示被写者持有，为0时表示空闲
+        os_task_p writer;//持有的写者
+        os_size_t reader_waiting;//等待的读者数量
+        os_size_t writer_waiting;//等待的写者数量
+        os_rwsem_policy_t policy;//优先策略
+        os_waitqueue_t reader_waitqueue;//读者等待队列，非互斥等待，释放时全部唤醒
+        os_waitqueue_t writer_waitqueue;//写者等待队列，互斥等待，释放时只唤醒一个
+    }os_rwsem_t,*os_rwsem_p;
+
+    void os_rwsem_init(os_rwsem_p rwsem,os_rwsem_policy_t policy);
+    void os_rwsem_down_read(os_rwsem_p rwsem);
+    os_bool_t os_rwsem_try_down_read(os_rwsem_p rwsem);
+    void os_rwsem_up_read(os_rwsem_p rwsem);
+    void os_rwsem_down_write(os_rwsem_p rwsem);
+    os_bool_t os_rwsem_try_down_write(os_rwsem_p rwsem);
+    void os_rwsem_up_write(os_rwsem_p rwsem);
+    void os_rwsem_downgrade(os_rwsem_p rwsem);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-25     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_SPINLOCK_H__
+#define __OS_SPINLOCK_H__
+
+    #include <dreamos.h>
+
+    //自旋锁结构体，仅用于多个hart之间的互斥，调用者需要自行关闭中断
+    typedef struct os_spinlock
+    {
+        volatile os_size_t locked;//锁定状态
+    }os_spinlock_t,*os_spinlock_p;
+
+    //自旋锁静态初始化值
+    #define OS_SPINLOCK_INIT {.locked = OS_FALSE}
+
+    void os_spinlock_init(os_spinlock_p lock);
+    void os_spinlock_lock(os_spinlock_p lock);
+    os_bool_t os_spinlock_trylock(os_spinlock_p lock);
+    void os_spinlock_unlock(os_spinlock_p lock);
+
+#endif
\ No newline at end of file
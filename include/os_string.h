@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-20     lizhirui     add page zero and page copy support
  */
 
 // @formatter:off
@@ -19,5 +20,7 @@
     void os_strcpy(char *dststr,const char *srcstr);
     os_ssize_t os_strcmp(const char *str1,const char *str2);
     os_ssize_t os_memcmp(const void *buf1,const void *buf2,os_size_t len);
+    void os_page_zero(void *page,os_size_t size);
+    void os_page_copy(void *dst,const void *src,os_size_t size);
 
 #endif
\ No newline at end of file
@@ -7,6 +7,10 @@
  * Date           Author       Notes
  * 2021-07-06     lizhirui     the first version
  * 2021-07-08     lizhirui     add getpid and getppid syscall
+ * 2021-07-26     lizhirui     add os_timespec_t
+ * 2021-07-27     lizhirui     add sched_setattr and sched_getattr syscall
+ * 2021-07-27     lizhirui     add os_tms_t and os_rusage_t
+ * 2021-07-28     lizhirui     add wait4 options and rusage argument
  */
 
 // @formatter:off
@@ -42,9 +46,87 @@
     #define OS_CLONE_NEWNET		0x40000000	/* New network namespace */
     #define OS_CLONE_IO		0x80000000	/* Clone io context */
 
+    /*
+    * scheduling policies:
+    */
+    #define OS_SCHED_NORMAL		0
+    #define OS_SCHED_FIFO		1
+    #define OS_SCHED_RR		2
+    #define OS_SCHED_DEADLINE	6
+
+    /*
+    * getrusage who:
+    */
+    #define OS_RUSAGE_SELF		0
+    #define OS_RUSAGE_CHILDREN	(-1)
+    #define OS_RUSAGE_THREAD	1
+
+    /*
+    * wait4 options:
+    */
+    #define OS_WNOHANG		0x00000001
+
     #ifndef __ASSEMBLY__
         #include <dreamos.h>
 
+        //用户态timespec结构体
+        typedef struct os_timespec
+        {
+            os_ssize_t tv_sec;//秒
+            os_ssize_t tv_nsec;//纳秒
+        }os_timespec_t,*os_timespec_p;
+
+        //用户态timeval结构体
+        typedef struct os_timeval
+        {
+            os_ssize_t tv_sec;//秒
+            os_ssize_t tv_usec;//微秒
+        }os_timeval_t,*os_timeval_p;
+
+        //用户态tms结构体，时间的单位均为tick
+        typedef struct os_tms
+        {
+            os_ssize_t tms_utime;//用户态CPU时间
+            os_ssize_t tms_stime;//内核态CPU时间
+            os_ssize_t tms_cutime;//已回收的子任务的用户态CPU时间
+            os_ssize_t tms_cstime;//已回收的子任务的内核态CPU时间
+        }os_tms_t,*os_tms_p;
+
+        //用户态rusage结构体，本系统不统计的项目总是为0
+        typedef struct os_rusage
+        {
+            os_timeval_t ru_utime;//用户态CPU时间
+            os_timeval_t ru_stime;//内核态CPU时间
+            os_ssize_t ru_maxrss;
+            os_ssize_t ru_ixrss;
+            os_ssize_t ru_idrss;
+            os_ssize_t ru_isrss;
+            os_ssize_t ru_minflt;
+            os_ssize_t ru_majflt;
+            os_ssize_t ru_nswap;
+            os_ssize_t ru_inblock;
+            os_ssize_t ru_oublock;
+            os_ssize_t ru_msgsnd;
+            os_ssize_t ru_msgrcv;
+            os_ssize_t ru_nsignals;
+            os_ssize_t ru_nvcsw;//主动让出处理器导致的任务切换次数
+            os_ssize_t ru_nivcsw;//被抢占导致的任务切换次数
+        }os_rusage_t,*os_rusage_p;
+
+        //用户态sched_attr结构体，时间参数的单位均为纳秒
+        //OS_SCHED_FIFO和OS_SCHED_RR的sched_priority使用内核的优先级定义，即数值越小优先级越高
+        typedef struct os_sched_attr
+        {
+            os_uint32_t size;//结构体大小
+            os_uint32_t sched_policy;//调度策略
+            os_uint64_t sched_flags;//调度标志，目前未使用
+            os_int32_t sched_nice;//nice值，用于OS_SCHED_NORMAL
+            os_uint32_t sched_priority;//优先级，用于OS_SCHED_FIFO和OS_SCHED_RR
+            os_uint64_t sched_runtime;//每个周期的运行时间，用于OS_SCHED_DEADLINE，下同
+            os_uint64_t sched_deadline;//相对截止时间
+            os_uint64_t sched_period;//周期
+        }os_sched_attr_t,*os_sched_attr_p;
+
         typedef os_ssize_t (*os_syscall_handler_t)(struct TrapFrame *regs,os_size_t arg0,os_size_t arg1,os_size_t arg2,os_size_t arg3,os_size_t arg4,os_size_t arg5);
 
         os_ssize_t os_syscall_getcwd(struct TrapFrame *regs,os_size_t buf,os_size_t size);
@@ -65,7 +147,7 @@
         os_ssize_t os_syscall_fstat(struct TrapFrame *regs,os_size_t fd,os_size_t kst);
         os_ssize_t os_syscall_clone(struct TrapFrame *regs,os_size_t clone_flags,os_size_t newsp,os_size_t parent_tidptr,os_size_t child_tidptr,os_size_t tls);
         os_ssize_t os_syscall_execve(struct TrapFrame *regs,os_size_t filename,os_size_t argv,os_size_t argc);
-        os_ssize_t os_syscall_wait4(struct TrapFrame *regs,os_size_t pid,os_size_t status,os_size_t options);
+        os_ssize_t os_syscall_wait4(struct TrapFrame *regs,os_ssize_t pid,os_size_t status,os_size_t options,os_size_t rusage);
         os_ssize_t os_syscall_exit(struct TrapFrame *regs,os_ssize_t ec);
         os_ssize_t os_syscall_getpid(struct TrapFrame *regs);
         os_ssize_t os_syscall_getppid(struct TrapFrame *regs);
@@ -73,8 +155,11 @@
         os_ssize_t os_syscall_munmap(struct TrapFrame *regs,os_size_t start,os_size_t len);
         os_ssize_t os_syscall_mmap(struct TrapFrame *regs,os_size_t start,os_size_t len,os_size_t prot,os_size_t flags,os_size_t fd,os_size_t off);
         os_ssize_t os_syscall_times(struct TrapFrame *regs,os_size_t tms);
+        os_ssize_t os_syscall_getrusage(struct TrapFrame *regs,os_ssize_t who,os_size_t usage);
         os_ssize_t os_syscall_uname(struct TrapFrame *regs,os_size_t uts);
         os_ssize_t os_syscall_sched_yield(struct TrapFrame *regs);
+        os_ssize_t os_syscall_sched_setattr(struct TrapFrame *regs,os_size_t pid,os_size_t uattr,os_size_t flags);
+        os_ssize_t os_syscall_sched_getattr(struct TrapFrame *regs,os_size_t pid,os_size_t uattr,os_size_t size,os_size_t flags);
         os_ssize_t os_syscall_gettimeofday(struct TrapFrame *regs,os_size_t ts);
         os_size_t os_syscall_nanosleep(struct TrapFrame *regs,os_size_t req,os_size_t rem);
     #endif
@@ -8,6 +8,22 @@
  * 2021-05-18     lizhirui     the first version
  * 2021-07-07     lizhirui     add vtable and parent field for task
  * 2021-07-08     lizhirui     add brk/init_brk/fd_bitmap/fd_list for task
+ * 2021-07-25     lizhirui     add on_cpu for smp task switch
+ * 2021-07-26     lizhirui     add cpu_id for per-hart runqueue
+ * 2021-07-26     lizhirui     add timed sleep
+ * 2021-07-27     lizhirui     add scheduling policy and fair scheduling fields
+ * 2021-07-27     lizhirui     add deadline scheduling fields
+ * 2021-07-27     lizhirui     add priority inheritance fields
+ * 2021-07-27     lizhirui     add lazy fpu context fields
+ * 2021-07-27     lizhirui     export os_task_get_kernel_stack_top
+ * 2021-07-27     lizhirui     add cpu time and context switch accounting fields
+ * 2021-07-28     lizhirui     split task structure into hot, warm and cold parts and allocate names to their actual length
+ * 2021-07-28     lizhirui     add zombie state, wait and task reaper
+ * 2021-07-28     lizhirui     add preempt count
+ * 2021-07-28     lizhirui     add batched wakeup
+ * 2021-07-28     lizhirui     free dynamic task structures after an rcu grace period
+ * 2021-07-28     lizhirui     add os_task_set_parent
+ * 2021-07-28     lizhirui     add reap_child field and OS_TASK_WAIT_STATUS
  */
 
 // @formatter:off
@@ -29,56 +45,168 @@
         OS_TASK_STATE_READY,//就绪态
         OS_TASK_STATE_BLOCKING,//阻塞态
         OS_TASK_STATE_SLEEPING,//睡眠态
-        OS_TASK_STATE_STOPPED,//终止态（任务已经彻底消亡，等待环境清理）
+        OS_TASK_STATE_STOPPED,//终止态（任务已经退出，保留pid和退出码等待父任务通过wait4回收，之后由回收线程清理环境）
     }os_task_state_t;
 
+    //调度策略枚举，靠前的调度策略总是优先于靠后的调度策略
+    typedef enum os_task_sched_policy
+    {
+        OS_TASK_SCHED_DEADLINE = 0,//最早截止时间优先调度，由常量带宽服务器限制每个周期的运行时间
+        OS_TASK_SCHED_RT,//固定优先级调度
+        OS_TASK_SCHED_FAIR,//按权重分配处理器时间的公平调度
+        OS_TASK_SCHED_POLICY_NUM
+    }os_task_sched_policy_t;
+
+    //公平调度任务的nice值范围，nice值越小，任务的权重越大
+    #define OS_TASK_NICE_MIN (-20)
+    #define OS_TASK_NICE_MAX (19)
+
+    //用于优先级继承的优先级，截止时间任务高于所有固定优先级任务，未继承任何优先级时为OS_TASK_PI_PRIORITY_NONE
+    #define OS_TASK_PI_PRIORITY_DEADLINE (-1)
+    #define OS_TASK_PI_PRIORITY_NONE ((os_ssize_t)TASK_PRIORITY_MAX)
+
+    //由退出码得到wait4返回的退出状态，编码与Linux一致，退出码位于第8~15位
+    #define OS_TASK_WAIT_STATUS(exit_code) ((os_int32_t)(((exit_code) & 0xFF) << 8))
+
+    //浮点寄存器中的内容未与任何逻辑处理器同步时的fpu_cpu_id
+    #define OS_TASK_FPU_CPU_NONE ((os_size_t)-1)
+
+    //浮点上下文，仅在任务使用过浮点单元后有效
+    typedef struct os_task_fpu_context
+    {
+        os_size_t f[32];//f0~f31
+        os_size_t fcsr;//浮点控制与状态寄存器
+    }os_task_fpu_context_t,*os_task_fpu_context_p;
+
     //文件描述符表的前置类型声明
     typedef struct os_file_fd_table os_file_fd_table_t,*os_file_fd_table_p;
 
-    //任务结构体
+    //任务结构体，按访问频率分为三部分，热数据集中在结构体开头，任务结构体按缓存行对齐，使每次调度只需访问每个任务的两个缓存行
     typedef struct os_task
     {
+        //热数据：每次任务切换和唤醒都会访问，必须位于前OS_TASK_HOT_SIZE字节中
         os_size_t sp;//栈顶指针，这个必须在结构体的第一项，以方便上下文切换汇编程序访问
+        volatile os_size_t on_cpu;//任务上下文是否仍在某个hart上（尚未保存到sp），这个必须在结构体的第二项，由上下文切换汇编程序维护
         os_size_t stack_addr;//栈起始地址
         os_size_t stack_size;//栈大小
-        struct os_task *parent;//父任务
-        char name[OS_VFS_PATH_MAX + 1];//任务名
-        char path[OS_VFS_PATH_MAX + 1];//任务路径
+        os_mmu_vtable_p vtable;//页表
+        os_task_state_t task_state;//任务状态
+        os_task_sched_policy_t sched_policy;//调度策略，包含因优先级继承导致的临时变化
+        os_size_t cpu_id;//任务所属运行队列的逻辑处理器编号，即任务上次运行或被分配到的hart
+        os_uint8_t on_rq;//任务是否位于运行队列中
+        os_uint8_t dl_throttled;//预算是否已经耗尽，耗尽后直到下一个周期补充预算前不会被调度
+        os_uint8_t fpu_used;//是否使用过浮点单元，未使用过浮点单元的任务在任务切换时不需要处理浮点上下文
+        os_uint8_t preempt_count;//禁止抢占的嵌套层次，不为0时中断中的调度请求会被推迟，随任务迁移，因此不受任务所在hart的影响
+        os_size_t priority;//任务优先级，包含继承的优先级
+        os_size_t tick_remaining;//剩余时间片
+        os_size_t tick_init;//拥有的时间片
+        os_size_t exec_start;//本次开始运行的时刻（纳秒）
+        os_size_t fpu_cpu_id;//最近一次将浮点上下文与浮点寄存器同步时所在的逻辑处理器编号
+        os_list_node_t schedule_node;//调度列表中的节点
+        os_size_t vruntime;//虚拟运行时间（纳秒），仅用于公平调度
+
+        //温数据：只有特定的调度类、优先级继承或CPU时间统计才会访问
+        os_size_t weight;//由nice值决定的权重，仅用于公平调度
+        os_ssize_t nice;//nice值，仅用于公平调度
+        os_rbtree_node_t fair_node;//公平调度红黑树中的节点
+        os_size_t utime;//用户态CPU时间（纳秒）
+        os_size_t stime;//内核态CPU时间（纳秒）
+        os_size_t nvcsw;//主动让出处理器（阻塞或睡眠）导致的任务切换次数
+        os_size_t nivcsw;//被抢占导致的任务切换次数
+        os_size_t dl_runtime;//每个周期的运行时间预算（纳秒），仅用于截止时间调度，下同
+        os_size_t dl_deadline;//相对于周期起点的截止时间（纳秒）
+        os_size_t dl_period;//周期（纳秒）
+        os_size_t dl_bw;//占用的带宽，即dl_runtime / dl_period，以定点数表示
+        os_size_t dl_abs_deadline;//当前作业的绝对截止时间（纳秒）
+        os_ssize_t dl_budget;//当前周期的剩余预算（纳秒），超支时为负数
+        os_size_t dl_miss_count;//截止时间错失次数
+        os_size_t dl_overrun_count;//预算超支次数
+        os_rbtree_node_t dl_node;//截止时间调度红黑树中的节点
+        os_list_node_t dl_throttle_node;//限流列表中的节点
+        os_size_t base_priority;//任务自身的优先级
+        os_task_sched_policy_t base_sched_policy;//任务自身的调度策略
+        os_ssize_t pi_priority;//从等待任务继承的优先级
+        struct os_mutex *pi_blocked_on;//正在等待的互斥锁
+        os_list_node_t pi_held_mutex_list;//持有的互斥锁列表
+
+        //冷数据：身份信息、文件系统、任务树和浮点上下文，只在创建、退出、系统调用等慢路径中访问
+        char *name;//任务名，按实际长度分配
+        char *path;//任务路径，按实际长度分配，内核任务没有路径，为OS_NULL
         os_size_t pid;//Process ID
         os_size_t tid;//Thread ID
         os_size_t sid;//Session ID
-        os_size_t priority;//任务优先级
-        os_size_t tick_init;//拥有的时间片
-        os_size_t tick_remaining;//剩余时间片
-        os_task_state_t task_state;//任务状态
+        struct os_task *parent;//父任务
+        os_list_node_t child_list;//子任务列表
+        os_list_node_t child_node;//子任务列表中的节点
+        os_list_node_t task_node;//任务列表中的节点
         task_func_t entry;//任务入口
         os_size_t arg;//任务入口参数
         task_exit_func_t exit_func;//任务退出函数（用于任务结束后的环境清理）
         os_ssize_t exit_code;//任务退出码
+        os_list_node_t reap_node;//回收列表中的节点
+        os_uint8_t wait_child;//是否正在wait4中等待子任务退出
+        os_uint8_t reap_child;//内核任务是否通过os_task_wait自行回收子任务，为OS_FALSE时内核任务的子任务退出后直接交给回收线程
+        os_uint8_t dynamic;//任务结构体是否由os_task_alloc分配，回收时只释放动态分配的任务结构体
+        os_rcu_head_t rcu;//用于在宽限期结束后释放动态分配的任务结构体，使通过pid无锁查找到的任务在读临界区中保持有效
+        os_size_t cutime;//已回收的子任务的用户态CPU时间之和（纳秒）
+        os_size_t cstime;//已回收的子任务的内核态CPU时间之和（纳秒）
         os_size_t brk;//堆上界
         os_size_t init_brk;//堆下界
         os_file_fd_table_p fd_table;//文件描述符表
-        os_mmu_vtable_p vtable;//页表
-        os_list_node_t task_node;//任务列表中的节点
-        os_list_node_t schedule_node;//调度列表中的节点
-        os_list_node_t child_list;//子任务列表
-        os_list_node_t child_node;//子任务列表中的节点
-    }os_task_t,*os_task_p;
+        os_task_fpu_context_t fpu_context;//浮点上下文
+    }__aligned(OS_CACHE_LINE_SIZE) os_task_t,*os_task_p;
+
+    //任务结构体中热数据的大小
+    #define OS_TASK_HOT_SIZE __builtin_offsetof(os_task_t,weight)
+
+    //批量唤醒上下文，一次唤醒多个任务时，当前hart只调度一次，发往其它hart的IPI也只发送一次
+    typedef struct os_task_wakeup_batch
+    {
+        os_bool_t resched;//当前hart是否需要重新调度
+        os_size_t ipi_mask;//需要通知重新调度的hart的逻辑处理器编号位图
+        os_size_t num;//被唤醒的任务数量
+    }os_task_wakeup_batch_t,*os_task_wakeup_batch_p;
 
     os_task_t *os_task_get_current_task();
+    os_task_p os_task_alloc();
+    void os_task_free(os_task_p task);
     os_err_t os_task_init(os_task_p task,os_size_t stack_size,os_size_t priority,os_size_t tick_init,task_func_t entry,os_size_t arg,const char *name);
+    void os_task_set_parent(os_task_p task,os_task_p parent);
     void os_task_remove(os_task_p task);
     void os_task_startup(os_task_p task);
+    OS_NORETURN void os_task_exit(os_ssize_t exit_code);
+    os_ssize_t os_task_wait(os_ssize_t pid,os_bool_t nohang,os_ssize_t *exit_code,os_size_t *utime,os_size_t *stime);
+    void os_task_set_reap_child(os_bool_t reap_child);
+    void os_task_reaper_startup();
+    void os_task_reaper_print_info();
+    os_err_t os_task_set_name(os_task_p task,const char *name);
+    os_err_t os_task_set_path(os_task_p task,const char *path);
+    os_err_t os_task_set_sched_policy(os_task_p task,os_task_sched_policy_t policy,os_ssize_t param);
+    os_err_t os_task_set_deadline(os_task_p task,os_size_t runtime,os_size_t deadline,os_size_t period);
+    os_ssize_t os_task_get_pi_priority(os_task_p task);
+    void os_task_pi_set_priority(os_task_p task,os_ssize_t priority);
+    void os_task_deadline_tick();
+    os_size_t os_task_deadline_get_next_tick();
     void os_task_yield();
     void os_task_sleep();
+    os_size_t os_task_sleep_ticks(os_size_t ticks);
+    os_size_t os_task_sleep_ns(os_size_t ns);
     void os_task_wakeup(os_task_t *task);
+    void os_task_wakeup_batch_init(os_task_wakeup_batch_p batch);
+    void os_task_wakeup_batch_add(os_task_wakeup_batch_p batch,os_task_p task);
+    void os_task_wakeup_batch_flush(os_task_wakeup_batch_p batch);
     os_task_p os_task_get_task_by_pid(os_size_t pid);
     void os_task_schedule();
+    os_task_p os_task_get_lazy_old_task();
+    os_task_p os_task_take_lazy_next_task();
+    os_size_t os_task_get_kernel_stack_top(os_task_t *task);
+    os_task_p os_task_idle_create(os_size_t cpu_id);
     os_bool_t os_task_scheduler_is_initialized();
     void os_task_scheduler_init();
     void os_task_scheduler_start();
     void os_task_switch_vtable(os_task_p task);
     void os_task_print_tree(os_task_p task);
+    void os_task_print_runqueue_info();
     os_task_p os_task_get_root_task();
     os_task_p os_task_get_main_task();
 
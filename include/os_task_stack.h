@@ -0,0 +1,23 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_TASK_STACK_H__
+#define __OS_TASK_STACK_H__
+
+    #include <dreamos.h>
+
+    void os_task_stack_init();
+    void *os_task_stack_alloc(os_size_t stack_size);
+    void os_task_stack_free(void *stack,os_size_t stack_size);
+    os_bool_t os_task_stack_is_guard_page(os_size_t addr);
+    void os_task_stack_print_info();
+
+#endif
\ No newline at end of file
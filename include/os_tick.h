@@ -6,6 +6,9 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-06     lizhirui     the first version
+ * 2021-07-26     lizhirui     add OS_NS_PER_TICK
+ * 2021-07-26     lizhirui     add tickless idle interface
+ * 2021-07-27     lizhirui     add os_tick_get_ns
  */
 
 // @formatter:off
@@ -14,7 +17,18 @@
 
     #include <dreamos.h>
 
+    //每个tick对应的纳秒数
+    #define OS_NS_PER_TICK (1000000000UL / TICK_PER_SECOND)
+    //表示不需要时钟中断的截止tick
+    #define OS_TICK_DEADLINE_NONE (~0UL)
+
     os_size_t os_tick_get();
+    os_size_t os_tick_get_ns();
     void os_tick_handler();
+    void os_tick_program_next();
+    void os_tick_idle_enter();
+    void os_tick_idle_exit();
+    void os_tick_resume();
+    void os_tick_print_info();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-26     lizhirui     the first version
+ * 2021-07-26     lizhirui     add os_timer_get_next_expire
+ */
+
+// @formatter:off
+#ifndef __OS_TIMER_H__
+#define __OS_TIMER_H__
+
+    #include <dreamos.h>
+
+    //定时器到期回调函数，在主核的时钟中断上下文中执行，执行时持有内核大锁
+    typedef void (*os_timer_func_t)(os_size_t arg);
+
+    //定时器允许推迟的tick数由定时时长自动决定（约为定时时长的1/256）
+    #define OS_TIMER_SLACK_AUTO ((os_size_t)-1)
+
+    //定时器结构体
+    typedef struct os_timer
+    {
+        os_list_node_t node;//时间轮槽位中的节点，定时器未启动时为空节点
+        os_size_t expire;//到期tick（已叠加slack）
+        os_size_t slack;//允许推迟的tick数，用于合并相近的到期时间，以减少时钟中断中的处理次数
+        os_timer_func_t func;//到期回调函数
+        os_size_t arg;//回调函数参数
+    }os_timer_t,*os_timer_p;
+
+    void os_timer_init(os_timer_p timer,os_timer_func_t func,os_size_t arg);
+    void os_timer_set_slack(os_timer_p timer,os_size_t slack);
+    void os_timer_start(os_timer_p timer,os_size_t ticks);
+    os_bool_t os_timer_stop(os_timer_p timer);
+    os_bool_t os_timer_is_active(os_timer_p timer);
+    os_size_t os_timer_get_remaining(os_timer_p timer);
+    os_size_t os_timer_get_next_expire();
+    void os_timer_handler();
+    void os_timer_system_init();
+
+#endif
\ No newline at end of file
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
+ * 2021-07-28     lizhirui     split vfs lock into read and write mode
  */
 
 // @formatter:off
@@ -111,8 +112,10 @@
         void *priv_data;//私有数据
     };
 
-    void vfs_lock();
-    void vfs_unlock();
+    void vfs_read_lock();
+    void vfs_read_unlock();
+    void vfs_write_lock();
+    void vfs_write_unlock();
     os_err_t os_vfs_normalize_path(const char *path,char *buf);
     os_vfs_mp_p os_vfs_find_mp_by_path(const char *path);
     os_err_t os_vfs_register(const os_vfs_p fs);
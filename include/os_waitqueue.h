@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
+ * 2021-07-26     lizhirui     add os_waitqueue_wait_timeout
+ * 2021-07-28     lizhirui     add exclusive wait, wake-all and batched wakeup
  */
 
 // @formatter:off
@@ -14,6 +16,9 @@
 
     #include <dreamos.h>
 
+    //无限等待
+    #define OS_WAITQUEUE_WAIT_FOREVER OS_NUMBER_MAX(os_size_t)
+
     //等待队列结构体
     typedef struct os_waitqueue
     {
@@ -25,12 +30,18 @@
     {
         os_task_p task;//关联任务
         os_list_node_t node;//关联列表节点
+        os_bool_t exclusive;//是否为互斥等待，每次唤醒只唤醒指定数量的互斥等待任务，非互斥等待任务则全部唤醒
     }os_waitqueue_node_t,*os_waitqueue_node_p;
 
     void os_waitqueue_add(os_waitqueue_p waitqueue,os_waitqueue_node_p node);
     void os_waitqueue_remove(os_waitqueue_node_p node);
     void os_waitqueue_wait(os_waitqueue_p waitqueue);
+    os_err_t os_waitqueue_wait_timeout(os_waitqueue_p waitqueue,os_size_t ticks);
+    void os_waitqueue_wait_exclusive(os_waitqueue_p waitqueue);
+    os_err_t os_waitqueue_wait_exclusive_timeout(os_waitqueue_p waitqueue,os_size_t ticks);
+    os_size_t os_waitqueue_wakeup_nr(os_waitqueue_p waitqueue,os_size_t nr_exclusive);
     void os_waitqueue_wakeup(os_waitqueue_p waitqueue);
+    void os_waitqueue_wakeup_all(os_waitqueue_p waitqueue);
     os_bool_t os_waitqueue_empty(os_waitqueue_p waitqueue);
     os_task_p os_waitqueue_get_head(os_waitqueue_p waitqueue);
     void os_waitqueue_init(os_waitqueue_p waitqueue);
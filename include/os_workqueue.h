@@ -0,0 +1,70 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ */
+
+// @formatter:off
+#ifndef __OS_WORKQUEUE_H__
+#define __OS_WORKQUEUE_H__
+
+    #include <dreamos.h>
+
+    //工作函数，在工作线程中执行，可以睡眠
+    typedef void (*os_work_func_t)(os_size_t arg);
+
+    //工作项结构体，同一工作项同一时刻只应加入一个工作队列，工作项处于等待执行或正在执行状态时不能释放
+    typedef struct os_work
+    {
+        os_list_node_t node;//工作队列等待列表中的节点
+        os_list_node_t run_node;//工作队列执行列表中的节点，工作项在执行期间可以再次加入等待列表
+        os_work_func_t func;//工作函数
+        os_size_t arg;//工作函数参数
+        struct os_workqueue *wq;//最近一次加入的工作队列
+        os_size_t seq;//加入工作队列时分配的序号，用于等待之前加入的工作项全部完成
+        os_size_t run_seq;//正在执行的这一次加入时分配的序号
+        os_size_t queue_time;//加入工作队列的时刻（纳秒），用于统计延迟
+        volatile os_bool_t pending;//是否在等待执行
+        volatile os_bool_t running;//是否正在执行，同一工作项不会被多个工作线程同时执行
+    }os_work_t,*os_work_p;
+
+    //工作队列结构体，由若干个工作线程按加入顺序执行工作项
+    typedef struct os_workqueue
+    {
+        const char *name;//工作队列名称
+        os_list_node_t pending_list;//等待执行的工作项列表，按序号排列
+        os_list_node_t running_list;//正在执行的工作项列表
+        os_waitqueue_t worker_waitqueue;//空闲的工作线程在此等待
+        os_waitqueue_t flush_waitqueue;//等待工作项完成的任务在此等待
+        os_task_p *worker;//工作线程
+        os_size_t worker_num;//工作线程数量
+        os_size_t seq;//最近一次分配的序号
+        //以下为统计信息
+        os_size_t depth;//等待执行的工作项数量
+        os_size_t max_depth;//等待执行的工作项数量的最大值
+        os_size_t running_num;//正在执行的工作项数量
+        os_size_t queue_count;//加入的工作项总数
+        os_size_t exec_count;//执行完成的工作项总数
+        os_size_t latency_total;//从加入到开始执行的总延迟（纳秒）
+        os_size_t latency_max;//从加入到开始执行的最大延迟（纳秒）
+        os_size_t exec_time_total;//工作函数的总执行时间（纳秒）
+        os_size_t exec_time_max;//工作函数的最大执行时间（纳秒）
+    }os_workqueue_t,*os_workqueue_p;
+
+    void os_work_init(os_work_p work,os_work_func_t func,os_size_t arg);
+    os_err_t os_workqueue_create(os_workqueue_p wq,const char *name,os_size_t worker_num,os_size_t priority);
+    os_bool_t os_workqueue_queue(os_workqueue_p wq,os_work_p work);
+    os_bool_t os_work_cancel(os_work_p work);
+    void os_work_flush(os_work_p work);
+    void os_workqueue_flush(os_workqueue_p wq);
+    os_size_t os_workqueue_get_depth(os_workqueue_p wq);
+    void os_workqueue_print_info(os_workqueue_p wq);
+    os_workqueue_p os_workqueue_get_system();
+    os_bool_t os_work_schedule(os_work_p work);
+    void os_workqueue_system_startup();
+
+#endif
\ No newline at end of file
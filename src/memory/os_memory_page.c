@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-28     lizhirui     protect buddy system with its own spinlock instead of big kernel lock
+ * 2021-07-28     lizhirui     disable preemption instead of interrupts while holding page lock
  */
 
 // @formatter:off
@@ -34,6 +36,9 @@ static os_size_t page_memory_start;//页面数据部分开始地址
 static os_size_t page_memory_end;//页面数据部分结束地址
 static os_size_t page_metainfo_bits_aligned;//完成2的幂对齐的元信息大小的2的对数
 static os_size_t page_allocated;//已分配的页面数
+//页面分配器锁，页面分配器不会调用其它需要加锁的模块，因此不再使用内核大锁，避免分配页面时与无关的临界区互相等待
+//页面分配器不会在中断上下文中使用，持有锁期间只禁止抢占，不关中断
+static os_spinlock_t page_lock = OS_SPINLOCK_INIT;
 
 /*!
  * 页面地址转页面元信息结构体指针
@@ -164,7 +169,8 @@ static inline page_metainfo_t *get_big_page(page_metainfo_t *page,page_metainfo_
 static void *_alloc(os_size_t order)
 {
     os_size_t i;
-    OS_ENTER_CRITICAL_AREA();
+    os_preempt_disable();
+    os_spinlock_lock(&page_lock);
 
     //按照Order从小到大分配，直到遇到一个空闲页面位置
     for(i = order;i < BUDDY_ORDER_UPLIMIT;i++)
@@ -187,34 +193,36 @@ static void *_alloc(os_size_t order)
 
             page_allocated += SIZE(order - PAGE_BITS);
             SYNC_DATA();
-            OS_LEAVE_CRITICAL_AREA();
+            os_spinlock_unlock(&page_lock);
+            os_preempt_enable();
             return (void *)addr;
         }
     }
 
     SYNC_DATA();
-    OS_LEAVE_CRITICAL_AREA();
+    os_spinlock_unlock(&page_lock);
+    os_preempt_enable();
     return OS_NULL;
 }
 
 /*!
- * 页面分配（其大小为2的幂，且>=size）
+ * 页面分配（其大小为2的幂，且>=size），不能在中断上下文中调用
  * @param size 页面大小
  * @return 成功返回页面地址，失败返回OS_NULL
  */
 void *os_memory_page_alloc(os_size_t size)
 {
+    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
     return _alloc(os_size_to_order(size));
 }
 
 /*!
- * 页面释放
+ * 页面释放，调用者必须持有页面分配器锁
  * @param addr 页面地址
  * @param old_order 页面已分配的Order
  */
 static void _free(void *addr,os_size_t old_order)
 {
-    OS_ENTER_CRITICAL_AREA();
     page_metainfo_t *page = addr_to_page_metainfo((os_size_t)addr);
     os_size_t i;
 
@@ -236,19 +244,21 @@ static void _free(void *addr,os_size_t old_order)
     }
 
     SYNC_DATA();
-    OS_LEAVE_CRITICAL_AREA();
 }
 
 /*!
- * 页面释放
+ * 页面释放，不能在中断上下文中调用
  * @param addr 页面地址
  */
 void os_memory_page_free(void *addr)
 {
-    OS_ENTER_CRITICAL_AREA();
+    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
+    os_preempt_disable();
+    os_spinlock_lock(&page_lock);
     page_metainfo_t *page = addr_to_page_metainfo((os_size_t)addr);
     _free(addr,page -> order_allocated);
-    OS_LEAVE_CRITICAL_AREA();
+    os_spinlock_unlock(&page_lock);
+    os_preempt_enable();
 }
 
 /*!
@@ -0,0 +1,259 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*
+ * 下半部（bottom half）用于将中断处理程序中耗时的工作推迟到中断处理程序之外执行
+ * 中断处理程序中调度的下半部在最外层中断退出前开中断执行，单次最多执行OS_BH_BATCH_MAX个，剩余的交给下半部线程执行
+ * 执行期间中断层次保持不变，因此下半部中的调度请求和嵌套中断中的调度请求都会推迟到最外层中断返回时处理
+ */
+static os_list_node_t bh_pending_list;//等待执行的下半部列表
+static volatile os_size_t bh_pending_num = 0;//等待执行的下半部数量
+static os_task_t bh_task;//下半部线程
+static volatile os_bool_t bh_task_started = OS_FALSE;//下半部线程是否已经启动
+
+//统计信息
+static os_size_t bh_raise_count = 0;//被调度的次数
+static os_size_t bh_run_count = 0;//执行的次数
+static os_size_t bh_thread_run_count = 0;//在下半部线程中执行的次数
+static os_size_t bh_max_pending_num = 0;//等待执行的下半部数量的最大值
+static os_size_t bh_latency_total = 0;//从被调度到开始执行的总延迟（纳秒）
+static os_size_t bh_latency_max = 0;//从被调度到开始执行的最大延迟（纳秒）
+
+/*!
+ * 取出第一个没有在其它hart上执行的下半部，并将其标记为正在执行
+ * @param threaded 是否在下半部线程中执行
+ * @return 成功返回下半部结构体指针，没有可执行的下半部时返回OS_NULL
+ */
+static os_bh_p bh_take(os_bool_t threaded)
+{
+    os_bh_p ret = OS_NULL;
+
+    OS_ENTER_CRITICAL_AREA();
+
+    os_list_entry_foreach(bh_pending_list,os_bh_t,node,bh,
+    {
+        if(!bh -> running)
+        {
+            ret = bh;
+            break;
+        }
+    });
+
+    if(ret != OS_NULL)
+    {
+        os_size_t latency = os_tick_get_ns() - ret -> raise_time;
+
+        os_list_node_remove(&ret -> node);
+        ret -> pending = OS_FALSE;
+        ret -> running = OS_TRUE;
+        bh_pending_num--;
+        bh_run_count++;
+        bh_thread_run_count += threaded ? 1 : 0;
+        bh_latency_total += latency;
+        bh_latency_max = MAX(bh_latency_max,latency);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 标记下半部执行完成
+ * @param bh 下半部结构体指针
+ */
+static void bh_finish(os_bh_p bh)
+{
+    OS_ENTER_CRITICAL_AREA();
+    bh -> running = OS_FALSE;
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 依次执行等待中的下半部，调用者必须处于开中断状态
+ * @param max_num 最多执行的下半部数量
+ * @param threaded 是否在下半部线程中执行
+ * @return 实际执行的下半部数量
+ */
+static os_size_t bh_run_batch(os_size_t max_num,os_bool_t threaded)
+{
+    os_size_t num = 0;
+
+    while(num < max_num)
+    {
+        os_bh_p bh = bh_take(threaded);
+
+        if(bh == OS_NULL)
+        {
+            break;
+        }
+
+        bh -> func(bh -> arg);
+        bh_finish(bh);
+        num++;
+    }
+
+    return num;
+}
+
+/*!
+ * 下半部线程入口
+ * @param arg 未使用
+ * @return 线程退出码
+ */
+static OS_NORETURN os_ssize_t os_bh_task_entry(os_size_t arg)
+{
+    while(1)
+    {
+        OS_ENTER_CRITICAL_AREA();
+
+        while(bh_pending_num == 0)
+        {
+            os_task_sleep();
+        }
+
+        OS_LEAVE_CRITICAL_AREA();
+        bh_run_batch(OS_BH_BATCH_MAX,OS_TRUE);
+        //每执行一批后让出CPU，避免持续调度的下半部长期占用CPU，剩余的下半部正在其它hart上执行时也需要让出CPU
+        os_task_yield();
+    }
+}
+
+/*!
+ * 下半部初始化
+ * @param bh 下半部结构体指针
+ * @param func 处理函数
+ * @param arg 处理函数参数
+ */
+void os_bh_init(os_bh_p bh,os_bh_func_t func,os_size_t arg)
+{
+    os_list_node_init(&bh -> node);
+    bh -> func = func;
+    bh -> arg = arg;
+    bh -> raise_time = 0;
+    bh -> pending = OS_FALSE;
+    bh -> running = OS_FALSE;
+}
+
+/*!
+ * 调度下半部，可以在中断上下文中调用
+ * 在中断上下文中调度时，下半部在最外层中断退出时执行，在任务上下文中调度时，下半部由下半部线程执行
+ * @param bh 下半部结构体指针
+ * @return 成功加入等待执行列表返回OS_TRUE，下半部已经在等待执行时返回OS_FALSE
+ */
+os_bool_t os_bh_schedule(os_bh_p bh)
+{
+    os_bool_t ret = OS_FALSE;
+
+    OS_ENTER_CRITICAL_AREA();
+
+    if(!bh -> pending)
+    {
+        bh -> pending = OS_TRUE;
+        bh -> raise_time = os_tick_get_ns();
+        os_list_insert_tail(bh_pending_list,&bh -> node);
+        bh_pending_num++;
+        bh_raise_count++;
+        bh_max_pending_num = MAX(bh_max_pending_num,bh_pending_num);
+        ret = OS_TRUE;
+
+        if(!os_is_in_interrupt() && bh_task_started)
+        {
+            os_task_wakeup(&bh_task);
+        }
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 取消等待执行的下半部，正在执行的下半部不受影响
+ * @param bh 下半部结构体指针
+ * @return 下半部在取消前处于等待执行状态返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_bh_cancel(os_bh_p bh)
+{
+    os_bool_t ret;
+
+    OS_ENTER_CRITICAL_AREA();
+    ret = bh -> pending;
+
+    if(ret)
+    {
+        os_list_node_remove(&bh -> node);
+        bh -> pending = OS_FALSE;
+        bh_pending_num--;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 在最外层中断退出前执行等待中的下半部，由os_leave_interrupt调用，调用时中断处于关闭状态，返回时中断仍处于关闭状态
+ */
+void os_bh_interrupt_exit()
+{
+    //没有等待执行的下半部时无需获取内核大锁
+    if(__atomic_load_n(&bh_pending_num,__ATOMIC_RELAXED) == 0)
+    {
+        return;
+    }
+
+    os_interrupt_enable(OS_TRUE);
+    bh_run_batch(OS_BH_BATCH_MAX,OS_FALSE);
+    os_interrupt_disable();
+
+    //超出单次处理上限的下半部交给下半部线程执行，避免中断频繁到来时被中断的任务长期得不到执行
+    if((__atomic_load_n(&bh_pending_num,__ATOMIC_RELAXED) > 0) && bh_task_started)
+    {
+        os_task_wakeup(&bh_task);
+    }
+}
+
+/*!
+ * 下半部子系统初始化
+ */
+void os_bh_system_init()
+{
+    os_list_init(bh_pending_list);
+    bh_pending_num = 0;
+}
+
+/*!
+ * 初始化并启动下半部线程
+ */
+void os_bh_startup()
+{
+    OS_ASSERT(os_task_init(&bh_task,OS_BH_TASK_STACK_SIZE,OS_BH_TASK_PRIORITY,OS_BH_TASK_TICK_INIT,os_bh_task_entry,0,"task_bh") == OS_ERR_OK);
+    os_task_startup(&bh_task);
+    bh_task_started = OS_TRUE;
+}
+
+/*!
+ * 获取等待执行的下半部数量
+ * @return 等待执行的下半部数量
+ */
+os_size_t os_bh_get_pending_num()
+{
+    return bh_pending_num;
+}
+
+/*!
+ * 打印下半部的统计信息
+ */
+void os_bh_print_info()
+{
+    os_size_t latency_avg = (bh_run_count > 0) ? (bh_latency_total / bh_run_count) : 0;
+    os_printf("bottom half:raised = %ld,run = %ld,threaded = %ld,pending = %ld,max pending = %ld,avg latency = %ld ns,max latency = %ld ns\n",bh_raise_count,bh_run_count,bh_thread_run_count,bh_pending_num,bh_max_pending_num,latency_avg,bh_latency_max);
+}
\ No newline at end of file
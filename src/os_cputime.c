@@ -0,0 +1,189 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-27     lizhirui     the first version
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*
+ * CPU时间统计
+ * 每个hart记录上一次统计的时刻，在用户态与内核态的边界（trap入口与返回用户态前）、进入与离开中断、任务切换时，
+ * 将自上一次统计以来经过的时间计入当前所处的类型，用户态时间与内核态时间同时计入当前任务
+ */
+
+static os_size_t cputime_last[OS_CPU_MAX_NUM][OS_CPUTIME_TYPE_NUM];//上一次打印时各hart的CPU时间，用于计算打印间隔内的利用率
+
+/*!
+ * 获取hart当前所处的CPU时间类型
+ * @param hart hart私有数据结构体指针
+ * @return CPU时间类型
+ */
+static os_cputime_type_t cputime_get_type(os_hart_p hart)
+{
+    if(hart -> cputime_user)
+    {
+        return OS_CPUTIME_USER;
+    }
+    else if(hart -> interrupt_nest > 0)
+    {
+        return OS_CPUTIME_IRQ;
+    }
+    else if((hart -> current_task != OS_NULL) && (hart -> current_task == hart -> idle_task))
+    {
+        return OS_CPUTIME_IDLE;
+    }
+
+    return OS_CPUTIME_SYSTEM;
+}
+
+/*!
+ * 将当前hart自上一次统计以来经过的时间计入当前所处的类型，调用者必须关闭中断
+ * 在进入中断前、离开中断前以及当前任务发生变化前调用
+ */
+void os_cputime_update()
+{
+    os_hart_p hart = os_hart_get_current();
+    os_size_t now = os_tick_get_ns();
+    os_size_t delta = now - hart -> cputime_timestamp;
+    os_cputime_type_t type = cputime_get_type(hart);
+    os_task_p task = hart -> current_task;
+
+    hart -> cputime_timestamp = now;
+    hart -> cputime[type] += delta;
+
+    if(task != OS_NULL)
+    {
+        if(type == OS_CPUTIME_USER)
+        {
+            task -> utime += delta;
+        }
+        else if(type == OS_CPUTIME_SYSTEM)
+        {
+            task -> stime += delta;
+        }
+    }
+}
+
+/*!
+ * 即将返回用户态时调用，该函数主要用于汇编程序，此时中断处于关闭状态
+ */
+void os_cputime_user_enter()
+{
+    os_cputime_update();
+    os_hart_get_current() -> cputime_user = OS_TRUE;
+}
+
+/*!
+ * 从用户态进入trap时调用，该函数主要用于汇编程序，此时中断处于关闭状态
+ */
+void os_cputime_user_exit()
+{
+    os_cputime_update();
+    os_hart_get_current() -> cputime_user = OS_FALSE;
+}
+
+/*!
+ * 初始化当前hart的CPU时间统计，在hart启动任务调度时调用，此前经过的时间不计入任何类型
+ */
+void os_cputime_hart_init()
+{
+    os_hart_p hart = os_hart_get_current();
+    hart -> cputime_user = OS_FALSE;
+    hart -> cputime_timestamp = os_tick_get_ns();
+}
+
+/*!
+ * 获取任务的CPU时间，若任务正在当前hart上运行，则包含尚未统计的部分
+ * @param task 任务结构体指针
+ * @param utime 用于返回用户态CPU时间（纳秒），可以为OS_NULL
+ * @param stime 用于返回内核态CPU时间（纳秒），可以为OS_NULL
+ */
+void os_cputime_get_task(os_task_p task,os_size_t *utime,os_size_t *stime)
+{
+    os_bool_t interrupt_state = os_interrupt_disable();
+
+    if(os_hart_get_current() -> current_task == task)
+    {
+        os_cputime_update();
+    }
+
+    if(utime != OS_NULL)
+    {
+        *utime = task -> utime;
+    }
+
+    if(stime != OS_NULL)
+    {
+        *stime = task -> stime;
+    }
+
+    os_interrupt_enable(interrupt_state);
+}
+
+/*!
+ * 打印各hart自上一次打印以来的CPU利用率，其它hart上尚未统计的时间按其当前所处的类型计入
+ */
+void os_cputime_print_info()
+{
+    static const char *type_name[OS_CPUTIME_TYPE_NUM] = {"user","sys","irq","idle"};
+    os_size_t i,j;
+    os_size_t total_busy = 0;
+    os_size_t total = 0;
+
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_cputime_update();
+    os_interrupt_enable(interrupt_state);
+
+    os_size_t now = os_tick_get_ns();
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        os_hart_p hart = os_hart_get(i);
+
+        if(!hart -> online)
+        {
+            continue;
+        }
+
+        os_size_t cputime[OS_CPUTIME_TYPE_NUM];
+        os_size_t sum = 0;
+
+        for(j = 0;j < OS_CPUTIME_TYPE_NUM;j++)
+        {
+            cputime[j] = hart -> cputime[j];
+        }
+
+        os_size_t timestamp = hart -> cputime_timestamp;
+
+        if(((os_ssize_t)(now - timestamp)) > 0)
+        {
+            cputime[cputime_get_type(hart)] += now - timestamp;
+        }
+
+        os_printf("cpu%ld:",i);
+
+        for(j = 0;j < OS_CPUTIME_TYPE_NUM;j++)
+        {
+            os_size_t delta = cputime[j] - cputime_last[i][j];
+            cputime_last[i][j] = cputime[j];
+            cputime[j] = delta;
+            sum += delta;
+        }
+
+        for(j = 0;j < OS_CPUTIME_TYPE_NUM;j++)
+        {
+            os_printf("%s %ld%%%s",type_name[j],(sum == 0) ? 0 : (cputime[j] * 100 / sum),(j == (OS_CPUTIME_TYPE_NUM - 1)) ? "\n" : ",");
+        }
+
+        total_busy += sum - cputime[OS_CPUTIME_IDLE];
+        total += sum;
+    }
+
+    os_printf("cpu utilization:%ld%%\n\n",(total == 0) ? 0 : (total_busy * 100 / total));
+}
\ No newline at end of file
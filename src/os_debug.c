@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
  * 2021-05-20     lizhirui     add os debug support
+ * 2021-07-21     lizhirui     flush log ring buffer before printing assertion
  */
 
 // @formatter:off
@@ -20,6 +21,7 @@
  */
 void os_assert_handler(const char *ex_string,const char *func,os_size_t line)
 {
+    os_log_panic();
     terminal_color_set(TERMINAL_COLOR_RED,TERMINAL_COLOR_BLACK);
     os_printf("(%s) assertion failed at function:%s, line number:%d \n",ex_string,func,line);
     terminal_color_set(TERMINAL_COLOR_WHITE,TERMINAL_COLOR_BLACK);
@@ -7,12 +7,15 @@
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
  * 2021-07-09     lizhirui     add op function for device
+ * 2021-07-22     lizhirui     add self lock device flag
+ * 2021-07-28     lizhirui     look up devices under rcu and add device unregister
+ * 2021-07-28     lizhirui     add os_device_get and os_device_put to hold devices across unregister
  */
 
 // @formatter:off
 #include <dreamos.h>
 
-static os_list_node_t device_list;//系统设备列表
+static os_list_node_t device_list;//系统设备列表，修改时持有全局锁，遍历在RCU读临界区中进行
 static os_mutex_t os_device_global_lock;//设备管理器全局锁
 static os_bool_t os_device_initialized = OS_FALSE;//设备管理器是否已初始化完成
 
@@ -33,7 +36,7 @@ static void os_device_unlock()
 }
 
 /*!
- * 获取设备列表
+ * 获取设备列表，只能在RCU读临界区中通过os_list_entry_foreach_rcu遍历
  * @return 设备列表指针
  */
 os_list_node_p os_device_get_list()
@@ -42,28 +45,69 @@ os_list_node_p os_device_get_list()
 }
 
 /*!
- * 从设备列表中寻找一个设备
+ * 在RCU读临界区中从设备列表中寻找一个设备
  * @param name 设备名
  * @return 若找到，则返回设备结构体指针，否则返回OS_NULL
  */
-os_device_p os_device_find(const char *name)
+static os_device_p device_find_rcu(const char *name)
 {
-    OS_ANNOTATION_NEED_DEVICE();
-    os_device_lock();
-
-    os_list_entry_foreach(device_list,os_device_t,node,entry,
+    os_list_entry_foreach_rcu(device_list,os_device_t,node,entry,
     {
         if(os_strcmp(entry -> name,name) == 0)
         {
-            os_device_unlock();
             return entry;
         }
     });
 
-    os_device_unlock();
     return OS_NULL;
 }
 
+/*!
+ * 从设备列表中寻找一个设备，查找不加锁，可以与设备的注册和解注册并发执行
+ * 返回的指针只能用于判断设备是否存在，需要访问设备时使用os_device_get
+ * @param name 设备名
+ * @return 若找到，则返回设备结构体指针，否则返回OS_NULL
+ */
+os_device_p os_device_find(const char *name)
+{
+    OS_ANNOTATION_NEED_DEVICE();
+    os_rcu_read_lock();
+    os_device_p dev = device_find_rcu(name);
+    os_rcu_read_unlock();
+    return dev;
+}
+
+/*!
+ * 从设备列表中寻找一个设备并增加其引用数，查找和增加引用数在同一次加锁中进行，使设备在调用os_device_put之前不会被解注册
+ * @param name 设备名
+ * @return 若找到，则返回设备结构体指针，否则返回OS_NULL
+ */
+os_device_p os_device_get(const char *name)
+{
+    OS_ANNOTATION_NEED_DEVICE();
+    os_device_lock();
+    os_device_p dev = device_find_rcu(name);
+
+    if(dev != OS_NULL)
+    {
+        __atomic_add_fetch(&dev -> refcnt,1,__ATOMIC_RELAXED);
+    }
+
+    os_device_unlock();
+    return dev;
+}
+
+/*!
+ * 减少通过os_device_get获取的设备的引用数
+ * @param dev 设备结构体指针
+ */
+void os_device_put(os_device_p dev)
+{
+    OS_ANNOTATION_NEED_DEVICE();
+    os_size_t refcnt = __atomic_sub_fetch(&dev -> refcnt,1,__ATOMIC_RELEASE);
+    OS_ASSERT(refcnt != OS_NUMBER_MAX(os_size_t));
+}
+
 /*!
  * 设备注册
  * @param dev 设备结构体指针
@@ -73,16 +117,54 @@ os_err_t os_device_register(os_device_p dev)
 {
     OS_ANNOTATION_NEED_DEVICE();
 
-    OS_ERR_RETURN_ERROR(os_device_find(dev -> name) != OS_NULL,-OS_ERR_EINVAL);
-
+    //检查设备名与插入设备在同一次加锁中进行，避免同名设备被同时注册
     os_device_lock();
+
+    if(device_find_rcu(dev -> name) != OS_NULL)
+    {
+        os_device_unlock();
+        return -OS_ERR_EINVAL;
+    }
+
     dev -> initialized = OS_TRUE;
     os_mutex_init(&dev -> lock);
-    os_list_insert_tail(device_list,&dev -> node);
+    //设备初始化完成后才对读者可见
+    os_list_insert_tail_rcu(device_list,&dev -> node);
     os_device_unlock();
     return OS_ERR_OK;
 }
 
+/*!
+ * 设备解注册，返回后已经没有读者能够通过设备列表访问该设备，调用者可以释放设备结构体
+ * @param dev 设备结构体指针
+ * @return 成功返回OS_ERR_OK，设备未注册或已经解注册返回-OS_ERR_EINVAL，设备仍被打开返回-OS_ERR_EBUSY
+ */
+os_err_t os_device_unregister(os_device_p dev)
+{
+    OS_ANNOTATION_NEED_DEVICE();
+    os_device_lock();
+
+    //已移除的节点prev为空
+    if(dev -> node.prev == OS_NULL)
+    {
+        os_device_unlock();
+        return -OS_ERR_EINVAL;
+    }
+
+    //引用数只在持有全局锁时从0增加，因此检查通过后不会再有新的引用
+    if(__atomic_load_n(&dev -> refcnt,__ATOMIC_ACQUIRE) > 0)
+    {
+        os_device_unlock();
+        return -OS_ERR_EBUSY;
+    }
+
+    os_list_node_remove_rcu(&dev -> node);
+    os_device_unlock();
+    //等待所有可能正在访问该设备的读者退出
+    os_rcu_synchronize();
+    return OS_ERR_OK;
+}
+
 /*!
  * 调用设备的初始化函数
  * @param dev 设备结构体指针
@@ -151,7 +233,7 @@ os_err_t os_device_op_open(os_device_p dev,os_size_t open_flag)
         }
     }
 
-    dev -> refcnt++;//增加设备引用数
+    __atomic_add_fetch(&dev -> refcnt,1,__ATOMIC_RELAXED);//增加设备引用数，调用者必须已经持有设备的引用
     os_mutex_unlock(&dev -> lock);
     return OS_ERR_OK;
 }
@@ -182,7 +264,7 @@ os_err_t os_device_op_close(os_device_p dev)
         }
     }
 
-    dev -> refcnt--;//减少设备引用数
+    __atomic_sub_fetch(&dev -> refcnt,1,__ATOMIC_RELEASE);//减少设备引用数
     os_mutex_unlock(&dev -> lock);
     return OS_ERR_OK;
 }
@@ -198,23 +280,32 @@ os_err_t os_device_op_close(os_device_p dev)
 os_err_t os_device_op_read(os_device_p dev,void *buf,os_size_t pos,os_size_t size)
 {
     OS_ANNOTATION_NEED_DEVICE();
-    os_mutex_lock(&dev -> lock);
+    //自行处理并发控制的设备（如可能长时间阻塞的控制台）不持有设备锁
+    os_bool_t need_lock = !(dev -> flag & OS_DEVICE_FLAG_SELF_LOCK);
 
     //权限检查
     if(dev -> open_flag & OS_FILE_FLAG_WRONLY)
     {
-        os_mutex_unlock(&dev -> lock);
         return -OS_ERR_EACCES;
     }
 
     os_err_t ret = 0;
 
+    if(need_lock)
+    {
+        os_mutex_lock(&dev -> lock);
+    }
+
     if(dev -> ops -> read != OS_NULL)
     {
         ret = dev -> ops -> read(dev,buf,pos,size);
     }
 
-    os_mutex_unlock(&dev -> lock);
+    if(need_lock)
+    {
+        os_mutex_unlock(&dev -> lock);
+    }
+
     return ret;
 }
 
@@ -229,23 +320,32 @@ os_err_t os_device_op_read(os_device_p dev,void *buf,os_size_t pos,os_size_t siz
 os_err_t os_device_op_write(os_device_p dev,const void *buf,os_size_t pos,os_size_t size)
 {
     OS_ANNOTATION_NEED_DEVICE();
-    os_mutex_lock(&dev -> lock);
+    //自行处理并发控制的设备（如可能长时间阻塞的控制台）不持有设备锁
+    os_bool_t need_lock = !(dev -> flag & OS_DEVICE_FLAG_SELF_LOCK);
 
     //权限检查
     if(!(dev -> open_flag & (OS_FILE_FLAG_WRONLY | OS_FILE_FLAG_RDWR)))
     {
-        os_mutex_unlock(&dev -> lock);
         return -OS_ERR_EACCES;
     }
 
     os_err_t ret = 0;
 
+    if(need_lock)
+    {
+        os_mutex_lock(&dev -> lock);
+    }
+
     if(dev -> ops -> write != OS_NULL)
     {
         ret = dev -> ops -> write(dev,buf,pos,size);
     }
 
-    os_mutex_unlock(&dev -> lock);
+    if(need_lock)
+    {
+        os_mutex_unlock(&dev -> lock);
+    }
+
     return ret;
 }
 
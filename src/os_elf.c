@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-07-08     lizhirui     the first version
  * 2021-07-09     lizhirui     add fd_table support
+ * 2021-07-28     lizhirui     allocate task name and path to their actual length
  */
 
 // @formatter:off
@@ -211,10 +212,8 @@ os_err_t os_elf_load(const char *path,os_size_t *entry)
     OS_ASSERT(t_fd != OS_NULL);
     OS_ERR_GET_ERROR_AND_GOTO(os_file_open(t_fd,OS_CONSOLE_DEVICE,OS_FILE_FLAG_WRONLY),ret,fd_table_err);
 
-    //销毁旧文件描述符表
-    os_file_fd_table_remove(old_fd_table);
     //设置任务可执行文件路径
-    os_strcpy(task -> path,path);
+    OS_ERR_GET_ERROR_AND_GOTO(os_task_set_path(task,path),ret,fd_table_err);
     const char *filename = path;
     const char *buf = path;
 
@@ -229,7 +228,9 @@ os_err_t os_elf_load(const char *path,os_size_t *entry)
     }
 
     //更新任务名
-    os_strcpy(task -> name,filename);
+    OS_ERR_GET_ERROR_AND_GOTO(os_task_set_name(task,filename),ret,fd_table_err);
+    //销毁旧文件描述符表
+    os_file_fd_table_remove(old_fd_table);
     task -> vtable = vtable;//设置任务页表
     os_mmu_switch(vtable);//切换到新的页表
     *entry = ehdr.e_entry;//返回任务的入口地址
@@ -8,30 +8,51 @@
  * 2021-07-05     lizhirui     the first version
  * 2021-07-06     lizhirui     add finer-grained lock
  * 2021-07-09     lizhirui     add fd_table support and open_flag check
+ * 2021-07-28     lizhirui     use rwsem as the file manager lock and take it in read mode when opening an existing file node
+ * 2021-07-28     lizhirui     free file node of failed open while holding file manager lock in write mode
+ * 2021-07-28     lizhirui     take file manager lock in read mode when closing a file unless the file node must be destroyed
  */
 
 // @formatter:off
 #include <dreamos.h>
 
 static os_list_node_t os_file_list;//系统文件节点列表
-static os_mutex_t os_file_global_lock;//文件管理器全局锁
+static os_rwsem_t os_file_global_lock;//文件管理器全局锁，查找文件节点时以读模式获取，插入和删除文件节点时以写模式获取
 
 /*!
- * 锁定文件管理器
+ * 以读模式锁定文件管理器
+ */
+static void os_file_read_lock()
+{
+    OS_ANNOTATION_NEED_VFS();
+    os_rwsem_down_read(&os_file_global_lock);
+}
+
+/*!
+ * 文件管理器读模式解锁
+ */
+static void os_file_read_unlock()
+{
+    OS_ANNOTATION_NEED_VFS();
+    os_rwsem_up_read(&os_file_global_lock);
+}
+
+/*!
+ * 以写模式锁定文件管理器
  */
 static void os_file_lock()
 {
     OS_ANNOTATION_NEED_VFS();
-    os_mutex_lock(&os_file_global_lock);
+    os_rwsem_down_write(&os_file_global_lock);
 }
 
 /*!
- * 解锁文件管理器
+ * 文件管理器写模式解锁
  */
 static void os_file_unlock()
 {
     OS_ANNOTATION_NEED_VFS();
-    os_mutex_unlock(&os_file_global_lock);
+    os_rwsem_up_write(&os_file_global_lock);
 }
 
 /*!
@@ -134,25 +155,22 @@ void os_file_fdid_remove(os_size_t fdid)
 }
 
 /*!
- * 根据文件路径寻找文件节点结构体并返回其指针
+ * 根据文件路径寻找文件节点结构体并返回其指针，调用者必须锁定文件管理器（读模式或写模式）
  * @param path 文件路径
  * @return 成功返回文件节点结构体指针，失败返回OS_NULL
  */
 static os_file_node_p os_file_fnode_find(const char *path)
 {
     OS_ANNOTATION_NEED_VFS();
-    os_file_lock();
 
     os_list_entry_foreach(os_file_list,os_file_node_t,node,entry,
     {
         if(os_strcmp(entry -> path,path) == 0)
         {
-            os_file_unlock();
             return entry;
         }
     });
 
-    os_file_unlock();
     return OS_NULL;
 }
 
@@ -250,46 +268,65 @@ void os_file_fd_table_remove(os_file_fd_table_p fd_table)
 os_err_t os_file_open(os_file_fd_p fd,const char *path,os_size_t open_flag)
 {
     OS_ANNOTATION_NEED_VFS();
-    //因为需要对文件列表及文件系统进行操作，所以首先需要开启二者的全局锁
-    os_file_lock();
-    vfs_lock();
-
     os_err_t ret = OS_ERR_OK;
 
-    //首先需要正规化路径，因此分配存放路径的内存空间
+    //首先需要正规化路径，因此分配存放路径的内存空间，正规化不涉及共享数据，无需加锁
     char *path_buf = os_memory_alloc(OS_VFS_PATH_MAX + 1);
-    OS_ERR_SET_ERROR_AND_GOTO(path_buf == OS_NULL,ret,-OS_ERR_ENOMEM,path_buf_alloc_err);
+    OS_ERR_RETURN_ERROR(path_buf == OS_NULL,-OS_ERR_ENOMEM);
     //执行路径正规化操作
     OS_ERR_GET_ERROR_AND_GOTO(os_vfs_normalize_path(path,path_buf),ret,err);
 
+    //查找期间只需以读模式锁定VFS，多个任务可以同时打开文件
+    vfs_read_lock();
     //根据路径获取文件系统节点
     os_vfs_mp_p mp = os_vfs_find_mp_by_path(path_buf);
-    OS_ERR_SET_ERROR_AND_GOTO(mp == OS_NULL,ret,-OS_ERR_ENOENT,err);
+
+    if(mp == OS_NULL)
+    {
+        vfs_read_unlock();
+        ret = -OS_ERR_ENOENT;
+        goto err;
+    }
 
     //试图获取文件节点，若获取失败，则分配一个新的文件节点，否则共享现有的文件节点
-    os_file_node_p fnode = os_file_fnode_find(path);
+    os_file_read_lock();
+    os_file_node_p fnode = os_file_fnode_find(path_buf);
     os_bool_t fnode_allocated = OS_FALSE;
 
     if(fnode == OS_NULL)
     {
-        fnode_allocated = OS_TRUE;
-        fnode = os_memory_alloc(sizeof(os_file_node_t));
-        
+        //插入文件节点需要以写模式锁定文件管理器，重新加锁期间其它任务可能已经创建了该文件节点，因此需要重新查找
+        os_file_read_unlock();
+        os_file_lock();
+        fnode = os_file_fnode_find(path_buf);
+
         if(fnode == OS_NULL)
         {
-            vfs_unlock();
-            os_memory_free(path_buf);
-            return -OS_ERR_ENOMEM;
+            fnode_allocated = OS_TRUE;
+            fnode = os_memory_alloc(sizeof(os_file_node_t));
+
+            if(fnode == OS_NULL)
+            {
+                os_file_unlock();
+                vfs_read_unlock();
+                ret = -OS_ERR_ENOMEM;
+                goto err;
+            }
+
+            fnode -> refcnt = 0;
+            fnode -> mp = mp;
+            fnode -> ops = mp -> fs -> ops -> file_ops;
+            //初始化文件节点的锁
+            os_mutex_init(&fnode -> lock);
+            os_strcpy(fnode -> path,path_buf);
+            //将新的文件节点挂入系统文件节点列表
+            os_list_insert_tail(os_file_list,&fnode -> node);
+        }
+        else
+        {
+            //其它任务已经创建了该文件节点，降级为读模式，避免在等待挂载点锁期间阻塞其它任务查找文件节点
+            os_rwsem_downgrade(&os_file_global_lock);
         }
-
-        fnode -> refcnt = 0;
-        fnode -> mp = mp;
-        fnode -> ops = mp -> fs -> ops -> file_ops;
-        //初始化文件节点的锁
-        os_mutex_init(&fnode -> lock);
-        os_strcpy(fnode -> path,path_buf);
-        //将新的文件节点挂入系统文件节点列表
-        os_list_insert_tail(os_file_list,&fnode -> node);
     }
 
     //初始化文件描述符的锁
@@ -301,10 +338,16 @@ os_err_t os_file_open(os_file_fd_p fd,const char *path,os_size_t open_flag)
 
     //锁定文件系统并解锁全局锁以提高并发效率，该操作必须在vfs解锁前完成以保证原子性
     os_mutex_lock(&mp -> lock);
-    vfs_unlock();
+    vfs_read_unlock();
     //对文件节点加锁，该操作必须在文件管理器全局锁解锁前完成以保证原子性
     os_mutex_lock(&fnode -> lock);
-    os_file_unlock();
+
+    //新分配的文件节点在打开操作完成前保持写模式锁定，使其它任务在打开失败时无法找到该文件节点，从而可以安全地释放
+    if(!fnode_allocated)
+    {
+        os_file_read_unlock();
+    }
+
     //执行文件的打开操作
     ret = mp -> fs -> ops -> file_ops -> open(fd);
 
@@ -319,13 +362,21 @@ os_err_t os_file_open(os_file_fd_p fd,const char *path,os_size_t open_flag)
         //增加文件节点的引用数
         fnode -> refcnt++;
         os_mutex_unlock(&fnode -> lock);
+
+        if(fnode_allocated)
+        {
+            os_file_unlock();
+        }
     }
     else
     {
         if(fnode_allocated)
         {
+            //仍然持有写模式锁，其它任务不可能引用该文件节点
             os_list_node_remove(&fnode -> node);
+            os_mutex_unlock(&fnode -> lock);
             os_memory_free(fnode);
+            os_file_unlock();
         }
         else
         {
@@ -340,12 +391,57 @@ os_err_t os_file_open(os_file_fd_p fd,const char *path,os_size_t open_flag)
 
 err:
     os_memory_free(path_buf);
-path_buf_alloc_err:
-    vfs_unlock();
-    os_file_unlock();
     return ret;
 }
 
+/*!
+ * 释放文件节点的一个引用，引用数变为0时将文件节点从系统文件节点列表中移除并销毁
+ * 引用数大于1时只需以读模式锁定文件管理器，否则需要以写模式重新加锁，使移除时其它任务无法查找到该文件节点
+ * @param fnode 文件节点结构体指针
+ */
+static void os_file_fnode_put(os_file_node_p fnode)
+{
+    os_vfs_mp_p mp = fnode -> mp;
+
+    //需要先后对文件系统和文件节点加锁（顺序不可错，防止死锁）
+    os_file_read_lock();
+    os_mutex_lock(&mp -> lock);
+    os_mutex_lock(&fnode -> lock);
+
+    if(fnode -> refcnt > 1)
+    {
+        fnode -> refcnt--;
+        os_mutex_unlock(&fnode -> lock);
+        os_mutex_unlock(&mp -> lock);
+        os_file_read_unlock();
+        return;
+    }
+
+    //当前任务持有最后一个引用，重新加锁期间文件节点不会被销毁，但其它任务可能打开该文件节点，因此需要在写模式下重新检查引用数
+    os_mutex_unlock(&fnode -> lock);
+    os_mutex_unlock(&mp -> lock);
+    os_file_read_unlock();
+    os_file_lock();
+    os_mutex_lock(&mp -> lock);
+    os_mutex_lock(&fnode -> lock);
+    fnode -> refcnt--;
+
+    if(fnode -> refcnt == 0)
+    {
+        mp -> open_file_cnt--;
+        os_list_node_remove(&fnode -> node);
+        os_mutex_unlock(&fnode -> lock);
+        os_memory_free(fnode);
+    }
+    else
+    {
+        os_mutex_unlock(&fnode -> lock);
+    }
+
+    os_mutex_unlock(&mp -> lock);
+    os_file_unlock();
+}
+
 /*!
  * 关闭文件
  * @param fd 文件描述符结构体指针
@@ -354,39 +450,17 @@ path_buf_alloc_err:
 os_err_t os_file_close(os_file_fd_p fd)
 {
     OS_ANNOTATION_NEED_VFS();
-    //因为可能对文件列表进行操作，所以此处对文件管理器加全局锁
-    os_file_lock();
     os_mutex_lock(&fd -> lock);//锁定该文件描述符
     //执行该文件描述符的关闭操作
     os_err_t ret = fd -> fnode -> ops -> close(fd);
     
     if(ret == OS_ERR_OK)
     {
-        /*
-         * 需要减少文件节点的引用数，若引用数变为0时需要销毁该文件节点，
-         * 因为可能涉及到文件系统操作，需要先后对文件系统和文件节点加锁（顺序不可错，防止死锁）
-         */
-        os_mutex_lock(&fd -> fnode -> mp -> lock);
-        os_mutex_lock(&fd -> fnode -> lock);
-        fd -> fnode -> refcnt--;
-
-        if(fd -> fnode -> refcnt == 0)
-        {
-            //引用数变为0时需要销毁文件节点
-            fd -> fnode -> mp -> open_file_cnt--;
-            os_list_node_remove(&fd -> fnode -> node);
-            os_memory_free(fd -> fnode);
-        }
-        else
-        {
-            os_mutex_unlock(&fd -> fnode -> lock);
-        }
-        
-        os_mutex_unlock(&fd -> fnode -> mp -> lock);
+        //需要减少文件节点的引用数，若引用数变为0时需要销毁该文件节点
+        os_file_fnode_put(fd -> fnode);
     }
 
     os_mutex_unlock(&fd -> lock);
-    os_file_unlock();
     return ret;
 }
 
@@ -510,5 +584,5 @@ os_err_t os_file_readdir(os_file_fd_p fd,os_dirent_p entry,os_size_t count)
 void os_file_init()
 {
     os_list_init(os_file_list);
-    os_mutex_init(&os_file_global_lock);
+    os_rwsem_init(&os_file_global_lock,OS_RWSEM_PREFER_READER);
 }
\ No newline at end of file
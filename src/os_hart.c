@@ -0,0 +1,151 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-25     lizhirui     the first version
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+extern os_size_t __stack_default;
+extern os_size_t __stack_interrupt_cpu0;
+
+void arch_hart_init(os_hart_p hart);
+os_size_t arch_mmu_get_satp(os_mmu_vtable_p vtable);
+
+//hart私有数据列表，按逻辑处理器编号索引，主核固定使用第0项，启动汇编程序会直接访问该列表
+os_hart_t os_hart_list[OS_CPU_MAX_NUM];
+//在线的hart数量
+static volatile os_size_t os_hart_online_num = 0;
+
+/*!
+ * 主核hart初始化函数，必须在内核初始化的最开始调用，主核的中断栈由链接脚本提供
+ */
+void os_hart_init()
+{
+    os_hart_p hart = os_hart_get_current();
+
+    OS_ASSERT(hart == &os_hart_list[0]);
+    hart -> cpu_id = 0;
+    hart -> interrupt_stack_addr = (os_size_t)&__stack_default;
+    hart -> interrupt_stack_top = (os_size_t)&__stack_interrupt_cpu0;
+    arch_hart_init(hart);
+    hart -> online = OS_TRUE;
+    os_hart_online_num = 1;
+}
+
+/*!
+ * 获取当前hart的私有数据，若调用者处于可被抢占的上下文中，返回后任务可能已被迁移到其它hart
+ * @return 当前hart的私有数据结构体指针
+ */
+os_hart_p os_hart_get_current()
+{
+    return (os_hart_p)ARCH_GET_THREAD_POINTER();
+}
+
+/*!
+ * 通过逻辑处理器编号获取hart私有数据
+ * @param cpu_id 逻辑处理器编号
+ * @return hart私有数据结构体指针
+ */
+os_hart_p os_hart_get(os_size_t cpu_id)
+{
+    OS_ASSERT(cpu_id < OS_CPU_MAX_NUM);
+    return &os_hart_list[cpu_id];
+}
+
+/*!
+ * 获取当前hart的逻辑处理器编号
+ * @return 逻辑处理器编号
+ */
+os_size_t os_hart_get_cpu_id()
+{
+    return os_hart_get_current() -> cpu_id;
+}
+
+/*!
+ * 获取在线的hart数量
+ * @return 在线的hart数量
+ */
+os_size_t os_hart_get_online_num()
+{
+    return __atomic_load_n(&os_hart_online_num,__ATOMIC_ACQUIRE);
+}
+
+/*!
+ * 启动所有从核，由主核的idle任务调用，每个从核拥有独立的中断栈与idle任务
+ */
+void os_hart_startup_secondary()
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_size_t boot_hart_id = os_hart_get(0) -> hart_id;
+    os_size_t cpu_id = 1;
+    os_size_t hart_id;
+
+    for(hart_id = 0;(hart_id < OS_CPU_MAX_NUM) && (cpu_id < OS_CPU_MAX_NUM);hart_id++)
+    {
+        //跳过主核以及不存在或已启动的hart
+        if((hart_id == boot_hart_id) || !bsp_hart_is_available(hart_id))
+        {
+            continue;
+        }
+
+        os_hart_p hart = &os_hart_list[cpu_id];
+        hart -> hart_id = hart_id;
+        hart -> cpu_id = cpu_id;
+        hart -> online = OS_FALSE;
+        hart -> interrupt_stack_addr = (os_size_t)os_memory_alloc(OS_HART_INTERRUPT_STACK_SIZE);
+
+        if(!hart -> interrupt_stack_addr)
+        {
+            os_printf("hart %ld:interrupt stack alloc failed\n",hart_id);
+            break;
+        }
+
+        hart -> interrupt_stack_top = hart -> interrupt_stack_addr + OS_HART_INTERRUPT_STACK_SIZE;
+        hart -> current_vtable = os_mmu_get_kernel_pagetable();
+        hart -> boot_satp = arch_mmu_get_satp(hart -> current_vtable);
+
+        if((hart -> idle_task = os_task_idle_create(cpu_id)) == OS_NULL)
+        {
+            os_printf("hart %ld:idle task create failed\n",hart_id);
+            os_memory_free((void *)hart -> interrupt_stack_addr);
+            break;
+        }
+
+        //保证从核能够看到以上初始化的数据
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        if(bsp_hart_start(hart_id,(os_size_t)hart) != OS_ERR_OK)
+        {
+            os_printf("hart %ld:start failed\n",hart_id);
+            os_task_remove(hart -> idle_task);
+            hart -> idle_task = OS_NULL;
+            os_memory_free((void *)hart -> interrupt_stack_addr);
+            continue;
+        }
+
+        cpu_id++;
+    }
+}
+
+/*!
+ * 从核的C语言入口，由_secondary_start在开启MMU后调用，此时中断处于关闭状态，该函数不会返回
+ */
+OS_NORETURN void os_hart_secondary_main()
+{
+    os_hart_p hart = os_hart_get_current();
+
+    arch_hart_init(hart);
+    bsp_hart_secondary_init();
+    hart -> online = OS_TRUE;
+    __atomic_fetch_add(&os_hart_online_num,1,__ATOMIC_RELEASE);
+    os_printf("hart %ld online as cpu %ld\n",hart -> hart_id,hart -> cpu_id);
+    os_task_scheduler_start();
+    //代码不应该执行到这里
+    while(1);
+}
\ No newline at end of file
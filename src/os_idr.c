@@ -0,0 +1,506 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ * 2021-07-28     lizhirui     add rcu mode for lockless lookup
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*
+ * 基数树每层OS_IDR_BITS位，每个节点用一个os_size_t记录各槽位是否已满，查找空闲id时逐层通过ctz直接定位第一个未满的槽位
+ * 因此分配、查找和释放的复杂度均为O(树的高度)，与已分配的id数量无关
+ * RCU模式下节点清零后才通过os_rcu_assign_pointer挂入树中，从树中摘下的节点在宽限期结束后才释放，因此查找只需沿槽位指针向下遍历，不读取已满标记
+ */
+#define IDR_SLOT_MASK MASK(OS_IDR_BITS)
+#define IDR_NODE_FULL OS_NUMBER_MAX(os_size_t)
+
+/*!
+ * 获取树的第level层（根节点为第0层）中id对应的槽位下标
+ * @param idr ID分配器结构体指针
+ * @param level 层号
+ * @param id id
+ * @return 槽位下标
+ */
+static inline os_size_t idr_index(os_idr_p idr,os_size_t level,os_size_t id)
+{
+    return (id >> ((idr -> height - 1 - level) * OS_IDR_BITS)) & IDR_SLOT_MASK;
+}
+
+/*!
+ * 分配一个清零的节点，优先使用缓存节点
+ * @param idr ID分配器结构体指针
+ * @return 成功返回节点指针，失败返回OS_NULL
+ */
+static os_idr_node_p idr_node_alloc(os_idr_p idr)
+{
+    os_idr_node_p node = idr -> spare;
+
+    if(node != OS_NULL)
+    {
+        idr -> spare = OS_NULL;
+    }
+    else if((node = os_memory_alloc(sizeof(os_idr_node_t))) == OS_NULL)
+    {
+        return OS_NULL;
+    }
+
+    os_memset(node,0,sizeof(os_idr_node_t));
+    idr -> node_count++;
+    return node;
+}
+
+/*!
+ * RCU模式下节点的延迟释放回调
+ * @param head 节点中的RCU回调节点
+ */
+static void idr_node_rcu_free(os_rcu_head_p head)
+{
+    os_memory_free(os_container_of(head,os_idr_node_t,rcu));
+}
+
+/*!
+ * 释放一个节点，缓存节点为空时保留该节点，RCU模式下读者可能仍在访问该节点，因此不缓存，在宽限期结束后释放
+ * @param idr ID分配器结构体指针
+ * @param node 节点指针
+ */
+static void idr_node_free(os_idr_p idr,os_idr_node_p node)
+{
+    idr -> node_count--;
+
+    if(idr -> rcu)
+    {
+        os_rcu_call(&node -> rcu,idr_node_rcu_free);
+    }
+    else if(idr -> spare == OS_NULL)
+    {
+        idr -> spare = node;
+    }
+    else
+    {
+        os_memory_free(node);
+    }
+}
+
+/*!
+ * 在子树中查找第一个不小于id的空闲id
+ * @param node 子树根节点
+ * @param shift 该节点槽位下标在id中的起始位
+ * @param base 该子树覆盖的第一个id
+ * @param id 查找的起始id，必须位于该子树覆盖的范围内
+ * @return 找到返回空闲id，否则返回OS_IDR_NONE
+ */
+static os_size_t idr_find_free(os_idr_node_p node,os_size_t shift,os_size_t base,os_size_t id)
+{
+    os_size_t first = (id >> shift) & IDR_SLOT_MASK;
+    os_size_t index = first;
+
+    while(index < OS_IDR_SLOT_NUM)
+    {
+        os_size_t free = ~node -> full & ~MASK(index);
+
+        if(free == 0)
+        {
+            return OS_IDR_NONE;
+        }
+
+        index = __builtin_ctzl(free);
+
+        //越过了起始槽位，从新槽位覆盖的第一个id开始查找
+        if(index != first)
+        {
+            id = base + (index << shift);
+        }
+
+        //空的槽位或不存在的子树中所有id都是空闲的
+        if((shift == 0) || (node -> slot[index] == OS_NULL))
+        {
+            return id;
+        }
+
+        os_size_t ret = idr_find_free(node -> slot[index],shift - OS_IDR_BITS,base + (index << shift),id);
+
+        if(ret != OS_IDR_NONE)
+        {
+            return ret;
+        }
+
+        //子树中不小于id的部分已满，继续查找下一个槽位
+        index++;
+    }
+
+    return OS_IDR_NONE;
+}
+
+/*!
+ * 查找[id,end)范围内的第一个空闲id
+ * @param idr ID分配器结构体指针
+ * @param id 查找的起始id
+ * @return 找到返回空闲id，否则返回OS_IDR_NONE
+ */
+static os_size_t idr_find_free_from(os_idr_p idr,os_size_t id)
+{
+    if(id >= idr -> end)
+    {
+        return OS_IDR_NONE;
+    }
+
+    if(idr -> root == OS_NULL)
+    {
+        return id;
+    }
+
+    os_size_t ret = idr_find_free(idr -> root,(idr -> height - 1) * OS_IDR_BITS,0,id);
+    return (ret < idr -> end) ? ret : OS_IDR_NONE;
+}
+
+/*!
+ * 释放id所在路径上所有空的节点，自底向上进行，遇到非空节点时停止
+ * @param idr ID分配器结构体指针
+ * @param path id所在路径上的节点，path[i]为第i层的节点
+ * @param depth 路径上已存在的节点数量
+ * @param id id
+ */
+static void idr_shrink(os_idr_p idr,os_idr_node_p *path,os_size_t depth,os_size_t id)
+{
+    while(depth > 0)
+    {
+        os_idr_node_p node = path[depth - 1];
+
+        if(node -> count != 0)
+        {
+            break;
+        }
+
+        idr_node_free(idr,node);
+        depth--;
+
+        if(depth == 0)
+        {
+            os_rcu_assign_pointer(idr -> root,OS_NULL);
+        }
+        else
+        {
+            os_rcu_assign_pointer(path[depth - 1] -> slot[idr_index(idr,depth - 1,id)],OS_NULL);
+            path[depth - 1] -> count--;
+        }
+    }
+}
+
+/*!
+ * 在空闲id处插入指针，并更新路径上各节点的已满标记
+ * @param idr ID分配器结构体指针
+ * @param id 空闲id
+ * @param ptr 指针
+ * @return 成功返回OS_ERR_OK，节点分配失败返回-OS_ERR_ENOMEM
+ */
+static os_err_t idr_insert(os_idr_p idr,os_size_t id,void *ptr)
+{
+    os_idr_node_p path[OS_IDR_MAX_HEIGHT];
+    void **slot = (void **)&idr -> root;
+    os_size_t level;
+
+    for(level = 0;level < idr -> height;level++)
+    {
+        if(*slot == OS_NULL)
+        {
+            os_idr_node_p node = idr_node_alloc(idr);
+
+            if(node == OS_NULL)
+            {
+                idr_shrink(idr,path,level,id);
+                return -OS_ERR_ENOMEM;
+            }
+
+            //节点初始化完成后才对读者可见
+            os_rcu_assign_pointer(*slot,node);
+
+            if(level > 0)
+            {
+                path[level - 1] -> count++;
+            }
+        }
+
+        path[level] = *slot;
+        slot = &path[level] -> slot[idr_index(idr,level,id)];
+    }
+
+    os_rcu_assign_pointer(*slot,ptr);
+    path[idr -> height - 1] -> count++;
+
+    //自底向上设置已满标记，直到某一层的节点未满为止
+    for(level = idr -> height;level > 0;level--)
+    {
+        os_idr_node_p node = path[level - 1];
+        node -> full |= SIZE(idr_index(idr,level - 1,id));
+
+        if(node -> full != IDR_NODE_FULL)
+        {
+            break;
+        }
+    }
+
+    idr -> count++;
+    return OS_ERR_OK;
+}
+
+/*!
+ * 查找id所在的叶子节点
+ * @param idr ID分配器结构体指针
+ * @param id id
+ * @param path 若不为OS_NULL，则返回id所在路径上的节点
+ * @return id已被分配返回叶子节点指针，否则返回OS_NULL
+ */
+static os_idr_node_p idr_lookup(os_idr_p idr,os_size_t id,os_idr_node_p *path)
+{
+    os_idr_node_p node = idr -> root;
+    os_size_t level;
+
+    if(id >= idr -> end)
+    {
+        return OS_NULL;
+    }
+
+    for(level = 0;(node != OS_NULL) && (level < (idr -> height - 1));level++)
+    {
+        if(path != OS_NULL)
+        {
+            path[level] = node;
+        }
+
+        node = node -> slot[idr_index(idr,level,id)];
+    }
+
+    if((node == OS_NULL) || !(node -> full & SIZE(id & IDR_SLOT_MASK)))
+    {
+        return OS_NULL;
+    }
+
+    if(path != OS_NULL)
+    {
+        path[level] = node;
+    }
+
+    return node;
+}
+
+/*!
+ * 初始化ID分配器
+ * @param idr ID分配器结构体指针
+ * @param start 可分配的最小id
+ * @param end 可分配的最大id + 1，必须大于start
+ */
+void os_idr_init(os_idr_p idr,os_size_t start,os_size_t end)
+{
+    OS_ASSERT(idr != OS_NULL);
+    OS_ASSERT(end > start);
+
+    idr -> root = OS_NULL;
+    idr -> spare = OS_NULL;
+    idr -> height = 1;
+    idr -> start = start;
+    idr -> end = end;
+    idr -> next = start;
+    idr -> count = 0;
+    idr -> node_count = 0;
+    idr -> rcu = OS_FALSE;
+
+    //计算覆盖[0,end)所需的树高度
+    while(((idr -> height * OS_IDR_BITS) < (sizeof(os_size_t) << 3)) && (((end - 1) >> (idr -> height * OS_IDR_BITS)) != 0))
+    {
+        idr -> height++;
+    }
+}
+
+/*!
+ * 以RCU模式初始化ID分配器，修改操作仍由调用者负责同步，os_idr_find可以在RCU读临界区中无锁调用
+ * @param idr ID分配器结构体指针
+ * @param start 可分配的最小id
+ * @param end 可分配的最大id + 1，必须大于start
+ */
+void os_idr_init_rcu(os_idr_p idr,os_size_t start,os_size_t end)
+{
+    os_idr_init(idr,start,end);
+    idr -> rcu = OS_TRUE;
+}
+
+/*!
+ * 释放子树中的所有节点
+ * @param node 子树根节点
+ * @param level 子树根节点所在的层号
+ * @param height 树的高度
+ */
+static void idr_destroy_subtree(os_idr_node_p node,os_size_t level,os_size_t height)
+{
+    os_size_t i;
+
+    if(level < (height - 1))
+    {
+        for(i = 0;i < OS_IDR_SLOT_NUM;i++)
+        {
+            if(node -> slot[i] != OS_NULL)
+            {
+                idr_destroy_subtree(node -> slot[i],level + 1,height);
+            }
+        }
+    }
+
+    os_memory_free(node);
+}
+
+/*!
+ * 销毁ID分配器，释放所有节点，已保存的指针由调用者自行处理，RCU模式下调用者必须保证已经没有读者
+ * @param idr ID分配器结构体指针
+ */
+void os_idr_destroy(os_idr_p idr)
+{
+    os_bool_t rcu = idr -> rcu;
+
+    if(idr -> root != OS_NULL)
+    {
+        idr_destroy_subtree(idr -> root,0,idr -> height);
+    }
+
+    if(idr -> spare != OS_NULL)
+    {
+        os_memory_free(idr -> spare);
+    }
+
+    os_idr_init(idr,idr -> start,idr -> end);
+    idr -> rcu = rcu;
+}
+
+/*!
+ * 分配最小的空闲id，并将其与指针关联
+ * @param idr ID分配器结构体指针
+ * @param ptr 要关联的指针，可以为OS_NULL
+ * @param id 返回分配的id
+ * @return 成功返回OS_ERR_OK，没有空闲id返回-OS_ERR_ENOSPC，内存不足返回-OS_ERR_ENOMEM
+ */
+os_err_t os_idr_alloc(os_idr_p idr,void *ptr,os_size_t *id)
+{
+    OS_ASSERT(id != OS_NULL);
+    os_size_t ret = idr_find_free_from(idr,idr -> start);
+    OS_ERR_RETURN_ERROR(ret == OS_IDR_NONE,-OS_ERR_ENOSPC);
+    OS_ERR_GET_ERROR_AND_RETURN(idr_insert(idr,ret,ptr));
+    *id = ret;
+    return OS_ERR_OK;
+}
+
+/*!
+ * 从上一次分配的id之后开始循环分配空闲id，并将其与指针关联，刚释放的id不会立即被重新分配
+ * @param idr ID分配器结构体指针
+ * @param ptr 要关联的指针，可以为OS_NULL
+ * @param id 返回分配的id
+ * @return 成功返回OS_ERR_OK，没有空闲id返回-OS_ERR_ENOSPC，内存不足返回-OS_ERR_ENOMEM
+ */
+os_err_t os_idr_alloc_cyclic(os_idr_p idr,void *ptr,os_size_t *id)
+{
+    OS_ASSERT(id != OS_NULL);
+    os_size_t ret = idr_find_free_from(idr,idr -> next);
+
+    //到达末尾后回绕到开头
+    if((ret == OS_IDR_NONE) && (idr -> next > idr -> start))
+    {
+        ret = idr_find_free_from(idr,idr -> start);
+    }
+
+    OS_ERR_RETURN_ERROR(ret == OS_IDR_NONE,-OS_ERR_ENOSPC);
+    OS_ERR_GET_ERROR_AND_RETURN(idr_insert(idr,ret,ptr));
+    idr -> next = ((ret + 1) < idr -> end) ? (ret + 1) : idr -> start;
+    *id = ret;
+    return OS_ERR_OK;
+}
+
+/*!
+ * 查找id关联的指针，未被分配的id对应的槽位总是为空，因此只需沿槽位指针向下遍历
+ * RCU模式下可以在RCU读临界区中调用，返回的指针只在读临界区中有效
+ * @param idr ID分配器结构体指针
+ * @param id id
+ * @return 返回关联的指针，id未被分配时返回OS_NULL
+ */
+void *os_idr_find(os_idr_p idr,os_size_t id)
+{
+    os_idr_node_p node = os_rcu_dereference(idr -> root);
+    os_size_t level;
+
+    if(id >= idr -> end)
+    {
+        return OS_NULL;
+    }
+
+    for(level = 0;(node != OS_NULL) && (level < (idr -> height - 1));level++)
+    {
+        node = os_rcu_dereference(node -> slot[idr_index(idr,level,id)]);
+    }
+
+    return (node != OS_NULL) ? os_rcu_dereference(node -> slot[id & IDR_SLOT_MASK]) : OS_NULL;
+}
+
+/*!
+ * 替换已分配的id关联的指针
+ * @param idr ID分配器结构体指针
+ * @param id id
+ * @param ptr 新的指针
+ * @return 返回原来关联的指针，id未被分配时返回OS_NULL且不做任何修改
+ */
+void *os_idr_replace(os_idr_p idr,os_size_t id,void *ptr)
+{
+    os_idr_node_p node = idr_lookup(idr,id,OS_NULL);
+
+    if(node == OS_NULL)
+    {
+        return OS_NULL;
+    }
+
+    void *old = node -> slot[id & IDR_SLOT_MASK];
+    os_rcu_assign_pointer(node -> slot[id & IDR_SLOT_MASK],ptr);
+    return old;
+}
+
+/*!
+ * 释放id，并释放路径上变为空的节点
+ * @param idr ID分配器结构体指针
+ * @param id 要释放的id
+ * @return 返回原来关联的指针，id未被分配时返回OS_NULL
+ */
+void *os_idr_remove(os_idr_p idr,os_size_t id)
+{
+    os_idr_node_p path[OS_IDR_MAX_HEIGHT];
+    os_idr_node_p node = idr_lookup(idr,id,path);
+    os_size_t level;
+
+    if(node == OS_NULL)
+    {
+        return OS_NULL;
+    }
+
+    void *ptr = node -> slot[id & IDR_SLOT_MASK];
+    os_rcu_assign_pointer(node -> slot[id & IDR_SLOT_MASK],OS_NULL);
+    node -> count--;
+
+    //路径上的所有节点都不再是满的
+    for(level = 0;level < idr -> height;level++)
+    {
+        path[level] -> full &= ~SIZE(idr_index(idr,level,id));
+    }
+
+    idr -> count--;
+    idr_shrink(idr,path,idr -> height,id);
+    return ptr;
+}
+
+/*!
+ * 获取已分配的id数量
+ * @param idr ID分配器结构体指针
+ * @return 已分配的id数量
+ */
+os_size_t os_idr_get_count(os_idr_p idr)
+{
+    return idr -> count;
+}
\ No newline at end of file
@@ -7,6 +7,15 @@
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
  * 2021-07-09     lizhirui     add device support
+ * 2021-07-21     lizhirui     add log subsystem initialization
+ * 2021-07-25     lizhirui     add hart initialization
+ * 2021-07-26     lizhirui     add timer initialization
+ * 2021-07-28     lizhirui     add kernel stack cache initialization
+ * 2021-07-28     lizhirui     add task structure layout check
+ * 2021-07-28     lizhirui     add bottom half initialization
+ * 2021-07-28     lizhirui     add wakeup batch check
+ * 2021-07-28     lizhirui     add rcu initialization
+ * 2021-07-28     lizhirui     add current task offset and mutex state alignment checks
  */
 
 // @formatter:off
@@ -48,6 +57,16 @@ static void print_system_info()
 static inline void os_build_check()
 {
     OS_BUILD_ASSERT(OS_SIZE_T_BITS != 0);
+    //任务结构体的热数据必须位于前两个缓存行中，且上下文切换汇编程序依赖sp和on_cpu的偏移
+    OS_BUILD_ASSERT(OS_TASK_HOT_SIZE <= (2 * OS_CACHE_LINE_SIZE));
+    OS_BUILD_ASSERT(__builtin_offsetof(os_task_t,sp) == 0);
+    OS_BUILD_ASSERT(__builtin_offsetof(os_task_t,on_cpu) == sizeof(os_size_t));
+    //批量唤醒使用os_size_t的位图记录需要通知的hart
+    OS_BUILD_ASSERT(OS_CPU_MAX_NUM <= (sizeof(os_size_t) << 3));
+    //当前任务通过以tp为基址的单条加载指令读取，偏移必须在12位立即数范围内
+    OS_BUILD_ASSERT(__builtin_offsetof(os_hart_t,current_task) < 2048);
+    //互斥锁状态的低两位用作标志位，要求任务结构体至少按4字节对齐
+    OS_BUILD_ASSERT(__alignof__(os_task_t) >= 4);
 }
 
 /*!
@@ -56,6 +75,8 @@ static inline void os_build_check()
 void os_init()
 {
     os_build_check();
+    os_hart_init();
+    os_log_init();
     bsp_early_init();
     print_system_info();
     os_memory_init();
@@ -63,6 +84,10 @@ void os_init()
     bsp_after_heap_init();
     os_device_init();
     os_vfs_init();
+    os_timer_system_init();
+    os_bh_system_init();
+    os_rcu_system_init();
+    os_task_stack_init();
     os_task_scheduler_init();
     bsp_after_task_scheduler_init();
     os_task_scheduler_start();
@@ -6,31 +6,51 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-25     lizhirui     add per-hart interrupt nest and big kernel lock for smp
+ * 2021-07-27     lizhirui     account interrupt time
+ * 2021-07-28     lizhirui     run bottom halves at outermost interrupt exit
+ * 2021-07-28     lizhirui     add preempt count
  */
 
 // @formatter:off
 #include <dreamos.h>
 
-//中断嵌套层次，若为0，则表示当前不在中断上下文中
-static os_size_t interrupt_nest = 0;
+//内核大锁，进入临界区时获取，保证各hart之间对内核全局数据结构的互斥访问
+static os_spinlock_t kernel_lock = OS_SPINLOCK_INIT;
 
 os_bool_t bsp_interrupt_disable();
 void bsp_interrupt_enable(os_bool_t enabled);
 
 /*!
- * 进入中断时通知内核更新当前的中断层次
+ * 进入中断时通知内核更新当前hart的中断层次，最外层中断开始前的时间计入被中断的上下文
  */
 void os_enter_interrupt()
 {
-    interrupt_nest++;
+    os_hart_p hart = os_hart_get_current();
+
+    if(hart -> interrupt_nest == 0)
+    {
+        os_cputime_update();
+    }
+
+    hart -> interrupt_nest++;
 }
 
 /*!
- * 离开中断时通知内核更新当前的中断层次
+ * 离开中断时通知内核更新当前hart的中断层次，最外层中断的执行时间计入中断时间
+ * 最外层中断离开前执行等待中的下半部，执行期间中断层次保持不变，因此下半部的执行时间也计入中断时间
  */
 void os_leave_interrupt()
 {
-    interrupt_nest--;
+    os_hart_p hart = os_hart_get_current();
+
+    if(hart -> interrupt_nest == 1)
+    {
+        os_bh_interrupt_exit();
+        os_cputime_update();
+    }
+
+    hart -> interrupt_nest--;
 }
 
 /*!
@@ -39,7 +59,165 @@ void os_leave_interrupt()
  */
 os_bool_t os_is_in_interrupt()
 {
-    return interrupt_nest > 0;
+    //关闭中断，防止读取hart数据期间任务被迁移到其它hart
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_bool_t ret = os_hart_get_current() -> interrupt_nest > 0;
+    os_interrupt_enable(interrupt_state);
+    return ret;
+}
+
+/*!
+ * 进入临界区，关闭当前hart的中断并获取内核大锁，支持嵌套调用，通常通过OS_ENTER_CRITICAL_AREA使用
+ * @return 之前的中断状态
+ */
+os_bool_t os_enter_critical_area()
+{
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_hart_p hart = os_hart_get_current();
+
+    if(hart -> kernel_lock_depth++ == 0)
+    {
+        os_spinlock_lock(&kernel_lock);
+    }
+
+    return interrupt_state;
+}
+
+/*!
+ * 离开临界区，最外层离开时释放内核大锁，并还原中断状态，通常通过OS_LEAVE_CRITICAL_AREA使用
+ * @param interrupt_state 进入临界区前的中断状态
+ */
+void os_leave_critical_area(os_bool_t interrupt_state)
+{
+    os_hart_p hart = os_hart_get_current();
+    os_bool_t resched = OS_FALSE;
+
+    if(--hart -> kernel_lock_depth == 0)
+    {
+        os_spinlock_unlock(&kernel_lock);
+        //临界区中重新允许抢占时无法立即调度，离开最外层临界区并开中断后再处理被推迟的抢占请求
+        resched = interrupt_state && hart -> need_resched;
+    }
+
+    os_interrupt_enable(interrupt_state);
+
+    if(resched)
+    {
+        os_preempt_check_resched();
+    }
+}
+
+/*!
+ * 完全释放当前hart持有的内核大锁，用于任务切换前，调用者必须处于临界区中
+ * @return 释放前的嵌套层次，用于切换回来后通过os_kernel_lock_reacquire恢复
+ */
+os_size_t os_kernel_lock_release_all()
+{
+    os_hart_p hart = os_hart_get_current();
+    os_size_t depth = hart -> kernel_lock_depth;
+
+    hart -> kernel_lock_depth = 0;
+
+    if(depth > 0)
+    {
+        os_spinlock_unlock(&kernel_lock);
+    }
+
+    return depth;
+}
+
+/*!
+ * 重新获取内核大锁并恢复嵌套层次，用于任务切换回来后，调用者必须已关闭中断
+ * @param depth os_kernel_lock_release_all返回的嵌套层次
+ */
+void os_kernel_lock_reacquire(os_size_t depth)
+{
+    if(depth > 0)
+    {
+        os_spinlock_lock(&kernel_lock);
+    }
+
+    os_hart_get_current() -> kernel_lock_depth = depth;
+}
+
+/*!
+ * 禁止抢占，支持嵌套调用，禁止抢占期间仍然可以响应中断，但中断中的调度请求会被推迟到重新允许抢占时处理
+ * 禁止抢占的区域中不能睡眠，用于保护不会在中断中访问的数据，以代替关中断
+ */
+void os_preempt_disable()
+{
+    os_task_p task = os_task_get_current_task();
+
+    if(task != OS_NULL)
+    {
+        task -> preempt_count++;
+        //禁止编译器将受保护区域中的访存移到计数增加之前
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+/*!
+ * 允许抢占，但不处理被推迟的抢占请求，用于紧接着会主动调度的场合
+ */
+void os_preempt_enable_no_resched()
+{
+    os_task_p task = os_task_get_current_task();
+
+    if(task != OS_NULL)
+    {
+        OS_ASSERT(task -> preempt_count > 0);
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        task -> preempt_count--;
+    }
+}
+
+/*!
+ * 允许抢占，最外层允许抢占时处理被推迟的抢占请求
+ */
+void os_preempt_enable()
+{
+    os_task_p task = os_task_get_current_task();
+
+    if(task != OS_NULL)
+    {
+        OS_ASSERT(task -> preempt_count > 0);
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+        if(--task -> preempt_count == 0)
+        {
+            os_preempt_check_resched();
+        }
+    }
+}
+
+/*!
+ * 若存在被推迟的抢占请求且当前可以被抢占，则立即进行调度
+ */
+void os_preempt_check_resched()
+{
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_hart_p hart = os_hart_get_current();
+    //在中断、临界区或关中断区域中不能在此处调度，分别由中断返回时的推迟切换、离开临界区时处理，关中断区域则等到下一次调度
+    os_bool_t resched = interrupt_state && hart -> need_resched && (hart -> interrupt_nest == 0) && (hart -> kernel_lock_depth == 0) && (hart -> current_task != OS_NULL) && (hart -> current_task -> preempt_count == 0);
+    os_interrupt_enable(interrupt_state);
+
+    if(resched)
+    {
+        os_task_schedule();
+    }
+}
+
+/*!
+ * 判断当前是否可以被抢占
+ * @return 可以被抢占返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_preemptible()
+{
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_hart_p hart = os_hart_get_current();
+    os_bool_t ret = interrupt_state && (hart -> interrupt_nest == 0) && (hart -> kernel_lock_depth == 0) && (hart -> current_task != OS_NULL) && (hart -> current_task -> preempt_count == 0);
+    os_interrupt_enable(interrupt_state);
+    return ret;
 }
 
 /*!
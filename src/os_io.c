@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-21     lizhirui     route os_printf and os_puts to the log ring buffer
  */
 
 // @formatter:off
@@ -430,26 +431,38 @@ size_t os_vsnprintf(char *buf,size_t size,const char *fmt,va_list args)
 }
 
 /*!
- * 打印字符串（支持格式化）
+ * 格式化字符串到指定缓冲区
+ * @param buf 缓冲区指针
+ * @param size 缓冲区大小
  * @param fmt 格式化字符串
  * @param ... 各个参数
+ * @return 格式化后的字符串长度
  */
-void os_printf(const char *fmt,...)
+size_t os_snprintf(char *buf,size_t size,const char *fmt,...)
 {
     va_list args;
     size_t length;
-    static char buffer[OS_PRINTF_BUFFER_SIZE];
 
     va_start(args,fmt);
-    length = os_vsnprintf(buffer,sizeof(buffer) - 1,fmt,args);
+    length = os_vsnprintf(buf,size,fmt,args);
+    va_end(args);
+    return length;
+}
 
-    if(length > (sizeof(buffer) - 1))
-    {
-        length = sizeof(buffer) - 1;
-    }
-    
-    bsp_puts(buffer);
+/*!
+ * 打印字符串（支持格式化），格式化在调用者栈上完成，输出通过日志环形缓冲区异步进行，因此可在任意上下文中调用
+ * @param fmt 格式化字符串
+ * @param ... 各个参数
+ */
+void os_printf(const char *fmt,...)
+{
+    va_list args;
+    char buffer[OS_PRINTF_BUFFER_SIZE];
+
+    va_start(args,fmt);
+    os_vsnprintf(buffer,sizeof(buffer),fmt,args);
     va_end(args);
+    os_log_puts(buffer);
 }
 
 /*!
@@ -458,5 +471,5 @@ void os_printf(const char *fmt,...)
  */
 void os_puts(const char *str)
 {
-    bsp_puts(str);
+    os_log_puts(str);
 }
\ No newline at end of file
@@ -0,0 +1,333 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-21     lizhirui     the first version
+ * 2021-07-28     lizhirui     wake the log task from producers above a watermark and wait on a waitqueue
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+void bsp_puts(const char *str);
+
+//槽位下标通过掩码计算，因此槽位数量必须为2的幂
+#if (OS_LOG_RECORD_NUM & (OS_LOG_RECORD_NUM - 1)) != 0
+    #error "OS_LOG_RECORD_NUM must be a power of 2"
+#endif
+
+static os_log_record_t os_log_ring[OS_LOG_RECORD_NUM];//日志环形缓冲区
+static volatile os_size_t os_log_write_pos = 0;//生产者写入位置，由各生产者通过CAS竞争推进
+static os_size_t os_log_read_pos = 0;//消费者读取位置，仅在持有消费者锁时访问
+static volatile os_size_t os_log_consumer_busy = OS_FALSE;//消费者锁，保证同一时刻只有一个消费者
+static volatile os_size_t os_log_dropped_count = 0;//因缓冲区满而丢弃的日志数量
+static os_size_t os_log_reported_dropped_count = 0;//已经报告过的丢弃日志数量
+static os_bool_t os_log_initialized = OS_FALSE;//日志子系统是否已经初始化
+static volatile os_bool_t os_log_sync_mode = OS_FALSE;//同步模式，panic后所有日志直接输出到控制台
+
+static os_task_t task_log;//日志输出任务结构体
+static os_bool_t task_log_started = OS_FALSE;//日志输出任务是否已启动
+static os_waitqueue_t task_log_waitqueue;//日志输出任务在此等待新的日志
+static volatile os_bool_t task_log_kicked = OS_FALSE;//生产者是否已经唤醒过日志输出任务，日志输出任务开始输出时清除，避免每条日志都获取内核大锁
+static os_bh_t task_log_bh;//用于唤醒日志输出任务的下半部，中断上下文中的生产者通过它唤醒日志输出任务
+
+/*!
+ * 检查是否有等待输出的日志，其它上下文正在输出时认为没有，由该上下文负责输出
+ * @return 有等待输出的日志返回OS_TRUE，否则返回OS_FALSE
+ */
+static os_bool_t os_log_pending()
+{
+    os_size_t pos = __atomic_load_n(&os_log_read_pos,__ATOMIC_RELAXED);
+    os_log_record_p record = &os_log_ring[pos & (OS_LOG_RECORD_NUM - 1)];
+
+    if(__atomic_load_n(&os_log_consumer_busy,__ATOMIC_ACQUIRE))
+    {
+        return OS_FALSE;
+    }
+
+    return __atomic_load_n(&record -> sequence,__ATOMIC_ACQUIRE) == (pos + 1);
+}
+
+/*!
+ * 唤醒日志输出任务，调用者不能持有任务树锁等内层锁
+ */
+static void os_log_task_kick()
+{
+    OS_ENTER_CRITICAL_AREA();
+
+    if(!os_waitqueue_empty(&task_log_waitqueue))
+    {
+        os_waitqueue_wakeup(&task_log_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 唤醒日志输出任务的下半部处理函数
+ * @param arg 参数
+ */
+static void os_log_bh_func(os_size_t arg)
+{
+    os_log_task_kick();
+}
+
+/*!
+ * 日志子系统初始化函数，在此之前的所有日志都同步输出
+ */
+void os_log_init()
+{
+    os_size_t i;
+
+    for(i = 0;i < OS_LOG_RECORD_NUM;i++)
+    {
+        os_log_ring[i].sequence = i;
+    }
+
+    os_log_write_pos = 0;
+    os_log_read_pos = 0;
+    os_waitqueue_init(&task_log_waitqueue);
+    os_bh_init(&task_log_bh,os_log_bh_func,0);
+    os_log_initialized = OS_TRUE;
+}
+
+/*!
+ * 尝试在环形缓冲区中写入一条日志，该函数是无锁的，可在任意上下文中调用
+ * @param str 日志内容
+ * @param length 日志长度，必须小于OS_LOG_RECORD_SIZE
+ * @return 成功返回OS_TRUE，缓冲区满返回OS_FALSE
+ */
+static os_bool_t os_log_push(const char *str,os_size_t length)
+{
+    os_size_t pos = __atomic_load_n(&os_log_write_pos,__ATOMIC_RELAXED);
+    os_log_record_p record;
+
+    //竞争一个空闲槽位
+    while(1)
+    {
+        record = &os_log_ring[pos & (OS_LOG_RECORD_NUM - 1)];
+        os_size_t sequence = __atomic_load_n(&record -> sequence,__ATOMIC_ACQUIRE);
+        os_ssize_t diff = (os_ssize_t)(sequence - pos);
+
+        if(diff == 0)
+        {
+            if(__atomic_compare_exchange_n(&os_log_write_pos,&pos,pos + 1,OS_TRUE,__ATOMIC_RELAXED,__ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            return OS_FALSE;
+        }
+        else
+        {
+            pos = __atomic_load_n(&os_log_write_pos,__ATOMIC_RELAXED);
+        }
+    }
+
+    record -> seq = pos;
+    record -> timestamp = os_tick_get();
+    record -> length = length;
+    os_memcpy(record -> data,str,length);
+    record -> data[length] = '\0';
+    //提交记录，使其对消费者可见
+    __atomic_store_n(&record -> sequence,pos + 1,__ATOMIC_RELEASE);
+    return OS_TRUE;
+}
+
+/*!
+ * 将环形缓冲区中已提交的日志全部输出到控制台，调用者必须持有消费者锁
+ */
+static void os_log_drain()
+{
+    os_size_t dropped_count = __atomic_load_n(&os_log_dropped_count,__ATOMIC_RELAXED);
+
+    while(1)
+    {
+        os_log_record_p record = &os_log_ring[os_log_read_pos & (OS_LOG_RECORD_NUM - 1)];
+
+        if(__atomic_load_n(&record -> sequence,__ATOMIC_ACQUIRE) != (os_log_read_pos + 1))
+        {
+            break;
+        }
+
+        bsp_puts(record -> data);
+        //释放槽位，供下一轮写入使用
+        __atomic_store_n(&record -> sequence,os_log_read_pos + OS_LOG_RECORD_NUM,__ATOMIC_RELEASE);
+        os_log_read_pos++;
+    }
+
+    if(dropped_count != os_log_reported_dropped_count)
+    {
+        char buf[64];
+        os_snprintf(buf,sizeof(buf),"\n[log] %ld messages dropped\n",dropped_count - os_log_reported_dropped_count);
+        bsp_puts(buf);
+        os_log_reported_dropped_count = dropped_count;
+    }
+}
+
+/*!
+ * 尝试获取消费者锁
+ * @return 成功返回OS_TRUE，否则返回OS_FALSE
+ */
+static os_bool_t os_log_consumer_trylock()
+{
+    return __atomic_exchange_n(&os_log_consumer_busy,OS_TRUE,__ATOMIC_ACQUIRE) == OS_FALSE;
+}
+
+/*!
+ * 释放消费者锁
+ */
+static void os_log_consumer_unlock()
+{
+    __atomic_store_n(&os_log_consumer_busy,OS_FALSE,__ATOMIC_RELEASE);
+}
+
+/*!
+ * 写入日志，日志会被切分为若干条记录写入环形缓冲区，并由日志输出任务异步输出到控制台
+ * 若日志子系统尚未初始化或已处于同步模式，则直接同步输出
+ * @param str 日志字符串
+ */
+void os_log_puts(const char *str)
+{
+    if(!os_log_initialized || os_log_sync_mode)
+    {
+        bsp_puts(str);
+        return;
+    }
+
+    os_size_t length = os_strlen(str);
+
+    while(length > 0)
+    {
+        os_size_t size = MIN(length,OS_LOG_RECORD_SIZE - 1);
+
+        //缓冲区满时尝试由当前上下文同步输出一次，若其它上下文正在输出，则丢弃该日志
+        if(!os_log_push(str,size))
+        {
+            if(os_log_consumer_trylock())
+            {
+                os_log_drain();
+                os_log_consumer_unlock();
+            }
+
+            if(!os_log_push(str,size))
+            {
+                __atomic_fetch_add(&os_log_dropped_count,1,__ATOMIC_RELAXED);
+            }
+        }
+
+        str += size;
+        length -= size;
+    }
+
+    //缓冲区中的日志超过水位线时提前唤醒日志输出任务，而不是等到系统空闲或缓冲区满
+    if(task_log_started && ((__atomic_load_n(&os_log_write_pos,__ATOMIC_RELAXED) - __atomic_load_n(&os_log_read_pos,__ATOMIC_RELAXED)) >= OS_LOG_WAKEUP_WATERMARK))
+    {
+        os_task_p task = os_task_get_current_task();
+
+        if(os_is_in_interrupt())
+        {
+            if(!__atomic_exchange_n(&task_log_kicked,OS_TRUE,__ATOMIC_RELAXED))
+            {
+                os_bh_schedule(&task_log_bh);
+            }
+        }
+        //禁止抢占时可能持有自旋锁，不能获取内核大锁，由之后的生产者或idle任务唤醒
+        else if((task != OS_NULL) && (task -> preempt_count == 0))
+        {
+            if(!__atomic_exchange_n(&task_log_kicked,OS_TRUE,__ATOMIC_RELAXED))
+            {
+                os_log_task_kick();
+            }
+        }
+    }
+}
+
+/*!
+ * 在当前上下文中同步输出缓冲区中的所有日志，若其它上下文正在输出，则直接返回
+ */
+void os_log_flush()
+{
+    if(os_log_consumer_trylock())
+    {
+        os_log_drain();
+        os_log_consumer_unlock();
+    }
+}
+
+/*!
+ * 系统发生致命错误时调用，强制输出缓冲区中的所有日志，并将日志子系统切换为同步模式
+ */
+void os_log_panic()
+{
+    os_log_sync_mode = OS_TRUE;
+
+    if(os_log_initialized)
+    {
+        //不再等待其它消费者，直接抢占消费者锁
+        __atomic_store_n(&os_log_consumer_busy,OS_TRUE,__ATOMIC_ACQUIRE);
+        os_log_drain();
+    }
+}
+
+/*!
+ * 若缓冲区中有待输出的日志，则唤醒日志输出任务，由idle任务调用，未达到水位线的日志由此得到输出
+ */
+void os_log_wakeup()
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+
+    if(task_log_started && os_log_pending())
+    {
+        os_log_task_kick();
+    }
+}
+
+/*!
+ * 获取因缓冲区满而丢弃的日志数量
+ * @return 丢弃的日志数量
+ */
+os_size_t os_log_get_dropped_count()
+{
+    return __atomic_load_n(&os_log_dropped_count,__ATOMIC_RELAXED);
+}
+
+/*!
+ * 日志输出任务入口，输出完缓冲区中的所有日志后在等待队列中等待，由超过水位线的生产者或idle任务唤醒
+ * @param arg 参数
+ * @return 线程退出码
+ */
+static OS_NORETURN os_ssize_t os_task_log_entry(os_size_t arg)
+{
+    while(1)
+    {
+        //先清除唤醒标志再输出，输出期间写入的日志超过水位线时生产者会再次唤醒日志输出任务
+        __atomic_store_n(&task_log_kicked,OS_FALSE,__ATOMIC_RELAXED);
+        os_log_flush();
+
+        //检查与等待均在临界区中进行，唤醒在内核大锁下进行，因此不会丢失唤醒
+        OS_ENTER_CRITICAL_AREA();
+
+        while(!os_log_pending())
+        {
+            os_waitqueue_wait(&task_log_waitqueue);
+        }
+
+        OS_LEAVE_CRITICAL_AREA();
+    }
+}
+
+/*!
+ * 初始化并启动日志输出任务
+ */
+void os_log_task_startup()
+{
+    OS_ASSERT(os_task_init(&task_log,OS_LOG_TASK_STACK_SIZE,OS_LOG_TASK_PRIORITY,OS_LOG_TASK_TICK_INIT,os_task_log_entry,0,"task_log") == OS_ERR_OK);
+    os_task_startup(&task_log);
+    task_log_started = OS_TRUE;
+}
\ No newline at end of file
@@ -7,6 +7,9 @@
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
  * 2021-06-02     lizhirui     add slub interface support
+ * 2021-07-20     lizhirui     use page zero for page allocation and add page operation test
+ * 2021-07-28     lizhirui     protect slub with its own spinlock instead of big kernel lock
+ * 2021-07-28     lizhirui     disable preemption instead of interrupts while holding slub lock
  */
 
 // @formatter:off
@@ -14,6 +17,40 @@
 
 //标识内存子系统是否已经初始化完成
 static os_bool_t os_memory_initialized = OS_FALSE;
+//slub锁，slub只会调用页面分配器，因此不再使用内核大锁
+//分配器不会在中断上下文中使用，持有锁期间只禁止抢占，不关中断，不会增加中断延迟
+static os_spinlock_t memory_slub_lock = OS_SPINLOCK_INIT;
+
+//页面操作测试，对比按字节的os_memset/os_memcpy与按页面的os_page_zero/os_page_copy的单页面周期开销
+static void page_op_test()
+{
+    const os_size_t page_count = 64;
+    os_size_t page_size = page_count * OS_MMU_PAGE_SIZE;
+    void *mem1 = os_memory_page_alloc(page_size);
+    void *mem2 = os_memory_page_alloc(page_size);
+    OS_ASSERT((mem1 != OS_NULL) && (mem2 != OS_NULL));
+
+    os_size_t start = ARCH_GET_CYCLE();
+    os_memset(mem1,0,page_size);
+    os_size_t memset_cycle = ARCH_GET_CYCLE() - start;
+
+    start = ARCH_GET_CYCLE();
+    os_page_zero(mem1,page_size);
+    os_size_t page_zero_cycle = ARCH_GET_CYCLE() - start;
+
+    start = ARCH_GET_CYCLE();
+    os_memcpy(mem2,mem1,page_size);
+    os_size_t memcpy_cycle = ARCH_GET_CYCLE() - start;
+
+    start = ARCH_GET_CYCLE();
+    os_page_copy(mem2,mem1,page_size);
+    os_size_t page_copy_cycle = ARCH_GET_CYCLE() - start;
+
+    os_printf("page zero: os_memset = %ld cycles/page,os_page_zero = %ld cycles/page\n",memset_cycle / page_count,page_zero_cycle / page_count);
+    os_printf("page copy: os_memcpy = %ld cycles/page,os_page_copy = %ld cycles/page\n",memcpy_cycle / page_count,page_copy_cycle / page_count);
+    os_memory_page_free(mem1);
+    os_memory_page_free(mem2);
+}
 
 /*!
  * 内存子系统初始化函数
@@ -23,6 +60,7 @@ void os_memory_init()
     os_memory_page_init();
     os_memory_slub_init();
     os_memory_initialized = OS_TRUE;
+    //page_op_test();
 }
 
 /*!
@@ -35,46 +73,54 @@ os_bool_t os_memory_is_initialized()
 }
 
 /*!
- * 分配指定大小的内存
+ * 分配指定大小的内存，不能在中断上下文中调用
  * @param size 内存大小
  * @return 成功返回内存地址，失败返回OS_NULL
  */
 void *os_memory_alloc(os_size_t size)
 {
     OS_ANNOTATION_NEED_DYNAMIC_MEMORY();
+    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
     
     void *ret;
 
-    OS_ENTER_CRITICAL_AREA();
-
     //slub最大只能分配页面大小一半的对象
     if(size < (OS_MMU_PAGE_SIZE >> 1))
     {
+        os_preempt_disable();
+        os_spinlock_lock(&memory_slub_lock);
         ret = os_memory_slub_alloc(size);
+        os_spinlock_unlock(&memory_slub_lock);
+        os_preempt_enable();
     }
     else
     {
         ret = os_memory_page_alloc(size);
     }
 
-    OS_LEAVE_CRITICAL_AREA();
-
     if(ret != OS_NULL)
     {
-        os_memset(ret,0,size);
+        if(size < (OS_MMU_PAGE_SIZE >> 1))
+        {
+            os_memset(ret,0,size);
+        }
+        else
+        {
+            os_page_zero(ret,ALIGN_UP(size,OS_MMU_PAGE_SIZE));
+        }
     }
 
     return ret;
 }
 
 /*!
- * 释放内存
+ * 释放内存，不能在中断上下文中调用
  * @param mem 要释放的内存地址
  */
 void os_memory_free(void *mem)
 {
     OS_ANNOTATION_NEED_DYNAMIC_MEMORY();
-    OS_ENTER_CRITICAL_AREA();
+    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
 
     //判断地址是否和PAGE边界对齐，SLUB分配的对象地址永远都不会和PAGE边界对齐，反之buddy system分配的页面地址永远都和PAGE边界对齐
     if(CHECK_ALIGN((os_size_t)mem,PAGE_BITS))
@@ -83,10 +129,12 @@ void os_memory_free(void *mem)
     }
     else
     {
+        os_preempt_disable();
+        os_spinlock_lock(&memory_slub_lock);
         os_memory_slub_free(mem);
+        os_spinlock_unlock(&memory_slub_lock);
+        os_preempt_enable();
     }
-
-    OS_LEAVE_CRITICAL_AREA();
 }
 
 /*!
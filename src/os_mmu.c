@@ -7,6 +7,10 @@
  * Date           Author       Notes
  * 2021-07-04     lizhirui     the first version
  * 2021-07-05     lizhirui     add io mapping support
+ * 2021-07-20     lizhirui     use page zero for vtable creation and fix auto mapping bug
+ * 2021-07-25     lizhirui     use per-hart current vtable
+ * 2021-07-28     lizhirui     add global tlb flush
+ * 2021-07-28     lizhirui     only require preemption disabled for global tlb flush
  */
 
 // @formatter:off
@@ -82,12 +86,13 @@ os_err_t os_mmu_create_mapping_auto(os_mmu_vtable_p vtable,os_size_t va,os_size_
         OS_ERR_RETURN_ERROR(mem == OS_NULL,-OS_ERR_ENOMEM);
         os_size_t pa = OS_MMU_VA_TO_PA((os_size_t)mem);
 
-        if((ret = os_mmu_create_mapping(vtable,va,pa,size,prot)) != OS_ERR_OK)
+        if((ret = os_mmu_create_mapping(vtable,va,pa,OS_MMU_PAGE_SIZE,prot)) != OS_ERR_OK)
         {
             os_memory_free(mem);
             return ret;
         }
 
+        va += OS_MMU_PAGE_SIZE;
         size -= OS_MMU_PAGE_SIZE;
     }
 
@@ -137,7 +142,7 @@ os_err_t os_mmu_vtable_create(os_mmu_vtable_p vtable,os_mmu_pt_l1_p l1_vtable,os
         vtable -> l1_vtable = l1_vtable;
     }
 
-    os_memset((void *)vtable -> l1_vtable,0,OS_MMU_L1_PAGES * OS_MMU_PAGE_SIZE);
+    os_page_zero((void *)vtable -> l1_vtable,OS_MMU_L1_PAGES * OS_MMU_PAGE_SIZE);
     return OS_ERR_OK;
 }
 
@@ -184,31 +189,60 @@ void os_mmu_vtable_remove(os_mmu_vtable_p vtable,os_bool_t remove_mapping)
 
 void arch_mmu_switch(os_mmu_vtable_p vtable);
 
-//当前页表结构体指针
-static os_mmu_vtable_p current_vtable = OS_NULL;
-
 /*!
- * 切换页表
+ * 切换当前hart的页表
  * @param vtable 页表结构体指针
  */
 void os_mmu_switch(os_mmu_vtable_p vtable)
 {
     OS_ASSERT(vtable != OS_NULL);
+    //关闭中断，防止切换期间任务被迁移到其它hart
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_hart_p hart = os_hart_get_current();
     
-    if(current_vtable != vtable)
+    if(hart -> current_vtable != vtable)
+    {
+        hart -> current_vtable = vtable;
+        arch_mmu_switch(vtable);
+    }
+
+    os_interrupt_enable(interrupt_state);
+}
+
+/*!
+ * 在所有在线的hart上刷新TLB中指定范围的映射，用于修改被所有页表共享的内核映射之后
+ * 调用者必须禁止抢占或关闭中断，保证执行期间不会被迁移到其它hart，远程刷新由SBI同步完成，不依赖本hart响应中断，因此无需关闭中断
+ * @param va 起始虚拟地址
+ * @param size 范围大小
+ */
+void os_mmu_flush_tlb_all(os_size_t va,os_size_t size)
+{
+    os_size_t cpu_id = os_hart_get_cpu_id();
+    os_size_t i;
+
+    OS_MMU_FLUSH_TLB();
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
     {
-        current_vtable = vtable;
-        arch_mmu_switch(current_vtable);
+        os_hart_p hart = os_hart_get(i);
+
+        if((i != cpu_id) && hart -> online)
+        {
+            bsp_hart_flush_tlb(hart -> hart_id,va,size);
+        }
     }
 }
 
 /*!
- * 获取当前的页表结构体指针
+ * 获取当前hart的页表结构体指针
  * @return
  */
 os_mmu_vtable_p os_mmu_get_current_vtable()
 {
-    return current_vtable;
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_mmu_vtable_p vtable = os_hart_get_current() -> current_vtable;
+    os_interrupt_enable(interrupt_state);
+    return vtable;
 }
 
 os_bool_t os_mmu_io_mapping_copy(os_mmu_vtable_p vtable);
@@ -223,7 +257,7 @@ os_bool_t os_mmu_page_fault_handler(os_size_t addr,os_bool_t write)
 {
     if(addr >= OS_MMU_MEMORYMAP_IO_START)
     {
-        return os_mmu_io_mapping_copy(current_vtable);
+        return os_mmu_io_mapping_copy(os_mmu_get_current_vtable());
     }
 
     return OS_FALSE;
@@ -6,54 +6,422 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
+ * 2021-07-27     lizhirui     add priority inheritance and wake waiters in priority order
+ * 2021-07-28     lizhirui     add condition variable with wait morphing
+ * 2021-07-28     lizhirui     add atomic fast path, optimistic spinning and handoff/steal policy
  */
 
 // @formatter:off
 #include <dreamos.h>
 
+/*
+ * 锁状态为一个os_size_t：未被持有时为0，否则为拥有者的任务结构体指针与标志位的位或
+ * 无竞争时加锁与解锁均只需一次原子比较交换（lr/sc），不关中断也不获取内核大锁；存在等待任务时设置MUTEX_FLAG_WAITERS，
+ * 使快速路径的比较交换失败而进入慢速路径，此后锁状态只在临界区中被修改，等待队列与优先级继承的维护与原来相同
+ */
+#define MUTEX_FLAG_WAITERS SIZE(0)//等待队列非空，解锁必须进入慢速路径
+#define MUTEX_FLAG_HANDOFF SIZE(1)//有等待任务被抢先过，下一次解锁必须直接移交，避免该任务饥饿
+#define MUTEX_FLAG_MASK MASK(2)
+
 /*!
  * 互斥锁初始化
  * @param mutex 互斥锁结构体指针
  */
 void os_mutex_init(os_mutex_p mutex)
 {
-    mutex -> locked = OS_FALSE;
-    mutex -> owner = OS_NULL;
+    mutex -> state = 0;
     mutex -> refcnt = 0;
+    mutex -> policy = OS_MUTEX_DEFAULT_POLICY;
     os_waitqueue_init(&mutex -> waitqueue);
+    os_list_node_init(&mutex -> held_node);
+    mutex -> sleep_count = 0;
+    mutex -> spin_count = 0;
+    mutex -> handoff_count = 0;
 }
 
 /*!
- * 互斥锁锁定，支持递归调用
+ * 设置互斥锁的解锁策略，在下一次解锁时生效
  * @param mutex 互斥锁结构体指针
+ * @param policy 解锁策略
  */
-void os_mutex_lock(os_mutex_p mutex)
+void os_mutex_set_policy(os_mutex_p mutex,os_mutex_policy_t policy)
 {
-    OS_ANNOTATION_NEED_TASK_CONTEXT();
-    OS_ENTER_CRITICAL_AREA();
+    OS_ASSERT(policy < OS_MUTEX_POLICY_NUM);
+    mutex -> policy = policy;
+}
+
+/*!
+ * 获取互斥锁的拥有者，只有拥有者自身能够得到稳定的结果
+ * @param mutex 互斥锁结构体指针
+ * @return 拥有者的任务结构体指针，未被持有时返回OS_NULL
+ */
+os_task_p os_mutex_get_owner(os_mutex_p mutex)
+{
+    return (os_task_p)(__atomic_load_n(&mutex -> state,__ATOMIC_RELAXED) & ~MUTEX_FLAG_MASK);
+}
+
+/*!
+ * 快速路径加锁，锁未被持有且没有标志位时通过一次原子比较交换获取
+ * @param mutex 互斥锁结构体指针
+ * @param task 当前任务
+ * @return 成功返回OS_TRUE，否则返回OS_FALSE
+ */
+static inline os_bool_t mutex_trylock_fast(os_mutex_p mutex,os_task_p task)
+{
+    os_size_t expected = 0;
+    return __atomic_compare_exchange_n(&mutex -> state,&expected,(os_size_t)task,OS_FALSE,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED);
+}
+
+/*!
+ * 按任务优先级将等待节点插入互斥锁的等待队列，调用者必须处于临界区
+ * @param mutex 互斥锁结构体指针
+ * @param node 等待节点
+ * @param head 为OS_TRUE时插入到同等优先级的任务之前，否则同等优先级的任务按等待的先后顺序排列
+ */
+static void mutex_waiter_insert(os_mutex_p mutex,os_waitqueue_node_p node,os_bool_t head)
+{
+    os_ssize_t priority = os_task_get_pi_priority(node -> task);
 
-    //若已经处于锁定状态，若当前任务就是该锁的拥有者，则锁的引用数自增，否则将当前任务加入该锁的等待列表，否则执行加锁操作
-    if(mutex -> locked)
+    os_list_entry_foreach(mutex -> waitqueue.waiting_list,os_waitqueue_node_t,node,entry,
     {
-        if(mutex -> owner == os_task_get_current_task())
+        os_ssize_t entry_priority = os_task_get_pi_priority(entry -> task);
+
+        if((entry_priority > priority) || (head && (entry_priority == priority)))
         {
-            mutex -> refcnt++;
+            os_list_node_insert_before(&node -> node,&entry -> node);
+            return;
         }
-        else
+    });
+
+    os_list_insert_tail(mutex -> waitqueue.waiting_list,&node -> node);
+}
+
+/*!
+ * 获取互斥锁等待队列中优先级最高的等待节点，调用者必须处于临界区
+ * @param mutex 互斥锁结构体指针
+ * @return 等待队列为空时返回OS_NULL
+ */
+static os_waitqueue_node_p mutex_get_top_waiter(os_mutex_p mutex)
+{
+    if(os_list_empty(mutex -> waitqueue.waiting_list))
+    {
+        return OS_NULL;
+    }
+
+    return os_list_entry(os_list_get_head(mutex -> waitqueue.waiting_list),os_waitqueue_node_t,node);
+}
+
+/*!
+ * 重新计算任务应当继承的优先级，即其持有的所有互斥锁中优先级最高的等待任务的优先级
+ * 若任务自身也在等待其它互斥锁，则调整其在该互斥锁等待队列中的位置，并沿等待链继续传递给该互斥锁的拥有者，调用者必须处于临界区
+ * @param task 互斥锁的拥有者
+ */
+static void mutex_pi_update(os_task_p task)
+{
+    while(task != OS_NULL)
+    {
+        os_ssize_t priority = OS_TASK_PI_PRIORITY_NONE;
+
+        os_list_entry_foreach(task -> pi_held_mutex_list,os_mutex_t,held_node,mutex,
+        {
+            os_waitqueue_node_p waiter = mutex_get_top_waiter(mutex);
+
+            if(waiter != OS_NULL)
+            {
+                priority = MIN(priority,os_task_get_pi_priority(waiter -> task));
+            }
+        });
+
+        //继承的优先级没有变化时，等待链上后续任务的优先级也不会变化
+        if(priority == task -> pi_priority)
+        {
+            break;
+        }
+
+        os_task_pi_set_priority(task,priority);
+        os_mutex_p blocked_on = task -> pi_blocked_on;
+
+        if(blocked_on == OS_NULL)
+        {
+            break;
+        }
+
+        //按新的优先级调整任务在等待队列中的位置
+        os_list_entry_foreach(blocked_on -> waitqueue.waiting_list,os_waitqueue_node_t,node,entry,
+        {
+            if(entry -> task == task)
+            {
+                os_list_node_remove(&entry -> node);
+                mutex_waiter_insert(blocked_on,entry,OS_FALSE);
+                break;
+            }
+        });
+
+        task = os_mutex_get_owner(blocked_on);
+    }
+}
+
+/*!
+ * 任务获得互斥锁后的处理，锁状态已经指向该任务，存在等待任务时将锁加入任务的持有互斥锁列表并继承等待任务的优先级，调用者必须处于临界区
+ * @param mutex 互斥锁结构体指针
+ * @param task 新的拥有者
+ */
+static void mutex_owned(os_mutex_p mutex,os_task_p task)
+{
+    mutex -> refcnt = 1;
+    task -> pi_blocked_on = OS_NULL;
+
+    if(mutex -> state & MUTEX_FLAG_WAITERS)
+    {
+        os_list_insert_tail(task -> pi_held_mutex_list,&mutex -> held_node);
+        mutex_pi_update(task);
+    }
+}
+
+/*!
+ * 在临界区中尝试让任务获取互斥锁，锁被持有时设置等待标志，使拥有者解锁时进入慢速路径，调用者必须处于临界区
+ * 拥有者为空但仍有等待任务时（抢先策略下等待任务被唤醒后尚未运行），任务可以抢先获取该锁
+ * @param mutex 互斥锁结构体指针
+ * @param task 要获取锁的任务，可以不是当前任务
+ * @return 成功获取返回OS_TRUE，锁被持有返回OS_FALSE
+ */
+static os_bool_t mutex_trylock_or_mark(os_mutex_p mutex,os_task_p task)
+{
+    os_size_t state = __atomic_load_n(&mutex -> state,__ATOMIC_RELAXED);
+
+    while(1)
+    {
+        if((state & ~MUTEX_FLAG_MASK) == 0)
+        {
+            if(__atomic_compare_exchange_n(&mutex -> state,&state,(os_size_t)task | (state & MUTEX_FLAG_WAITERS),OS_FALSE,__ATOMIC_ACQUIRE,__ATOMIC_RELAXED))
+            {
+                mutex_owned(mutex,task);
+                return OS_TRUE;
+            }
+        }
+        else if((state & MUTEX_FLAG_WAITERS) || __atomic_compare_exchange_n(&mutex -> state,&state,state | MUTEX_FLAG_WAITERS,OS_FALSE,__ATOMIC_RELAXED,__ATOMIC_RELAXED))
         {
-            os_waitqueue_wait(&mutex -> waitqueue);
+            return OS_FALSE;
         }
     }
+}
+
+/*!
+ * 将等待节点加入互斥锁的等待队列，并让拥有者继承等待任务的优先级，锁必须已被设置等待标志，调用者必须处于临界区
+ * @param mutex 互斥锁结构体指针
+ * @param node 等待节点，task成员必须已经设置
+ * @param head 为OS_TRUE时插入到同等优先级的任务之前
+ */
+static void mutex_waiter_add(os_mutex_p mutex,os_waitqueue_node_p node,os_bool_t head)
+{
+    os_task_p owner = os_mutex_get_owner(mutex);
+
+    node -> exclusive = OS_TRUE;
+    mutex_waiter_insert(mutex,node,head);
+    node -> task -> pi_blocked_on = mutex;
+
+    //拥有者通过快速路径获得锁时，锁尚未加入其持有互斥锁列表
+    if(os_list_node_empty(&mutex -> held_node))
+    {
+        os_list_insert_tail(owner -> pi_held_mutex_list,&mutex -> held_node);
+    }
+
+    mutex_pi_update(owner);
+}
+
+/*!
+ * 在临界区中获取当前任务未持有的互斥锁，必要时睡眠等待，返回时当前任务为锁的拥有者且引用数为1，调用者必须处于临界区
+ * @param mutex 互斥锁结构体指针
+ * @param task 当前任务
+ * @param node 等待节点，可以已经位于该锁的等待队列中（由条件变量移入）
+ */
+static void mutex_acquire(os_mutex_p mutex,os_task_p task,os_waitqueue_node_p node)
+{
+    os_bool_t waited = !os_list_node_empty(&node -> node);
+
+    //直接移交时锁的拥有者会被设置为当前任务；抢先策略下节点会被移出等待队列，此时需要重新竞争；其余的唤醒均为虚假唤醒
+    while(os_mutex_get_owner(mutex) != task)
+    {
+        if(os_list_node_empty(&node -> node))
+        {
+            if(mutex_trylock_or_mark(mutex,task))
+            {
+                break;
+            }
+
+            node -> task = task;
+            //被抢先过的任务排在同等优先级的任务之前，并要求下一次解锁时直接移交
+            mutex_waiter_add(mutex,node,waited);
+
+            if(waited)
+            {
+                __atomic_or_fetch(&mutex -> state,MUTEX_FLAG_HANDOFF,__ATOMIC_RELAXED);
+            }
+
+            waited = OS_TRUE;
+            mutex -> sleep_count++;
+        }
+
+        os_task_sleep();
+    }
+}
+
+/*!
+ * 完全释放当前任务持有的互斥锁，若存在等待任务，则按解锁策略处理优先级最高的等待任务，并将其加入批量唤醒上下文，调用者必须处于临界区
+ * @param mutex 互斥锁结构体指针
+ * @param task 当前任务
+ * @param batch 批量唤醒上下文结构体指针
+ */
+static void mutex_release(os_mutex_p mutex,os_task_p task,os_task_wakeup_batch_p batch)
+{
+    os_waitqueue_node_p waiter = mutex_get_top_waiter(mutex);
+    os_list_node_remove(&mutex -> held_node);
+
+    //锁被当前任务持有且处于临界区中，其它任务无法修改锁状态
+    if(waiter == OS_NULL)
+    {
+        __atomic_store_n(&mutex -> state,0,__ATOMIC_RELEASE);
+        return;
+    }
+
+    os_task_p next_task = waiter -> task;
+    os_list_node_remove(&waiter -> node);
+    os_size_t waiters = os_list_empty(mutex -> waitqueue.waiting_list) ? 0 : MUTEX_FLAG_WAITERS;
+
+    /*
+     * 直接移交：让等待任务直接成为锁的拥有者，然后唤醒该任务，这里切不可直接唤醒，否则会导致在未完成加锁操作的情况下，该任务获得锁
+     * 抢先策略：只清除拥有者并唤醒等待任务，等待任务运行后重新竞争，在此之前正在运行的任务可以获取该锁，解锁者也无需等待等待任务被调度
+     */
+    if((mutex -> policy == OS_MUTEX_POLICY_HANDOFF) || (mutex -> state & MUTEX_FLAG_HANDOFF))
+    {
+        __atomic_store_n(&mutex -> state,(os_size_t)next_task | waiters,__ATOMIC_RELEASE);
+        mutex_owned(mutex,next_task);
+        mutex -> handoff_count++;
+    }
     else
+    {
+        next_task -> pi_blocked_on = OS_NULL;
+        __atomic_store_n(&mutex -> state,waiters,__ATOMIC_RELEASE);
+    }
+
+    //当前任务不再继承该锁的等待任务的优先级，需要在唤醒等待任务之前恢复，以便唤醒时进行正确的抢占判断
+    mutex_pi_update(task);
+    os_task_wakeup_batch_add(batch,next_task);
+}
+
+/*!
+ * 加锁的慢速路径中，若拥有者正在其它hart上运行，则自旋等待其解锁，避免睡眠与唤醒的开销
+ * 拥有者的任务结构体在RCU宽限期结束后才会被释放，因此在RCU读临界区（禁止抢占）中自旋，可以安全地访问拥有者
+ * @param mutex 互斥锁结构体指针
+ * @param task 当前任务
+ * @return 成功获取返回OS_TRUE，否则返回OS_FALSE
+ */
+static os_bool_t mutex_spin(os_mutex_p mutex,os_task_p task)
+{
+    os_bool_t ret = OS_FALSE;
+    os_size_t i;
+
+    if((OS_MUTEX_SPIN_MAX == 0) || (os_hart_get_online_num() <= 1))
+    {
+        return OS_FALSE;
+    }
+
+    os_rcu_read_lock();
+
+    for(i = 0;i < OS_MUTEX_SPIN_MAX;i++)
+    {
+        os_size_t state = __atomic_load_n(&mutex -> state,__ATOMIC_RELAXED);
+        os_task_p owner = (os_task_p)(state & ~MUTEX_FLAG_MASK);
+
+        if(state == 0)
+        {
+            if(mutex_trylock_fast(mutex,task))
+            {
+                ret = OS_TRUE;
+                break;
+            }
+
+            continue;
+        }
+
+        //拥有者不在运行、需要直接移交给等待任务或当前hart有被推迟的抢占请求时停止自旋，进入睡眠等待
+        if((owner == OS_NULL) || !owner -> on_cpu || (state & MUTEX_FLAG_HANDOFF) || ((mutex -> policy == OS_MUTEX_POLICY_HANDOFF) && (state & MUTEX_FLAG_WAITERS)) || os_hart_get_current() -> need_resched)
+        {
+            break;
+        }
+    }
+
+    os_rcu_read_unlock();
+
+    if(ret)
+    {
+        mutex -> spin_count++;
+    }
+
+    return ret;
+}
+
+/*!
+ * 互斥锁锁定，支持递归调用，等待期间锁的拥有者会继承当前任务的优先级
+ * @param mutex 互斥锁结构体指针
+ */
+void os_mutex_lock(os_mutex_p mutex)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_task_p task = os_task_get_current_task();
+
+    //快速路径：锁未被持有时直接获取，不关中断也不获取内核大锁
+    if(mutex_trylock_fast(mutex,task))
+    {
+        mutex -> refcnt = 1;
+        return;
+    }
+
+    //只有拥有者自身能够观察到拥有者为自己，此时锁的引用数自增
+    if(os_mutex_get_owner(mutex) == task)
+    {
+        mutex -> refcnt++;
+        return;
+    }
+
+    if(mutex_spin(mutex,task))
     {
         mutex -> refcnt = 1;
-        mutex -> owner = os_task_get_current_task();
-        mutex -> locked = OS_TRUE;
+        return;
     }
-    
+
+    os_waitqueue_node_t node;
+    os_list_node_init(&node.node);
+    OS_ENTER_CRITICAL_AREA();
+    mutex_acquire(mutex,task,&node);
     OS_LEAVE_CRITICAL_AREA();
 }
 
+/*!
+ * 尝试锁定互斥锁，不会睡眠，支持递归调用
+ * @param mutex 互斥锁结构体指针
+ * @return 成功返回OS_TRUE，锁被其它任务持有返回OS_FALSE
+ */
+os_bool_t os_mutex_trylock(os_mutex_p mutex)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_task_p task = os_task_get_current_task();
+
+    if(mutex_trylock_fast(mutex,task))
+    {
+        mutex -> refcnt = 1;
+        return OS_TRUE;
+    }
+
+    if(os_mutex_get_owner(mutex) == task)
+    {
+        mutex -> refcnt++;
+        return OS_TRUE;
+    }
+
+    return OS_FALSE;
+}
+
 /*!
  * 互斥锁解锁，支持递归调用
  * @param mutex 互斥锁结构体指针
@@ -61,34 +429,192 @@ void os_mutex_lock(os_mutex_p mutex)
 void os_mutex_unlock(os_mutex_p mutex)
 {
     OS_ANNOTATION_NEED_TASK_CONTEXT();
-    OS_ENTER_CRITICAL_AREA();
-    OS_ASSERT(mutex -> owner == os_task_get_current_task());
-    OS_ASSERT(mutex -> locked);
+    os_task_p task = os_task_get_current_task();
+    OS_ASSERT(os_mutex_get_owner(mutex) == task);
     OS_ASSERT(mutex -> refcnt > 0);
     //引用数递减
     mutex -> refcnt--;
 
-    //若引用数变为0，则唤醒等待列表中的一个任务
-    if(mutex -> refcnt == 0)
+    if(mutex -> refcnt > 0)
+    {
+        return;
+    }
+
+    //快速路径：没有等待任务时通过一次原子比较交换释放该锁
+    os_size_t expected = (os_size_t)task;
+
+    if(__atomic_compare_exchange_n(&mutex -> state,&expected,0,OS_FALSE,__ATOMIC_RELEASE,__ATOMIC_RELAXED))
     {
-        os_task_p next_task = os_waitqueue_get_head(&mutex -> waitqueue);
+        return;
+    }
 
-        /*
-         * 若等待列表中存在一个任务，则让该任务直接成为锁的拥有者，并设置锁的引用数为1，然后唤醒该任务，这里切不可直接唤醒，否则会导致在未完成
-         * 加锁操作的情况下，该任务获得锁；若不存在任何任务，则释放该锁
-         */
-        if(next_task != OS_NULL)
+    //存在等待任务，此后锁状态只会在临界区中被修改
+    os_task_wakeup_batch_t batch;
+    OS_ENTER_CRITICAL_AREA();
+    os_task_wakeup_batch_init(&batch);
+    mutex_release(mutex,task,&batch);
+    os_task_wakeup_batch_flush(&batch);
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 条件变量初始化
+ * @param cond 条件变量结构体指针
+ */
+void os_cond_init(os_cond_p cond)
+{
+    os_waitqueue_init(&cond -> waitqueue);
+    cond -> mutex = OS_NULL;
+}
+
+/*!
+ * 判断等待节点是否仍在条件变量的等待队列中，唤醒时节点会被移动到互斥锁的等待队列中（此时pi_blocked_on指向该互斥锁），或被移出，调用者必须处于临界区
+ * @param mutex 互斥锁结构体指针
+ * @param task 当前任务
+ * @param node 等待节点
+ * @return 仍在条件变量的等待队列中返回OS_TRUE，否则返回OS_FALSE
+ */
+static inline os_bool_t cond_waiting(os_mutex_p mutex,os_task_p task,os_waitqueue_node_p node)
+{
+    return !os_list_node_empty(&node -> node) && (task -> pi_blocked_on != mutex);
+}
+
+/*!
+ * 原子地释放互斥锁并在条件变量上等待，返回时重新持有互斥锁，调用者应当在循环中检查等待条件
+ * @param cond 条件变量结构体指针
+ * @param mutex 当前任务持有的互斥锁，递归持有时会被完全释放，返回时恢复原有的引用数
+ * @param ticks 最长等待时间（tick），为OS_WAITQUEUE_WAIT_FOREVER时只在被唤醒时返回
+ * @return 被唤醒返回OS_ERR_OK，超时返回-OS_ERR_ETIMEDOUT
+ */
+static os_err_t cond_wait(os_cond_p cond,os_mutex_p mutex,os_size_t ticks)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_waitqueue_node_t node;
+    os_task_wakeup_batch_t batch;
+    os_err_t ret = OS_ERR_OK;
+
+    OS_ENTER_CRITICAL_AREA();
+    os_task_p task = os_task_get_current_task();
+    OS_ASSERT(os_mutex_get_owner(mutex) == task);
+    OS_ASSERT(os_waitqueue_empty(&cond -> waitqueue) || (cond -> mutex == mutex));
+    os_size_t refcnt = mutex -> refcnt;
+    cond -> mutex = mutex;
+
+    //必须在释放互斥锁之前加入条件变量的等待队列，否则会丢失释放后到达的唤醒
+    node.task = task;
+    node.exclusive = OS_TRUE;
+    os_waitqueue_add(&cond -> waitqueue,&node);
+    os_task_wakeup_batch_init(&batch);
+    mutex_release(mutex,task,&batch);
+    os_task_wakeup_batch_flush(&batch);
+
+    /*
+     * 唤醒时等待节点会被直接移动到互斥锁的等待队列中，或者在互斥锁未被持有时直接成为锁的拥有者，
+     * 因此不会出现被唤醒后立即在互斥锁上再次睡眠的情况，离开条件变量的等待队列后由mutex_acquire完成加锁
+     */
+    if(ticks != OS_WAITQUEUE_WAIT_FOREVER)
+    {
+        os_size_t remaining = ticks;
+
+        while(cond_waiting(mutex,task,&node) && (remaining > 0))
+        {
+            remaining = os_task_sleep_ticks(remaining);
+        }
+
+        //超时时仍在条件变量的等待队列中，需要自行获取互斥锁
+        if(cond_waiting(mutex,task,&node))
+        {
+            os_waitqueue_remove(&node);
+            ret = -OS_ERR_ETIMEDOUT;
+        }
+    }
+    else
+    {
+        while(cond_waiting(mutex,task,&node))
+        {
+            os_task_sleep();
+        }
+    }
+
+    mutex_acquire(mutex,task,&node);
+    mutex -> refcnt = refcnt;
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 原子地释放互斥锁并在条件变量上等待，返回时重新持有互斥锁，调用者应当在循环中检查等待条件
+ * @param cond 条件变量结构体指针
+ * @param mutex 当前任务持有的互斥锁
+ */
+void os_cond_wait(os_cond_p cond,os_mutex_p mutex)
+{
+    cond_wait(cond,mutex,OS_WAITQUEUE_WAIT_FOREVER);
+}
+
+/*!
+ * 原子地释放互斥锁并在条件变量上等待，最多等待ticks个tick，返回时重新持有互斥锁
+ * @param cond 条件变量结构体指针
+ * @param mutex 当前任务持有的互斥锁
+ * @param ticks 最长等待时间（tick）
+ * @return 被唤醒返回OS_ERR_OK，超时返回-OS_ERR_ETIMEDOUT
+ */
+os_err_t os_cond_wait_timeout(os_cond_p cond,os_mutex_p mutex,os_size_t ticks)
+{
+    return cond_wait(cond,mutex,ticks);
+}
+
+/*!
+ * 按等待的先后顺序唤醒条件变量上最多nr个任务
+ * 互斥锁被持有时（通常为唤醒者自身持有），等待任务不会被唤醒，而是直接移动到互斥锁的等待队列中，由解锁操作唤醒，避免被唤醒的任务立即在互斥锁上再次睡眠
+ * 互斥锁未被持有时，等待任务直接成为锁的拥有者后被唤醒
+ * @param cond 条件变量结构体指针
+ * @param nr 最多唤醒的任务数量
+ */
+static void cond_wakeup(os_cond_p cond,os_size_t nr)
+{
+    os_task_wakeup_batch_t batch;
+
+    OS_ENTER_CRITICAL_AREA();
+    os_mutex_p mutex = cond -> mutex;
+    os_task_wakeup_batch_init(&batch);
+
+    while((nr > 0) && !os_waitqueue_empty(&cond -> waitqueue))
+    {
+        os_waitqueue_node_p node = os_list_entry(os_list_get_head(cond -> waitqueue.waiting_list),os_waitqueue_node_t,node);
+        os_task_p task = node -> task;
+        os_waitqueue_remove(node);
+
+        if(mutex_trylock_or_mark(mutex,task))
         {
-            mutex -> refcnt = 1;
-            mutex -> owner = next_task;
-            os_waitqueue_wakeup(&mutex -> waitqueue);
+            os_task_wakeup_batch_add(&batch,task);
         }
         else
         {
-            mutex -> owner = OS_NULL;
-            mutex -> locked = OS_FALSE;
+            mutex_waiter_add(mutex,node,OS_FALSE);
         }
+
+        nr--;
     }
-    
+
+    os_task_wakeup_batch_flush(&batch);
     OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 唤醒条件变量上等待时间最长的一个任务，若没有等待任务，则不动作
+ * @param cond 条件变量结构体指针
+ */
+void os_cond_signal(os_cond_p cond)
+{
+    cond_wakeup(cond,1);
+}
+
+/*!
+ * 唤醒条件变量上的所有任务
+ * @param cond 条件变量结构体指针
+ */
+void os_cond_broadcast(os_cond_p cond)
+{
+    cond_wakeup(cond,OS_NUMBER_MAX(os_size_t));
 }
\ No newline at end of file
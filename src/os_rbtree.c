@@ -0,0 +1,428 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-27     lizhirui     the first version
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+#define RBTREE_RED 0
+#define RBTREE_BLACK 1
+
+//空节点视为黑色
+#define rbtree_is_black(node) (((node) == OS_NULL) || ((node) -> color == RBTREE_BLACK))
+
+/*!
+ * 以node为支点左旋
+ * @param tree 红黑树结构体指针
+ * @param node 支点
+ */
+static void rbtree_rotate_left(os_rbtree_p tree,os_rbtree_node_p node)
+{
+    os_rbtree_node_p right = node -> right;
+
+    node -> right = right -> left;
+
+    if(right -> left != OS_NULL)
+    {
+        right -> left -> parent = node;
+    }
+
+    right -> parent = node -> parent;
+
+    if(node -> parent == OS_NULL)
+    {
+        tree -> root = right;
+    }
+    else if(node == node -> parent -> left)
+    {
+        node -> parent -> left = right;
+    }
+    else
+    {
+        node -> parent -> right = right;
+    }
+
+    right -> left = node;
+    node -> parent = right;
+}
+
+/*!
+ * 以node为支点右旋
+ * @param tree 红黑树结构体指针
+ * @param node 支点
+ */
+static void rbtree_rotate_right(os_rbtree_p tree,os_rbtree_node_p node)
+{
+    os_rbtree_node_p left = node -> left;
+
+    node -> left = left -> right;
+
+    if(left -> right != OS_NULL)
+    {
+        left -> right -> parent = node;
+    }
+
+    left -> parent = node -> parent;
+
+    if(node -> parent == OS_NULL)
+    {
+        tree -> root = left;
+    }
+    else if(node == node -> parent -> right)
+    {
+        node -> parent -> right = left;
+    }
+    else
+    {
+        node -> parent -> left = left;
+    }
+
+    left -> right = node;
+    node -> parent = left;
+}
+
+/*!
+ * 用子树new_node替换子树old_node在树中的位置
+ * @param tree 红黑树结构体指针
+ * @param old_node 被替换的子树
+ * @param new_node 新的子树，可以为OS_NULL
+ */
+static void rbtree_transplant(os_rbtree_p tree,os_rbtree_node_p old_node,os_rbtree_node_p new_node)
+{
+    if(old_node -> parent == OS_NULL)
+    {
+        tree -> root = new_node;
+    }
+    else if(old_node == old_node -> parent -> left)
+    {
+        old_node -> parent -> left = new_node;
+    }
+    else
+    {
+        old_node -> parent -> right = new_node;
+    }
+
+    if(new_node != OS_NULL)
+    {
+        new_node -> parent = old_node -> parent;
+    }
+}
+
+/*!
+ * 红黑树初始化
+ * @param tree 红黑树结构体指针
+ */
+void os_rbtree_init(os_rbtree_p tree)
+{
+    tree -> root = OS_NULL;
+    tree -> leftmost = OS_NULL;
+}
+
+/*!
+ * 向红黑树中插入节点，时间复杂度为O(log n)
+ * @param tree 红黑树结构体指针
+ * @param node 要插入的节点
+ * @param less 节点比较函数
+ */
+void os_rbtree_insert(os_rbtree_p tree,os_rbtree_node_p node,os_rbtree_less_func_t less)
+{
+    os_rbtree_node_p parent = OS_NULL;
+    os_rbtree_node_p *link = &tree -> root;
+    os_bool_t leftmost = OS_TRUE;
+
+    while(*link != OS_NULL)
+    {
+        parent = *link;
+
+        if(less(node,parent))
+        {
+            link = &parent -> left;
+        }
+        else
+        {
+            link = &parent -> right;
+            leftmost = OS_FALSE;
+        }
+    }
+
+    node -> parent = parent;
+    node -> left = OS_NULL;
+    node -> right = OS_NULL;
+    node -> color = RBTREE_RED;
+    *link = node;
+
+    if(leftmost)
+    {
+        tree -> leftmost = node;
+    }
+
+    //修复连续的红色节点
+    while((node -> parent != OS_NULL) && (node -> parent -> color == RBTREE_RED))
+    {
+        parent = node -> parent;
+        os_rbtree_node_p grandparent = parent -> parent;
+
+        if(parent == grandparent -> left)
+        {
+            os_rbtree_node_p uncle = grandparent -> right;
+
+            if(!rbtree_is_black(uncle))
+            {
+                parent -> color = RBTREE_BLACK;
+                uncle -> color = RBTREE_BLACK;
+                grandparent -> color = RBTREE_RED;
+                node = grandparent;
+            }
+            else
+            {
+                if(node == parent -> right)
+                {
+                    rbtree_rotate_left(tree,parent);
+                    node = parent;
+                    parent = node -> parent;
+                }
+
+                parent -> color = RBTREE_BLACK;
+                grandparent -> color = RBTREE_RED;
+                rbtree_rotate_right(tree,grandparent);
+            }
+        }
+        else
+        {
+            os_rbtree_node_p uncle = grandparent -> left;
+
+            if(!rbtree_is_black(uncle))
+            {
+                parent -> color = RBTREE_BLACK;
+                uncle -> color = RBTREE_BLACK;
+                grandparent -> color = RBTREE_RED;
+                node = grandparent;
+            }
+            else
+            {
+                if(node == parent -> left)
+                {
+                    rbtree_rotate_right(tree,parent);
+                    node = parent;
+                    parent = node -> parent;
+                }
+
+                parent -> color = RBTREE_BLACK;
+                grandparent -> color = RBTREE_RED;
+                rbtree_rotate_left(tree,grandparent);
+            }
+        }
+    }
+
+    tree -> root -> color = RBTREE_BLACK;
+}
+
+/*!
+ * 修复删除黑色节点后的黑高
+ * @param tree 红黑树结构体指针
+ * @param node 替代被删除节点的子树，可以为OS_NULL
+ * @param parent node的父节点
+ */
+static void rbtree_remove_fixup(os_rbtree_p tree,os_rbtree_node_p node,os_rbtree_node_p parent)
+{
+    while((node != tree -> root) && rbtree_is_black(node))
+    {
+        if(node == parent -> left)
+        {
+            os_rbtree_node_p sibling = parent -> right;
+
+            if(!rbtree_is_black(sibling))
+            {
+                sibling -> color = RBTREE_BLACK;
+                parent -> color = RBTREE_RED;
+                rbtree_rotate_left(tree,parent);
+                sibling = parent -> right;
+            }
+
+            if(rbtree_is_black(sibling -> left) && rbtree_is_black(sibling -> right))
+            {
+                sibling -> color = RBTREE_RED;
+                node = parent;
+                parent = node -> parent;
+            }
+            else
+            {
+                if(rbtree_is_black(sibling -> right))
+                {
+                    sibling -> left -> color = RBTREE_BLACK;
+                    sibling -> color = RBTREE_RED;
+                    rbtree_rotate_right(tree,sibling);
+                    sibling = parent -> right;
+                }
+
+                sibling -> color = parent -> color;
+                parent -> color = RBTREE_BLACK;
+                sibling -> right -> color = RBTREE_BLACK;
+                rbtree_rotate_left(tree,parent);
+                node = tree -> root;
+            }
+        }
+        else
+        {
+            os_rbtree_node_p sibling = parent -> left;
+
+            if(!rbtree_is_black(sibling))
+            {
+                sibling -> color = RBTREE_BLACK;
+                parent -> color = RBTREE_RED;
+                rbtree_rotate_right(tree,parent);
+                sibling = parent -> left;
+            }
+
+            if(rbtree_is_black(sibling -> left) && rbtree_is_black(sibling -> right))
+            {
+                sibling -> color = RBTREE_RED;
+                node = parent;
+                parent = node -> parent;
+            }
+            else
+            {
+                if(rbtree_is_black(sibling -> left))
+                {
+                    sibling -> right -> color = RBTREE_BLACK;
+                    sibling -> color = RBTREE_RED;
+                    rbtree_rotate_left(tree,sibling);
+                    sibling = parent -> left;
+                }
+
+                sibling -> color = parent -> color;
+                parent -> color = RBTREE_BLACK;
+                sibling -> left -> color = RBTREE_BLACK;
+                rbtree_rotate_right(tree,parent);
+                node = tree -> root;
+            }
+        }
+    }
+
+    if(node != OS_NULL)
+    {
+        node -> color = RBTREE_BLACK;
+    }
+}
+
+/*!
+ * 从红黑树中删除节点，时间复杂度为O(log n)
+ * @param tree 红黑树结构体指针
+ * @param node 要删除的节点，必须位于该树中
+ */
+void os_rbtree_remove(os_rbtree_p tree,os_rbtree_node_p node)
+{
+    os_rbtree_node_p child;
+    os_rbtree_node_p parent;
+    os_size_t removed_color = node -> color;
+
+    if(tree -> leftmost == node)
+    {
+        tree -> leftmost = os_rbtree_next(node);
+    }
+
+    if(node -> left == OS_NULL)
+    {
+        child = node -> right;
+        parent = node -> parent;
+        rbtree_transplant(tree,node,node -> right);
+    }
+    else if(node -> right == OS_NULL)
+    {
+        child = node -> left;
+        parent = node -> parent;
+        rbtree_transplant(tree,node,node -> left);
+    }
+    else
+    {
+        //用后继节点替代被删除的节点
+        os_rbtree_node_p successor = node -> right;
+
+        while(successor -> left != OS_NULL)
+        {
+            successor = successor -> left;
+        }
+
+        removed_color = successor -> color;
+        child = successor -> right;
+
+        if(successor -> parent == node)
+        {
+            parent = successor;
+        }
+        else
+        {
+            parent = successor -> parent;
+            rbtree_transplant(tree,successor,successor -> right);
+            successor -> right = node -> right;
+            successor -> right -> parent = successor;
+        }
+
+        rbtree_transplant(tree,node,successor);
+        successor -> left = node -> left;
+        successor -> left -> parent = successor;
+        successor -> color = node -> color;
+    }
+
+    if(removed_color == RBTREE_BLACK)
+    {
+        rbtree_remove_fixup(tree,child,parent);
+    }
+
+    node -> parent = OS_NULL;
+    node -> left = OS_NULL;
+    node -> right = OS_NULL;
+}
+
+/*!
+ * 获取红黑树中的最小节点，时间复杂度为O(1)
+ * @param tree 红黑树结构体指针
+ * @return 最小节点，树为空时返回OS_NULL
+ */
+os_rbtree_node_p os_rbtree_first(os_rbtree_p tree)
+{
+    return tree -> leftmost;
+}
+
+/*!
+ * 获取节点的中序后继节点
+ * @param node 红黑树节点
+ * @return 后继节点，不存在时返回OS_NULL
+ */
+os_rbtree_node_p os_rbtree_next(os_rbtree_node_p node)
+{
+    if(node -> right != OS_NULL)
+    {
+        node = node -> right;
+
+        while(node -> left != OS_NULL)
+        {
+            node = node -> left;
+        }
+
+        return node;
+    }
+
+    while((node -> parent != OS_NULL) && (node == node -> parent -> right))
+    {
+        node = node -> parent;
+    }
+
+    return node -> parent;
+}
+
+/*!
+ * 检测红黑树是否为空
+ * @param tree 红黑树结构体指针
+ * @return 为空返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_rbtree_empty(os_rbtree_p tree)
+{
+    return tree -> root == OS_NULL;
+}
\ No newline at end of file
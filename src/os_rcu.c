@@ -0,0 +1,284 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ * 2021-07-28     lizhirui     invoke callbacks in system workqueue instead of bottom half
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*
+ * 读临界区即禁止抢占的区域，只修改当前任务的抢占计数，不使用任何原子操作和内存屏障
+ * 任务切换只能在抢占计数为0时发生，因此hart在调度、时钟中断和空闲循环中观察到当前任务的抢占计数为0时，即处于静止状态
+ * 宽限期开始后，所有在线hart都经过一次静止状态时宽限期结束，此时宽限期开始前进入的读临界区都已退出，之前移除的对象可以被释放
+ * 回调函数在宽限期结束后交给系统工作队列执行，避免在调度器中执行任意代码，且回调函数中可以释放内存（内存分配器不能在中断上下文中使用）
+ */
+static os_spinlock_t rcu_lock = OS_SPINLOCK_INIT;//保护宽限期状态和回调列表
+static os_bool_t rcu_gp_running = OS_FALSE;//是否有正在进行的宽限期
+static os_size_t rcu_qs_mask = 0;//当前宽限期中尚未经过静止状态的hart的逻辑处理器编号位图
+static os_rcu_head_p rcu_next_list = OS_NULL;//等待下一个宽限期的回调列表
+static os_rcu_head_p *rcu_next_tail = &rcu_next_list;
+static os_rcu_head_p rcu_wait_list = OS_NULL;//等待当前宽限期结束的回调列表
+static os_rcu_head_p *rcu_wait_tail = &rcu_wait_list;
+static os_rcu_head_p volatile rcu_done_list = OS_NULL;//宽限期已经结束、等待执行的回调列表
+static os_rcu_head_p *rcu_done_tail = (os_rcu_head_p *)&rcu_done_list;
+static os_work_t rcu_work;//执行回调函数的工作项
+static volatile os_bool_t rcu_work_ready = OS_FALSE;//系统工作队列是否已经启动
+
+//统计信息
+static os_size_t rcu_gp_count = 0;//已完成的宽限期数量
+static os_size_t rcu_call_count = 0;//注册的回调数量
+static os_size_t rcu_invoke_count = 0;//已执行的回调数量
+static os_size_t rcu_gp_time_total = 0;//宽限期的总时长（纳秒）
+static os_size_t rcu_gp_time_max = 0;//宽限期的最大时长（纳秒）
+static os_size_t rcu_gp_start_time = 0;//当前宽限期的开始时刻（纳秒）
+
+//用于os_rcu_synchronize等待宽限期结束
+typedef struct rcu_sync
+{
+    os_rcu_head_t head;
+    os_waitqueue_t waitqueue;
+    volatile os_bool_t done;
+}rcu_sync_t,*rcu_sync_p;
+
+/*!
+ * 开始新的宽限期，调用者必须持有rcu_lock
+ * 处于空闲等待中的hart不会产生调度和时钟中断，因此向其它所有在线hart发送IPI，使其尽快经过静止状态
+ */
+static void rcu_gp_start()
+{
+    os_size_t cpu_id = os_hart_get_cpu_id();
+    os_size_t i;
+
+    rcu_wait_list = rcu_next_list;
+    rcu_wait_tail = rcu_next_tail;
+    rcu_next_list = OS_NULL;
+    rcu_next_tail = &rcu_next_list;
+    rcu_gp_running = OS_TRUE;
+    rcu_gp_start_time = os_tick_get_ns();
+    rcu_qs_mask = 0;
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        os_hart_p hart = os_hart_get(i);
+
+        if(hart -> online)
+        {
+            rcu_qs_mask |= SIZE(i);
+            hart -> rcu_need_qs = OS_TRUE;
+        }
+    }
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        if((i != cpu_id) && (rcu_qs_mask & SIZE(i)))
+        {
+            bsp_hart_send_ipi(os_hart_get(i) -> hart_id);
+        }
+    }
+}
+
+/*!
+ * 结束当前宽限期，将等待当前宽限期的回调移入待执行列表，若有回调在等待下一个宽限期，则立即开始新的宽限期，调用者必须持有rcu_lock
+ */
+static void rcu_gp_end()
+{
+    os_size_t gp_time = os_tick_get_ns() - rcu_gp_start_time;
+
+    rcu_gp_count++;
+    rcu_gp_time_total += gp_time;
+    rcu_gp_time_max = MAX(rcu_gp_time_max,gp_time);
+
+    if(rcu_wait_list != OS_NULL)
+    {
+        *rcu_done_tail = rcu_wait_list;
+        rcu_done_tail = rcu_wait_tail;
+    }
+
+    rcu_wait_list = OS_NULL;
+    rcu_wait_tail = &rcu_wait_list;
+    rcu_gp_running = OS_FALSE;
+
+    if(rcu_next_list != OS_NULL)
+    {
+        rcu_gp_start();
+    }
+}
+
+/*!
+ * 执行宽限期已经结束的回调函数，在系统工作队列的工作线程中执行
+ * @param arg 未使用
+ */
+static void rcu_work_func(os_size_t arg)
+{
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_spinlock_lock(&rcu_lock);
+    os_rcu_head_p head = rcu_done_list;
+    rcu_done_list = OS_NULL;
+    rcu_done_tail = (os_rcu_head_p *)&rcu_done_list;
+    os_spinlock_unlock(&rcu_lock);
+    os_interrupt_enable(interrupt_state);
+
+    while(head != OS_NULL)
+    {
+        os_rcu_head_p next = head -> next;
+        head -> func(head);
+        head = next;
+        __atomic_add_fetch(&rcu_invoke_count,1,__ATOMIC_RELAXED);
+    }
+}
+
+/*!
+ * os_rcu_synchronize使用的回调函数，唤醒等待宽限期结束的任务
+ * @param head RCU回调节点
+ */
+static void rcu_sync_func(os_rcu_head_p head)
+{
+    rcu_sync_p sync = os_container_of(head,rcu_sync_t,head);
+
+    OS_ENTER_CRITICAL_AREA();
+    sync -> done = OS_TRUE;
+    os_waitqueue_wakeup(&sync -> waitqueue);
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 进入RCU读临界区，读临界区可以嵌套，期间不能睡眠，可以在中断上下文中使用
+ */
+void os_rcu_read_lock()
+{
+    os_preempt_disable();
+}
+
+/*!
+ * 退出RCU读临界区
+ */
+void os_rcu_read_unlock()
+{
+    os_preempt_enable();
+}
+
+/*!
+ * 注册RCU回调函数，回调函数在当前所有读临界区退出后执行，可以在中断上下文和读临界区中调用
+ * @param head RCU回调节点，通常嵌入在要释放的对象中
+ * @param func 回调函数
+ */
+void os_rcu_call(os_rcu_head_p head,os_rcu_func_t func)
+{
+    head -> next = OS_NULL;
+    head -> func = func;
+
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_spinlock_lock(&rcu_lock);
+    *rcu_next_tail = head;
+    rcu_next_tail = &head -> next;
+    rcu_call_count++;
+
+    //正在进行的宽限期开始时该回调尚未注册，需要等到下一个宽限期
+    if(!rcu_gp_running)
+    {
+        rcu_gp_start();
+    }
+
+    os_spinlock_unlock(&rcu_lock);
+    os_interrupt_enable(interrupt_state);
+}
+
+/*!
+ * 等待一个完整的宽限期结束，返回时调用前进入的所有读临界区都已退出，不能在读临界区中调用
+ * 回调函数由系统工作队列执行，因此不能在系统工作队列的工作函数中调用
+ */
+void os_rcu_synchronize()
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    rcu_sync_t sync;
+
+    os_waitqueue_init(&sync.waitqueue);
+    sync.done = OS_FALSE;
+    os_rcu_call(&sync.head,rcu_sync_func);
+
+    OS_ENTER_CRITICAL_AREA();
+
+    while(!sync.done)
+    {
+        os_waitqueue_wait(&sync.waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 报告当前hart经过了一次静止状态，在调度、时钟中断和空闲循环中调用
+ * 当前任务处于读临界区（禁止抢占）或持有内核大锁时不是静止状态，此时不动作
+ * 没有正在进行的宽限期或本hart已经报告过时只读取一个hart私有变量
+ */
+void os_rcu_qs()
+{
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_hart_p hart = os_hart_get_current();
+    os_task_p task = hart -> current_task;
+
+    if(hart -> rcu_need_qs && (hart -> kernel_lock_depth == 0) && ((task == OS_NULL) || (task -> preempt_count == 0)))
+    {
+        os_spinlock_lock(&rcu_lock);
+        hart -> rcu_need_qs = OS_FALSE;
+
+        if(rcu_qs_mask & SIZE(hart -> cpu_id))
+        {
+            rcu_qs_mask &= ~SIZE(hart -> cpu_id);
+
+            if(rcu_qs_mask == 0)
+            {
+                rcu_gp_end();
+            }
+        }
+
+        os_spinlock_unlock(&rcu_lock);
+    }
+
+    os_interrupt_enable(interrupt_state);
+}
+
+/*!
+ * 报告静止状态，并在存在宽限期已经结束的回调时将其交给系统工作队列执行，在时钟中断和空闲循环中调用，不能在调度器中调用
+ * 系统工作队列启动前宽限期已经结束的回调保留在待执行列表中
+ */
+void os_rcu_check()
+{
+    os_rcu_qs();
+
+    if(rcu_work_ready && (rcu_done_list != OS_NULL))
+    {
+        os_work_schedule(&rcu_work);
+    }
+}
+
+/*!
+ * RCU子系统初始化
+ */
+void os_rcu_system_init()
+{
+    os_work_init(&rcu_work,rcu_work_func,0);
+}
+
+/*!
+ * 允许将回调交给系统工作队列执行，必须在系统工作队列启动之后调用，此后才能调用os_rcu_synchronize
+ */
+void os_rcu_startup()
+{
+    rcu_work_ready = OS_TRUE;
+}
+
+/*!
+ * 打印RCU统计信息
+ */
+void os_rcu_print_info()
+{
+    os_size_t gp_count = rcu_gp_count;
+    os_printf("rcu: gp = %ld,avg gp = %ldns,max gp = %ldns,call = %ld,invoke = %ld,gp running = %d,qs mask = 0x%lx\n",gp_count,(gp_count > 0) ? (rcu_gp_time_total / gp_count) : 0,rcu_gp_time_max,rcu_call_count,rcu_invoke_count,rcu_gp_running,rcu_qs_mask);
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*!
+ * 检测读者能否立即获取读写信号量，调用者必须处于临界区
+ * @param rwsem 读写信号量结构体指针
+ * @return 能获取返回OS_TRUE，否则返回OS_FALSE
+ */
+static os_bool_t rwsem_can_read(os_rwsem_p rwsem)
+{
+    if(rwsem -> count < 0)
+    {
+        return OS_FALSE;
+    }
+
+    return (rwsem -> policy != OS_RWSEM_PREFER_WRITER) || (rwsem -> writer_waiting == 0);
+}
+
+/*!
+ * 读写信号量变为空闲或只被读者持有时，按优先策略唤醒等待者，调用者必须处于临界区
+ * 被唤醒的任务会重新检查获取条件，因此这里只需唤醒可能成功获取的一方
+ * @param rwsem 读写信号量结构体指针
+ */
+static void rwsem_wakeup(os_rwsem_p rwsem)
+{
+    os_bool_t wakeup_writer = (rwsem -> count == 0) && (rwsem -> writer_waiting > 0);
+
+    //读者优先时，有读者等待则只唤醒读者
+    if(wakeup_writer && (rwsem -> policy == OS_RWSEM_PREFER_READER) && (rwsem -> reader_waiting > 0))
+    {
+        wakeup_writer = OS_FALSE;
+    }
+
+    if(wakeup_writer)
+    {
+        os_waitqueue_wakeup(&rwsem -> writer_waitqueue);
+    }
+    else if((rwsem -> reader_waiting > 0) && rwsem_can_read(rwsem))
+    {
+        os_waitqueue_wakeup_all(&rwsem -> reader_waitqueue);
+    }
+}
+
+/*!
+ * 读写信号量初始化
+ * @param rwsem 读写信号量结构体指针
+ * @param policy 优先策略
+ */
+void os_rwsem_init(os_rwsem_p rwsem,os_rwsem_policy_t policy)
+{
+    OS_ASSERT(policy < OS_RWSEM_POLICY_NUM);
+    rwsem -> count = 0;
+    rwsem -> writer = OS_NULL;
+    rwsem -> reader_waiting = 0;
+    rwsem -> writer_waiting = 0;
+    rwsem -> policy = policy;
+    os_waitqueue_init(&rwsem -> reader_waitqueue);
+    os_waitqueue_init(&rwsem -> writer_waitqueue);
+}
+
+/*!
+ * 以读模式获取读写信号量，必要时等待
+ * @param rwsem 读写信号量结构体指针
+ */
+void os_rwsem_down_read(os_rwsem_p rwsem)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    OS_ENTER_CRITICAL_AREA();
+    OS_ASSERT(rwsem -> writer != os_task_get_current_task());
+
+    while(!rwsem_can_read(rwsem))
+    {
+        rwsem -> reader_waiting++;
+        os_waitqueue_wait(&rwsem -> reader_waitqueue);
+        rwsem -> reader_waiting--;
+    }
+
+    rwsem -> count++;
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 尝试以读模式获取读写信号量，不等待
+ * @param rwsem 读写信号量结构体指针
+ * @return 成功返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_rwsem_try_down_read(os_rwsem_p rwsem)
+{
+    os_bool_t ret;
+
+    OS_ENTER_CRITICAL_AREA();
+    ret = rwsem_can_read(rwsem);
+
+    if(ret)
+    {
+        rwsem -> count++;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 释放以读模式获取的读写信号量
+ * @param rwsem 读写信号量结构体指针
+ */
+void os_rwsem_up_read(os_rwsem_p rwsem)
+{
+    OS_ENTER_CRITICAL_AREA();
+    OS_ASSERT(rwsem -> count > 0);
+    rwsem -> count--;
+
+    if(rwsem -> count == 0)
+    {
+        rwsem_wakeup(rwsem);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 以写模式获取读写信号量，必要时等待
+ * @param rwsem 读写信号量结构体指针
+ */
+void os_rwsem_down_write(os_rwsem_p rwsem)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    OS_ENTER_CRITICAL_AREA();
+    os_task_p task = os_task_get_current_task();
+    OS_ASSERT(rwsem -> writer != task);
+
+    while(rwsem -> count != 0)
+    {
+        rwsem -> writer_waiting++;
+        os_waitqueue_wait_exclusive(&rwsem -> writer_waitqueue);
+        rwsem -> writer_waiting--;
+    }
+
+    rwsem -> count = -1;
+    rwsem -> writer = task;
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 尝试以写模式获取读写信号量，不等待
+ * @param rwsem 读写信号量结构体指针
+ * @return 成功返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_rwsem_try_down_write(os_rwsem_p rwsem)
+{
+    os_bool_t ret;
+
+    OS_ENTER_CRITICAL_AREA();
+    ret = rwsem -> count == 0;
+
+    if(ret)
+    {
+        rwsem -> count = -1;
+        rwsem -> writer = os_task_get_current_task();
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 释放以写模式获取的读写信号量
+ * @param rwsem 读写信号量结构体指针
+ */
+void os_rwsem_up_write(os_rwsem_p rwsem)
+{
+    OS_ENTER_CRITICAL_AREA();
+    OS_ASSERT(rwsem -> count == -1);
+    OS_ASSERT(rwsem -> writer == os_task_get_current_task());
+    rwsem -> count = 0;
+    rwsem -> writer = OS_NULL;
+    rwsem_wakeup(rwsem);
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 将以写模式持有的读写信号量原子地降级为读模式，期间其它写者无法获取
+ * @param rwsem 读写信号量结构体指针
+ */
+void os_rwsem_downgrade(os_rwsem_p rwsem)
+{
+    OS_ENTER_CRITICAL_AREA();
+    OS_ASSERT(rwsem -> count == -1);
+    OS_ASSERT(rwsem -> writer == os_task_get_current_task());
+    rwsem -> count = 1;
+    rwsem -> writer = OS_NULL;
+
+    //降级后等待的读者也可以获取，写者优先时仍然需要等待写者
+    if((rwsem -> reader_waiting > 0) && rwsem_can_read(rwsem))
+    {
+        os_waitqueue_wakeup_all(&rwsem -> reader_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
\ No newline at end of file
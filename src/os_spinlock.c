@@ -0,0 +1,53 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-25     lizhirui     the first version
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*!
+ * 自旋锁初始化
+ * @param lock 自旋锁结构体指针
+ */
+void os_spinlock_init(os_spinlock_p lock)
+{
+    __atomic_store_n(&lock -> locked,OS_FALSE,__ATOMIC_RELAXED);
+}
+
+/*!
+ * 自旋锁锁定，该函数不支持递归调用
+ * 竞争失败时只读等待锁被释放后再重新尝试，避免持续的原子写操作占用总线
+ * @param lock 自旋锁结构体指针
+ */
+void os_spinlock_lock(os_spinlock_p lock)
+{
+    while(__atomic_exchange_n(&lock -> locked,OS_TRUE,__ATOMIC_ACQUIRE) != OS_FALSE)
+    {
+        while(__atomic_load_n(&lock -> locked,__ATOMIC_RELAXED) != OS_FALSE);
+    }
+}
+
+/*!
+ * 尝试锁定自旋锁
+ * @param lock 自旋锁结构体指针
+ * @return 成功返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_spinlock_trylock(os_spinlock_p lock)
+{
+    return __atomic_exchange_n(&lock -> locked,OS_TRUE,__ATOMIC_ACQUIRE) == OS_FALSE;
+}
+
+/*!
+ * 自旋锁解锁
+ * @param lock 自旋锁结构体指针
+ */
+void os_spinlock_unlock(os_spinlock_p lock)
+{
+    __atomic_store_n(&lock -> locked,OS_FALSE,__ATOMIC_RELEASE);
+}
\ No newline at end of file
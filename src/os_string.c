@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
+ * 2021-07-20     lizhirui     add page zero and page copy support
  */
 
 // @formatter:off
@@ -133,4 +134,80 @@ os_ssize_t os_memcmp(const void *buf1,const void *buf2,os_size_t len)
 	}
 
 	return 0;
+}
+
+/*!
+ * 按页面清零一段内存，若开启了OS_ARCH_ZICBOZ，则使用cbo.zero按cache块清零，否则按64位字展开写入
+ * @param page 内存指针，必须与页面边界对齐
+ * @param size 内存大小，必须为页面大小的整数倍
+ */
+void os_page_zero(void *page,os_size_t size)
+{
+    OS_ASSERT(CHECK_ALIGN((os_size_t)page,PAGE_BITS));
+    OS_ASSERT(CHECK_ALIGN(size,PAGE_BITS));
+
+    #ifdef OS_ARCH_ZICBOZ
+        os_size_t addr = (os_size_t)page;
+        os_size_t end = addr + size;
+
+        for(;addr < end;addr += OS_ARCH_CBOZ_BLOCK_SIZE * 4)
+        {
+            ARCH_CBO_ZERO(addr);
+            ARCH_CBO_ZERO(addr + OS_ARCH_CBOZ_BLOCK_SIZE);
+            ARCH_CBO_ZERO(addr + OS_ARCH_CBOZ_BLOCK_SIZE * 2);
+            ARCH_CBO_ZERO(addr + OS_ARCH_CBOZ_BLOCK_SIZE * 3);
+        }
+    #else
+        os_uint64_t *t_ptr = (os_uint64_t *)page;
+        os_uint64_t *t_end = (os_uint64_t *)((os_size_t)page + size);
+
+        for(;t_ptr < t_end;t_ptr += 8)
+        {
+            t_ptr[0] = 0;
+            t_ptr[1] = 0;
+            t_ptr[2] = 0;
+            t_ptr[3] = 0;
+            t_ptr[4] = 0;
+            t_ptr[5] = 0;
+            t_ptr[6] = 0;
+            t_ptr[7] = 0;
+        }
+    #endif
+}
+
+/*!
+ * 按页面拷贝一段内存，按64位字展开读写
+ * @param dst 目标内存指针，必须与页面边界对齐
+ * @param src 源内存指针，必须与页面边界对齐
+ * @param size 内存大小，必须为页面大小的整数倍
+ */
+void os_page_copy(void *dst,const void *src,os_size_t size)
+{
+    OS_ASSERT(CHECK_ALIGN((os_size_t)dst,PAGE_BITS));
+    OS_ASSERT(CHECK_ALIGN((os_size_t)src,PAGE_BITS));
+    OS_ASSERT(CHECK_ALIGN(size,PAGE_BITS));
+
+    os_uint64_t *t_dst = (os_uint64_t *)dst;
+    const os_uint64_t *t_src = (const os_uint64_t *)src;
+    const os_uint64_t *t_end = (const os_uint64_t *)((os_size_t)src + size);
+
+    for(;t_src < t_end;t_dst += 8,t_src += 8)
+    {
+        os_uint64_t r0 = t_src[0];
+        os_uint64_t r1 = t_src[1];
+        os_uint64_t r2 = t_src[2];
+        os_uint64_t r3 = t_src[3];
+        os_uint64_t r4 = t_src[4];
+        os_uint64_t r5 = t_src[5];
+        os_uint64_t r6 = t_src[6];
+        os_uint64_t r7 = t_src[7];
+        t_dst[0] = r0;
+        t_dst[1] = r1;
+        t_dst[2] = r2;
+        t_dst[3] = r3;
+        t_dst[4] = r4;
+        t_dst[5] = r5;
+        t_dst[6] = r6;
+        t_dst[7] = r7;
+    }
 }
\ No newline at end of file
@@ -8,6 +8,16 @@
  * 2021-07-06     lizhirui     the first version
  * 2021-07-08     lizhirui     add copy_from_user and execve syscall support
  * 2021-07-09     lizhirui     add some syscalls
+ * 2021-07-26     lizhirui     implement nanosleep syscall
+ * 2021-07-27     lizhirui     add sched_setattr and sched_getattr syscall
+ * 2021-07-27     lizhirui     implement times and getrusage syscall
+ * 2021-07-28     lizhirui     fix task structure release when clone fails to initialize the task
+ * 2021-07-28     lizhirui     allocate cache line aligned task structure in clone
+ * 2021-07-28     lizhirui     implement exit and wait4 syscall with zombie tasks, start the cloned task and return its pid
+ * 2021-07-28     lizhirui     move cloned task to its new parent with os_task_set_parent
+ * 2021-07-28     lizhirui     access the task found by pid in sched_setattr and sched_getattr only inside critical area
+ * 2021-07-28     lizhirui     encode wait4 exit status with OS_TASK_WAIT_STATUS
+ * 2021-07-28     lizhirui     forbid user tasks to change the scheduling attributes of kernel tasks
  */
 
 // @formatter:off
@@ -247,52 +257,62 @@ os_ssize_t os_syscall_clone(struct TrapFrame *regs,os_size_t clone_flags,os_size
 {
     OS_ANNOTATION_NEED_TASK_CONTEXT();
     os_task_p cur_task = os_task_get_current_task();
-    os_task_p task = os_memory_alloc(sizeof(os_task_t));
+    os_task_p task = os_task_alloc();
     OS_ERR_RETURN_ERROR(task == OS_NULL,-OS_ERR_EPERM);
-    OS_ENTER_CRITICAL_AREA();
     os_err_t err;
 
+    //os_task_init失败时已经释放了其申请的资源，只需释放任务结构体
     if((err = os_task_init(task,cur_task -> stack_size,cur_task -> priority,cur_task -> tick_init,cur_task -> entry,cur_task -> arg,cur_task -> name)) != OS_ERR_OK)
     {
-        os_task_remove(task);
-        OS_LEAVE_CRITICAL_AREA();
+        os_task_free(task);
         return err;
     }
 
-    os_list_node_remove(&task -> child_node);
-    task -> parent = cur_task -> parent;
-    os_list_insert_tail(task -> parent -> child_list,&task -> child_node);
+    //子任务启动之前只有当前任务能访问其内核栈和页表，因此只有修改任务树和页表引用计数时需要进入临界区，复制内存期间可以被中断和抢占
     arch_task_clone_stack_frame_init(regs,task,newsp);
 
     if(clone_flags & OS_CLONE_VM)
     {
+        OS_ENTER_CRITICAL_AREA();
+        task -> vtable -> refcnt--;
         task -> vtable = cur_task -> vtable;
         task -> vtable -> refcnt++;
+        OS_LEAVE_CRITICAL_AREA();
     }
     else
     {
-        task -> vtable -> refcnt--;
-        task -> vtable = os_memory_alloc(sizeof(os_mmu_vtable_t));
+        os_mmu_vtable_p vtable = os_memory_alloc(sizeof(os_mmu_vtable_t));
 
-        if(task -> vtable == OS_NULL)
+        if(vtable == OS_NULL)
         {
             os_task_remove(task);
-            OS_LEAVE_CRITICAL_AREA();
-            return err;
+            return -OS_ERR_ENOMEM;
         }
 
+        OS_ENTER_CRITICAL_AREA();
+        task -> vtable -> refcnt--;
+        task -> vtable = vtable;
+        OS_LEAVE_CRITICAL_AREA();
         err = os_clone_copy_memory(task);
 
         if(err != OS_ERR_OK)
         {
             os_task_remove(task);
-            OS_LEAVE_CRITICAL_AREA();
             return err;
         }
     }
 
+    OS_ENTER_CRITICAL_AREA();
+
+    //os_task_init已将当前任务设置为父任务，指定OS_CLONE_PARENT时与当前任务共用父任务
+    if(clone_flags & OS_CLONE_PARENT)
+    {
+        os_task_set_parent(task,cur_task -> parent);
+    }
+
+    os_task_startup(task);
     OS_LEAVE_CRITICAL_AREA();
-    return OS_ERR_OK;
+    return task -> pid;
 }
 
 void arch_task_execve_stack_frame_init(struct TrapFrame *regs,os_size_t entry);
@@ -313,20 +333,49 @@ os_ssize_t os_syscall_execve(struct TrapFrame *regs,os_size_t filename,os_size_t
     return ret;
 }
 
-os_ssize_t os_syscall_wait4(struct TrapFrame *regs,os_size_t pid,os_size_t status,os_size_t options)
+/*!
+ * 将纳秒数转换为timeval结构体
+ * @param tv timeval结构体指针
+ * @param ns 纳秒数
+ */
+static void os_syscall_ns_to_timeval(os_timeval_p tv,os_size_t ns)
 {
-    return 0;
+    tv -> tv_sec = ns / 1000000000UL;
+    tv -> tv_usec = (ns % 1000000000UL) / 1000UL;
 }
 
+os_ssize_t os_syscall_wait4(struct TrapFrame *regs,os_ssize_t pid,os_size_t status,os_size_t options,os_size_t rusage)
+{
+    os_ssize_t exit_code;
+    os_size_t utime,stime;
+    os_ssize_t ret = os_task_wait(pid,(options & OS_WNOHANG) != 0,&exit_code,&utime,&stime);
+
+    if(ret <= 0)
+    {
+        return ret;
+    }
+
+    if(status != 0)
+    {
+        os_int32_t wstatus = OS_TASK_WAIT_STATUS(exit_code);
+        OS_ERR_GET_ERROR_AND_RETURN(os_copy_to_user(status,&wstatus,sizeof(wstatus)));
+    }
+
+    if(rusage != 0)
+    {
+        os_rusage_t buf;
+        os_memset(&buf,0,sizeof(buf));
+        os_syscall_ns_to_timeval(&buf.ru_utime,utime);
+        os_syscall_ns_to_timeval(&buf.ru_stime,stime);
+        OS_ERR_GET_ERROR_AND_RETURN(os_copy_to_user(rusage,&buf,sizeof(buf)));
+    }
+
+    return ret;
+}
 
 os_ssize_t os_syscall_exit(struct TrapFrame *regs,os_ssize_t ec)
 {
-    OS_ENTER_CRITICAL_AREA();
-    os_task_get_current_task() -> exit_code = ec;
-    os_task_get_current_task() -> task_state = OS_TASK_STATE_STOPPED;
-    OS_LEAVE_CRITICAL_AREA();
-    os_task_schedule();
-    return OS_ERR_OK;
+    os_task_exit(ec);
 }
 
 os_ssize_t os_syscall_getpid(struct TrapFrame *regs)
@@ -365,7 +414,53 @@ os_ssize_t os_syscall_mmap(struct TrapFrame *regs,os_size_t start,os_size_t len,
 
 os_ssize_t os_syscall_times(struct TrapFrame *regs,os_size_t tms)
 {
-    return 0;
+    os_task_p task = os_task_get_current_task();
+    os_tms_t buf;
+    os_size_t utime,stime;
+
+    if(tms != 0)
+    {
+        os_cputime_get_task(task,&utime,&stime);
+        buf.tms_utime = utime / OS_NS_PER_TICK;
+        buf.tms_stime = stime / OS_NS_PER_TICK;
+        buf.tms_cutime = task -> cutime / OS_NS_PER_TICK;
+        buf.tms_cstime = task -> cstime / OS_NS_PER_TICK;
+        OS_ERR_GET_ERROR_AND_RETURN(os_copy_to_user(tms,&buf,sizeof(buf)));
+    }
+
+    return os_tick_get();
+}
+
+os_ssize_t os_syscall_getrusage(struct TrapFrame *regs,os_ssize_t who,os_size_t usage)
+{
+    os_task_p task = os_task_get_current_task();
+    os_rusage_t buf;
+    os_size_t utime,stime;
+
+    os_memset(&buf,0,sizeof(buf));
+
+    switch(who)
+    {
+        //系统尚不支持线程组，线程与进程的统计相同
+        case OS_RUSAGE_SELF:
+        case OS_RUSAGE_THREAD:
+            os_cputime_get_task(task,&utime,&stime);
+            os_syscall_ns_to_timeval(&buf.ru_utime,utime);
+            os_syscall_ns_to_timeval(&buf.ru_stime,stime);
+            buf.ru_nvcsw = task -> nvcsw;
+            buf.ru_nivcsw = task -> nivcsw;
+            break;
+
+        case OS_RUSAGE_CHILDREN:
+            os_syscall_ns_to_timeval(&buf.ru_utime,task -> cutime);
+            os_syscall_ns_to_timeval(&buf.ru_stime,task -> cstime);
+            break;
+
+        default:
+            return -OS_ERR_EINVAL;
+    }
+
+    return os_copy_to_user(usage,&buf,sizeof(buf));
 }
 
 os_ssize_t os_syscall_uname(struct TrapFrame *regs,os_size_t uts)
@@ -379,6 +474,116 @@ os_ssize_t os_syscall_sched_yield(struct TrapFrame *regs)
     return OS_ERR_OK;
 }
 
+/*!
+ * 通过pid查找任务，pid为0时表示当前任务
+ * 任务结构体在RCU宽限期结束后才会被释放，持有内核大锁的hart不会经过静止状态，因此调用者必须在临界区中调用该函数并使用返回的任务
+ * @param pid 任务pid
+ * @return 找到的任务，不存在时返回OS_NULL
+ */
+static os_task_p os_syscall_find_task(os_size_t pid)
+{
+    return (pid == 0) ? os_task_get_current_task() : os_task_get_task_by_pid(pid);
+}
+
+/*!
+ * 根据调度属性设置任务的调度策略
+ * @param task 任务结构体指针
+ * @param attr 调度属性
+ * @return 成功返回OS_ERR_OK，失败返回负数错误码
+ */
+static os_err_t os_syscall_set_sched_attr(os_task_p task,os_sched_attr_p attr)
+{
+    switch(attr -> sched_policy)
+    {
+        case OS_SCHED_NORMAL:
+            return os_task_set_sched_policy(task,OS_TASK_SCHED_FAIR,attr -> sched_nice);
+
+        case OS_SCHED_FIFO:
+        case OS_SCHED_RR:
+            return os_task_set_sched_policy(task,OS_TASK_SCHED_RT,attr -> sched_priority);
+
+        case OS_SCHED_DEADLINE:
+            //period为0时与deadline相同
+            return os_task_set_deadline(task,attr -> sched_runtime,attr -> sched_deadline,(attr -> sched_period == 0) ? attr -> sched_deadline : attr -> sched_period);
+
+        default:
+            return -OS_ERR_EINVAL;
+    }
+}
+
+os_ssize_t os_syscall_sched_setattr(struct TrapFrame *regs,os_size_t pid,os_size_t uattr,os_size_t flags)
+{
+    os_sched_attr_t attr;
+    os_err_t ret;
+
+    OS_ERR_RETURN_ERROR(flags != 0,-OS_ERR_EINVAL);
+    //复制用户数据需要遍历页表，在查找任务之前完成，使临界区中只访问任务结构体
+    OS_ERR_GET_ERROR_AND_RETURN(os_copy_from_user(&attr,uattr,sizeof(attr)));
+    OS_ERR_RETURN_ERROR(attr.size < sizeof(attr),-OS_ERR_EINVAL);
+
+    OS_ENTER_CRITICAL_AREA();
+    os_task_p task = os_syscall_find_task(pid);
+
+    if(task == OS_NULL)
+    {
+        ret = -OS_ERR_ESRCH;
+    }
+    //内核任务（使用内核页表）的调度属性不允许被用户任务修改
+    else if(task -> vtable == os_mmu_get_kernel_pagetable())
+    {
+        ret = -OS_ERR_EPERM;
+    }
+    else
+    {
+        ret = os_syscall_set_sched_attr(task,&attr);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+os_ssize_t os_syscall_sched_getattr(struct TrapFrame *regs,os_size_t pid,os_size_t uattr,os_size_t size,os_size_t flags)
+{
+    os_sched_attr_t attr;
+
+    OS_ERR_RETURN_ERROR((flags != 0) || (size < sizeof(attr)),-OS_ERR_EINVAL);
+    os_memset(&attr,0,sizeof(attr));
+    attr.size = sizeof(attr);
+
+    OS_ENTER_CRITICAL_AREA();
+    os_task_p task = os_syscall_find_task(pid);
+
+    if(task == OS_NULL)
+    {
+        OS_LEAVE_CRITICAL_AREA();
+        return -OS_ERR_ESRCH;
+    }
+
+    switch(task -> base_sched_policy)
+    {
+        case OS_TASK_SCHED_DEADLINE:
+            attr.sched_policy = OS_SCHED_DEADLINE;
+            attr.sched_runtime = task -> dl_runtime;
+            attr.sched_deadline = task -> dl_deadline;
+            attr.sched_period = task -> dl_period;
+            break;
+
+        case OS_TASK_SCHED_RT:
+            attr.sched_policy = OS_SCHED_RR;
+            attr.sched_priority = task -> base_priority;
+            break;
+
+        default:
+            attr.sched_policy = OS_SCHED_NORMAL;
+            attr.sched_nice = task -> nice;
+            break;
+    }
+
+    //复制到用户内存之前离开临界区，此后不再访问任务结构体
+    OS_LEAVE_CRITICAL_AREA();
+    return os_copy_to_user(uattr,&attr,sizeof(attr));
+}
+
 os_ssize_t os_syscall_gettimeofday(struct TrapFrame *regs,os_size_t ts)
 {
     return 0;
@@ -386,5 +591,27 @@ os_ssize_t os_syscall_gettimeofday(struct TrapFrame *regs,os_size_t ts)
 
 os_size_t os_syscall_nanosleep(struct TrapFrame *regs,os_size_t req,os_size_t rem)
 {
-    return 0;
+    os_timespec_t ts;
+    os_size_t ns;
+
+    OS_ERR_GET_ERROR_AND_RETURN(os_copy_from_user(&ts,req,sizeof(ts)));
+    OS_ERR_RETURN_ERROR((ts.tv_sec < 0) || (ts.tv_nsec < 0) || (ts.tv_nsec >= 1000000000L),-OS_ERR_EINVAL);
+
+    //防止溢出
+    if(((os_size_t)ts.tv_sec) >= ((~0UL) / 1000000000UL))
+    {
+        ns = ~0UL;
+    }
+    else
+    {
+        ns = ts.tv_sec * 1000000000UL + ts.tv_nsec;
+    }
+
+    //系统尚不支持信号，提前唤醒均视为虚假唤醒，因此总是睡眠到时间耗尽，也不需要写回rem
+    while(ns > 0)
+    {
+        ns = os_task_sleep_ns(ns);
+    }
+
+    return OS_ERR_OK;
 }
\ No newline at end of file
@@ -10,6 +10,34 @@
  * 2021-07-07     lizhirui     add pid support
  * 2021-07-08     lizhirui     add fd list/bitmap and brk/init_brk fields support for task
  * 2021-07-09     lizhirui     add fd_table support
+ * 2021-07-21     lizhirui     start log task in idle task
+ * 2021-07-22     lizhirui     allow task wakeup in interrupt context
+ * 2021-07-24     lizhirui     add ready priority bitmap for scheduler
+ * 2021-07-25     lizhirui     add smp support with shared ready queue and per-hart idle task
+ * 2021-07-26     lizhirui     add per-hart runqueue with work stealing and wakeup affinity
+ * 2021-07-26     lizhirui     add timed sleep
+ * 2021-07-26     lizhirui     add tickless idle
+ * 2021-07-27     lizhirui     add scheduling class and fair scheduling class
+ * 2021-07-27     lizhirui     add deadline scheduling class
+ * 2021-07-27     lizhirui     add priority inheritance support
+ * 2021-07-27     lizhirui     track the kernel stack top of the current task for trap entry
+ * 2021-07-27     lizhirui     add cpu time and context switch accounting
+ * 2021-07-28     lizhirui     allocate kernel stacks from the guarded kernel stack cache
+ * 2021-07-28     lizhirui     add cache line aligned task allocation and allocate names to their actual length
+ * 2021-07-28     lizhirui     replace pid bitmap and pid hashmap with radix tree id allocator
+ * 2021-07-28     lizhirui     add task exit, wait and task reaper
+ * 2021-07-28     lizhirui     defer lazy task switch while running bottom halves
+ * 2021-07-28     lizhirui     defer preemption while preemption is disabled and shorten task remove and clone critical areas
+ * 2021-07-28     lizhirui     add batched wakeup
+ * 2021-07-28     lizhirui     report rcu quiescent state on schedule and look up tasks by pid without locking
+ * 2021-07-28     lizhirui     read current task with a single tp relative load
+ * 2021-07-28     lizhirui     protect task tree with its own spinlock and allocate pids and print task tree with preemption disabled instead of interrupts
+ * 2021-07-28     lizhirui     modify page table reference count and task tree in critical area when initializing task
+ * 2021-07-28     lizhirui     allow kernel tasks to reap their children with os_task_wait
+ * 2021-07-28     lizhirui     print task tree under big kernel lock instead of task tree lock
+ * 2021-07-28     lizhirui     remove reaped tasks from their parent while holding task tree lock
+ * 2021-07-28     lizhirui     avoid overflow when converting sleep time from nanoseconds to ticks
+ * 2021-07-28     lizhirui     free replaced task name and path after an rcu grace period
  */
 
 // @formatter:off
@@ -17,318 +45,1956 @@
 
 //任务优先级开区间上界（即实际优先级的的数量）
 #define TASK_PRIORITY_UPLIMIT (TASK_PRIORITY_MAX + 1)
+//就绪优先级位图的字数
+#define TASK_PRIORITY_BITMAP_WORDS DIV_UP(TASK_PRIORITY_UPLIMIT,SIZE(OS_SIZE_T_BITS))
 
-static os_list_node_t task_list;//任务列表
-static os_list_node_t priority_ready_list[TASK_PRIORITY_UPLIMIT];//按任务优先级存储的任务就绪列表
+//就绪优先级位图采用两级结构，组位图的每一位对应一个位图字，因此最多支持256个优先级
+#if TASK_PRIORITY_MAX > 255
+    #error "TASK_PRIORITY_MAX must be less than 256"
+#endif
 
-os_task_t *current_task = OS_NULL;//当前任务
+//运行队列，每个hart一个，保存分配到该hart上的就绪任务，正在运行的任务不在运行队列中
+typedef struct os_task_runqueue
+{
+    os_spinlock_t lock;//运行队列锁，保护运行队列中的所有字段
+    //截止时间调度类
+    os_rbtree_t dl_tree;//按绝对截止时间排序的就绪任务
+    os_size_t dl_num;//截止时间调度类的就绪任务数量
+    os_list_node_t dl_throttled_list;//预算耗尽、等待补充预算的任务
+    os_size_t dl_miss_count;//截止时间错失次数
+    os_size_t dl_overrun_count;//预算超支次数
+    //固定优先级调度类
+    os_list_node_t priority_ready_list[TASK_PRIORITY_UPLIMIT];//按任务优先级存储的任务就绪列表
+    os_size_t priority_ready_bitmap[TASK_PRIORITY_BITMAP_WORDS];//就绪优先级位图，第i位为1表示优先级i的就绪列表非空
+    volatile os_size_t priority_ready_group;//就绪优先级组位图，第i位为1表示priority_ready_bitmap[i]非零
+    //公平调度类
+    os_rbtree_t fair_tree;//按虚拟运行时间排序的就绪任务
+    os_size_t fair_num;//公平调度类的就绪任务数量
+    os_size_t fair_weight;//公平调度类的就绪任务的权重之和
+    os_size_t min_vruntime;//单调递增的最小虚拟运行时间，用于放置新就绪的任务
+    volatile os_size_t ready_num;//就绪任务数量，其它hart会无锁读取该值以选择窃取目标
+    os_size_t steal_count;//从其它hart窃取任务的次数
+    os_size_t migration_count;//从其它hart迁入的任务数量
+}os_task_runqueue_t,*os_task_runqueue_p;
+
+//调度类，调度器按调度策略的顺序依次询问各调度类，排在前面的调度类中的就绪任务总是优先于后面的调度类
+typedef struct os_task_sched_class
+{
+    void (*enqueue)(os_task_runqueue_p rq,os_task_p task);//将任务放入运行队列
+    void (*dequeue)(os_task_runqueue_p rq,os_task_p task);//将任务移出运行队列
+    os_task_p (*pick_next)(os_task_runqueue_p rq);//获取下一个应当运行的任务，不将其移出运行队列
+    os_bool_t (*check_preempt)(os_task_p current_task,os_task_p task,os_bool_t round_robin);//判断task是否应当抢占同一调度类中的current_task
+    void (*update_current)(os_task_runqueue_p rq,os_task_p task);//统计正在运行的任务的运行时间
+    void (*set_next)(os_task_runqueue_p rq,os_task_p task);//任务被选中运行时调用
+    void (*place)(os_task_runqueue_p rq,os_task_p task);//任务被唤醒或启动、放入运行队列之前调用
+    void (*migrate)(os_task_runqueue_p old_rq,os_task_runqueue_p rq,os_task_p task);//任务从old_rq迁移到rq时调用
+}os_task_sched_class_t,*os_task_sched_class_p;
+
+//任务名称和任务路径的存储结构，字符串紧跟在RCU回调节点之后，被替换的字符串可能仍在被通过pid查找到该任务的读者访问，需要在宽限期结束后释放
+typedef struct task_string
+{
+    os_rcu_head_t rcu;//用于在宽限期结束后释放被替换的字符串
+    char str[];//字符串内容，按实际长度分配
+}task_string_t,*task_string_p;
 
-//以下三个变量用于在中断中请求任务切换时推迟请求
-os_bool_t need_lazy_task_switch = OS_FALSE;//是否有挂起的任务切换请求
-os_task_t *lazy_old_task = OS_NULL;//切换来源任务
-os_task_t *lazy_next_task = OS_NULL;//切换目标任务
+static os_list_node_t task_list;//任务列表
+//任务树锁，保护各任务的子任务列表和父任务指针，修改任务树时需要同时持有内核大锁和任务树锁，只读遍历任务树时持有其中之一即可
+//加锁顺序为内核大锁→任务树锁，持有任务树锁时只禁止抢占，不关中断，也不能再获取内核大锁，因此不能调用os_printf等可能获取内核大锁的函数
+static os_spinlock_t task_tree_lock = OS_SPINLOCK_INIT;
+static os_task_runqueue_t task_runqueue[OS_CPU_MAX_NUM];//各hart的运行队列，按逻辑处理器编号索引
 
 //调度器是否初始化完成
 static os_bool_t os_task_scheduler_initialized = OS_FALSE;
 
-static os_task_t task_idle;//idle任务结构体
+static os_size_t task_deadline_total_bw = 0;//所有截止时间任务占用的带宽之和，由内核大锁保护
+
+static os_task_t task_idle;//主核idle任务结构体，也是任务树的根
 static os_task_t task_main;//main任务结构体
 
 void arch_task_switch(os_task_t *old_task,os_task_t *new_task);
 void arch_task_stack_frame_init(os_task_t *task);
 
 /*!
- * 获取当前的任务
+ * 获取任务树锁，期间禁止抢占
+ */
+static inline void task_tree_lock_acquire()
+{
+    os_preempt_disable();
+    os_spinlock_lock(&task_tree_lock);
+}
+
+/*!
+ * 释放任务树锁
+ */
+static inline void task_tree_lock_release()
+{
+    os_spinlock_unlock(&task_tree_lock);
+    os_preempt_enable();
+}
+
+/*!
+ * 获取当前hart上的任务
  * @return 若调度器已启动，则该函数返回当前的任务，否则返回OS_NULL
  */
 os_task_t *os_task_get_current_task()
 {
-    return current_task;
+    //通过单条以tp为基址的加载指令读取，读取期间任务不会被迁移到其它hart，因此无需关闭中断
+    return (os_task_p)ARCH_LOAD_THREAD_POINTER_FIELD(__builtin_offsetof(os_hart_t,current_task));
 }
 
+//带宽定点数的小数位数
+#define DL_BW_SHIFT 20
+//截止时间调度允许的最大周期（纳秒），保证带宽计算不会溢出
+#define DL_PERIOD_MAX SIZE(42)
+
 /*!
- * 获取下一个任务，该函数按照优先级从高到低遍历priority_ready_list，返回优先级最高的就绪任务，当同一优先级存在多个就绪任务时，返回靠前的任务
- * @return 优先级最高的就绪任务
+ * 截止时间调度红黑树节点比较函数，按绝对截止时间排序
  */
-static os_task_t *get_next_task()
+static os_bool_t dl_less(os_rbtree_node_p a,os_rbtree_node_p b)
 {
-    os_size_t i;
+    os_task_p task_a = os_rbtree_entry(a,os_task_t,dl_node);
+    os_task_p task_b = os_rbtree_entry(b,os_task_t,dl_node);
+    return ((os_ssize_t)(task_a -> dl_abs_deadline - task_b -> dl_abs_deadline)) < 0;
+}
+
+/*!
+ * 按剩余预算设置时间片，使预算耗尽后的下一个tick触发调度
+ * @param task 任务结构体指针
+ */
+static void dl_update_tick_remaining(os_task_p task)
+{
+    task -> tick_remaining = (task -> dl_budget > 0) ? ((task -> dl_budget - 1) / OS_NS_PER_TICK) : 0;
+}
+
+/*!
+ * 开始一个新的作业，截止时间从当前时刻起算，并补满预算
+ * @param task 任务结构体指针
+ * @param now 当前时刻（纳秒）
+ */
+static void dl_renew(os_task_p task,os_size_t now)
+{
+    task -> dl_abs_deadline = now + task -> dl_deadline;
+    task -> dl_budget = task -> dl_runtime;
+}
+
+/*!
+ * 获取预算耗尽的任务补充预算的时刻，即下一个周期的起点
+ * @param task 任务结构体指针
+ * @return 补充预算的时刻（纳秒）
+ */
+static inline os_size_t dl_get_replenish_time(os_task_p task)
+{
+    return task -> dl_abs_deadline - task -> dl_deadline + task -> dl_period;
+}
+
+/*!
+ * 在下一个周期补充预算，超支的部分从下一个周期的预算中扣除，若补充后截止时间已过，则重新开始一个作业
+ * @param task 任务结构体指针
+ * @param now 当前时刻（纳秒）
+ */
+static void dl_replenish(os_task_p task,os_size_t now)
+{
+    while(task -> dl_budget <= 0)
+    {
+        task -> dl_abs_deadline += task -> dl_period;
+        task -> dl_budget += task -> dl_runtime;
+    }
 
-    //按优先级查表
-    for(i = 0;i < TASK_PRIORITY_UPLIMIT;i++)
+    if(((os_ssize_t)(task -> dl_abs_deadline - now)) <= 0)
     {
-        if(!os_list_empty(priority_ready_list[i]))
-        {
-            return os_list_entry(os_list_get_head(priority_ready_list[i]),os_task_t,schedule_node);
-        }
+        dl_renew(task,now);
     }
+}
 
-    return OS_NULL;
+static void dl_enqueue(os_task_runqueue_p rq,os_task_p task)
+{
+    os_rbtree_insert(&rq -> dl_tree,&task -> dl_node,dl_less);
+    rq -> dl_num++;
+}
+
+static void dl_dequeue(os_task_runqueue_p rq,os_task_p task)
+{
+    os_rbtree_remove(&rq -> dl_tree,&task -> dl_node);
+    rq -> dl_num--;
 }
 
 /*!
- * 返回任务错误码
- * @param exit_code 错误码
+ * 返回绝对截止时间最早的任务
  */
-void task_exit(os_ssize_t exit_code)
+static os_task_p dl_pick_next(os_task_runqueue_p rq)
 {
-    current_task -> exit_code = exit_code;
-    while(1);
+    os_rbtree_node_p first = os_rbtree_first(&rq -> dl_tree);
+    return (first != OS_NULL) ? os_rbtree_entry(first,os_task_t,dl_node) : OS_NULL;
 }
 
 /*!
- * 执行任务调度，该函数将会选出下一个应当执行的任务，若下一任务与当前任务不同，将会触发任务切换行为
+ * 截止时间更早的任务抢占当前任务
  */
-void os_task_schedule()
+static os_bool_t dl_check_preempt(os_task_p current_task,os_task_p task,os_bool_t round_robin)
 {
-    OS_ENTER_CRITICAL_AREA();
-    os_task_t *next_task = get_next_task();
-    OS_ASSERT(next_task != OS_NULL);
+    return ((os_ssize_t)(task -> dl_abs_deadline - current_task -> dl_abs_deadline)) < 0;
+}
+
+/*!
+ * 从剩余预算中扣除实际运行时间，错过截止时间时重新开始一个作业，预算耗尽时将任务移入限流列表，直到下一个周期补充预算
+ */
+static void dl_update_current(os_task_runqueue_p rq,os_task_p task)
+{
+    os_size_t now = os_tick_get_ns();
+
+    task -> dl_budget -= (os_ssize_t)(now - task -> exec_start);
+    task -> exec_start = now;
 
-    //优先级检测，若当前任务仍处于运行态且新任务优先级更低，则继续执行当前任务
-    if(current_task -> task_state == OS_TASK_STATE_RUNNING)
+    if(task -> dl_budget <= 0)
     {
-        if(next_task -> priority > current_task -> priority)
-        {
-            next_task = current_task;
-        }
+        task -> dl_overrun_count++;
+        rq -> dl_overrun_count++;
+        task -> dl_throttled = OS_TRUE;
+        os_list_insert_tail(rq -> dl_throttled_list,&task -> dl_throttle_node);
+    }
+    else if(((os_ssize_t)(now - task -> dl_abs_deadline)) > 0)
+    {
+        task -> dl_miss_count++;
+        rq -> dl_miss_count++;
+        dl_renew(task,now);
     }
 
-    if((current_task -> sp < current_task -> stack_addr) || (current_task -> sp > (current_task -> stack_addr + current_task -> stack_size)))
+    dl_update_tick_remaining(task);
+}
+
+static void dl_set_next(os_task_runqueue_p rq,os_task_p task)
+{
+    dl_update_tick_remaining(task);
+}
+
+/*!
+ * 常量带宽服务器的唤醒规则：若以剩余预算在剩余时间内运行会超出任务的带宽，则开始一个新的作业，以免挤占其它任务的带宽
+ */
+static void dl_place(os_task_runqueue_p rq,os_task_p task)
+{
+    os_size_t now = os_tick_get_ns();
+    os_ssize_t laxity = (os_ssize_t)(task -> dl_abs_deadline - now);
+
+    if((laxity <= 0) || (task -> dl_budget <= 0) || (((((os_size_t)task -> dl_budget) << DL_BW_SHIFT) / laxity) > task -> dl_bw))
     {
-        os_printf("stack overflow!\n");
-        while(1);
+        dl_renew(task,now);
     }
-    
-    //检查是否需要进行任务切换
-    if(next_task != current_task)
+}
+
+/*!
+ * 绝对截止时间是全局的，迁移时无需调整
+ */
+static void dl_migrate(os_task_runqueue_p old_rq,os_task_runqueue_p rq,os_task_p task)
+{
+
+}
+
+//截止时间调度类
+static const os_task_sched_class_t dl_sched_class =
+{
+    .enqueue = dl_enqueue,
+    .dequeue = dl_dequeue,
+    .pick_next = dl_pick_next,
+    .check_preempt = dl_check_preempt,
+    .update_current = dl_update_current,
+    .set_next = dl_set_next,
+    .place = dl_place,
+    .migrate = dl_migrate,
+};
+
+/*!
+ * 将任务插入运行队列中对应优先级的就绪列表尾部，并更新就绪优先级位图，调用者必须持有运行队列锁
+ * @param rq 运行队列
+ * @param task 任务结构体指针
+ */
+static void rt_enqueue(os_task_runqueue_p rq,os_task_p task)
+{
+    os_size_t word = task -> priority >> OS_SIZE_T_BITS;
+
+    os_list_insert_tail(rq -> priority_ready_list[task -> priority],&task -> schedule_node);
+    rq -> priority_ready_bitmap[word] |= SIZE(task -> priority & MASK(OS_SIZE_T_BITS));
+    rq -> priority_ready_group |= SIZE(word);
+}
+
+/*!
+ * 将任务从运行队列的就绪列表中移除，若该优先级的就绪列表变为空，则更新就绪优先级位图，调用者必须持有运行队列锁
+ * @param rq 运行队列
+ * @param task 任务结构体指针
+ */
+static void rt_dequeue(os_task_runqueue_p rq,os_task_p task)
+{
+    os_size_t word = task -> priority >> OS_SIZE_T_BITS;
+
+    os_list_node_remove(&task -> schedule_node);
+
+    if(os_list_empty(rq -> priority_ready_list[task -> priority]))
     {
-        os_list_node_remove(&next_task -> schedule_node);
+        rq -> priority_ready_bitmap[word] &= ~SIZE(task -> priority & MASK(OS_SIZE_T_BITS));
 
-        if(current_task -> task_state == OS_TASK_STATE_RUNNING)
+        if(rq -> priority_ready_bitmap[word] == 0)
         {
-            os_list_insert_tail(priority_ready_list[current_task -> priority],&current_task -> schedule_node);
-            current_task -> task_state = OS_TASK_STATE_READY;
+            rq -> priority_ready_group &= ~SIZE(word);
         }
+    }
+}
 
-        //时间片重置
-        if(current_task -> tick_remaining == 0)
-        {
-            current_task -> tick_remaining = current_task -> tick_init;
-        }
+/*!
+ * 通过就绪优先级位图查找最高的就绪优先级，返回优先级最高的就绪任务，当同一优先级存在多个就绪任务时，返回靠前的任务
+ * @param rq 运行队列
+ * @return 优先级最高的就绪任务，若没有就绪任务，则返回OS_NULL
+ */
+static os_task_p rt_pick_next(os_task_runqueue_p rq)
+{
+    if(rq -> priority_ready_group == 0)
+    {
+        return OS_NULL;
+    }
 
-        os_task_t *old_task = current_task;
-        current_task = next_task;
-        current_task -> task_state = OS_TASK_STATE_RUNNING;
+    os_size_t word = FIND_FIRST_SET(rq -> priority_ready_group);
+    os_size_t priority = (word << OS_SIZE_T_BITS) + FIND_FIRST_SET(rq -> priority_ready_bitmap[word]);
+    return os_list_entry(os_list_get_head(rq -> priority_ready_list[priority]),os_task_t,schedule_node);
+}
 
-        //若当前在中断上下文中，则推迟任务切换，否则立即进行任务切换
-        if(os_is_in_interrupt())
+/*!
+ * 优先级数值更小的任务抢占当前任务，时间片轮转时同等优先级的任务也会抢占当前任务
+ */
+static os_bool_t rt_check_preempt(os_task_p current_task,os_task_p task,os_bool_t round_robin)
+{
+    return round_robin ? (task -> priority <= current_task -> priority) : (task -> priority < current_task -> priority);
+}
+
+static void rt_update_current(os_task_runqueue_p rq,os_task_p task)
+{
+
+}
+
+static void rt_set_next(os_task_runqueue_p rq,os_task_p task)
+{
+
+}
+
+static void rt_place(os_task_runqueue_p rq,os_task_p task)
+{
+
+}
+
+static void rt_migrate(os_task_runqueue_p old_rq,os_task_runqueue_p rq,os_task_p task)
+{
+
+}
+
+//固定优先级调度类
+static const os_task_sched_class_t rt_sched_class =
+{
+    .enqueue = rt_enqueue,
+    .dequeue = rt_dequeue,
+    .pick_next = rt_pick_next,
+    .check_preempt = rt_check_preempt,
+    .update_current = rt_update_current,
+    .set_next = rt_set_next,
+    .place = rt_place,
+    .migrate = rt_migrate,
+};
+
+//nice值为0的任务的权重
+#define FAIR_NICE_0_WEIGHT 1024
+//调度周期（纳秒）
+#define FAIR_LATENCY_NS (OS_TASK_FAIR_LATENCY_TICKS * OS_NS_PER_TICK)
+
+//nice值到权重的映射，nice值每增加1，任务获得的处理器时间约减少10%
+static const os_size_t fair_nice_to_weight[OS_TASK_NICE_MAX - OS_TASK_NICE_MIN + 1] =
+{
+    88761,71755,56483,46273,36291,
+    29154,23254,18705,14949,11916,
+    9548,7620,6100,4904,3906,
+    3121,2501,1991,1586,1277,
+    1024,820,655,526,423,
+    335,272,215,172,137,
+    110,87,70,56,45,
+    36,29,23,18,15,
+};
+
+/*!
+ * 公平调度红黑树节点比较函数，按虚拟运行时间排序
+ */
+static os_bool_t fair_less(os_rbtree_node_p a,os_rbtree_node_p b)
+{
+    os_task_p task_a = os_rbtree_entry(a,os_task_t,fair_node);
+    os_task_p task_b = os_rbtree_entry(b,os_task_t,fair_node);
+    return ((os_ssize_t)(task_a -> vruntime - task_b -> vruntime)) < 0;
+}
+
+/*!
+ * 更新运行队列的最小虚拟运行时间，该值只增不减
+ * @param rq 运行队列
+ * @param current_task 正在运行的公平调度任务，可以为OS_NULL
+ */
+static void fair_update_min_vruntime(os_task_runqueue_p rq,os_task_p current_task)
+{
+    os_rbtree_node_p first = os_rbtree_first(&rq -> fair_tree);
+    os_size_t vruntime;
+
+    if(current_task != OS_NULL)
+    {
+        vruntime = current_task -> vruntime;
+
+        if((first != OS_NULL) && fair_less(first,&current_task -> fair_node))
         {
-            need_lazy_task_switch = OS_TRUE;
-            lazy_old_task = old_task;
-            lazy_next_task = next_task;
+            vruntime = os_rbtree_entry(first,os_task_t,fair_node) -> vruntime;
         }
-        else
+    }
+    else if(first != OS_NULL)
+    {
+        vruntime = os_rbtree_entry(first,os_task_t,fair_node) -> vruntime;
+    }
+    else
+    {
+        return;
+    }
+
+    if(((os_ssize_t)(vruntime - rq -> min_vruntime)) > 0)
+    {
+        rq -> min_vruntime = vruntime;
+    }
+}
+
+static void fair_enqueue(os_task_runqueue_p rq,os_task_p task)
+{
+    os_rbtree_insert(&rq -> fair_tree,&task -> fair_node,fair_less);
+    rq -> fair_num++;
+    rq -> fair_weight += task -> weight;
+}
+
+static void fair_dequeue(os_task_runqueue_p rq,os_task_p task)
+{
+    os_rbtree_remove(&rq -> fair_tree,&task -> fair_node);
+    rq -> fair_num--;
+    rq -> fair_weight -= task -> weight;
+    fair_update_min_vruntime(rq,OS_NULL);
+}
+
+/*!
+ * 返回虚拟运行时间最小的任务，红黑树缓存了最左节点，因此为O(1)
+ */
+static os_task_p fair_pick_next(os_task_runqueue_p rq)
+{
+    os_rbtree_node_p first = os_rbtree_first(&rq -> fair_tree);
+    return (first != OS_NULL) ? os_rbtree_entry(first,os_task_t,fair_node) : OS_NULL;
+}
+
+/*!
+ * 虚拟运行时间比当前任务小超过唤醒抢占粒度的任务抢占当前任务，以避免过于频繁的切换
+ */
+static os_bool_t fair_check_preempt(os_task_p current_task,os_task_p task,os_bool_t round_robin)
+{
+    return ((os_ssize_t)(current_task -> vruntime - task -> vruntime)) > ((os_ssize_t)OS_TASK_FAIR_WAKEUP_GRANULARITY_NS);
+}
+
+/*!
+ * 按权重将实际运行时间折算为虚拟运行时间，权重越大的任务虚拟运行时间增长越慢
+ */
+static void fair_update_current(os_task_runqueue_p rq,os_task_p task)
+{
+    os_size_t now = os_tick_get_ns();
+    os_size_t delta = now - task -> exec_start;
+
+    task -> exec_start = now;
+    task -> vruntime += (task -> weight == FAIR_NICE_0_WEIGHT) ? delta : (delta * FAIR_NICE_0_WEIGHT / task -> weight);
+    fair_update_min_vruntime(rq,task);
+}
+
+/*!
+ * 按权重在调度周期中分配时间片，就绪任务较多时调度周期按最小时间片延长
+ */
+static void fair_set_next(os_task_runqueue_p rq,os_task_p task)
+{
+    os_size_t period = MAX(OS_TASK_FAIR_LATENCY_TICKS,(rq -> fair_num + 1) * OS_TASK_FAIR_MIN_GRANULARITY_TICKS);
+    os_size_t slice = MAX(period * task -> weight / (rq -> fair_weight + task -> weight),OS_TASK_FAIR_MIN_GRANULARITY_TICKS);
+    //时间片剩余量为0时，经过一个tick即被抢占
+    task -> tick_remaining = slice - 1;
+}
+
+/*!
+ * 睡眠或新启动的任务最多获得半个调度周期的补偿，避免长时间睡眠后独占处理器
+ */
+static void fair_place(os_task_runqueue_p rq,os_task_p task)
+{
+    os_size_t vruntime = rq -> min_vruntime - (FAIR_LATENCY_NS >> 1);
+
+    if(((os_ssize_t)(task -> vruntime - vruntime)) < 0)
+    {
+        task -> vruntime = vruntime;
+    }
+}
+
+/*!
+ * 各运行队列的虚拟运行时间互不相关，迁移时保持任务相对于最小虚拟运行时间的偏移
+ */
+static void fair_migrate(os_task_runqueue_p old_rq,os_task_runqueue_p rq,os_task_p task)
+{
+    task -> vruntime = task -> vruntime - old_rq -> min_vruntime + rq -> min_vruntime;
+}
+
+//公平调度类
+static const os_task_sched_class_t fair_sched_class =
+{
+    .enqueue = fair_enqueue,
+    .dequeue = fair_dequeue,
+    .pick_next = fair_pick_next,
+    .check_preempt = fair_check_preempt,
+    .update_current = fair_update_current,
+    .set_next = fair_set_next,
+    .place = fair_place,
+    .migrate = fair_migrate,
+};
+
+//按调度策略索引的调度类
+static const os_task_sched_class_p task_sched_class[OS_TASK_SCHED_POLICY_NUM] =
+{
+    [OS_TASK_SCHED_DEADLINE] = (os_task_sched_class_p)&dl_sched_class,
+    [OS_TASK_SCHED_RT] = (os_task_sched_class_p)&rt_sched_class,
+    [OS_TASK_SCHED_FAIR] = (os_task_sched_class_p)&fair_sched_class,
+};
+
+/*!
+ * 获取任务所属的调度类
+ * @param task 任务结构体指针
+ * @return 调度类
+ */
+static inline os_task_sched_class_p task_get_sched_class(os_task_p task)
+{
+    return task_sched_class[task -> sched_policy];
+}
+
+/*!
+ * 将任务放入运行队列，调用者必须持有运行队列锁
+ * @param rq 运行队列
+ * @param task 任务结构体指针
+ */
+static inline void ready_list_insert(os_task_runqueue_p rq,os_task_p task)
+{
+    task_get_sched_class(task) -> enqueue(rq,task);
+    task -> on_rq = OS_TRUE;
+    rq -> ready_num++;
+}
+
+/*!
+ * 将任务移出运行队列，调用者必须持有运行队列锁
+ * @param rq 运行队列
+ * @param task 任务结构体指针
+ */
+static inline void ready_list_remove(os_task_runqueue_p rq,os_task_p task)
+{
+    task_get_sched_class(task) -> dequeue(rq,task);
+    task -> on_rq = OS_FALSE;
+    rq -> ready_num--;
+}
+
+/*!
+ * 获取运行队列中的下一个任务，按调度类的顺序查找，调用者必须持有运行队列锁
+ * @param rq 运行队列
+ * @return 下一个应当运行的就绪任务，若没有就绪任务，则返回OS_NULL
+ */
+static os_task_t *get_next_task(os_task_runqueue_p rq)
+{
+    os_size_t i;
+
+    for(i = 0;i < OS_TASK_SCHED_POLICY_NUM;i++)
+    {
+        os_task_p task = task_sched_class[i] -> pick_next(rq);
+
+        if(task != OS_NULL)
         {
-            arch_task_switch(old_task,next_task);
+            return task;
         }
     }
 
-    OS_LEAVE_CRITICAL_AREA();
+    return OS_NULL;
 }
 
 /*!
- * 获取任务内核栈顶，该函数主要用于汇编程序，用于从中断栈切换到线程内核栈时使用
- * @param task 要获取内核栈顶的任务
- * @return 内核栈顶地址
+ * 判断任务是否应当抢占hart上正在运行的任务，调度类靠前的任务总是抢占调度类靠后的任务
+ * @param hart 目标hart
+ * @param current_task hart上正在运行的任务
+ * @param task 就绪任务
+ * @param round_robin 是否为时间片轮转，为OS_TRUE时固定优先级调度类中同等优先级的任务也会抢占
+ * @return 应当抢占返回OS_TRUE，否则返回OS_FALSE
  */
-os_size_t os_task_get_kernel_stack_top(os_task_t *task)
+static os_bool_t task_should_preempt(os_hart_p hart,os_task_p current_task,os_task_p task,os_bool_t round_robin)
 {
-    return task -> stack_addr + task -> stack_size;
-}
+    if((current_task == OS_NULL) || (current_task == hart -> idle_task))
+    {
+        return OS_TRUE;
+    }
+
+    if(task -> sched_policy != current_task -> sched_policy)
+    {
+        return task -> sched_policy < current_task -> sched_policy;
+    }
 
-static os_bitmap_t os_task_pid_bitmap;//任务pid位图，其中每一位为1表示空闲，为0表示占用
-static os_hashmap_t os_task_pid_to_task_hashmap;//用于将任务pid映射到任务结构体指针
+    return task_get_sched_class(task) -> check_preempt(current_task,task,round_robin);
+}
 
 /*!
- * 获取一个新的pid，该函数在获取的同时，会将该pid在位图中标记为占用状态
- * @param pid 新的pid
- * @return 成功返回OS_ERR_OK，失败返回-OS_ERR_EPERM（通常由于无空闲的pid导致）
+ * 锁定任务所属的运行队列，任务可能在锁定前被迁移，因此锁定后需要再次确认，调用者必须关闭中断
+ * @param task 任务结构体指针
+ * @return 已锁定的运行队列
  */
-static os_err_t os_task_get_new_pid(os_size_t *pid)
+static os_task_runqueue_p task_runqueue_lock(os_task_p task)
 {
-    OS_ASSERT(pid != OS_NULL);
-    os_size_t ret = os_bitmap_find_some_ones(&os_task_pid_bitmap,0,1);
+    while(1)
+    {
+        os_size_t cpu_id = __atomic_load_n(&task -> cpu_id,__ATOMIC_RELAXED);
+        os_task_runqueue_p rq = &task_runqueue[cpu_id];
+
+        os_spinlock_lock(&rq -> lock);
+
+        if(task -> cpu_id == cpu_id)
+        {
+            return rq;
+        }
+
+        os_spinlock_unlock(&rq -> lock);
+    }
+}
+
+/*!
+ * 从就绪任务最多的hart窃取其优先级最高的就绪任务，并放入本地运行队列，调用者必须持有本地运行队列锁
+ * @param rq 本地运行队列
+ * @param cpu_id 本地逻辑处理器编号
+ * @return 成功返回窃取到的任务，否则返回OS_NULL
+ */
+static os_task_p task_steal(os_task_runqueue_p rq,os_size_t cpu_id)
+{
+    os_task_runqueue_p busiest = OS_NULL;
+    os_size_t busiest_num = 0;
+    os_size_t i;
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        os_size_t num = __atomic_load_n(&task_runqueue[i].ready_num,__ATOMIC_RELAXED);
+
+        if((i != cpu_id) && (num > busiest_num))
+        {
+            busiest = &task_runqueue[i];
+            busiest_num = num;
+        }
+    }
+
+    //已经持有本地运行队列锁，为避免两个hart互相窃取时发生死锁，只尝试锁定目标运行队列
+    if((busiest == OS_NULL) || !os_spinlock_trylock(&busiest -> lock))
+    {
+        return OS_NULL;
+    }
+
+    os_task_p task = get_next_task(busiest);
+
+    if(task != OS_NULL)
+    {
+        ready_list_remove(busiest,task);
+        task_get_sched_class(task) -> migrate(busiest,rq,task);
+        task -> cpu_id = cpu_id;
+        ready_list_insert(rq,task);
+        rq -> steal_count++;
+        rq -> migration_count++;
+    }
+
+    os_spinlock_unlock(&busiest -> lock);
+    return task;
+}
+
+/*!
+ * 为被唤醒或新启动的任务选择目标hart，优先选择任务上次运行的hart以利用cache亲和性，
+ * 若任务在该hart上无法立即运行，则选择一个空闲的hart
+ * @param task 任务结构体指针
+ * @return 目标hart的逻辑处理器编号
+ */
+static os_size_t task_select_cpu(os_task_p task)
+{
+    os_size_t cpu_id = task -> cpu_id;
+    os_hart_p hart = os_hart_get(cpu_id);
+    os_size_t i;
+
+    if(!hart -> online)
+    {
+        cpu_id = os_hart_get_cpu_id();
+        hart = os_hart_get(cpu_id);
+    }
+
+    //以下对其它hart状态的读取均未加锁，只用于选择目标hart
+    if(task_should_preempt(hart,hart -> current_task,task,OS_FALSE))
+    {
+        return cpu_id;
+    }
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        hart = os_hart_get(i);
+
+        if(hart -> online && (hart -> current_task == hart -> idle_task) && (task_runqueue[i].ready_num == 0))
+        {
+            return i;
+        }
+    }
+
+    return cpu_id;
+}
+
+/*!
+ * 将任务设置为就绪态并放入指定hart的运行队列，调用者必须关闭中断
+ * @param task 任务结构体指针
+ * @param cpu_id 目标hart的逻辑处理器编号
+ */
+static void task_enqueue(os_task_p task,os_size_t cpu_id)
+{
+    os_task_runqueue_p rq;
+
+    //预算耗尽的截止时间任务留在原运行队列的限流列表中，补充预算时再放入运行队列
+    if(task -> dl_throttled)
+    {
+        rq = task_runqueue_lock(task);
+
+        if(task -> dl_throttled)
+        {
+            task -> task_state = OS_TASK_STATE_READY;
+            os_spinlock_unlock(&rq -> lock);
+            return;
+        }
+
+        os_spinlock_unlock(&rq -> lock);
+    }
+
+    rq = &task_runqueue[cpu_id];
+    os_task_sched_class_p sched_class = task_get_sched_class(task);
+
+    os_spinlock_lock(&rq -> lock);
+
+    if(task -> cpu_id != cpu_id)
+    {
+        sched_class -> migrate(&task_runqueue[task -> cpu_id],rq,task);
+        task -> cpu_id = cpu_id;
+        rq -> migration_count++;
+    }
+
+    sched_class -> place(rq,task);
+    task -> task_state = OS_TASK_STATE_READY;
+    ready_list_insert(rq,task);
+    os_spinlock_unlock(&rq -> lock);
+}
+
+/*!
+ * 若新就绪的任务可以抢占目标hart上正在运行的任务，则向目标hart发送IPI，使其重新调度
+ * @param task 新就绪的任务
+ * @param cpu_id 目标hart的逻辑处理器编号，必须不是当前hart
+ */
+static void task_kick_cpu(os_task_p task,os_size_t cpu_id)
+{
+    os_hart_p hart = os_hart_get(cpu_id);
+
+    if(task_should_preempt(hart,hart -> current_task,task,OS_FALSE))
+    {
+        bsp_hart_send_ipi(hart -> hart_id);
+    }
+}
+
+/*!
+ * 向一个处于空闲状态的hart发送IPI，使其从其它hart窃取任务
+ * @param cpu_id 当前hart的逻辑处理器编号
+ */
+static void task_kick_idle_cpu(os_size_t cpu_id)
+{
+    os_size_t i;
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        os_hart_p hart = os_hart_get(i);
+
+        if((i != cpu_id) && hart -> online && (hart -> current_task == hart -> idle_task))
+        {
+            bsp_hart_send_ipi(hart -> hart_id);
+            return;
+        }
+    }
+}
+
+/*!
+ * 判断当前hart是否有可运行的任务，包括本地运行队列中的任务与可从其它hart窃取的任务，由idle任务无锁调用
+ * @return 有可运行的任务返回OS_TRUE，否则返回OS_FALSE
+ */
+static os_bool_t task_runqueue_has_work()
+{
+    os_size_t i;
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        if(__atomic_load_n(&task_runqueue[i].ready_num,__ATOMIC_RELAXED) != 0)
+        {
+            return OS_TRUE;
+        }
+    }
+
+    return OS_FALSE;
+}
+
+/*!
+ * 返回任务错误码
+ * @param exit_code 错误码
+ */
+void task_exit(os_ssize_t exit_code)
+{
+    os_task_exit(exit_code);
+}
+
+/*!
+ * 执行任务调度，该函数将会为当前hart选出下一个应当执行的任务，若下一任务与当前任务不同，将会触发任务切换行为
+ * 每个hart只从自己的运行队列中选择任务，本地运行队列为空时从其它hart窃取任务，仍然没有可运行的任务时运行当前hart的idle任务
+ * 该函数只持有运行队列锁，不需要内核大锁
+ */
+void os_task_schedule()
+{
+    //进入调度器即经过一次静止状态，需要在获取运行队列锁之前报告
+    os_rcu_qs();
+
+    os_bool_t interrupt_state = os_interrupt_disable();
+    os_hart_p hart = os_hart_get_current();
+    os_task_runqueue_p rq = &task_runqueue[hart -> cpu_id];
+    os_task_t *current_task = hart -> current_task;
+
+    os_spinlock_lock(&rq -> lock);
+    //本次调度会重新评估是否需要抢占，之前被推迟的抢占请求不再需要处理
+    hart -> need_resched = OS_FALSE;
+
+    if(current_task != hart -> idle_task)
+    {
+        task_get_sched_class(current_task) -> update_current(rq,current_task);
+    }
+
+    os_task_t *next_task = get_next_task(rq);
+
+    //预算耗尽的截止时间任务已被移入限流列表，即使仍处于运行态也不能继续运行
+    os_bool_t current_runnable = (current_task -> task_state == OS_TASK_STATE_RUNNING) && !current_task -> dl_throttled;
+
+    //本地运行队列为空，且当前hart即将空闲时，从其它hart窃取任务
+    if((next_task == OS_NULL) && ((current_task == hart -> idle_task) || !current_runnable))
+    {
+        next_task = task_steal(rq,hart -> cpu_id);
+    }
+
+    //抢占检测，若当前任务仍可运行且下一任务不应抢占当前任务，则继续执行当前任务
+    if(current_runnable)
+    {
+        if((next_task == OS_NULL) || !task_should_preempt(hart,current_task,next_task,OS_TRUE))
+        {
+            next_task = current_task;
+        }
+    }
+    else if(next_task == OS_NULL)
+    {
+        next_task = hart -> idle_task;
+    }
+
+    //禁止抢占期间不能睡眠或退出
+    OS_ASSERT((current_task -> task_state == OS_TASK_STATE_RUNNING) || (current_task -> preempt_count == 0));
+
+    //当前任务禁止抢占时推迟本次抢占（包括预算耗尽的截止时间任务被换下），在重新允许抢占时再进行调度
+    if((next_task != current_task) && (current_task -> preempt_count > 0))
+    {
+        hart -> need_resched = OS_TRUE;
+        hart -> preempt_deferred_count++;
+        next_task = current_task;
+    }
+
+    if((current_task -> sp < current_task -> stack_addr) || (current_task -> sp > (current_task -> stack_addr + current_task -> stack_size)))
+    {
+        os_log_panic();
+        os_printf("stack overflow!\n");
+        while(1);
+    }
+    
+    //检查是否需要进行任务切换
+    if(next_task != current_task)
+    {
+        //idle任务与hart绑定，不进入运行队列
+        if(next_task != hart -> idle_task)
+        {
+            ready_list_remove(rq,next_task);
+        }
+
+        if(current_task -> task_state == OS_TASK_STATE_RUNNING)
+        {
+            if(current_runnable && (current_task != hart -> idle_task))
+            {
+                ready_list_insert(rq,current_task);
+            }
+
+            current_task -> task_state = OS_TASK_STATE_READY;
+        }
+
+        //时间片重置
+        if(current_task -> tick_remaining == 0)
+        {
+            current_task -> tick_remaining = current_task -> tick_init;
+        }
+
+        //仍可运行的任务被切换出去视为被抢占
+        if(current_runnable)
+        {
+            current_task -> nivcsw++;
+        }
+        else
+        {
+            current_task -> nvcsw++;
+        }
+
+        //当前任务发生变化前，将已经经过的时间计入旧任务
+        os_cputime_update();
+        hart -> current_task = next_task;
+        //从用户态进入trap只可能发生在任务切换完成之后，因此可以提前设置
+        hart -> kernel_stack_top = os_task_get_kernel_stack_top(next_task);
+        next_task -> task_state = OS_TASK_STATE_RUNNING;
+        next_task -> exec_start = os_tick_get_ns();
+        task_get_sched_class(next_task) -> set_next(rq,next_task);
+
+        //结束空闲时恢复时间片轮转所需的时钟中断
+        if(current_task == hart -> idle_task)
+        {
+            os_tick_resume();
+        }
+
+        //本地仍有等待运行的任务时，通知处于空闲等待中的hart来窃取
+        if(rq -> ready_num > 0)
+        {
+            task_kick_idle_cpu(hart -> cpu_id);
+        }
+
+        //若当前在中断上下文中，则推迟任务切换，否则立即进行任务切换
+        if(os_is_in_interrupt())
+        {
+            //同一次中断中可能发生多次调度，切换来源始终是被中断的任务
+            if(!hart -> need_lazy_task_switch)
+            {
+                hart -> need_lazy_task_switch = OS_TRUE;
+                hart -> lazy_old_task = current_task;
+            }
+
+            hart -> lazy_next_task = next_task;
+
+            //重新选中了被中断的任务，无需切换
+            if(next_task == hart -> lazy_old_task)
+            {
+                hart -> need_lazy_task_switch = OS_FALSE;
+            }
+
+            os_spinlock_unlock(&rq -> lock);
+        }
+        else
+        {
+            //切换期间释放运行队列锁和内核大锁，其它hart可以在此期间窃取旧任务，并等待其上下文保存完毕后再切换到该任务
+            os_spinlock_unlock(&rq -> lock);
+            os_size_t lock_depth = os_kernel_lock_release_all();
+            arch_task_switch(current_task,next_task);
+            //返回时可能已经位于其它hart上
+            os_kernel_lock_reacquire(lock_depth);
+        }
+    }
+    else
+    {
+        os_spinlock_unlock(&rq -> lock);
+    }
+
+    os_interrupt_enable(interrupt_state);
+}
+
+/*!
+ * 获取当前hart挂起的任务切换请求的来源任务，该函数主要用于汇编程序，在中断返回前调用
+ * 执行下半部期间开中断，嵌套中断返回时中断层次不为0，此时不进行任务切换，由最外层中断返回时处理
+ * @return 若存在挂起的任务切换请求，则返回切换来源任务，否则返回OS_NULL
+ */
+os_task_p os_task_get_lazy_old_task()
+{
+    os_hart_p hart = os_hart_get_current();
+    return (hart -> need_lazy_task_switch && (hart -> interrupt_nest == 0)) ? hart -> lazy_old_task : OS_NULL;
+}
+
+/*!
+ * 取出当前hart挂起的任务切换请求的目标任务，并清除该请求，该函数主要用于汇编程序
+ * @return 切换目标任务
+ */
+os_task_p os_task_take_lazy_next_task()
+{
+    os_hart_p hart = os_hart_get_current();
+    hart -> need_lazy_task_switch = OS_FALSE;
+    return hart -> lazy_next_task;
+}
+
+/*!
+ * 获取任务内核栈顶，用户任务处于内核态时，其用户态上下文位于内核栈顶
+ * @param task 要获取内核栈顶的任务
+ * @return 内核栈顶地址
+ */
+os_size_t os_task_get_kernel_stack_top(os_task_t *task)
+{
+    return task -> stack_addr + task -> stack_size;
+}
+
+static os_idr_t os_task_pid_idr;//任务pid分配器，同时用于将任务pid映射到任务结构体指针，分配和释放时持有pid锁，查找在RCU读临界区中进行
+static os_spinlock_t task_pid_lock = OS_SPINLOCK_INIT;//pid锁，分配pid时可能需要分配基数树节点，持有锁期间只禁止抢占，不关中断
+
+/*!
+ * 获取一个新的pid，并将该pid与任务结构体进行关联，pid循环分配，刚释放的pid不会立即被重新使用
+ * @param task 任务结构体指针
+ * @return 成功返回OS_ERR_OK，无空闲的pid返回-OS_ERR_EAGAIN，内存不足返回-OS_ERR_ENOMEM
+ */
+static os_err_t os_task_get_new_pid(os_task_p task)
+{
+    os_preempt_disable();
+    os_spinlock_lock(&task_pid_lock);
+    os_err_t err = os_idr_alloc_cyclic(&os_task_pid_idr,task,&task -> pid);
+    os_spinlock_unlock(&task_pid_lock);
+    os_preempt_enable();
+    return (err == -OS_ERR_ENOSPC) ? -OS_ERR_EAGAIN : err;
+}
+
+/*!
+ * 释放一个pid，通常用于任务初始化失败或任务销毁时
+ * @param pid 要释放的pid
+ */
+static void os_task_release_pid(os_size_t pid)
+{
+    os_preempt_disable();
+    os_spinlock_lock(&task_pid_lock);
+    os_idr_remove(&os_task_pid_idr,pid);
+    os_spinlock_unlock(&task_pid_lock);
+    os_preempt_enable();
+}
+
+/*!
+ * 分配一个按缓存行对齐的任务结构体，使任务结构体的热数据恰好占据独立的缓存行，不与其它对象共享
+ * 分配器只保证8字节对齐，因此多分配一个缓存行，并将原始指针保存在任务结构体之前，由os_task_free释放
+ * @return 成功返回任务结构体指针，失败返回OS_NULL
+ */
+os_task_p os_task_alloc()
+{
+    void *raw = os_memory_alloc(sizeof(os_task_t) + OS_CACHE_LINE_SIZE);
+
+    if(raw == OS_NULL)
+    {
+        return OS_NULL;
+    }
+
+    os_task_p task = (os_task_p)ALIGN_UP((os_size_t)raw + sizeof(void *),OS_CACHE_LINE_SIZE);
+    ((void **)task)[-1] = raw;
+    task -> dynamic = OS_TRUE;
+    return task;
+}
+
+/*!
+ * 释放由os_task_alloc分配的任务结构体
+ * @param task 任务结构体指针
+ */
+void os_task_free(os_task_p task)
+{
+    os_memory_free(((void **)task)[-1]);
+}
+
+/*!
+ * 分配并复制一个任务名称或任务路径字符串
+ * @param str 源字符串
+ * @return 成功返回新字符串，内存不足时返回OS_NULL
+ */
+static char *task_string_dup(const char *str)
+{
+    task_string_p buf = os_memory_alloc(sizeof(task_string_t) + os_strlen(str) + 1);
+
+    if(buf == OS_NULL)
+    {
+        return OS_NULL;
+    }
+
+    os_strcpy(buf -> str,str);
+    return buf -> str;
+}
+
+/*!
+ * 立即释放由task_string_dup分配的字符串，调用者必须保证已经没有读者访问该字符串
+ * @param str 字符串，可以为OS_NULL
+ */
+static void task_string_free(char *str)
+{
+    if(str != OS_NULL)
+    {
+        os_memory_free(os_container_of(str,task_string_t,str));
+    }
+}
+
+/*!
+ * 被替换的字符串的延迟释放回调
+ * @param head 字符串存储结构中的RCU回调节点
+ */
+static void task_string_rcu_free(os_rcu_head_p head)
+{
+    os_memory_free(os_container_of(head,task_string_t,rcu));
+}
+
+/*!
+ * 替换任务名称或任务路径，新字符串发布之后，旧字符串在宽限期结束后释放
+ * @param ptr 任务结构体中的字符串指针
+ * @param str 新字符串
+ * @return 成功返回OS_ERR_OK，失败返回负数错误码
+ */
+static os_err_t task_string_replace(char **ptr,const char *str)
+{
+    char *buf = task_string_dup(str);
+
+    if(buf == OS_NULL)
+    {
+        return -OS_ERR_ENOMEM;
+    }
+
+    char *old = *ptr;
+    os_rcu_assign_pointer(*ptr,buf);
+
+    if(old != OS_NULL)
+    {
+        os_rcu_call(&os_container_of(old,task_string_t,str) -> rcu,task_string_rcu_free);
+    }
+
+    return OS_ERR_OK;
+}
+
+/*!
+ * 任务结构体的延迟释放回调，在宽限期结束后释放任务名称、任务路径和任务结构体
+ * @param head 任务结构体中的RCU回调节点
+ */
+static void task_rcu_free(os_rcu_head_p head)
+{
+    os_task_p task = os_container_of(head,os_task_t,rcu);
+    task_string_free(task -> name);
+    task_string_free(task -> path);
+    os_task_free(task);
+}
+
+/*!
+ * 设置任务名称，名称按实际长度分配，旧名称在宽限期结束后释放
+ * @param task 任务结构体指针
+ * @param name 任务名称
+ * @return 成功返回OS_ERR_OK，失败返回负数错误码
+ */
+os_err_t os_task_set_name(os_task_p task,const char *name)
+{
+    return task_string_replace(&task -> name,name);
+}
+
+/*!
+ * 设置任务路径，路径按实际长度分配，旧路径在宽限期结束后释放
+ * @param task 任务结构体指针
+ * @param path 任务路径
+ * @return 成功返回OS_ERR_OK，失败返回负数错误码
+ */
+os_err_t os_task_set_path(os_task_p task,const char *path)
+{
+    return task_string_replace(&task -> path,path);
+}
+
+/*!
+ * 初始化一个任务结构体
+ * @param task 任务结构体指针
+ * @param stack_size 任务内核栈大小
+ * @param priority 任务优先级，该值必须小于TASK_PRIORITY_MAX，否则会导致EPERM错误
+ * @param tick_init 时间片数量
+ * @param entry 任务入口
+ * @param arg 传递给任务入口的参数
+ * @param name 任务名称
+ * @return 成功返回OS_ERR_OK，失败返回负数错误码
+ */
+os_err_t os_task_init(os_task_p task,os_size_t stack_size,os_size_t priority,os_size_t tick_init,task_func_t entry,os_size_t arg,const char *name)
+{
+    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
+    OS_ASSERT(task != OS_NULL);
+
+    if(priority > TASK_PRIORITY_MAX)
+    {
+        return -OS_ERR_EPERM;
+    }
+
+    //创建内核栈，内核栈来自带保护页的内核栈缓存，且不会被清零
+    task -> stack_addr = (os_size_t)os_task_stack_alloc(stack_size);
+    
+    if(!task -> stack_addr)
+    {
+        return -OS_ERR_ENOMEM;
+    }
+
+    //初始化任务名称和任务路径（内核任务路径为空，用户任务才有路径信息），名称按实际长度分配
+    task -> name = OS_NULL;
+    task -> path = OS_NULL;
+    os_err_t err = os_task_set_name(task,(name != OS_NULL) ? name : "");
+
+    if(err != OS_ERR_OK)
+    {
+        os_task_stack_free((void *)task -> stack_addr,stack_size);
+        return err;
+    }
+
+    //申请新的pid，并将pid与任务结构体进行关联
+    err = os_task_get_new_pid(task);
+
+    if(err != OS_ERR_OK)
+    {
+        task_string_free(task -> name);
+        os_task_stack_free((void *)task -> stack_addr,stack_size);
+        return err;
+    }
+
+    //创建文件描述符表
+    if((task -> fd_table = os_file_fd_table_create()) == OS_NULL)
+    {
+        os_task_release_pid(task -> pid);
+        //pid已经对通过pid查找任务的读者可见，需要等待这些读者退出后，调用者才能释放任务结构体
+        os_rcu_synchronize();
+        task_string_free(task -> name);
+        os_task_stack_free((void *)task -> stack_addr,stack_size);
+        return -OS_ERR_ENOMEM;
+    }
+
+    task -> stack_size = stack_size;
+    task -> sp = task -> stack_addr + task -> stack_size;
+    task -> on_cpu = OS_FALSE;
+    task -> cpu_id = os_hart_get_cpu_id();
+    task -> priority = priority;
+    task -> base_priority = priority;
+    //新任务默认使用固定优先级调度
+    task -> sched_policy = OS_TASK_SCHED_RT;
+    task -> base_sched_policy = OS_TASK_SCHED_RT;
+    task -> pi_priority = OS_TASK_PI_PRIORITY_NONE;
+    task -> pi_blocked_on = OS_NULL;
+    os_list_init(task -> pi_held_mutex_list);
+    task -> on_rq = OS_FALSE;
+    task -> preempt_count = 0;
+    task -> nice = 0;
+    task -> weight = FAIR_NICE_0_WEIGHT;
+    task -> vruntime = 0;
+    task -> exec_start = 0;
+    task -> utime = 0;
+    task -> stime = 0;
+    task -> cutime = 0;
+    task -> cstime = 0;
+    task -> nvcsw = 0;
+    task -> nivcsw = 0;
+    task -> dl_runtime = 0;
+    task -> dl_deadline = 0;
+    task -> dl_period = 0;
+    task -> dl_bw = 0;
+    task -> dl_abs_deadline = 0;
+    task -> dl_budget = 0;
+    task -> dl_throttled = OS_FALSE;
+    task -> dl_miss_count = 0;
+    task -> dl_overrun_count = 0;
+    os_list_node_init(&task -> dl_throttle_node);
+    //任务首次执行浮点指令时才启用浮点单元
+    task -> fpu_used = OS_FALSE;
+    task -> fpu_cpu_id = OS_TASK_FPU_CPU_NONE;
+    task -> tick_init = tick_init;
+    task -> tick_remaining = tick_init;
+    task -> entry = entry;
+    task -> arg = arg;
+    task -> task_state = OS_TASK_STATE_READY;//让任务初始处于就绪态
+    task -> exit_func = task_exit;//设置任务退出时的错误码处理和环境清理函数
+    task -> exit_code = 0;
+    task -> wait_child = OS_FALSE;
+    task -> reap_child = OS_FALSE;
+    os_list_node_init(&task -> reap_node);
+    //初始化初始brk边界和当前brk边界，仅用于用户任务，因此此处设置为0
+    task -> init_brk = 0;
+    task -> brk = 0;
+    //初始化新任务的子任务列表
+    os_list_init(task -> child_list);
+    //初始化新任务的任务列表节点和调度列表节点
+    os_list_node_init(&task -> task_node);
+    os_list_node_init(&task -> schedule_node);
+
+    //页表引用计数和任务树会被任务销毁、退出时的子任务移交和回收线程并发修改，必须在临界区中修改
+    OS_ENTER_CRITICAL_AREA();
+    //将任务的页表设置为内核页表，并将内核页表引用数+1
+    task -> vtable = os_mmu_get_kernel_pagetable();
+    task -> vtable -> refcnt++;
+    task_tree_lock_acquire();
+    //将当前任务作为新任务的父任务构成任务树，并将新任务加入当前的任务的子任务列表
+    task -> parent = os_task_get_current_task();
+
+    if(task -> parent != OS_NULL)
+    {
+        os_list_insert_tail(task -> parent -> child_list,&task -> child_node);
+    }
+
+    task_tree_lock_release();
+    OS_LEAVE_CRITICAL_AREA();
+
+    //初始化新任务的入口上下文
+    arch_task_stack_frame_init(task);
+    return OS_ERR_OK;
+}
+
+/*!
+ * 将尚未启动的任务移动到另一个父任务的子任务列表中
+ * @param task 任务结构体指针
+ * @param parent 新的父任务结构体指针
+ */
+void os_task_set_parent(os_task_p task,os_task_p parent)
+{
+    OS_ENTER_CRITICAL_AREA();
+    task_tree_lock_acquire();
+    os_list_node_remove(&task -> child_node);
+    task -> parent = parent;
+    os_list_insert_tail(parent -> child_list,&task -> child_node);
+    task_tree_lock_release();
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 销毁任务，该函数用于将任务结构体从内核中剥离，一般仅用于任务自身的环境清理，请不要在任务运行时调用该函数，否则可能导致系统崩溃
+ * @param task 要销毁的任务
+ */
+void os_task_remove(os_task_p task)
+{
+    os_bool_t vtable_remove;
+
+    //在临界区中只将任务从各个全局数据结构中摘除，资源的释放在临界区之外进行，以缩短关中断的时间
+    OS_ENTER_CRITICAL_AREA();
+    OS_ASSERT(task != &task_idle);
+    OS_ASSERT(task != &task_main);
+    OS_ASSERT(task -> parent != OS_NULL);
+    os_list_node_remove(&task -> task_node);
+
+    os_task_runqueue_p rq = task_runqueue_lock(task);
+
+    if(task -> on_rq)
+    {
+        ready_list_remove(rq,task);
+    }
+
+    os_list_node_remove(&task -> dl_throttle_node);
+    os_spinlock_unlock(&rq -> lock);
+
+    //释放截止时间任务占用的带宽
+    if(task -> sched_policy == OS_TASK_SCHED_DEADLINE)
+    {
+        task_deadline_total_bw -= task -> dl_bw;
+    }
+
+    task_tree_lock_acquire();
+    os_list_node_remove(&task -> child_node);
+
+    os_list_entry_foreach_safe(task -> child_list,os_task_t,child_node,entry,
+    {
+        os_list_node_remove(&entry -> child_node);
+        os_list_insert_tail(task -> parent -> child_list,&entry -> child_node);
+        entry -> parent = task -> parent;
+    });
+
+    task_tree_lock_release();
+    task -> vtable -> refcnt--;
+    vtable_remove = task -> vtable -> refcnt == 0;
+    os_task_release_pid(task -> pid);
+    OS_LEAVE_CRITICAL_AREA();
+
+    //任务已经不可见，页表也不再被其它任务引用，此后的释放操作可以被中断和抢占
+    os_task_stack_free((void *)task -> stack_addr,task -> stack_size);
+
+    if(vtable_remove)
+    {
+        os_mmu_vtable_remove(task -> vtable,OS_TRUE);
+        os_memory_free(task -> vtable);
+    }
+
+    os_file_fd_table_remove(task -> fd_table);
+    //wait fd_list remove code
+
+    //静态分配的任务结构体由其所有者管理，动态分配的任务结构体、任务名称和任务路径可能仍在被通过pid查找到该任务的读者访问，在宽限期结束后释放
+    if(task -> dynamic)
+    {
+        os_rcu_call(&task -> rcu,task_rcu_free);
+    }
+    else
+    {
+        task_string_free(task -> path);
+        task_string_free(task -> name);
+    }
+}
+
+/*!
+ * 启动任务，该任务必须首先被初始化，否则行为不可预测
+ * @param task 要启动的任务
+ */
+void os_task_startup(os_task_p task)
+{
+    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
+    OS_ASSERT(task != OS_NULL);
+    OS_ENTER_CRITICAL_AREA();
+    os_list_insert_tail(task_list,&task -> task_node);
+    os_size_t cpu_id = task_select_cpu(task);
+    task_enqueue(task,cpu_id);
+
+    if(cpu_id != os_hart_get_cpu_id())
+    {
+        task_kick_cpu(task,cpu_id);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+static os_task_t task_reaper;//任务回收线程
+static os_list_node_t task_reap_list;//等待回收的任务列表
+static os_size_t task_reap_count = 0;//已回收的任务数量
+static os_size_t task_reap_batch_count = 0;//回收线程的批处理次数
+static os_size_t task_reap_max_batch = 0;//单次批处理回收的最大任务数量
+
+/*!
+ * 将已退出的任务交给回收线程，调用者必须处于临界区并持有任务树锁
+ * @param task 已退出的任务
+ */
+static void task_reap_enqueue(os_task_p task)
+{
+    //任务不再属于父任务，不会再被wait4找到
+    os_list_node_remove(&task -> child_node);
+    os_list_insert_tail(task_reap_list,&task -> reap_node);
+
+    if(task_reaper.task_state == OS_TASK_STATE_SLEEPING)
+    {
+        os_task_wakeup(&task_reaper);
+    }
+}
+
+/*!
+ * 通知父任务子任务已经退出，调用者必须处于临界区并持有任务树锁
+ * 父任务为内核任务时一般不会调用wait4，除非其通过os_task_set_reap_child声明自行回收子任务，否则直接将子任务交给回收线程，其它情况下唤醒正在wait4中等待的父任务
+ * @param task 已退出的任务
+ */
+static void task_notify_parent(os_task_p task)
+{
+    os_task_p parent = task -> parent;
+
+    if((parent == OS_NULL) || ((parent -> vtable == os_mmu_get_kernel_pagetable()) && !parent -> reap_child))
+    {
+        task_reap_enqueue(task);
+    }
+    else if(parent -> wait_child)
+    {
+        parent -> wait_child = OS_FALSE;
+        os_task_wakeup(parent);
+    }
+}
+
+/*!
+ * 等待已退出的任务被彻底切换出去，此后其内核栈和运行时间统计都不再变化
+ * @param task 已退出的任务
+ */
+static void task_wait_off_cpu(os_task_p task)
+{
+    while(__atomic_load_n(&task -> on_cpu,__ATOMIC_ACQUIRE))
+    {
+        os_task_yield();
+    }
+}
+
+/*!
+ * 退出当前任务，任务进入终止态，保留pid和退出码直到被父任务回收，内核栈、页表、文件描述符表等资源由回收线程释放
+ * @param exit_code 退出码
+ */
+void os_task_exit(os_ssize_t exit_code)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_task_p task = os_task_get_current_task();
+    OS_ASSERT(task != &task_main);
+    OS_ASSERT(task != os_hart_get_current() -> idle_task);
+    OS_ENTER_CRITICAL_AREA();
+    task -> exit_code = exit_code;
+    task_tree_lock_acquire();
+
+    //将子任务交给父任务，其中已经退出的子任务由新的父任务负责回收
+    os_list_entry_foreach_safe(task -> child_list,os_task_t,child_node,entry,
+    {
+        os_list_node_remove(&entry -> child_node);
+        os_list_insert_tail(task -> parent -> child_list,&entry -> child_node);
+        entry -> parent = task -> parent;
+
+        if(entry -> task_state == OS_TASK_STATE_STOPPED)
+        {
+            task_notify_parent(entry);
+        }
+    });
+
+    task -> task_state = OS_TASK_STATE_STOPPED;
+    //交给回收线程时需要将任务移出父任务的子任务列表，因此在释放任务树锁之前通知父任务，释放任务树锁时可能立即发生任务切换，处于终止态的任务不会再被调度
+    task_notify_parent(task);
+    task_tree_lock_release();
+    os_task_schedule();
+    OS_LEAVE_CRITICAL_AREA();
+
+    while(1);
+}
+
+/*!
+ * 等待当前任务的子任务退出并回收该子任务，其运行时间计入当前任务的子任务运行时间
+ * @param pid 要等待的子任务pid，为负数或0时等待任意子任务（系统尚不支持进程组）
+ * @param nohang 为OS_TRUE时若没有已经退出的子任务则立即返回
+ * @param exit_code 若不为OS_NULL，则返回子任务的退出码
+ * @param utime 若不为OS_NULL，则返回子任务及其已回收的子任务的用户态CPU时间之和（纳秒）
+ * @param stime 若不为OS_NULL，则返回子任务及其已回收的子任务的内核态CPU时间之和（纳秒）
+ * @return 成功返回被回收的子任务pid，nohang为OS_TRUE且没有已经退出的子任务时返回0，没有符合条件的子任务时返回-OS_ERR_ECHILD
+ */
+os_ssize_t os_task_wait(os_ssize_t pid,os_bool_t nohang,os_ssize_t *exit_code,os_size_t *utime,os_size_t *stime)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_task_p task = os_task_get_current_task();
+    os_ssize_t ret;
+
+    OS_ENTER_CRITICAL_AREA();
+
+    while(1)
+    {
+        os_bool_t found = OS_FALSE;
+        os_task_p zombie = OS_NULL;
+
+        os_list_entry_foreach(task -> child_list,os_task_t,child_node,entry,
+        {
+            if((pid <= 0) || (entry -> pid == (os_size_t)pid))
+            {
+                found = OS_TRUE;
+
+                if(entry -> task_state == OS_TASK_STATE_STOPPED)
+                {
+                    zombie = entry;
+                    break;
+                }
+            }
+        });
+
+        if(zombie != OS_NULL)
+        {
+            task_wait_off_cpu(zombie);
+            os_size_t child_utime = zombie -> utime + zombie -> cutime;
+            os_size_t child_stime = zombie -> stime + zombie -> cstime;
+            task -> cutime += child_utime;
+            task -> cstime += child_stime;
+
+            if(exit_code != OS_NULL)
+            {
+                *exit_code = zombie -> exit_code;
+            }
+
+            if(utime != OS_NULL)
+            {
+                *utime = child_utime;
+            }
+
+            if(stime != OS_NULL)
+            {
+                *stime = child_stime;
+            }
+
+            ret = zombie -> pid;
+            task_tree_lock_acquire();
+            task_reap_enqueue(zombie);
+            task_tree_lock_release();
+            break;
+        }
+
+        if(!found)
+        {
+            ret = -OS_ERR_ECHILD;
+            break;
+        }
+
+        if(nohang)
+        {
+            ret = 0;
+            break;
+        }
+
+        //检查与睡眠均在临界区中进行，子任务退出时的唤醒不会丢失
+        task -> wait_child = OS_TRUE;
+        os_task_sleep();
+        task -> wait_child = OS_FALSE;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 设置当前内核任务是否通过os_task_wait自行回收子任务，内核任务默认不回收子任务，其子任务退出后直接交给回收线程
+ * 恢复为OS_FALSE时，已经退出但尚未回收的子任务会被交给回收线程
+ * @param reap_child 是否自行回收子任务
+ */
+void os_task_set_reap_child(os_bool_t reap_child)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_task_p task = os_task_get_current_task();
+
+    OS_ENTER_CRITICAL_AREA();
+    task -> reap_child = reap_child;
+
+    if(!reap_child && (task -> vtable == os_mmu_get_kernel_pagetable()))
+    {
+        task_tree_lock_acquire();
+
+        os_list_entry_foreach_safe(task -> child_list,os_task_t,child_node,entry,
+        {
+            if(entry -> task_state == OS_TASK_STATE_STOPPED)
+            {
+                task_reap_enqueue(entry);
+            }
+        });
+
+        task_tree_lock_release();
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 任务回收线程入口，每次取出回收列表中的所有任务批量释放其资源，使退出和wait4路径不必承担销毁页表、释放页面和关闭文件的开销
+ * @param arg 参数
+ * @return 线程退出码
+ */
+static OS_NORETURN os_ssize_t os_task_reaper_entry(os_size_t arg)
+{
+    os_list_node_t batch;
+
+    while(1)
+    {
+        os_size_t num = 0;
+
+        OS_ENTER_CRITICAL_AREA();
+
+        while(os_list_empty(task_reap_list))
+        {
+            os_task_sleep();
+        }
+
+        //将回收列表整体摘到局部列表中，回收期间新退出的任务留到下一批处理
+        batch.next = task_reap_list.next;
+        batch.prev = task_reap_list.prev;
+        batch.next -> prev = &batch;
+        batch.prev -> next = &batch;
+        os_list_init(task_reap_list);
+        OS_LEAVE_CRITICAL_AREA();
+
+        while(!os_list_empty(batch))
+        {
+            os_task_p task = os_list_entry(os_list_get_head(batch),os_task_t,reap_node);
+            os_list_node_remove(&task -> reap_node);
+            task_wait_off_cpu(task);
+            os_task_remove(task);
+            num++;
+        }
+
+        task_reap_count += num;
+        task_reap_batch_count++;
+        task_reap_max_batch = MAX(task_reap_max_batch,num);
+    }
+}
+
+/*!
+ * 初始化并启动任务回收线程
+ */
+void os_task_reaper_startup()
+{
+    os_list_init(task_reap_list);
+    OS_ASSERT(os_task_init(&task_reaper,OS_TASK_REAPER_STACK_SIZE,OS_TASK_REAPER_PRIORITY,OS_TASK_REAPER_TICK_INIT,os_task_reaper_entry,0,"task_reaper") == OS_ERR_OK);
+    os_task_startup(&task_reaper);
+}
+
+/*!
+ * 打印任务回收线程的统计信息
+ */
+void os_task_reaper_print_info()
+{
+    os_printf("task reaper:reaped = %ld,batch = %ld,max batch = %ld\n",task_reap_count,task_reap_batch_count,task_reap_max_batch);
+}
+
+/*!
+ * 准备修改任务的调度参数，将任务移出运行队列，若任务原本使用截止时间调度，则释放其占用的带宽并解除限流
+ * 调用者必须处于临界区并持有任务所属的运行队列锁，修改完成后若返回值为OS_TRUE，需要将任务放回运行队列
+ * @param rq 任务所属的运行队列
+ * @param task 任务结构体指针
+ * @return 修改完成后是否需要将任务放回运行队列
+ */
+static os_bool_t task_sched_attr_change_begin(os_task_runqueue_p rq,os_task_p task)
+{
+    os_bool_t on_rq = task -> on_rq;
+
+    //任务位于运行队列中时，需要从原调度类的运行队列中移出，再放入新调度类的运行队列
+    if(on_rq)
+    {
+        ready_list_remove(rq,task);
+    }
+
+    if(task -> sched_policy == OS_TASK_SCHED_DEADLINE)
+    {
+        task_deadline_total_bw -= task -> dl_bw;
+        task -> dl_bw = 0;
+
+        //被限流前处于可运行状态的任务需要放回运行队列
+        if(task -> dl_throttled)
+        {
+            os_list_node_remove(&task -> dl_throttle_node);
+            task -> dl_throttled = OS_FALSE;
+            on_rq = task -> task_state == OS_TASK_STATE_READY;
+        }
+    }
+
+    return on_rq;
+}
+
+/*!
+ * 根据任务自身的调度策略与继承的优先级确定任务实际的调度策略与优先级，调用者必须持有任务所属的运行队列锁，且任务不在运行队列中
+ * 继承的优先级高于任务自身的优先级时，任务临时以继承的优先级参与固定优先级调度，截止时间任务本身高于所有固定优先级任务，因此不受影响
+ * @param rq 任务所属的运行队列
+ * @param task 任务结构体指针
+ */
+static void task_apply_sched_policy(os_task_runqueue_p rq,os_task_p task)
+{
+    os_task_sched_policy_t old_policy = task -> sched_policy;
+    os_ssize_t base_priority = (task -> base_sched_policy == OS_TASK_SCHED_RT) ? (os_ssize_t)task -> base_priority : OS_TASK_PI_PRIORITY_NONE;
+
+    if((task -> base_sched_policy != OS_TASK_SCHED_DEADLINE) && (task -> pi_priority < base_priority))
+    {
+        task -> sched_policy = OS_TASK_SCHED_RT;
+        task -> priority = MAX(task -> pi_priority,0);
+    }
+    else
+    {
+        task -> sched_policy = task -> base_sched_policy;
+        task -> priority = task -> base_priority;
+    }
+
+    //从其它调度策略切换而来的任务从当前的最小虚拟运行时间开始计算
+    if((task -> sched_policy == OS_TASK_SCHED_FAIR) && (old_policy != OS_TASK_SCHED_FAIR))
+    {
+        task -> vruntime = rq -> min_vruntime;
+        task -> exec_start = os_tick_get_ns();
+    }
+}
+
+/*!
+ * 获取任务用于优先级继承的优先级，数值越小优先级越高，截止时间任务高于所有固定优先级任务，公平调度任务低于所有固定优先级任务
+ * @param task 任务结构体指针
+ * @return 任务当前的优先级
+ */
+os_ssize_t os_task_get_pi_priority(os_task_p task)
+{
+    switch(task -> sched_policy)
+    {
+        case OS_TASK_SCHED_DEADLINE:
+            return OS_TASK_PI_PRIORITY_DEADLINE;
+
+        case OS_TASK_SCHED_RT:
+            return task -> priority;
+
+        default:
+            return OS_TASK_PI_PRIORITY_NONE;
+    }
+}
+
+/*!
+ * 设置任务继承的优先级，由互斥锁在等待任务变化时调用，调用者必须处于临界区
+ * @param task 任务结构体指针
+ * @param priority 继承的优先级，为OS_TASK_PI_PRIORITY_NONE时表示不继承任何优先级
+ */
+void os_task_pi_set_priority(os_task_p task,os_ssize_t priority)
+{
+    os_task_runqueue_p rq = task_runqueue_lock(task);
+    task -> pi_priority = priority;
+
+    if(task -> base_sched_policy != OS_TASK_SCHED_DEADLINE)
+    {
+        os_bool_t on_rq = task -> on_rq;
+
+        if(on_rq)
+        {
+            ready_list_remove(rq,task);
+        }
+
+        task_apply_sched_policy(rq,task);
+
+        if(on_rq)
+        {
+            ready_list_insert(rq,task);
+        }
 
-    if(ret == OS_NUMBER_MAX(os_size_t))
-    {
-        return OS_ERR_EPERM;
+        //被提升优先级的任务在其它hart上就绪时，通知该hart重新调度，使其尽快运行并释放互斥锁
+        if(on_rq && (task -> cpu_id != os_hart_get_cpu_id()))
+        {
+            task_kick_cpu(task,task -> cpu_id);
+        }
     }
 
-    *pid = ret;
-    os_bitmap_set_bit(&os_task_pid_bitmap,ret,0);
-    return OS_ERR_OK;
-}
-
-/*!
- * 释放一个pid，通常用于任务初始化失败或任务销毁时
- * @param 要释放的pid
- */
-static void os_task_release_pid(os_size_t pid)
-{
-    os_bitmap_set_bit(&os_task_pid_bitmap,pid,1);
+    os_spinlock_unlock(&rq -> lock);
 }
 
 /*!
- * 初始化一个任务结构体
+ * 设置任务的调度策略，可以在任务启动前或运行期间调用
  * @param task 任务结构体指针
- * @param stack_size 任务内核栈大小
- * @param priority 任务优先级，该值必须小于TASK_PRIORITY_MAX，否则会导致EPERM错误
- * @param tick_init 时间片数量
- * @param entry 任务入口
- * @param arg 传递给任务入口的参数
- * @param name 任务名称
- * @return 成功返回OS_ERR_OK，失败返回负数错误码
+ * @param policy 调度策略
+ * @param param 调度参数，固定优先级调度时为优先级，公平调度时为nice值
+ * @return 成功返回OS_ERR_OK，参数非法返回-OS_ERR_EINVAL
  */
-os_err_t os_task_init(os_task_p task,os_size_t stack_size,os_size_t priority,os_size_t tick_init,task_func_t entry,os_size_t arg,const char *name)
+os_err_t os_task_set_sched_policy(os_task_p task,os_task_sched_policy_t policy,os_ssize_t param)
 {
-    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
     OS_ASSERT(task != OS_NULL);
 
-    if(priority > TASK_PRIORITY_MAX)
+    if(policy == OS_TASK_SCHED_RT)
     {
-        return -OS_ERR_EPERM;
+        //最低优先级保留给idle任务
+        OS_ERR_RETURN_ERROR((param < 0) || (param >= TASK_PRIORITY_MAX),-OS_ERR_EINVAL);
     }
-
-    //创建内核栈
-    task -> stack_addr = (os_size_t)os_memory_alloc(stack_size);
-    
-    if(!task -> stack_addr)
+    else if(policy == OS_TASK_SCHED_FAIR)
     {
-        return -OS_ERR_ENOMEM;
+        OS_ERR_RETURN_ERROR((param < OS_TASK_NICE_MIN) || (param > OS_TASK_NICE_MAX),-OS_ERR_EINVAL);
     }
-
-    //初始化任务名称和任务路径（内核任务路径为空，用户任务才有路径信息）
-    os_memset(task -> name,0,sizeof(task -> name));
-    os_memset(task -> path,0,sizeof(task -> path));
-
-    if(name != OS_NULL)
+    else
     {
-        os_strcpy(task -> name,name);
+        return -OS_ERR_EINVAL;
     }
 
-    //申请新的pid
-    os_err_t err = os_task_get_new_pid(&task -> pid);
-
-    if(err != OS_ERR_OK)
-    {
-        os_memory_free((void *)task -> stack_addr);
-        return err;
-    }
+    OS_ENTER_CRITICAL_AREA();
+    os_task_runqueue_p rq = task_runqueue_lock(task);
+    os_bool_t on_rq = task_sched_attr_change_begin(rq,task);
 
-    //将pid与任务结构体进行关联
-    if((err = os_hashmap_set(&os_task_pid_to_task_hashmap,task -> pid,task)) != OS_ERR_OK)
+    if(policy == OS_TASK_SCHED_RT)
     {
-        os_task_release_pid(task -> pid);
-        os_memory_free((void *)task -> stack_addr);
-        return err;
+        task -> base_priority = param;
     }
-
-    //创建文件描述符表
-    if((task -> fd_table = os_file_fd_table_create()) == OS_NULL)
+    else
     {
-        os_hashmap_remove_item(&os_task_pid_to_task_hashmap,task -> pid);
-        os_task_release_pid(task -> pid);
-        os_memory_free((void *)task -> stack_addr);
-        return err;
+        task -> nice = param;
+        task -> weight = fair_nice_to_weight[param - OS_TASK_NICE_MIN];
     }
 
-    task -> stack_size = stack_size;
-    task -> sp = task -> stack_addr + task -> stack_size;
-    task -> priority = priority;
-    task -> tick_init = tick_init;
-    task -> tick_remaining = tick_init;
-    task -> entry = entry;
-    task -> arg = arg;
-    task -> task_state = OS_TASK_STATE_READY;//让任务初始处于就绪态
-    task -> exit_func = task_exit;//设置任务退出时的错误码处理和环境清理函数
-    //将任务的页表设置为内核页表，并将内核页表引用数+1
-    task -> vtable = os_mmu_get_kernel_pagetable();
-    task -> vtable -> refcnt++;
-    //将当前任务作为新任务的父任务构成任务树
-    task -> parent = os_task_get_current_task();
-    //初始化初始brk边界和当前brk边界，仅用于用户任务，因此此处设置为0
-    task -> init_brk = 0;
-    task -> brk = 0;
-    //初始化新任务的子任务列表
-    os_list_init(task -> child_list);
-    //初始化新任务的任务列表节点和调度列表节点
-    os_list_node_init(&task -> task_node);
-    os_list_node_init(&task -> schedule_node);
+    task -> base_sched_policy = policy;
+    task_apply_sched_policy(rq,task);
 
-    //将新任务加入当前的任务的子任务列表
-    if(task -> parent != OS_NULL)
+    if(on_rq)
     {
-        os_list_insert_tail(task -> parent -> child_list,&task -> child_node);
+        ready_list_insert(rq,task);
     }
 
-    //初始化新任务的入口上下文
-    arch_task_stack_frame_init(task);
+    os_spinlock_unlock(&rq -> lock);
+    OS_LEAVE_CRITICAL_AREA();
     return OS_ERR_OK;
 }
 
 /*!
- * 销毁任务，该函数用于将任务结构体从内核中剥离，一般仅用于任务自身的环境清理，请不要在任务运行时调用该函数，否则可能导致系统崩溃
- * @param task 要销毁的任务
+ * 将任务设置为截止时间调度，任务在每个周期中最多运行runtime纳秒，并在周期起点之后的deadline纳秒内获得这些运行时间
+ * 所有截止时间任务的带宽之和不能超过各在线hart可用带宽之和，否则拒绝设置
+ * @param task 任务结构体指针
+ * @param runtime 每个周期的运行时间（纳秒）
+ * @param deadline 相对于周期起点的截止时间（纳秒），必须满足runtime <= deadline <= period
+ * @param period 周期（纳秒）
+ * @return 成功返回OS_ERR_OK，参数非法返回-OS_ERR_EINVAL，带宽不足返回-OS_ERR_EBUSY
  */
-void os_task_remove(os_task_p task)
+os_err_t os_task_set_deadline(os_task_p task,os_size_t runtime,os_size_t deadline,os_size_t period)
 {
+    OS_ASSERT(task != OS_NULL);
+    OS_ERR_RETURN_ERROR((runtime == 0) || (runtime > deadline) || (deadline > period) || (period > DL_PERIOD_MAX),-OS_ERR_EINVAL);
+
+    os_size_t bw = (runtime << DL_BW_SHIFT) / period;
+    os_size_t bw_limit = os_hart_get_online_num() * ((((os_size_t)OS_TASK_DEADLINE_BW_PERCENT) << DL_BW_SHIFT) / 100);
+    os_err_t err = OS_ERR_OK;
+
     OS_ENTER_CRITICAL_AREA();
-    OS_ASSERT(task != &task_idle);
-    OS_ASSERT(task != &task_main);
-    OS_ASSERT(task -> parent != OS_NULL);
-    os_memory_free((void *)task -> stack_addr);
-    os_list_node_remove(&task -> task_node);
-    os_list_node_remove(&task -> child_node);
+    os_size_t old_bw = (task -> sched_policy == OS_TASK_SCHED_DEADLINE) ? task -> dl_bw : 0;
 
-    if(!os_list_node_empty(&task -> schedule_node))
+    //准入控制，保证所有截止时间任务的带宽需求都能得到满足
+    if((task_deadline_total_bw - old_bw + bw) > bw_limit)
+    {
+        err = -OS_ERR_EBUSY;
+    }
+    else
     {
-        os_list_node_remove(&task -> schedule_node);
+        os_task_runqueue_p rq = task_runqueue_lock(task);
+        os_bool_t on_rq = task_sched_attr_change_begin(rq,task);
+        os_size_t now = os_tick_get_ns();
+
+        task -> dl_runtime = runtime;
+        task -> dl_deadline = deadline;
+        task -> dl_period = period;
+        task -> dl_bw = bw;
+        task_deadline_total_bw += bw;
+        task -> base_sched_policy = OS_TASK_SCHED_DEADLINE;
+        task -> sched_policy = OS_TASK_SCHED_DEADLINE;
+        task -> exec_start = now;
+        dl_renew(task,now);
+
+        if(on_rq)
+        {
+            ready_list_insert(rq,task);
+        }
+
+        os_spinlock_unlock(&rq -> lock);
     }
 
-    os_list_entry_foreach_safe(task -> child_list,os_task_t,child_node,entry,
+    OS_LEAVE_CRITICAL_AREA();
+    return err;
+}
+
+/*!
+ * 为当前hart上到达下一个周期的被限流任务补充预算，并将其中可运行的任务放回运行队列，由时钟中断处理程序调用，调用者必须关闭中断
+ */
+void os_task_deadline_tick()
+{
+    os_hart_p hart = os_hart_get_current();
+    os_task_runqueue_p rq = &task_runqueue[hart -> cpu_id];
+    os_bool_t need_schedule = OS_FALSE;
+
+    os_spinlock_lock(&rq -> lock);
+    os_size_t now = os_tick_get_ns();
+
+    os_list_entry_foreach_safe(rq -> dl_throttled_list,os_task_t,dl_throttle_node,task,
     {
-        os_list_node_remove(&entry -> child_node);
-        os_list_insert_tail(task -> parent -> child_list,&entry -> child_node);
-        entry -> parent = task -> parent;
+        if(((os_ssize_t)(now - dl_get_replenish_time(task))) >= 0)
+        {
+            os_list_node_remove(&task -> dl_throttle_node);
+            task -> dl_throttled = OS_FALSE;
+            dl_replenish(task,now);
+
+            //在限流期间进入睡眠的任务在被唤醒时再放入运行队列
+            if(task -> task_state == OS_TASK_STATE_READY)
+            {
+                ready_list_insert(rq,task);
+                need_schedule = need_schedule || task_should_preempt(hart,hart -> current_task,task,OS_FALSE);
+            }
+        }
     });
 
-    task -> vtable -> refcnt--;
+    os_spinlock_unlock(&rq -> lock);
 
-    if(task -> vtable -> refcnt == 0)
+    if(need_schedule)
     {
-        os_mmu_vtable_remove(task -> vtable,OS_TRUE);
-        os_memory_free(task -> vtable);
+        os_task_schedule();
     }
-
-    os_file_fd_table_remove(task -> fd_table);
-    //wait fd_list remove code
-    os_memory_free(task);
-    OS_LEAVE_CRITICAL_AREA();
 }
 
 /*!
- * 启动任务，该任务必须首先被初始化，否则行为不可预测
- * @param task 要启动的任务
+ * 获取当前hart上的被限流任务最早需要补充预算的tick，用于设置下一次时钟中断，调用者必须关闭中断
+ * @return 最早需要补充预算的tick，没有被限流的任务时返回OS_TICK_DEADLINE_NONE
  */
-void os_task_startup(os_task_p task)
+os_size_t os_task_deadline_get_next_tick()
 {
-    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
-    OS_ASSERT(task != OS_NULL);
-    OS_ENTER_CRITICAL_AREA();
-    os_list_insert_tail(task_list,&task -> task_node);
-    os_list_insert_tail(priority_ready_list[task -> priority],&task -> schedule_node);
-    OS_LEAVE_CRITICAL_AREA();
+    os_task_runqueue_p rq = &task_runqueue[os_hart_get_cpu_id()];
+    os_size_t tick = OS_TICK_DEADLINE_NONE;
+
+    os_spinlock_lock(&rq -> lock);
+
+    os_list_entry_foreach(rq -> dl_throttled_list,os_task_t,dl_throttle_node,task,
+    {
+        tick = MIN(tick,DIV_UP(dl_get_replenish_time(task),OS_NS_PER_TICK));
+    });
+
+    os_spinlock_unlock(&rq -> lock);
+    return tick;
 }
 
 /*!
@@ -350,9 +2016,7 @@ static void set_current_task_state(os_task_state_t state)
 void os_task_yield()
 {
     OS_ANNOTATION_NEED_TASK_CONTEXT();
-    OS_ENTER_CRITICAL_AREA();
     os_task_schedule();
-    OS_LEAVE_CRITICAL_AREA();
 }
 
 /*!
@@ -367,37 +2031,161 @@ void os_task_sleep()
     OS_LEAVE_CRITICAL_AREA();
 }
 
+/*!
+ * 睡眠超时定时器回调函数
+ * @param arg 睡眠的任务
+ */
+static void os_task_sleep_timeout(os_size_t arg)
+{
+    os_task_wakeup((os_task_p)arg);
+}
+
+/*!
+ * 让当前任务睡眠指定的tick数，期间可以被os_task_wakeup提前唤醒
+ * @param ticks 睡眠时长（tick）
+ * @return 被提前唤醒时返回剩余的tick数，否则返回0
+ */
+os_size_t os_task_sleep_ticks(os_size_t ticks)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_timer_t timer;
+    os_size_t remaining;
+
+    OS_ENTER_CRITICAL_AREA();
+    os_timer_init(&timer,os_task_sleep_timeout,(os_size_t)os_task_get_current_task());
+    os_timer_start(&timer,ticks);
+    os_task_sleep();
+    //定时器回调函数在内核大锁下执行，因此在临界区中停止定时器后，回调函数不会再唤醒当前任务
+    remaining = os_timer_get_remaining(&timer);
+    os_timer_stop(&timer);
+    OS_LEAVE_CRITICAL_AREA();
+    return remaining;
+}
+
+/*!
+ * 让当前任务睡眠指定的纳秒数，实际睡眠时长会向上对齐到tick，期间可以被os_task_wakeup提前唤醒
+ * @param ns 睡眠时长（纳秒）
+ * @return 被提前唤醒时返回剩余的纳秒数，否则返回0
+ */
+os_size_t os_task_sleep_ns(os_size_t ns)
+{
+    if(ns == 0)
+    {
+        os_task_yield();
+        return 0;
+    }
+
+    //ns接近上限时DIV_UP会溢出，因此分别计算商和余数
+    os_size_t ticks = ns / OS_NS_PER_TICK + ((ns % OS_NS_PER_TICK) != 0);
+
+    //当前tick已经过去了一部分，额外等待一个tick以保证睡眠时长不短于要求的时长
+    if(ticks < OS_NUMBER_MAX(os_size_t))
+    {
+        ticks++;
+    }
+
+    os_size_t remaining = os_task_sleep_ticks(ticks);
+    return (remaining > (OS_NUMBER_MAX(os_size_t) / OS_NS_PER_TICK)) ? OS_NUMBER_MAX(os_size_t) : (remaining * OS_NS_PER_TICK);
+}
+
 /*!
  * 唤醒任务
  * @param task 要唤醒的任务
  */
 void os_task_wakeup(os_task_t *task)
 {
-    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    os_task_wakeup_batch_t batch;
+
+    OS_ENTER_CRITICAL_AREA();
+    os_task_wakeup_batch_init(&batch);
+    os_task_wakeup_batch_add(&batch,task);
+    os_task_wakeup_batch_flush(&batch);
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 初始化批量唤醒上下文
+ * @param batch 批量唤醒上下文结构体指针
+ */
+void os_task_wakeup_batch_init(os_task_wakeup_batch_p batch)
+{
+    batch -> resched = OS_FALSE;
+    batch -> ipi_mask = 0;
+    batch -> num = 0;
+}
+
+/*!
+ * 唤醒任务，但推迟调度和IPI的发送，直到调用os_task_wakeup_batch_flush，调用者必须处于临界区，以保证推迟期间任务所在的hart不发生变化
+ * @param batch 批量唤醒上下文结构体指针
+ * @param task 要唤醒的任务
+ */
+void os_task_wakeup_batch_add(os_task_wakeup_batch_p batch,os_task_p task)
+{
+    //中断上下文中的唤醒会通过延迟任务切换完成
+    OS_ANNOTATION_NEED_TASK_SCHEDULER();
     OS_ENTER_CRITICAL_AREA();
 
     //只有睡眠状态的任务才能被唤醒
     if(task -> task_state == OS_TASK_STATE_SLEEPING)
     {
-        //将任务设置为就绪状态
-        task -> task_state = OS_TASK_STATE_READY;
-        os_list_insert_tail(priority_ready_list[task -> priority],&task -> schedule_node);
-        //立即执行调度
+        //将任务设置为就绪状态，并放入选定hart的运行队列
+        os_size_t cpu_id = task_select_cpu(task);
+        task_enqueue(task,cpu_id);
+        batch -> num++;
+
+        //目标为当前hart时需要执行调度，否则在需要时通知目标hart重新调度
+        if(cpu_id == os_hart_get_cpu_id())
+        {
+            batch -> resched = OS_TRUE;
+        }
+        else
+        {
+            os_hart_p hart = os_hart_get(cpu_id);
+
+            if(task_should_preempt(hart,hart -> current_task,task,OS_FALSE))
+            {
+                batch -> ipi_mask |= SIZE(cpu_id);
+            }
+        }
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 完成批量唤醒，向需要重新调度的其它hart发送IPI，并在当前hart上执行一次调度
+ * @param batch 批量唤醒上下文结构体指针
+ */
+void os_task_wakeup_batch_flush(os_task_wakeup_batch_p batch)
+{
+    OS_ENTER_CRITICAL_AREA();
+
+    while(batch -> ipi_mask != 0)
+    {
+        os_size_t cpu_id = __builtin_ctzl(batch -> ipi_mask);
+        batch -> ipi_mask &= ~SIZE(cpu_id);
+        bsp_hart_send_ipi(os_hart_get(cpu_id) -> hart_id);
+    }
+
+    if(batch -> resched)
+    {
+        batch -> resched = OS_FALSE;
         os_task_schedule();
     }
-    
+
     OS_LEAVE_CRITICAL_AREA();
 }
 
 /*!
- * 通过pid获取任务结构体指针
+ * 通过pid获取任务结构体指针，查找不加锁，返回的任务结构体只在调用者所处的RCU读临界区或临界区中保证有效
  * @param pid
  * @return 若pid无效，则返回OS_NULL
  */
 os_task_p os_task_get_task_by_pid(os_size_t pid)
 {
-    os_task_p ret;
-    os_hashmap_get(&os_task_pid_to_task_hashmap,pid,(void **)&ret);
+    os_rcu_read_lock();
+    os_task_p ret = os_idr_find(&os_task_pid_idr,pid);
+    os_rcu_read_unlock();
     return ret;
 }
 
@@ -409,7 +2197,39 @@ os_task_p os_task_get_task_by_pid(os_size_t pid)
 os_ssize_t os_task_main_entry(os_size_t arg);
 
 /*!
- * 启动的第一个线程，idle线程入口
+ * idle任务的空闲循环，所有hart共用
+ */
+static OS_NORETURN void os_task_idle_loop()
+{
+    while(1)
+    {
+        //系统空闲时唤醒日志输出任务
+        os_log_wakeup();
+        //空闲循环处于静止状态，同时执行宽限期已经结束的回调
+        os_rcu_check();
+
+        //在关闭中断后检查，避免错过检查之后到来的唤醒，wfi在中断关闭时仍会被sie中允许的中断唤醒
+        os_bool_t interrupt_state = os_interrupt_disable();
+
+        if(!task_runqueue_has_work())
+        {
+            os_tick_idle_enter();
+            ARCH_WAIT_FOR_INTERRUPT();
+            os_tick_idle_exit();
+        }
+
+        os_interrupt_enable(interrupt_state);
+
+        //仅在存在可运行的任务时才进入调度器，避免频繁竞争运行队列锁
+        if(task_runqueue_has_work())
+        {
+            os_task_yield();
+        }
+    }
+}
+
+/*!
+ * 启动的第一个线程，主核idle线程入口
  * @param arg 要传递的参数
  * @return 线程退出码
  */
@@ -418,12 +2238,57 @@ OS_NORETURN os_ssize_t os_task_idle_entry(os_size_t arg)
     //初始化启动main线程
     OS_ASSERT(os_task_init(&task_main,MAIN_TASK_STACK_SIZE,MAIN_TASK_PRIORITY,MAIN_TASK_TICK_INIT,os_task_main_entry,0,"task_main") == OS_ERR_OK);
     os_task_startup(&task_main);
-
+    //启动日志输出任务
+    os_log_task_startup();
+    //启动任务回收线程
+    os_task_reaper_startup();
+    //启动下半部线程和系统工作队列
+    os_bh_startup();
+    os_workqueue_system_startup();
+    os_rcu_startup();
+    //启动从核
+    os_hart_startup_secondary();
     //执行空闲操作
-    while(1)
+    os_task_idle_loop();
+}
+
+/*!
+ * 从核idle线程入口
+ * @param arg 逻辑处理器编号
+ * @return 线程退出码
+ */
+static OS_NORETURN os_ssize_t os_task_idle_secondary_entry(os_size_t arg)
+{
+    os_task_idle_loop();
+}
+
+/*!
+ * 创建从核的idle任务，idle任务只加入任务列表，不进入就绪列表
+ * @param cpu_id 逻辑处理器编号
+ * @return 成功返回任务结构体指针，失败返回OS_NULL
+ */
+os_task_p os_task_idle_create(os_size_t cpu_id)
+{
+    char name[16];
+    os_task_p task = os_task_alloc();
+
+    if(task == OS_NULL)
     {
-        os_task_yield();
+        return OS_NULL;
+    }
+
+    os_snprintf(name,sizeof(name),"task_idle%ld",cpu_id);
+
+    if(os_task_init(task,IDLE_TASK_STACK_SIZE,TASK_PRIORITY_MAX,IDLE_TASK_TICK_INIT,os_task_idle_secondary_entry,cpu_id,name) != OS_ERR_OK)
+    {
+        os_task_free(task);
+        return OS_NULL;
     }
+
+    OS_ENTER_CRITICAL_AREA();
+    os_list_insert_tail(task_list,&task -> task_node);
+    OS_LEAVE_CRITICAL_AREA();
+    return task;
 }
 
 /*!
@@ -444,27 +2309,56 @@ void os_task_scheduler_init()
 
     os_list_init(task_list);
 
-    for(i = 0;i < TASK_PRIORITY_UPLIMIT;i++)
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
     {
-        os_list_init(priority_ready_list[i]);
+        os_task_runqueue_p rq = &task_runqueue[i];
+        os_size_t j;
+
+        os_spinlock_init(&rq -> lock);
+
+        for(j = 0;j < TASK_PRIORITY_UPLIMIT;j++)
+        {
+            os_list_init(rq -> priority_ready_list[j]);
+        }
+
+        for(j = 0;j < TASK_PRIORITY_BITMAP_WORDS;j++)
+        {
+            rq -> priority_ready_bitmap[j] = 0;
+        }
+
+        rq -> priority_ready_group = 0;
+        os_rbtree_init(&rq -> dl_tree);
+        rq -> dl_num = 0;
+        os_list_init(rq -> dl_throttled_list);
+        rq -> dl_miss_count = 0;
+        rq -> dl_overrun_count = 0;
+        os_rbtree_init(&rq -> fair_tree);
+        rq -> fair_num = 0;
+        rq -> fair_weight = 0;
+        rq -> min_vruntime = 0;
+        rq -> ready_num = 0;
+        rq -> steal_count = 0;
+        rq -> migration_count = 0;
     }
 
-    OS_ASSERT(os_bitmap_create(&os_task_pid_bitmap,OS_TASK_MAX_NUM,OS_NULL,1) == OS_ERR_OK);
-    OS_ASSERT(os_hashmap_create(&os_task_pid_to_task_hashmap,MIN(1000,OS_TASK_MAX_NUM),OS_NULL) == OS_ERR_OK);
+    os_idr_init_rcu(&os_task_pid_idr,0,OS_TASK_MAX_NUM);
     OS_ASSERT(os_task_init(&task_idle,IDLE_TASK_STACK_SIZE,TASK_PRIORITY_MAX,IDLE_TASK_TICK_INIT,os_task_idle_entry,0,"task_idle") == OS_ERR_OK);
-    os_task_startup(&task_idle);
+    os_list_insert_tail(task_list,&task_idle.task_node);
+    os_hart_get_current() -> idle_task = &task_idle;
     os_task_scheduler_initialized = OS_TRUE;
 }
 
 /*!
- * 任务调度器启动，从这时候开始，就进入了第一个任务上下文，该函数不会返回
+ * 任务调度器启动，从这时候开始，当前hart就进入了其idle任务上下文，该函数不会返回，主核与从核均通过该函数启动调度
  */
 void os_task_scheduler_start()
 {
-    current_task = &task_idle;
-    current_task -> task_state = OS_TASK_STATE_RUNNING;
-    os_list_node_remove(&current_task -> schedule_node);
-    arch_task_switch(OS_NULL,current_task);
+    os_hart_p hart = os_hart_get_current();
+    hart -> current_task = hart -> idle_task;
+    hart -> kernel_stack_top = os_task_get_kernel_stack_top(hart -> current_task);
+    hart -> current_task -> task_state = OS_TASK_STATE_RUNNING;
+    os_cputime_hart_init();
+    arch_task_switch(OS_NULL,hart -> current_task);
 }
 
 /*!
@@ -477,7 +2371,7 @@ void os_task_switch_vtable(os_task_p task)
 }
 
 /*!
- * 用于打印任务树的递归函数
+ * 用于打印任务树的递归函数，调用者必须持有内核大锁
  * @param task 任务结构体指针
  * @param level 当前层次
  */
@@ -485,8 +2379,6 @@ static void __os_task_print_tree(os_task_p task,os_size_t level)
 {
     os_size_t i;
 
-    OS_ENTER_CRITICAL_AREA();
-    
     os_list_entry_foreach(task -> child_list,os_task_t,child_node,entry,
     {
         for(i = 0;i < level;i++)
@@ -497,8 +2389,6 @@ static void __os_task_print_tree(os_task_p task,os_size_t level)
         os_printf("|--%d - %s - 0x%p - %s\n",entry -> pid,entry -> name,entry,(os_task_get_task_by_pid(task -> pid) == task) ? "pid map normal" : "pid map error");
         __os_task_print_tree(entry,level + 1);
     });
-
-    OS_LEAVE_CRITICAL_AREA();
 }
 
 /*!
@@ -510,11 +2400,39 @@ void os_task_print_tree(os_task_p task)
     os_printf("Task Tree:\n");
     os_printf("---------------------------\n\n");
     os_printf("%d - %s - 0x%p - %s\n",task -> pid,task -> name,task,(os_task_get_task_by_pid(task -> pid) == task) ? "pid map normal" : "pid map error");
+    //只读遍历任务树，持有内核大锁即可，输出过程可能获取内核大锁，因此不能持有任务树锁
+    OS_ENTER_CRITICAL_AREA();
     __os_task_print_tree(task,0);
+    OS_LEAVE_CRITICAL_AREA();
     os_printf("\n---------------------------\n");
     os_printf("\n");
 }
 
+/*!
+ * 打印各hart的运行队列统计信息
+ */
+void os_task_print_runqueue_info()
+{
+    os_size_t i;
+
+    os_printf("Runqueue:\n");
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        os_hart_p hart = os_hart_get(i);
+
+        if(hart -> online)
+        {
+            os_task_runqueue_p rq = &task_runqueue[i];
+            os_task_p current_task = hart -> current_task;
+            os_printf("cpu%ld(hart %ld):ready = %ld(deadline = %ld,fair = %ld),steal = %ld,migration = %ld,preempt_deferred = %ld,min_vruntime = %ld,current = %s\n",i,hart -> hart_id,rq -> ready_num,rq -> dl_num,rq -> fair_num,rq -> steal_count,rq -> migration_count,hart -> preempt_deferred_count,rq -> min_vruntime,(current_task != OS_NULL) ? current_task -> name : "none");
+            os_printf("cpu%ld(hart %ld):deadline misses = %ld,budget overruns = %ld\n",i,hart -> hart_id,rq -> dl_miss_count,rq -> dl_overrun_count);
+        }
+    }
+
+    os_printf("\n");
+}
+
 /*!
  * 获取根任务
  * @return 根任务结构体指针
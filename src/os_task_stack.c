@@ -0,0 +1,233 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ * 2021-07-28     lizhirui     protect kernel stack cache with its own spinlock and disable preemption instead of interrupts
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*
+ * 内核栈位于内核空间最高处的独立映射区域中，每个内核栈占用一个槽位，栈底紧贴槽位最低处不映射的保护页，栈顶之上直到下一个槽位同样不映射
+ * 内核栈溢出时会访问保护页并触发页面fault，而不会悄悄破坏相邻的内存
+ * 释放的内核栈保留映射，按大小缓存起来，再次分配时直接复用，无需重新分配物理内存、建立映射和刷新TLB，也不清零
+ */
+#define TASK_STACK_REGION_SIZE SIZE(OS_MMU_MEMORYMAP_KSTACK_BITS)
+#define TASK_STACK_SLOT_SIZE SIZE(OS_MMU_KSTACK_SLOT_BITS)
+#define TASK_STACK_GUARD_SIZE SIZE(OS_MMU_KSTACK_GUARD_BITS)
+#define TASK_STACK_SLOT_NUM SIZE(OS_MMU_MEMORYMAP_KSTACK_BITS - OS_MMU_KSTACK_SLOT_BITS)
+//可缓存的内核栈大小为页面大小到槽位大小的一半之间的2的幂，每种大小一个缓存列表
+#define TASK_STACK_CLASS_NUM (OS_MMU_KSTACK_SLOT_BITS - OS_MMU_OFFSET_BITS)
+#define TASK_STACK_SLOT_ADDR(slot) (OS_MMU_MEMORYMAP_KSTACK_START + ((slot) << OS_MMU_KSTACK_SLOT_BITS))
+#define TASK_STACK_ADDR_TO_SLOT(addr) (((addr) - OS_MMU_MEMORYMAP_KSTACK_START) >> OS_MMU_KSTACK_SLOT_BITS)
+
+static os_size_t task_stack_slot_bitmap_memory[TASK_STACK_SLOT_NUM / (sizeof(os_size_t) << 3)];//槽位位图内存
+static os_bitmap_t task_stack_slot_bitmap;//槽位位图，其中每一位为1表示空闲，为0表示占用（包括缓存中的内核栈）
+static os_list_node_t task_stack_cache[TASK_STACK_CLASS_NUM];//缓存的内核栈列表，链表节点位于内核栈的最低处
+static os_size_t task_stack_cache_num[TASK_STACK_CLASS_NUM];//各缓存列表中的内核栈数量
+static os_size_t task_stack_slot_used = 0;//已占用的槽位数量
+static os_size_t task_stack_cache_hit = 0;//从缓存中分配的次数
+static os_size_t task_stack_cache_miss = 0;//缓存为空，需要新建映射的次数
+static os_size_t task_stack_fallback = 0;//无法使用槽位，退化为普通内存分配的次数
+static os_bool_t task_stack_initialized = OS_FALSE;//内核栈缓存是否已初始化
+//内核栈缓存锁，内核栈只在任务上下文中分配和释放，持有锁期间只禁止抢占，不关中断，建立映射和刷新TLB期间仍然可以响应中断
+static os_spinlock_t task_stack_lock = OS_SPINLOCK_INIT;
+
+/*!
+ * 获取内核栈大小对应的缓存列表编号
+ * @param stack_size 内核栈大小
+ * @return 缓存列表编号，内核栈大小无法使用槽位时返回TASK_STACK_CLASS_NUM
+ */
+static os_size_t task_stack_get_class(os_size_t stack_size)
+{
+    if((stack_size < OS_MMU_PAGE_SIZE) || (stack_size > (TASK_STACK_SLOT_SIZE >> 1)) || !IS_POWER_OF_2(stack_size))
+    {
+        return TASK_STACK_CLASS_NUM;
+    }
+
+    return ALIGN_DOWN_MAX(stack_size) - OS_MMU_OFFSET_BITS;
+}
+
+/*!
+ * 检查地址是否位于内核栈映射区域中
+ * @param addr 地址
+ * @return 位于内核栈映射区域中返回OS_TRUE，否则返回OS_FALSE
+ */
+static inline os_bool_t task_stack_in_region(os_size_t addr)
+{
+    return (addr >= OS_MMU_MEMORYMAP_KSTACK_START) && ((addr - OS_MMU_MEMORYMAP_KSTACK_START) < TASK_STACK_REGION_SIZE);
+}
+
+/*!
+ * 内核栈缓存初始化，必须在创建第一个任务之前调用
+ */
+void os_task_stack_init()
+{
+    os_size_t i;
+
+    OS_ASSERT(os_bitmap_create(&task_stack_slot_bitmap,TASK_STACK_SLOT_NUM,task_stack_slot_bitmap_memory,1) == OS_ERR_OK);
+
+    for(i = 0;i < TASK_STACK_CLASS_NUM;i++)
+    {
+        os_list_init(task_stack_cache[i]);
+        task_stack_cache_num[i] = 0;
+    }
+
+    //在创建任何用户页表之前建立内核栈区域的下级页表，此后建立的内核栈映射对所有页表可见
+    OS_ASSERT(os_mmu_create_pagetable(os_mmu_get_kernel_pagetable(),OS_MMU_MEMORYMAP_KSTACK_START,TASK_STACK_REGION_SIZE) == OS_ERR_OK);
+    task_stack_initialized = OS_TRUE;
+}
+
+/*!
+ * 分配内核栈，内核栈的内容不会被清零，不能在中断上下文中调用
+ * 大小为页面大小到槽位大小的一半之间的2的幂的内核栈带有保护页，其它大小的内核栈退化为普通内存分配
+ * @param stack_size 内核栈大小
+ * @return 成功返回内核栈起始地址，失败返回OS_NULL
+ */
+void *os_task_stack_alloc(os_size_t stack_size)
+{
+    os_size_t class_id = task_stack_get_class(stack_size);
+    os_mmu_pt_prot_t prot = OS_MMU_PROT_KERNEL;
+    void *stack = OS_NULL;
+
+    OS_ANNOTATION_NEED_NON_INTERRUPT_CONTEXT();
+    OS_MMU_PROT_RW(&prot);
+    os_preempt_disable();
+    os_spinlock_lock(&task_stack_lock);
+
+    if(task_stack_initialized && (class_id < TASK_STACK_CLASS_NUM))
+    {
+        //优先复用缓存中同样大小的内核栈，其映射仍然有效，最近释放的内核栈最可能仍在缓存中
+        if(!os_list_empty(task_stack_cache[class_id]))
+        {
+            os_list_node_p node = os_list_get_head(task_stack_cache[class_id]);
+            os_list_node_remove(node);
+            task_stack_cache_num[class_id]--;
+            task_stack_cache_hit++;
+            stack = (void *)node;
+        }
+        else
+        {
+            os_size_t slot = os_bitmap_find_some_ones(&task_stack_slot_bitmap,0,1);
+
+            if(slot != OS_NUMBER_MAX(os_size_t))
+            {
+                //内核栈不需要清零，因此直接从页面分配器获取物理内存
+                void *mem = os_memory_page_alloc(stack_size);
+
+                if(mem == OS_NULL)
+                {
+                    os_spinlock_unlock(&task_stack_lock);
+                    os_preempt_enable();
+                    return OS_NULL;
+                }
+
+                os_size_t stack_addr = TASK_STACK_SLOT_ADDR(slot) + TASK_STACK_GUARD_SIZE;
+
+                if(os_mmu_create_mapping(os_mmu_get_kernel_pagetable(),stack_addr,OS_MMU_VA_TO_PA((os_size_t)mem),stack_size,prot) != OS_ERR_OK)
+                {
+                    os_mmu_remove_mapping(os_mmu_get_kernel_pagetable(),stack_addr,stack_size);
+                    os_memory_page_free(mem);
+                    os_spinlock_unlock(&task_stack_lock);
+                    os_preempt_enable();
+                    return OS_NULL;
+                }
+
+                //RISC-V允许TLB缓存无效的页表项，新建立的映射同样需要在所有hart上刷新
+                os_mmu_flush_tlb_all(stack_addr,stack_size);
+                os_bitmap_set_bit(&task_stack_slot_bitmap,slot,0);
+                task_stack_slot_used++;
+                task_stack_cache_miss++;
+                stack = (void *)stack_addr;
+            }
+        }
+    }
+
+    os_spinlock_unlock(&task_stack_lock);
+    os_preempt_enable();
+
+    if(stack == OS_NULL)
+    {
+        __atomic_fetch_add(&task_stack_fallback,1,__ATOMIC_RELAXED);
+        stack = os_memory_alloc(stack_size);
+    }
+
+    return stack;
+}
+
+/*!
+ * 释放内核栈，缓存未满时保留映射放入缓存，否则解除映射并归还物理内存和槽位，不能在中断上下文中调用
+ * @param stack 内核栈起始地址
+ * @param stack_size 内核栈大小，必须与分配时一致
+ */
+void os_task_stack_free(void *stack,os_size_t stack_size)
+{
+    os_size_t stack_addr = (os_size_t)stack;
+
+    if(!task_stack_in_region(stack_addr))
+    {
+        os_memory_free(stack);
+        return;
+    }
+
+    os_size_t class_id = task_stack_get_class(stack_size);
+    OS_ASSERT(class_id < TASK_STACK_CLASS_NUM);
+    os_preempt_disable();
+    os_spinlock_lock(&task_stack_lock);
+
+    if(task_stack_cache_num[class_id] < OS_TASK_STACK_CACHE_NUM)
+    {
+        os_list_insert_head(task_stack_cache[class_id],(os_list_node_p)stack_addr);
+        task_stack_cache_num[class_id]++;
+    }
+    else
+    {
+        void *mem = os_mmu_user_va_to_kernel_va(os_mmu_get_kernel_pagetable(),stack_addr);
+        OS_ASSERT(mem != OS_NULL);
+        os_mmu_remove_mapping(os_mmu_get_kernel_pagetable(),stack_addr,stack_size);
+        //其它hart可能仍然缓存着该内核栈的映射，必须在物理内存被重新分配之前完成刷新
+        os_mmu_flush_tlb_all(stack_addr,stack_size);
+        os_memory_page_free(mem);
+        os_bitmap_set_bit(&task_stack_slot_bitmap,TASK_STACK_ADDR_TO_SLOT(stack_addr),1);
+        task_stack_slot_used--;
+    }
+
+    os_spinlock_unlock(&task_stack_lock);
+    os_preempt_enable();
+}
+
+/*!
+ * 检查地址是否位于内核栈的保护页中，用于在页面fault时判断是否发生了内核栈溢出
+ * @param addr 地址
+ * @return 位于保护页中返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_task_stack_is_guard_page(os_size_t addr)
+{
+    return task_stack_in_region(addr) && (((addr - OS_MMU_MEMORYMAP_KSTACK_START) & (TASK_STACK_SLOT_SIZE - 1)) < TASK_STACK_GUARD_SIZE);
+}
+
+/*!
+ * 输出内核栈缓存的统计信息
+ */
+void os_task_stack_print_info()
+{
+    os_size_t cached = 0;
+    os_size_t i;
+
+    os_preempt_disable();
+    os_spinlock_lock(&task_stack_lock);
+
+    for(i = 0;i < TASK_STACK_CLASS_NUM;i++)
+    {
+        cached += task_stack_cache_num[i];
+    }
+
+    os_printf("kernel stack:slot_used = %ld,cached = %ld,cache_hit = %ld,cache_miss = %ld,fallback = %ld\n",task_stack_slot_used,cached,task_stack_cache_hit,task_stack_cache_miss,task_stack_fallback);
+    os_spinlock_unlock(&task_stack_lock);
+    os_preempt_enable();
+}
\ No newline at end of file
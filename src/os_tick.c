@@ -7,38 +7,156 @@
  * Date           Author       Notes
  * 2021-05-18     lizhirui     the first version
  * 2021-07-06     lizhirui     add global tick
+ * 2021-07-25     lizhirui     only boot hart updates global tick
+ * 2021-07-26     lizhirui     drive timer wheel from tick handler
+ * 2021-07-26     lizhirui     add tickless idle with one-shot tick
+ * 2021-07-27     lizhirui     add os_tick_get_ns
+ * 2021-07-27     lizhirui     replenish deadline task budget from tick handler
+ * 2021-07-28     lizhirui     report rcu quiescent state from tick handler
  */
 
 // @formatter:off
 #include <dreamos.h>
 
-//系统全局Tick值
-static os_size_t global_tick = 0;
+/*!
+ * 根据当前任务的剩余时间片、被限流任务补充预算的时间与最近的定时器到期时间设置当前hart的下一次时钟中断，调用者必须关闭中断
+ */
+void os_tick_program_next()
+{
+    os_hart_p hart = os_hart_get_current();
+    os_task_p task = hart -> current_task;
+    os_size_t deadline = OS_TICK_DEADLINE_NONE;
+
+    //idle任务不需要时间片轮转
+    if((task != OS_NULL) && (task != hart -> idle_task))
+    {
+        deadline = hart -> tick_last + task -> tick_remaining + 1;
+    }
+
+    //被限流的截止时间任务需要在下一个周期起点补充预算
+    deadline = MIN(deadline,os_task_deadline_get_next_tick());
+
+    //定时器时间轮由主核驱动，在临界区中更新tick_deadline，以便os_timer_start判断是否需要通知主核
+    if(hart -> cpu_id == 0)
+    {
+        OS_ENTER_CRITICAL_AREA();
+        deadline = MIN(deadline,os_timer_get_next_expire());
+        hart -> tick_deadline = deadline;
+        bsp_tick_set_deadline(deadline);
+        OS_LEAVE_CRITICAL_AREA();
+    }
+    else
+    {
+        hart -> tick_deadline = deadline;
+        bsp_tick_set_deadline(deadline);
+    }
+}
 
 /*!
  * 内核调度定时器中断处理程序，应在定时器中断中被调用
+ * 时钟中断为单次触发，两次中断之间可能经过了多个tick，因此按实际经过的tick数扣除时间片
  */
 void os_tick_handler()
 {
-    global_tick++;
-    os_task_t *cur_task = os_task_get_current_task();
+    os_hart_p hart = os_hart_get_current();
+    os_size_t now = os_tick_get();
+    os_size_t elapsed = now - hart -> tick_last;
+    os_task_t *cur_task = hart -> current_task;
 
-    if(cur_task -> tick_remaining > 0)
+    hart -> tick_last = now;
+    hart -> tick_interrupt_count++;
+
+    if(cur_task -> tick_remaining >= elapsed)
     {
-        cur_task -> tick_remaining--;
+        cur_task -> tick_remaining -= elapsed;
     }
     else
     {
         cur_task -> tick_remaining = cur_task -> tick_init;
         os_task_schedule();
     }
+
+    os_task_deadline_tick();
+    os_rcu_check();
+
+    if(hart -> cpu_id == 0)
+    {
+        os_timer_handler();
+    }
+
+    os_tick_program_next();
+}
+
+/*!
+ * hart即将进入空闲等待时调用，停止时间片轮转所需的时钟中断，只保留定时器所需的时钟中断，调用者必须关闭中断
+ */
+void os_tick_idle_enter()
+{
+    os_tick_program_next();
+}
+
+/*!
+ * hart从空闲等待中被唤醒时调用，调用者必须关闭中断
+ */
+void os_tick_idle_exit()
+{
+    os_hart_get_current() -> idle_wakeup_count++;
+}
+
+/*!
+ * hart结束空闲、即将运行其它任务时调用，空闲期间的tick不计入任何任务的时间片，并在下一个tick恢复时钟中断，调用者必须关闭中断
+ */
+void os_tick_resume()
+{
+    os_hart_p hart = os_hart_get_current();
+    os_size_t now = os_tick_get();
+
+    hart -> tick_last = now;
+
+    //若已设置的时钟中断更早（可能已经挂起），则保留该时钟中断
+    if(hart -> tick_deadline > (now + 1))
+    {
+        hart -> tick_deadline = now + 1;
+        bsp_tick_set_deadline(hart -> tick_deadline);
+    }
 }
 
 /*!
- * 获取当前的系统全局Tick值
+ * 打印各hart的时钟中断统计信息
+ */
+void os_tick_print_info()
+{
+    os_size_t i;
+
+    os_printf("Tick:%ld\n",os_tick_get());
+
+    for(i = 0;i < OS_CPU_MAX_NUM;i++)
+    {
+        os_hart_p hart = os_hart_get(i);
+
+        if(hart -> online)
+        {
+            os_printf("cpu%ld:timer interrupts = %ld,idle wakeups = %ld\n",i,hart -> tick_interrupt_count,hart -> idle_wakeup_count);
+        }
+    }
+
+    os_printf("\n");
+}
+
+/*!
+ * 获取当前的系统全局Tick值，该值由硬件计数器换算得到，时钟中断停止期间仍然准确
  * @return
  */
 os_size_t os_tick_get()
 {
-    return global_tick;
+    return bsp_tick_get();
 }
+
+/*!
+ * 获取系统启动以来经过的纳秒数，精度高于tick，用于统计任务的运行时间
+ * @return 纳秒数
+ */
+os_size_t os_tick_get_ns()
+{
+    return bsp_tick_get_ns();
+}
\ No newline at end of file
@@ -0,0 +1,332 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-26     lizhirui     the first version
+ * 2021-07-26     lizhirui     add os_timer_get_next_expire for tickless idle
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+/*
+ * 分层时间轮，共OS_TIMER_WHEEL_LEVEL_NUM层，每层2^OS_TIMER_WHEEL_BITS个槽位，第i层每个槽位覆盖2^(OS_TIMER_WHEEL_BITS * i)个tick
+ * 定时器按剩余时间放入对应层级的槽位，插入与删除均为O(1)，高层级的槽位在低层级转完一圈时级联到低层级
+ */
+#define TIMER_WHEEL_SIZE SIZE(OS_TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK MASK(OS_TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MAX_DELTA MASK(OS_TIMER_WHEEL_BITS * OS_TIMER_WHEEL_LEVEL_NUM)
+
+static os_list_node_t timer_wheel[OS_TIMER_WHEEL_LEVEL_NUM][TIMER_WHEEL_SIZE];//时间轮槽位
+static os_size_t timer_wheel_tick = 0;//时间轮下一个待处理的tick
+static volatile os_size_t timer_active_num = 0;//已启动且尚未执行回调的定时器数量
+
+/*!
+ * 将定时器放入时间轮中对应的槽位，调用者必须处于临界区
+ * @param timer 定时器结构体指针
+ */
+static void timer_wheel_insert(os_timer_p timer)
+{
+    os_size_t expire = timer -> expire;
+    os_size_t delta = expire - timer_wheel_tick;
+    os_size_t level;
+
+    //已经到期的定时器放入下一个待处理tick对应的槽位
+    if(((os_ssize_t)delta) < 0)
+    {
+        expire = timer_wheel_tick;
+        delta = 0;
+    }
+    //超出时间轮范围的定时器暂时放入最远的槽位，到达该槽位后重新插入
+    else if(delta > TIMER_WHEEL_MAX_DELTA)
+    {
+        expire = timer_wheel_tick + TIMER_WHEEL_MAX_DELTA;
+        delta = TIMER_WHEEL_MAX_DELTA;
+    }
+
+    for(level = 0;level < (OS_TIMER_WHEEL_LEVEL_NUM - 1);level++)
+    {
+        if(delta < SIZE(OS_TIMER_WHEEL_BITS * (level + 1)))
+        {
+            break;
+        }
+    }
+
+    os_size_t index = (expire >> (OS_TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    os_list_insert_tail(timer_wheel[level][index],&timer -> node);
+}
+
+/*!
+ * 将时间轮指定层级中当前tick对应槽位的所有定时器重新插入到更低的层级，调用者必须处于临界区
+ * @param level 层级
+ * @return 该层级当前的槽位下标，为0时说明该层级也转完了一圈，需要继续级联更高的层级
+ */
+static os_size_t timer_wheel_cascade(os_size_t level)
+{
+    os_size_t index = (timer_wheel_tick >> (OS_TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+
+    os_list_entry_foreach_safe(timer_wheel[level][index],os_timer_t,node,timer,
+    {
+        os_list_node_remove(&timer -> node);
+        timer_wheel_insert(timer);
+    });
+
+    return index;
+}
+
+/*!
+ * 在允许的推迟范围内选择低位为0最多的到期时间，使相近的定时器落在同一个tick上到期
+ * @param expire 原始到期tick
+ * @param slack 允许推迟的tick数
+ * @return 调整后的到期tick，位于[expire,expire + slack]范围内
+ */
+static os_size_t timer_apply_slack(os_size_t expire,os_size_t slack)
+{
+    os_size_t limit = expire + slack;
+    os_size_t diff = limit ^ expire;
+
+    if((slack == 0) || (limit < expire))
+    {
+        return expire;
+    }
+
+    //保留最高不同位及以上的部分，清零其余低位
+    return limit & ~MASK(ALIGN_DOWN_MAX(diff));
+}
+
+/*!
+ * 定时器初始化，定时器初始为未启动状态
+ * @param timer 定时器结构体指针
+ * @param func 到期回调函数
+ * @param arg 回调函数参数
+ */
+void os_timer_init(os_timer_p timer,os_timer_func_t func,os_size_t arg)
+{
+    os_list_node_init(&timer -> node);
+    timer -> expire = 0;
+    timer -> slack = OS_TIMER_SLACK_AUTO;
+    timer -> func = func;
+    timer -> arg = arg;
+}
+
+/*!
+ * 设置定时器允许推迟的tick数，在下一次启动定时器时生效
+ * @param timer 定时器结构体指针
+ * @param slack 允许推迟的tick数，为OS_TIMER_SLACK_AUTO时由定时时长自动决定
+ */
+void os_timer_set_slack(os_timer_p timer,os_size_t slack)
+{
+    timer -> slack = slack;
+}
+
+/*!
+ * 启动定时器，若定时器已经启动，则重新设置到期时间，回调函数最早在ticks个tick之后执行
+ * @param timer 定时器结构体指针
+ * @param ticks 定时时长（tick）
+ */
+void os_timer_start(os_timer_p timer,os_size_t ticks)
+{
+    OS_ENTER_CRITICAL_AREA();
+
+    if(!os_list_node_empty(&timer -> node))
+    {
+        os_list_node_remove(&timer -> node);
+        timer_active_num--;
+    }
+
+    //时间轮为空时时钟中断不会推进时间轮，此时可以直接将时间轮对齐到当前tick
+    if(timer_active_num == 0)
+    {
+        timer_wheel_tick = os_tick_get() + 1;
+    }
+
+    os_size_t slack = (timer -> slack == OS_TIMER_SLACK_AUTO) ? (ticks >> 8) : timer -> slack;
+    timer -> expire = timer_apply_slack(os_tick_get() + ticks,slack);
+    timer_wheel_insert(timer);
+    timer_active_num++;
+
+    //主核的下一次时钟中断晚于定时器到期时间时（例如主核处于空闲等待中），需要让主核重新设置时钟中断
+    os_hart_p hart = os_hart_get(0);
+
+    if(timer -> expire < hart -> tick_deadline)
+    {
+        if(os_hart_get_cpu_id() == 0)
+        {
+            os_tick_program_next();
+        }
+        else
+        {
+            bsp_hart_send_ipi(hart -> hart_id);
+        }
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 停止定时器，在临界区中调用时，返回后可以保证回调函数不会再被执行
+ * @param timer 定时器结构体指针
+ * @return 定时器在停止前处于启动状态返回OS_TRUE，否则（未启动或已经到期）返回OS_FALSE
+ */
+os_bool_t os_timer_stop(os_timer_p timer)
+{
+    os_bool_t active;
+
+    OS_ENTER_CRITICAL_AREA();
+    active = !os_list_node_empty(&timer -> node);
+
+    if(active)
+    {
+        os_list_node_remove(&timer -> node);
+        timer_active_num--;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return active;
+}
+
+/*!
+ * 检测定时器是否处于启动状态
+ * @param timer 定时器结构体指针
+ * @return 处于启动状态返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_timer_is_active(os_timer_p timer)
+{
+    return !os_list_node_empty(&timer -> node);
+}
+
+/*!
+ * 获取定时器距离到期的剩余tick数
+ * @param timer 定时器结构体指针
+ * @return 剩余tick数，定时器未启动或已经到期时返回0
+ */
+os_size_t os_timer_get_remaining(os_timer_p timer)
+{
+    os_size_t remaining = 0;
+
+    OS_ENTER_CRITICAL_AREA();
+
+    if(!os_list_node_empty(&timer -> node))
+    {
+        os_ssize_t delta = (os_ssize_t)(timer -> expire - os_tick_get());
+        remaining = (delta > 0) ? delta : 0;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return remaining;
+}
+
+/*!
+ * 获取下一次需要处理时间轮的tick，调用者必须处于临界区
+ * 第0层中最近的非空槽位即为最近的到期时间；第0层为空时，更高层级的定时器都不早于第0层下一次转完一圈的时刻，此时返回该时刻以进行级联
+ * @return 下一次需要处理时间轮的tick，没有启动的定时器时返回OS_TICK_DEADLINE_NONE
+ */
+os_size_t os_timer_get_next_expire()
+{
+    os_size_t i;
+
+    if(timer_active_num == 0)
+    {
+        return OS_TICK_DEADLINE_NONE;
+    }
+
+    for(i = 0;i < TIMER_WHEEL_SIZE;i++)
+    {
+        os_size_t tick = timer_wheel_tick + i;
+
+        if(((tick & TIMER_WHEEL_MASK) == 0) || !os_list_empty(timer_wheel[0][tick & TIMER_WHEEL_MASK]))
+        {
+            return tick;
+        }
+    }
+
+    return timer_wheel_tick + TIMER_WHEEL_SIZE;
+}
+
+/*!
+ * 定时器时钟处理程序，由主核在全局tick更新后调用，推进时间轮并执行所有到期定时器的回调函数
+ */
+void os_timer_handler()
+{
+    //没有启动的定时器时无需获取内核大锁
+    if(__atomic_load_n(&timer_active_num,__ATOMIC_RELAXED) == 0)
+    {
+        return;
+    }
+
+    OS_ENTER_CRITICAL_AREA();
+    os_size_t now = os_tick_get();
+
+    while((timer_active_num > 0) && (((os_ssize_t)(now - timer_wheel_tick)) >= 0))
+    {
+        os_size_t index = timer_wheel_tick & TIMER_WHEEL_MASK;
+        os_size_t level;
+        os_list_node_t expired_list;
+
+        //第0层转完一圈时，逐层级联
+        if(index == 0)
+        {
+            for(level = 1;level < OS_TIMER_WHEEL_LEVEL_NUM;level++)
+            {
+                if(timer_wheel_cascade(level) != 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        //先将到期槽位中的定时器摘到局部列表中并推进时间轮，使回调函数中重新启动的定时器不会在本tick中再次执行
+        os_list_init(expired_list);
+
+        if(!os_list_empty(timer_wheel[0][index]))
+        {
+            expired_list.next = timer_wheel[0][index].next;
+            expired_list.prev = timer_wheel[0][index].prev;
+            expired_list.next -> prev = &expired_list;
+            expired_list.prev -> next = &expired_list;
+            os_list_init(timer_wheel[0][index]);
+        }
+
+        timer_wheel_tick++;
+
+        while(!os_list_empty(expired_list))
+        {
+            os_timer_p timer = os_list_entry(os_list_get_head(expired_list),os_timer_t,node);
+            os_list_node_remove(&timer -> node);
+
+            //超出时间轮范围的定时器尚未真正到期，重新插入
+            if(((os_ssize_t)(timer -> expire - now)) > 0)
+            {
+                timer_wheel_insert(timer);
+                continue;
+            }
+
+            timer_active_num--;
+            timer -> func(timer -> arg);
+        }
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 定时器子系统初始化
+ */
+void os_timer_system_init()
+{
+    os_size_t i,j;
+
+    for(i = 0;i < OS_TIMER_WHEEL_LEVEL_NUM;i++)
+    {
+        for(j = 0;j < TIMER_WHEEL_SIZE;j++)
+        {
+            os_list_init(timer_wheel[i][j]);
+        }
+    }
+
+    timer_wheel_tick = os_tick_get() + 1;
+    timer_active_num = 0;
+}
\ No newline at end of file
@@ -7,6 +7,8 @@
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
  * 2021-07-06     lizhirui     add finer-grained lock
+ * 2021-07-28     lizhirui     use rwsem as the global lock, lookups take it in read mode
+ * 2021-07-28     lizhirui     hold device reference in mount point and during mkfs
  */
 
 // @formatter:off
@@ -15,49 +17,64 @@
 static os_list_node_t fs_list;//文件系统列表
 static os_list_node_t mount_list;//文件系统挂载表
 
-static os_mutex_t vfs_global_lock;//VFS全局锁
+static os_rwsem_t vfs_global_lock;//VFS全局锁，保护文件系统列表和挂载表，查找时以读模式获取，注册、挂载和卸载时以写模式获取
 
 //标识VFS是否初始化完成
 static os_bool_t os_vfs_initialized = OS_FALSE;
 
 /*!
- * VFS加锁
+ * VFS以读模式加锁，不支持递归加锁
  */
-void vfs_lock()
+void vfs_read_lock()
 {
     OS_ANNOTATION_NEED_VFS();
-    os_mutex_lock(&vfs_global_lock);
+    os_rwsem_down_read(&vfs_global_lock);
 }
 
 /*!
- * VFS解锁
+ * VFS读模式解锁
  */
-void vfs_unlock()
+void vfs_read_unlock()
 {
     OS_ANNOTATION_NEED_VFS();
-    os_mutex_unlock(&vfs_global_lock);
+    os_rwsem_up_read(&vfs_global_lock);
 }
 
 /*!
- * 通过文件系统名称在文件系统列表中文件系统结构体指针
+ * VFS以写模式加锁，不支持递归加锁
+ */
+void vfs_write_lock()
+{
+    OS_ANNOTATION_NEED_VFS();
+    os_rwsem_down_write(&vfs_global_lock);
+}
+
+/*!
+ * VFS写模式解锁
+ */
+void vfs_write_unlock()
+{
+    OS_ANNOTATION_NEED_VFS();
+    os_rwsem_up_write(&vfs_global_lock);
+}
+
+/*!
+ * 通过文件系统名称在文件系统列表中文件系统结构体指针，调用者必须持有VFS锁（读模式或写模式）
  * @param fs_name 文件系统名称
  * @return 若找到，返回文件系统结构体指针，否则返回OS_NULL
  */
 static os_vfs_p os_vfs_find_fs_by_name(const char *fs_name)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
 
     os_list_entry_foreach(fs_list,os_vfs_t,node,entry,
     {
         if(os_strcmp(entry -> name,fs_name) == 0)
         {
-            vfs_unlock();
             return entry;
         }
     });
 
-    vfs_unlock();
     return OS_NULL;
 }
 
@@ -69,17 +86,18 @@ static os_vfs_p os_vfs_find_fs_by_name(const char *fs_name)
 os_err_t os_vfs_register(const os_vfs_p fs)
 {
     OS_ANNOTATION_NEED_VFS();
+    vfs_write_lock();
 
     if(os_vfs_find_fs_by_name(fs -> name) != OS_NULL)
     {
+        vfs_write_unlock();
         return -OS_ERR_EINVAL;
     }
 
-    vfs_lock();
     os_mutex_init(&fs -> lock);
     fs -> mount_refcnt = 0;
     os_list_insert_tail(fs_list,&fs -> node);
-    vfs_unlock();
+    vfs_write_unlock();
     return OS_ERR_OK;
 }
 
@@ -179,14 +197,13 @@ os_err_t os_vfs_normalize_path(const char *path,char *buf)
 
 /*!
  * 根据路径查找挂载点，并返回挂载点结构体指针，原理是进行前缀路径匹配，最长的前缀匹配的挂载点就是目标挂载点
+ * 调用者必须持有VFS锁（读模式或写模式），并在释放VFS锁之前锁定挂载点或增加其引用，以防止挂载点被卸载
  * @param path 路径
  * @return 若找到则返回挂载点结构体指针，否则返回OS_NULL
  */
 os_vfs_mp_p os_vfs_find_mp_by_path(const char *path)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
-    
     OS_ASSERT(path != OS_NULL);
 
     os_size_t path_len = os_strlen(path);
@@ -208,7 +225,6 @@ os_vfs_mp_p os_vfs_find_mp_by_path(const char *path)
         }
     });
 
-    vfs_unlock();
     return ret;
 }
 
@@ -224,7 +240,7 @@ os_vfs_mp_p os_vfs_find_mp_by_path(const char *path)
 os_err_t os_vfs_mount(const char *mount_path,const char *fs_name,const char *dev,os_size_t mount_flag,void *priv_data)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
+    vfs_write_lock();
 
     os_err_t ret = OS_ERR_OK;
     //检测文件系统是否存在
@@ -232,7 +248,7 @@ os_err_t os_vfs_mount(const char *mount_path,const char *fs_name,const char *dev
 
     if(fs == OS_NULL)
     {
-        vfs_unlock();
+        vfs_write_unlock();
         return -OS_ERR_EINVAL;
     }
 
@@ -254,18 +270,18 @@ os_err_t os_vfs_mount(const char *mount_path,const char *fs_name,const char *dev
         OS_ERR_SET_ERROR_AND_GOTO(state.type != OS_FILE_TYPE_DIRECTORY,ret,-OS_ERR_ENOTDIR,err);
     }
 
-    //若设备名不为OS_NULL，则获取对应的设备结构体指针
+    //若设备名不为OS_NULL，则获取对应的设备结构体指针，挂载点在卸载之前一直持有该设备的引用
     os_device_p dev_obj = OS_NULL;
 
     if(dev != OS_NULL)
     {
-        dev_obj = os_device_find(dev);
+        dev_obj = os_device_get(dev);
         OS_ERR_SET_ERROR_AND_GOTO(dev_obj == OS_NULL,ret,-OS_ERR_EINVAL,err);
     }
 
     //分配新的挂载点
     os_vfs_mp_p mp = os_memory_alloc(sizeof(os_vfs_mp_t));
-    OS_ERR_SET_ERROR_AND_GOTO(mp == OS_NULL,ret,-OS_ERR_ENOMEM,err);
+    OS_ERR_SET_ERROR_AND_GOTO(mp == OS_NULL,ret,-OS_ERR_ENOMEM,dev_err);
 
     mp -> fs = fs;
     os_strcpy(mp -> path,path_buf);
@@ -294,7 +310,7 @@ os_err_t os_vfs_mount(const char *mount_path,const char *fs_name,const char *dev
     if(ret != OS_ERR_OK)
     {
         os_memory_free(mp);
-        goto err;
+        goto dev_err;
     }
 
     //增加父挂载点的引用数
@@ -306,12 +322,20 @@ os_err_t os_vfs_mount(const char *mount_path,const char *fs_name,const char *dev
     os_list_insert_tail(mount_list,&mp -> node);
     //增加挂载点对应文件系统的应用数
     fs -> mount_refcnt++;
+    goto err;
+
+//挂载失败时释放挂载点持有的设备引用
+dev_err:
+    if(dev_obj != OS_NULL)
+    {
+        os_device_put(dev_obj);
+    }
 
 err:
     os_memory_free(path_buf);
 path_buf_alloc_err:
     os_mutex_unlock(&fs -> lock);
-    vfs_unlock();
+    vfs_write_unlock();
     return ret;
 }
 
@@ -323,7 +347,7 @@ path_buf_alloc_err:
 os_err_t os_vfs_unmount(const char *mount_path)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
+    vfs_write_lock();
 
     os_err_t ret = OS_ERR_OK;
     
@@ -340,6 +364,12 @@ os_err_t os_vfs_unmount(const char *mount_path)
     os_mutex_lock(&mp -> fs -> lock);
     mp -> fs -> mount_refcnt--;
     os_mutex_unlock(&mp -> fs -> lock);
+
+    if(mp -> dev != OS_NULL)
+    {
+        os_device_put(mp -> dev);
+    }
+
     os_memory_free(mp);
 
     os_vfs_mp_p mount_mp = os_vfs_find_mp_by_path(path_buf);
@@ -349,7 +379,7 @@ os_err_t os_vfs_unmount(const char *mount_path)
 err:
     os_memory_free(path_buf);
 path_buf_alloc_err:
-    vfs_unlock();
+    vfs_write_unlock();
     return ret;
 }
 
@@ -366,20 +396,21 @@ os_err_t os_vfs_mkfs(const char *fs_name,const char *dev)
 
     os_err_t ret = OS_ERR_OK;
 
-    vfs_lock();
+    vfs_read_lock();
     os_vfs_p fs = os_vfs_find_fs_by_name(fs_name);
     OS_ERR_SET_ERROR_AND_GOTO(fs == OS_NULL,ret,-OS_ERR_EINVAL,err);
     OS_ERR_SET_ERROR_AND_GOTO(dev == OS_NULL,ret,-OS_ERR_EINVAL,err);
-    os_device_p dev_obj = os_device_find(dev);
+    os_device_p dev_obj = os_device_get(dev);
     OS_ERR_SET_ERROR_AND_GOTO(dev_obj == OS_NULL,ret,-OS_ERR_EINVAL,err);
     os_mutex_lock(&fs -> lock);
-    vfs_unlock();
+    vfs_read_unlock();
     ret = fs -> ops -> mkfs(fs,dev_obj);
     os_mutex_unlock(&fs -> lock);
+    os_device_put(dev_obj);
     return ret;
 
 err:
-    vfs_unlock();
+    vfs_read_unlock();
     return ret;
 }
 
@@ -392,7 +423,7 @@ err:
 os_err_t os_vfs_statfs(const char *mount_path,os_vfs_state_p state)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
+    vfs_read_lock();
 
     os_err_t ret = OS_ERR_OK;
     
@@ -403,7 +434,7 @@ os_err_t os_vfs_statfs(const char *mount_path,os_vfs_state_p state)
     os_vfs_mp_p mp = os_vfs_find_mp_by_path(path_buf);
     OS_ERR_SET_ERROR_AND_GOTO(mp == OS_NULL,ret,-OS_ERR_EINVAL,err);
     os_mutex_lock(&mp -> lock);
-    vfs_unlock();
+    vfs_read_unlock();
     ret = mp -> fs -> ops -> statfs(mp,state);
     os_mutex_unlock(&mp -> lock);
     os_memory_free(path_buf);
@@ -412,7 +443,7 @@ os_err_t os_vfs_statfs(const char *mount_path,os_vfs_state_p state)
 err:
     os_memory_free(path_buf);
 path_buf_alloc_err:
-    vfs_unlock();
+    vfs_read_unlock();
     return ret;
 }
 
@@ -424,7 +455,7 @@ path_buf_alloc_err:
 os_err_t os_vfs_unlink(const char *path)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
+    vfs_read_lock();
 
     os_err_t ret = OS_ERR_OK;
     
@@ -435,7 +466,7 @@ os_err_t os_vfs_unlink(const char *path)
     os_vfs_mp_p mp = os_vfs_find_mp_by_path(path_buf);
     OS_ERR_SET_ERROR_AND_GOTO(mp == OS_NULL,ret,-OS_ERR_EINVAL,err);
     os_mutex_lock(&mp -> lock);
-    vfs_unlock();
+    vfs_read_unlock();
     ret = mp -> fs -> ops -> unlink(mp,path);
     os_mutex_unlock(&mp -> lock);
     os_memory_free(path_buf);
@@ -444,7 +475,7 @@ os_err_t os_vfs_unlink(const char *path)
 err:
     os_memory_free(path_buf);
 path_buf_alloc_err:
-    vfs_unlock();
+    vfs_read_unlock();
     return ret;
 }
 
@@ -457,7 +488,7 @@ path_buf_alloc_err:
 os_err_t os_vfs_stat(const char *path,os_file_state_p state)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
+    vfs_read_lock();
 
     os_err_t ret = OS_ERR_OK;
     
@@ -468,7 +499,7 @@ os_err_t os_vfs_stat(const char *path,os_file_state_p state)
     os_vfs_mp_p mp = os_vfs_find_mp_by_path(path_buf);
     OS_ERR_SET_ERROR_AND_GOTO(mp == OS_NULL,ret,-OS_ERR_EINVAL,err);
     os_mutex_lock(&mp -> lock);
-    vfs_unlock();
+    vfs_read_unlock();
     ret = mp -> fs -> ops -> stat(mp,path,state);
     os_mutex_unlock(&mp -> lock);
     os_memory_free(path_buf);
@@ -477,7 +508,7 @@ os_err_t os_vfs_stat(const char *path,os_file_state_p state)
 err:
     os_memory_free(path_buf);
 path_buf_alloc_err:
-    vfs_unlock();
+    vfs_read_unlock();
     return ret;
 }
 
@@ -490,7 +521,7 @@ path_buf_alloc_err:
 os_err_t os_vfs_rename(const char *old_path,const char *new_path)
 {
     OS_ANNOTATION_NEED_VFS();
-    vfs_lock();
+    vfs_read_lock();
 
     os_err_t ret = OS_ERR_OK;
     
@@ -511,7 +542,7 @@ os_err_t os_vfs_rename(const char *old_path,const char *new_path)
     OS_ERR_SET_ERROR_AND_GOTO(old_mp != new_mp,ret,-OS_ERR_EXDEV,err);
 
     os_mutex_lock(&old_mp -> lock);
-    vfs_unlock();
+    vfs_read_unlock();
     ret = old_mp -> fs -> ops -> rename(old_mp,old_path_buf,new_path_buf);
     os_mutex_unlock(&old_mp -> lock);
     os_memory_free(new_path_buf);
@@ -523,7 +554,7 @@ err:
 new_path_buf_alloc_err:
     os_memory_free(old_path_buf);
 old_path_buf_alloc_err:
-    vfs_unlock();
+    vfs_read_unlock();
     return ret;
 }
 
@@ -543,7 +574,8 @@ void os_vfs_init()
 {
     os_list_init(fs_list);
     os_list_init(mount_list);
-    os_mutex_init(&vfs_global_lock);
+    //挂载和卸载很少发生，使用写者优先以避免其在持续的查找负载下饥饿
+    os_rwsem_init(&vfs_global_lock,OS_RWSEM_PREFER_WRITER);
     os_file_init();
     os_vfs_initialized = OS_TRUE;
 }
@@ -6,6 +6,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-05     lizhirui     the first version
+ * 2021-07-26     lizhirui     add os_waitqueue_wait_timeout
+ * 2021-07-28     lizhirui     add exclusive wait, wake-all and batched wakeup
+ * 2021-07-28     lizhirui     wake non-exclusive waiters queued behind exclusive waiters
+ * 2021-07-28     lizhirui     restore single waiter semantics of os_waitqueue_wakeup
  */
 
 // @formatter:off
@@ -35,20 +39,133 @@ void os_waitqueue_remove(os_waitqueue_node_p node)
 }
 
 /*!
- * 让当前任务在指定的等待队列中等待，执行该函数后，当前任务会进入睡眠态
+ * 让当前任务在指定的等待队列中等待，最多等待ticks个tick
  * @param waitqueue 等待队列结构体指针
+ * @param exclusive 是否为互斥等待
+ * @param ticks 最长等待时间（tick），为OS_WAITQUEUE_WAIT_FOREVER时只在被唤醒时返回
+ * @return 被唤醒返回OS_ERR_OK，超时返回-OS_ERR_ETIMEDOUT
  */
-void os_waitqueue_wait(os_waitqueue_p waitqueue)
+static os_err_t waitqueue_wait(os_waitqueue_p waitqueue,os_bool_t exclusive,os_size_t ticks)
 {
     OS_ANNOTATION_NEED_TASK_CONTEXT();
     os_waitqueue_node_t node;
+    os_err_t ret = OS_ERR_OK;
+
+    OS_ENTER_CRITICAL_AREA();
     node.task = os_task_get_current_task();
+    node.exclusive = exclusive;
     os_waitqueue_add(waitqueue,&node);
-    os_task_sleep();
+
+    if(ticks == OS_WAITQUEUE_WAIT_FOREVER)
+    {
+        os_task_sleep();
+    }
+    else
+    {
+        os_size_t remaining = ticks;
+
+        //唤醒时节点会被移出等待队列，节点仍在队列中说明是超时或其它原因导致的唤醒
+        while(!os_list_node_empty(&node.node) && (remaining > 0))
+        {
+            remaining = os_task_sleep_ticks(remaining);
+        }
+    }
+
+    //被其它原因唤醒时节点仍在等待队列中，必须在返回前移除，调用者通常会在检查等待条件后再次等待
+    if(!os_list_node_empty(&node.node))
+    {
+        os_waitqueue_remove(&node);
+        ret = (ticks == OS_WAITQUEUE_WAIT_FOREVER) ? OS_ERR_OK : -OS_ERR_ETIMEDOUT;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
 }
 
 /*!
- * 唤醒等待队列中的一个任务，若队列为空，则不动作
+ * 让当前任务在指定的等待队列中等待，执行该函数后，当前任务会进入睡眠态，调用者应当在临界区中检查等待条件并调用该函数
+ * @param waitqueue 等待队列结构体指针
+ */
+void os_waitqueue_wait(os_waitqueue_p waitqueue)
+{
+    waitqueue_wait(waitqueue,OS_FALSE,OS_WAITQUEUE_WAIT_FOREVER);
+}
+
+/*!
+ * 让当前任务在指定的等待队列中等待，最多等待ticks个tick
+ * @param waitqueue 等待队列结构体指针
+ * @param ticks 最长等待时间（tick）
+ * @return 被唤醒返回OS_ERR_OK，超时返回-OS_ERR_ETIMEDOUT
+ */
+os_err_t os_waitqueue_wait_timeout(os_waitqueue_p waitqueue,os_size_t ticks)
+{
+    return waitqueue_wait(waitqueue,OS_FALSE,ticks);
+}
+
+/*!
+ * 让当前任务在指定的等待队列中互斥等待，os_waitqueue_wakeup_nr只唤醒指定数量的互斥等待任务，用于避免多个任务竞争同一资源时被同时唤醒
+ * @param waitqueue 等待队列结构体指针
+ */
+void os_waitqueue_wait_exclusive(os_waitqueue_p waitqueue)
+{
+    waitqueue_wait(waitqueue,OS_TRUE,OS_WAITQUEUE_WAIT_FOREVER);
+}
+
+/*!
+ * 让当前任务在指定的等待队列中互斥等待，最多等待ticks个tick
+ * @param waitqueue 等待队列结构体指针
+ * @param ticks 最长等待时间（tick）
+ * @return 被唤醒返回OS_ERR_OK，超时返回-OS_ERR_ETIMEDOUT
+ */
+os_err_t os_waitqueue_wait_exclusive_timeout(os_waitqueue_p waitqueue,os_size_t ticks)
+{
+    return waitqueue_wait(waitqueue,OS_TRUE,ticks);
+}
+
+/*!
+ * 按等待的先后顺序唤醒等待队列中的任务，非互斥等待的任务全部唤醒，互斥等待的任务最多唤醒nr_exclusive个
+ * 所有任务被唤醒后当前hart只调度一次，不会因为被唤醒的任务优先级更高而在唤醒过程中被逐个抢占
+ * @param waitqueue 等待队列结构体指针
+ * @param nr_exclusive 最多唤醒的互斥等待任务数量
+ * @return 被唤醒的任务数量
+ */
+os_size_t os_waitqueue_wakeup_nr(os_waitqueue_p waitqueue,os_size_t nr_exclusive)
+{
+    os_task_wakeup_batch_t batch;
+    os_size_t num = 0;
+
+    OS_ENTER_CRITICAL_AREA();
+    os_task_wakeup_batch_init(&batch);
+
+    os_list_entry_foreach_safe(waitqueue -> waiting_list,os_waitqueue_node_t,node,entry,
+    {
+        os_bool_t exclusive = entry -> exclusive;
+
+        //互斥等待的任务已经唤醒足够数量时跳过其余互斥等待的任务，但仍然唤醒排在其后的非互斥等待的任务
+        if(exclusive && (nr_exclusive == 0))
+        {
+            continue;
+        }
+
+        //被唤醒的任务需要等到当前hart离开临界区后才能继续运行，因此移出节点后节点所在的栈仍然有效
+        os_waitqueue_remove(entry);
+        os_task_wakeup_batch_add(&batch,entry -> task);
+        num++;
+
+        if(exclusive)
+        {
+            nr_exclusive--;
+        }
+    });
+
+    os_task_wakeup_batch_flush(&batch);
+    OS_LEAVE_CRITICAL_AREA();
+    return num;
+}
+
+/*!
+ * 唤醒等待队列头部的一个任务，不区分互斥等待和非互斥等待，若队列为空，则不动作
+ * 需要同时唤醒所有非互斥等待的任务时使用os_waitqueue_wakeup_nr
  * @param waitqueue 等待队列结构体指针
  */
 void os_waitqueue_wakeup(os_waitqueue_p waitqueue)
@@ -65,6 +182,15 @@ void os_waitqueue_wakeup(os_waitqueue_p waitqueue)
     OS_LEAVE_CRITICAL_AREA();
 }
 
+/*!
+ * 唤醒等待队列中的所有任务
+ * @param waitqueue 等待队列结构体指针
+ */
+void os_waitqueue_wakeup_all(os_waitqueue_p waitqueue)
+{
+    os_waitqueue_wakeup_nr(waitqueue,OS_NUMBER_MAX(os_size_t));
+}
+
 /*!
  * 检测等待队列是否为空
  * @param waitqueue 等待队列结构体指针
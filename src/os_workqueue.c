@@ -0,0 +1,364 @@
+/*
+ * Copyright lizhirui
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2021-07-28     lizhirui     the first version
+ * 2021-07-28     lizhirui     workers use exclusive wait
+ */
+
+// @formatter:off
+#include <dreamos.h>
+
+static os_workqueue_t system_workqueue;//系统工作队列，供不需要独立工作线程的驱动程序使用
+
+/*!
+ * 唤醒所有等待工作项完成的任务，调用者必须处于临界区
+ * @param wq 工作队列结构体指针
+ */
+static void workqueue_wakeup_flusher(os_workqueue_p wq)
+{
+    os_waitqueue_wakeup_all(&wq -> flush_waitqueue);
+}
+
+/*!
+ * 获取尚未完成的工作项中最小的序号，调用者必须处于临界区
+ * 等待列表按序号排列，执行列表中最多只有worker_num个工作项，因此只需检查等待列表的头部和整个执行列表
+ * @param wq 工作队列结构体指针
+ * @return 最小的序号，没有尚未完成的工作项时返回下一个将要分配的序号
+ */
+static os_size_t workqueue_get_oldest_seq(os_workqueue_p wq)
+{
+    os_size_t ret = wq -> seq + 1;
+
+    if(!os_list_empty(wq -> pending_list))
+    {
+        ret = os_list_entry(os_list_get_head(wq -> pending_list),os_work_t,node) -> seq;
+    }
+
+    os_list_entry_foreach(wq -> running_list,os_work_t,run_node,work,
+    {
+        ret = MIN(ret,work -> run_seq);
+    });
+
+    return ret;
+}
+
+/*!
+ * 取出第一个没有被其它工作线程执行的工作项，并将其移入执行列表，调用者必须处于临界区
+ * @param wq 工作队列结构体指针
+ * @return 成功返回工作项结构体指针，没有可执行的工作项时返回OS_NULL
+ */
+static os_work_p workqueue_take(os_workqueue_p wq)
+{
+    os_work_p ret = OS_NULL;
+
+    os_list_entry_foreach(wq -> pending_list,os_work_t,node,work,
+    {
+        if(!work -> running)
+        {
+            ret = work;
+            break;
+        }
+    });
+
+    if(ret != OS_NULL)
+    {
+        os_size_t latency = os_tick_get_ns() - ret -> queue_time;
+
+        os_list_node_remove(&ret -> node);
+        os_list_insert_tail(wq -> running_list,&ret -> run_node);
+        ret -> run_seq = ret -> seq;
+        ret -> pending = OS_FALSE;
+        ret -> running = OS_TRUE;
+        wq -> depth--;
+        wq -> running_num++;
+        wq -> latency_total += latency;
+        wq -> latency_max = MAX(wq -> latency_max,latency);
+    }
+
+    return ret;
+}
+
+/*!
+ * 标记工作项执行完成，并唤醒等待工作项完成的任务
+ * @param wq 工作队列结构体指针
+ * @param work 工作项结构体指针
+ * @param exec_time 工作函数的执行时间（纳秒）
+ */
+static void workqueue_finish(os_workqueue_p wq,os_work_p work,os_size_t exec_time)
+{
+    OS_ENTER_CRITICAL_AREA();
+    os_list_node_remove(&work -> run_node);
+    work -> running = OS_FALSE;
+    wq -> running_num--;
+    wq -> exec_count++;
+    wq -> exec_time_total += exec_time;
+    wq -> exec_time_max = MAX(wq -> exec_time_max,exec_time);
+    workqueue_wakeup_flusher(wq);
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 工作线程入口
+ * @param arg 工作队列结构体指针
+ * @return 线程退出码
+ */
+static OS_NORETURN os_ssize_t workqueue_worker_entry(os_size_t arg)
+{
+    os_workqueue_p wq = (os_workqueue_p)arg;
+
+    while(1)
+    {
+        os_work_p work;
+
+        OS_ENTER_CRITICAL_AREA();
+
+        while((work = workqueue_take(wq)) == OS_NULL)
+        {
+            //互斥等待，每加入一个工作项只唤醒一个空闲的工作线程
+            os_waitqueue_wait_exclusive(&wq -> worker_waitqueue);
+        }
+
+        OS_LEAVE_CRITICAL_AREA();
+
+        os_size_t start = os_tick_get_ns();
+        work -> func(work -> arg);
+        workqueue_finish(wq,work,os_tick_get_ns() - start);
+    }
+}
+
+/*!
+ * 工作项初始化
+ * @param work 工作项结构体指针
+ * @param func 工作函数
+ * @param arg 工作函数参数
+ */
+void os_work_init(os_work_p work,os_work_func_t func,os_size_t arg)
+{
+    os_list_node_init(&work -> node);
+    os_list_node_init(&work -> run_node);
+    work -> func = func;
+    work -> arg = arg;
+    work -> wq = OS_NULL;
+    work -> seq = 0;
+    work -> run_seq = 0;
+    work -> queue_time = 0;
+    work -> pending = OS_FALSE;
+    work -> running = OS_FALSE;
+}
+
+/*!
+ * 创建工作队列并启动其工作线程
+ * @param wq 工作队列结构体指针
+ * @param name 工作队列名称，工作线程以“名称/编号”命名，该字符串在工作队列的整个生命周期内必须有效
+ * @param worker_num 工作线程数量
+ * @param priority 工作线程优先级
+ * @return 成功返回OS_ERR_OK，失败返回错误码
+ */
+os_err_t os_workqueue_create(os_workqueue_p wq,const char *name,os_size_t worker_num,os_size_t priority)
+{
+    os_err_t ret = OS_ERR_OK;
+    os_size_t i;
+    char task_name[32];
+
+    OS_ERR_RETURN_ERROR(worker_num == 0,-OS_ERR_EINVAL);
+
+    wq -> name = name;
+    os_list_init(wq -> pending_list);
+    os_list_init(wq -> running_list);
+    os_waitqueue_init(&wq -> worker_waitqueue);
+    os_waitqueue_init(&wq -> flush_waitqueue);
+    wq -> worker_num = worker_num;
+    wq -> seq = 0;
+    wq -> depth = 0;
+    wq -> max_depth = 0;
+    wq -> running_num = 0;
+    wq -> queue_count = 0;
+    wq -> exec_count = 0;
+    wq -> latency_total = 0;
+    wq -> latency_max = 0;
+    wq -> exec_time_total = 0;
+    wq -> exec_time_max = 0;
+    wq -> worker = os_memory_alloc(sizeof(os_task_p) * worker_num);
+    OS_ERR_RETURN_ERROR(wq -> worker == OS_NULL,-OS_ERR_ENOMEM);
+
+    //先创建全部工作线程再统一启动，使创建失败时可以直接移除已经创建的线程
+    for(i = 0;i < worker_num;i++)
+    {
+        os_task_p task = os_task_alloc();
+
+        if(task == OS_NULL)
+        {
+            ret = -OS_ERR_ENOMEM;
+            goto worker_err;
+        }
+
+        os_snprintf(task_name,sizeof(task_name),"%s/%ld",name,i);
+
+        if((ret = os_task_init(task,OS_WORKQUEUE_WORKER_STACK_SIZE,priority,OS_WORKQUEUE_WORKER_TICK_INIT,workqueue_worker_entry,(os_size_t)wq,task_name)) != OS_ERR_OK)
+        {
+            os_task_free(task);
+            goto worker_err;
+        }
+
+        wq -> worker[i] = task;
+    }
+
+    for(i = 0;i < worker_num;i++)
+    {
+        os_task_startup(wq -> worker[i]);
+    }
+
+    return OS_ERR_OK;
+
+worker_err:
+    while(i > 0)
+    {
+        i--;
+        os_task_remove(wq -> worker[i]);
+    }
+
+    os_memory_free(wq -> worker);
+    wq -> worker = OS_NULL;
+    return ret;
+}
+
+/*!
+ * 将工作项加入工作队列，可以在中断上下文中调用
+ * @param wq 工作队列结构体指针
+ * @param work 工作项结构体指针
+ * @return 成功加入返回OS_TRUE，工作项已经在等待执行时返回OS_FALSE
+ */
+os_bool_t os_workqueue_queue(os_workqueue_p wq,os_work_p work)
+{
+    os_bool_t ret = OS_FALSE;
+
+    OS_ENTER_CRITICAL_AREA();
+
+    if(!work -> pending)
+    {
+        work -> pending = OS_TRUE;
+        work -> wq = wq;
+        work -> seq = ++wq -> seq;
+        work -> queue_time = os_tick_get_ns();
+        os_list_insert_tail(wq -> pending_list,&work -> node);
+        wq -> depth++;
+        wq -> queue_count++;
+        wq -> max_depth = MAX(wq -> max_depth,wq -> depth);
+        os_waitqueue_wakeup(&wq -> worker_waitqueue);
+        ret = OS_TRUE;
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 取消等待执行的工作项，正在执行的工作项不受影响
+ * @param work 工作项结构体指针
+ * @return 工作项在取消前处于等待执行状态返回OS_TRUE，否则返回OS_FALSE
+ */
+os_bool_t os_work_cancel(os_work_p work)
+{
+    os_bool_t ret;
+
+    OS_ENTER_CRITICAL_AREA();
+    ret = work -> pending;
+
+    if(ret)
+    {
+        os_list_node_remove(&work -> node);
+        work -> pending = OS_FALSE;
+        work -> wq -> depth--;
+        workqueue_wakeup_flusher(work -> wq);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+    return ret;
+}
+
+/*!
+ * 等待工作项执行完成，返回时工作项既不处于等待执行状态，也不处于正在执行状态，不能在同一工作队列的工作函数中调用
+ * @param work 工作项结构体指针
+ */
+void os_work_flush(os_work_p work)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    OS_ENTER_CRITICAL_AREA();
+
+    while(work -> pending || work -> running)
+    {
+        os_waitqueue_wait(&work -> wq -> flush_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 等待调用前加入工作队列的所有工作项执行完成，调用期间新加入的工作项不会延长等待时间，不能在同一工作队列的工作函数中调用
+ * @param wq 工作队列结构体指针
+ */
+void os_workqueue_flush(os_workqueue_p wq)
+{
+    OS_ANNOTATION_NEED_TASK_CONTEXT();
+    OS_ENTER_CRITICAL_AREA();
+    os_size_t target = wq -> seq;
+
+    while(workqueue_get_oldest_seq(wq) <= target)
+    {
+        os_waitqueue_wait(&wq -> flush_waitqueue);
+    }
+
+    OS_LEAVE_CRITICAL_AREA();
+}
+
+/*!
+ * 获取工作队列中等待执行的工作项数量
+ * @param wq 工作队列结构体指针
+ * @return 等待执行的工作项数量
+ */
+os_size_t os_workqueue_get_depth(os_workqueue_p wq)
+{
+    return wq -> depth;
+}
+
+/*!
+ * 打印工作队列的统计信息
+ * @param wq 工作队列结构体指针
+ */
+void os_workqueue_print_info(os_workqueue_p wq)
+{
+    os_size_t latency_avg = (wq -> exec_count > 0) ? (wq -> latency_total / wq -> exec_count) : 0;
+    os_size_t exec_time_avg = (wq -> exec_count > 0) ? (wq -> exec_time_total / wq -> exec_count) : 0;
+    os_printf("workqueue %s:workers = %ld,depth = %ld,max depth = %ld,running = %ld,queued = %ld,executed = %ld,avg latency = %ld ns,max latency = %ld ns,avg exec = %ld ns,max exec = %ld ns\n",wq -> name,wq -> worker_num,wq -> depth,wq -> max_depth,wq -> running_num,wq -> queue_count,wq -> exec_count,latency_avg,wq -> latency_max,exec_time_avg,wq -> exec_time_max);
+}
+
+/*!
+ * 获取系统工作队列
+ * @return 系统工作队列结构体指针
+ */
+os_workqueue_p os_workqueue_get_system()
+{
+    return &system_workqueue;
+}
+
+/*!
+ * 将工作项加入系统工作队列，可以在中断上下文中调用
+ * @param work 工作项结构体指针
+ * @return 成功加入返回OS_TRUE，工作项已经在等待执行时返回OS_FALSE
+ */
+os_bool_t os_work_schedule(os_work_p work)
+{
+    return os_workqueue_queue(&system_workqueue,work);
+}
+
+/*!
+ * 创建系统工作队列并启动其工作线程
+ */
+void os_workqueue_system_startup()
+{
+    OS_ASSERT(os_workqueue_create(&system_workqueue,"events",OS_SYSTEM_WORKQUEUE_WORKER_NUM,OS_SYSTEM_WORKQUEUE_PRIORITY) == OS_ERR_OK);
+}
\ No newline at end of file
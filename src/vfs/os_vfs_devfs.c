@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-07-09     lizhirui     the first version
+ * 2021-07-28     lizhirui     walk device list under rcu in readdir
+ * 2021-07-28     lizhirui     hold device reference while the device file is open
  */
 
 // @formatter:off
@@ -70,14 +72,21 @@ static os_err_t devfs_open(os_file_fd_p fd)
     OS_ASSERT(fd != OS_NULL);
     OS_ASSERT(fd -> fnode != OS_NULL);
 
-    os_device_p dev = os_device_find(fd -> fnode -> path + fd -> fnode -> mp -> subpath_offset);
+    //每个打开的文件描述符持有一个设备引用，在关闭时释放，使设备在打开期间不会被解注册
+    os_device_p dev = os_device_get(fd -> fnode -> path + fd -> fnode -> mp -> subpath_offset);
 
     if(dev == OS_NULL)
     {
         return -OS_ERR_ENOENT;
     }
 
-    OS_ERR_GET_ERROR_AND_RETURN(os_device_op_open(dev,fd -> open_flag));
+    os_err_t ret = os_device_op_open(dev,fd -> open_flag);
+
+    if(ret != OS_ERR_OK)
+    {
+        os_device_put(dev);
+        return ret;
+    }
 
     if(fd -> fnode -> refcnt >= 1)
     {
@@ -95,7 +104,14 @@ static os_err_t devfs_open(os_file_fd_p fd)
 static os_err_t devfs_close(os_file_fd_p fd)
 {
     os_device_p dev = (os_device_p)fd -> fnode -> priv_data;
-    return os_device_op_close(dev);
+    os_err_t ret = os_device_op_close(dev);
+
+    if(ret == OS_ERR_OK)
+    {
+        os_device_put(dev);
+    }
+
+    return ret;
 }
 
 static os_err_t devfs_ioctl(os_file_fd_p fd,os_size_t cmd,os_size_t arg)
@@ -129,40 +145,34 @@ static os_err_t devfs_lseek(os_file_fd_p fd,os_size_t offset)
 
 static os_err_t devfs_readdir(os_file_fd_p fd,os_dirent_p entry,os_size_t count)
 {
-    os_size_t i;
+    os_size_t index = 0;
+    os_size_t i = 0;
 
     if(count == 0)
     {
         return -OS_ERR_EINVAL;
     }
 
-    os_list_node_p list_root = os_device_get_list();
-    os_list_node_p cur_node = list_root;
-    cur_node = cur_node -> next;
+    //设备列表可能被并发修改，在RCU读临界区中遍历，跳过已经读取过的设备
+    os_rcu_read_lock();
 
-    for(i = 0;i < fd -> pos;i++)
+    os_list_entry_foreach_rcu(*os_device_get_list(),os_device_t,node,dev,
     {
-        if(cur_node -> next == list_root)
+        if(i >= count)
         {
-            fd -> pos = i;
             break;
         }
 
-        cur_node = cur_node -> next;
-    }
-
-    for(i = 0;(i < count) && (fd -> pos < fd -> fnode -> size);i++,fd -> pos++)
-    {
-        if(cur_node -> next == list_root)
+        if(index++ >= fd -> pos)
         {
-            break;
+            os_strcpy(entry[i].name,dev -> name);
+            entry[i].type = OS_FILE_TYPE_DEVICE;
+            i++;
         }
+    });
 
-        os_device_p dev = os_container_of(cur_node,os_device_t,node);
-        os_strcpy(entry[i].name,dev -> name);
-        entry[i].type = OS_FILE_TYPE_DEVICE;
-    }
-
+    os_rcu_read_unlock();
+    fd -> pos += i;
     return i;
 }
 